@@ -0,0 +1,207 @@
+// Бенчмарк динамической иерархии объёмов (VgetAabbTree): обновление тысяч движущихся объектов и запросы к дереву.
+// Результаты запросов сверяются с полным перебором толстых AABB всех листьев.
+#include "vget_aabb_tree.hpp"
+#include "vget_camera.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr size_t OBJECT_COUNT = 20'000;
+	constexpr int FRAME_COUNT = 120;
+	constexpr int QUERIES_PER_FRAME = 100;	// сферических, AABB и лучевых запросов за кадр
+	constexpr float WORLD_HALF_SIZE = 100.f;
+	constexpr float FRAME_TIME = 1.f / 60.f;
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	double elapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	struct MovingObject
+	{
+		glm::vec3 position;
+		glm::vec3 velocity;
+		glm::vec3 extents;
+		int32_t proxy;
+
+		vget::Aabb box() const { return vget::Aabb{ position - extents, position + extents }; }
+	};
+
+	// Сравнение результата запроса с эталоном без учёта порядка
+	bool sameSet(std::vector<uint32_t> a, std::vector<uint32_t> b)
+	{
+		std::sort(a.begin(), a.end());
+		std::sort(b.begin(), b.end());
+		return a == b;
+	}
+}
+
+int main()
+{
+	using namespace vget;
+
+	std::mt19937 rng{ 42 };
+	std::uniform_real_distribution<float> position{ -WORLD_HALF_SIZE, WORLD_HALF_SIZE };
+	std::uniform_real_distribution<float> size{ .2f, 1.5f };
+	std::uniform_real_distribution<float> speed{ -3.f, 3.f };
+	std::uniform_real_distribution<float> unit{ -1.f, 1.f };
+
+	// Движется только каждый четвёртый объект, остальные статичны, как в типичной сцене
+	std::vector<MovingObject> objects(OBJECT_COUNT);
+	for (size_t i = 0; i < OBJECT_COUNT; ++i)
+	{
+		auto& obj = objects[i];
+		obj.position = { position(rng), position(rng), position(rng) };
+		obj.velocity = i % 4 == 0 ? glm::vec3{ speed(rng), speed(rng), speed(rng) } : glm::vec3{ 0.f };
+		obj.extents = { size(rng), size(rng), size(rng) };
+	}
+
+	VgetAabbTree tree{};
+	auto start = Clock::now();
+	for (size_t i = 0; i < OBJECT_COUNT; ++i)
+	{
+		objects[i].proxy = tree.createProxy(objects[i].box(), static_cast<uint32_t>(i));
+	}
+	const double buildMs = elapsedMs(start);
+	tree.validate();
+	const int32_t buildHeight = tree.getHeight();
+	const float buildAreaRatio = tree.getAreaRatio();
+
+	VgetCamera camera{};
+	camera.setPerspectiveProjection(glm::radians(50.f), 1280.f / 960.f, .1f, 100.f);
+
+	double updateMs = 0.0, frustumMs = 0.0, sphereMs = 0.0, aabbMs = 0.0, rayMs = 0.0;
+	size_t reinserts = 0, frustumHits = 0;
+	std::vector<uint32_t> result;
+	std::vector<uint32_t> expected;
+	bool mismatch = false;
+
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		// Обновление: движущиеся объекты отражаются от границ мира
+		start = Clock::now();
+		for (auto& obj : objects)
+		{
+			if (obj.velocity == glm::vec3{ 0.f }) continue;
+			const glm::vec3 displacement = obj.velocity * FRAME_TIME;
+			obj.position += displacement;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (std::abs(obj.position[axis]) > WORLD_HALF_SIZE) obj.velocity[axis] = -obj.velocity[axis];
+			}
+			if (tree.moveProxy(obj.proxy, obj.box(), displacement)) ++reinserts;
+		}
+		updateMs += elapsedMs(start);
+
+		// Камера вращается вокруг центра мира
+		const float angle = frame * .05f;
+		camera.setViewYXZ(glm::vec3{ 0.f }, glm::vec3{ 0.f, angle, 0.f });
+		const Frustum frustum = camera.getFrustum();
+
+		result.clear();
+		start = Clock::now();
+		tree.queryFrustum(frustum, result);
+		frustumMs += elapsedMs(start);
+		frustumHits += result.size();
+
+		// Эталонная проверка раз в 30 кадров, чтобы перебор не доминировал во времени работы бенчмарка
+		const bool verify = frame % 30 == 0;
+		if (verify)
+		{
+			expected.clear();
+			for (size_t i = 0; i < OBJECT_COUNT; ++i)
+			{
+				if (frustum.intersects(tree.getFatAabb(objects[i].proxy))) expected.push_back(static_cast<uint32_t>(i));
+			}
+			mismatch |= !sameSet(result, expected);
+		}
+
+		for (int q = 0; q < QUERIES_PER_FRAME; ++q)
+		{
+			const glm::vec3 point{ position(rng), position(rng), position(rng) };
+			const float radius = 5.f;
+			const Aabb box{ point - glm::vec3{ 4.f }, point + glm::vec3{ 4.f } };
+			const glm::vec3 direction{ unit(rng), unit(rng), unit(rng) };
+
+			result.clear();
+			start = Clock::now();
+			tree.querySphere(point, radius, result);
+			sphereMs += elapsedMs(start);
+			if (verify && q == 0)
+			{
+				expected.clear();
+				for (size_t i = 0; i < OBJECT_COUNT; ++i)
+				{
+					const Aabb& fat = tree.getFatAabb(objects[i].proxy);
+					const glm::vec3 delta = glm::clamp(point, fat.min, fat.max) - point;
+					if (glm::dot(delta, delta) <= radius * radius) expected.push_back(static_cast<uint32_t>(i));
+				}
+				mismatch |= !sameSet(result, expected);
+			}
+
+			result.clear();
+			start = Clock::now();
+			tree.queryAabb(box, result);
+			aabbMs += elapsedMs(start);
+			if (verify && q == 0)
+			{
+				expected.clear();
+				for (size_t i = 0; i < OBJECT_COUNT; ++i)
+				{
+					if (tree.getFatAabb(objects[i].proxy).overlaps(box)) expected.push_back(static_cast<uint32_t>(i));
+				}
+				mismatch |= !sameSet(result, expected);
+			}
+
+			result.clear();
+			start = Clock::now();
+			tree.queryRay(point, direction, 50.f, result);
+			rayMs += elapsedMs(start);
+			if (verify && q == 0)
+			{
+				expected.clear();
+				for (size_t i = 0; i < OBJECT_COUNT; ++i)
+				{
+					const Aabb& fat = tree.getFatAabb(objects[i].proxy);
+					const glm::vec3 t1 = (fat.min - point) / direction;
+					const glm::vec3 t2 = (fat.max - point) / direction;
+					const glm::vec3 tNear = glm::min(t1, t2);
+					const glm::vec3 tFar = glm::max(t1, t2);
+					const float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+					const float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, 50.f));
+					if (tEnter <= tExit) expected.push_back(static_cast<uint32_t>(i));
+				}
+				mismatch |= !sameSet(result, expected);
+			}
+		}
+	}
+	tree.validate();
+
+	std::cout << "Dynamic AABB tree, " << OBJECT_COUNT << " objects (" << OBJECT_COUNT / 4 << " moving), "
+		<< FRAME_COUNT << " frames\n";
+	std::cout << "  build:\t\t" << buildMs << " ms (height " << buildHeight << ", area ratio " << buildAreaRatio << ")\n";
+	std::cout << "  update:\t\t" << updateMs / FRAME_COUNT << " ms/frame, "
+		<< static_cast<double>(reinserts) / FRAME_COUNT << " reinserts/frame\n";
+	std::cout << "  frustum query:\t" << frustumMs / FRAME_COUNT * 1000.0 << " us ("
+		<< frustumHits / FRAME_COUNT << " hits avg)\n";
+	std::cout << "  sphere query:\t\t" << sphereMs / (FRAME_COUNT * QUERIES_PER_FRAME) * 1000.0 << " us\n";
+	std::cout << "  aabb query:\t\t" << aabbMs / (FRAME_COUNT * QUERIES_PER_FRAME) * 1000.0 << " us\n";
+	std::cout << "  ray query:\t\t" << rayMs / (FRAME_COUNT * QUERIES_PER_FRAME) * 1000.0 << " us\n";
+	std::cout << "  final tree:\t\theight " << tree.getHeight() << ", area ratio " << tree.getAreaRatio() << "\n";
+
+	if (mismatch)
+	{
+		std::cerr << "Tree query results differ from brute force!" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,568 @@
+// Бенчмарк конвейера загрузки ассетов на CPU: разбор .obj, слияние вершин, оптимизация индексов под кэш вершин,
+// декодирование изображений и построение мип-уровней. Загрузка останавливается перед созданием буферов и изображений,
+// поэтому девайс Vulkan не нужен.
+// Модели: все .obj из models/ и сгенерированные большие .obj (сетка ландшафта и россыпь кубов отдельными фигурами).
+// Изображения: файлы из models/ и сгенерированные PNG. PNG пишутся без сжатия (блоки stored), поэтому их декодирование
+// показывает в основном разбор и снятие фильтров строк - реальные текстуры можно передать аргументами.
+// Для каждого этапа выводит время, пропускную способность (МБ/с файла, вершин/с, пикселей/с), количество выделений
+// памяти и пик кучи. Вершины считаются по углам треугольников на входе этапа.
+// Проверяет, что оптимизация индексов сохраняет треугольники с их обходом и не ухудшает попадания в кэш вершин,
+// и что мип-уровни однотонного изображения сохраняют цвет, а усреднение идёт в линейном пространстве.
+//
+// asset_pipeline_benchmark [model.obj | image.png ...]
+#include "vget_model.hpp"
+#include "vget_texture.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifndef MODELS_DIR
+#define MODELS_DIR "../models/"
+#endif
+
+namespace
+{
+	// Учёт выделений через глобальные operator new/delete. stb_image выделяет память через malloc,
+	// поэтому пиксели при декодировании видны только в пиковом RSS процесса.
+	std::atomic<uint64_t> allocationCount{ 0 };
+	std::atomic<uint64_t> allocatedBytes{ 0 };
+	std::atomic<int64_t> liveBytes{ 0 };
+	std::atomic<int64_t> peakLiveBytes{ 0 };
+	constexpr size_t ALLOCATION_HEADER = alignof(std::max_align_t);	// перед блоком хранится его размер
+}
+
+void* operator new(size_t size)
+{
+	void* block = std::malloc(size + ALLOCATION_HEADER);
+	if (block == nullptr) throw std::bad_alloc{};
+	*static_cast<size_t*>(block) = size;
+
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	const int64_t live = liveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+	int64_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+	while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+	return static_cast<char*>(block) + ALLOCATION_HEADER;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	if (pointer == nullptr) return;
+	char* block = static_cast<char*>(pointer) - ALLOCATION_HEADER;
+	liveBytes.fetch_sub(static_cast<int64_t>(*reinterpret_cast<size_t*>(block)), std::memory_order_relaxed);
+	std::free(block);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* pointer) noexcept { operator delete(pointer); }
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete(pointer); }
+
+namespace
+{
+	using Builder = vget::VgetModel::Builder;
+	using ImageData = vget::VgetTexture::ImageData;
+
+	constexpr uint32_t TERRAIN_GRID = 384;			// ландшафт из TERRAIN_GRID x TERRAIN_GRID квадов
+	constexpr uint32_t CUBE_COUNT = 20'000;			// кубы с плоскими нормалями, каждый - отдельная фигура .obj
+	constexpr uint32_t VERTEX_CACHE_SIZE = 16;		// как в VgetModel::Builder::optimizeIndices
+	constexpr size_t TARGET_VERTICES = 2'000'000;	// повторы замера набирают столько вершин (пикселей) на файл
+	constexpr uint32_t MAX_ITERATIONS = 50;
+
+	double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	double megabytes(double bytes) { return bytes / (1024.0 * 1024.0); }
+
+	// Результат замера одного этапа. Выделения - за один проход, пик кучи - сверх занятой до этапа памяти.
+	struct Phase
+	{
+		double ms = 0.0;
+		uint64_t allocations = 0;
+		uint64_t bytes = 0;
+		int64_t peakBytes = 0;
+
+		void add(const Phase& other)
+		{
+			ms += other.ms;
+			allocations = other.allocations;
+			bytes = other.bytes;
+			peakBytes = std::max(peakBytes, other.peakBytes);
+		}
+	};
+
+	template<typename Func>
+	Phase measure(Func&& func)
+	{
+		const uint64_t allocationsBefore = allocationCount.load();
+		const uint64_t bytesBefore = allocatedBytes.load();
+		const int64_t base = liveBytes.load();
+		peakLiveBytes.store(base);
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		func();
+		const double ms = elapsedMs(start);
+		return Phase{ ms, allocationCount.load() - allocationsBefore, allocatedBytes.load() - bytesBefore, peakLiveBytes.load() - base };
+	}
+
+	// Итог этапа по всем файлам
+	struct PhaseTotal
+	{
+		double ms = 0.0;
+		double fileBytes = 0.0;
+		double items = 0.0;		// вершины или пиксели
+		uint64_t allocations = 0;
+		int64_t peakBytes = 0;
+	};
+
+	void printPhase(const char* name, const Phase& phase, uint32_t iterations, double fileBytes, double items, const char* itemUnit, PhaseTotal& total)
+	{
+		const double ms = phase.ms / iterations;
+		std::cout << "  " << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << ms << " ms";
+		if (fileBytes > 0.0) std::cout << std::setprecision(1) << std::setw(9) << megabytes(fileBytes) / (ms * 1e-3) << " MB/s";
+		else std::cout << std::setw(14) << "";
+		std::cout << std::setprecision(2) << std::setw(9) << items / (ms * 1e-3) * 1e-6 << " M" << itemUnit << "/s"
+			<< "   allocs " << phase.allocations << " (" << std::setprecision(1) << megabytes(static_cast<double>(phase.bytes)) << " MB)"
+			<< ", peak heap " << megabytes(static_cast<double>(phase.peakBytes)) << " MB\n";
+
+		total.ms += ms;
+		total.fileBytes += fileBytes;
+		total.items += items;
+		total.allocations += phase.allocations;
+		total.peakBytes = std::max(total.peakBytes, phase.peakBytes);
+	}
+
+	void printTotal(const char* name, const PhaseTotal& total, const char* itemUnit)
+	{
+		std::cout << "  " << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << total.ms << " ms";
+		if (total.fileBytes > 0.0) std::cout << std::setprecision(1) << std::setw(9) << megabytes(total.fileBytes) / (total.ms * 1e-3) << " MB/s";
+		else std::cout << std::setw(14) << "";
+		std::cout << std::setprecision(2) << std::setw(9) << total.items / (total.ms * 1e-3) * 1e-6 << " M" << itemUnit << "/s"
+			<< "   allocs " << total.allocations << ", peak heap " << std::setprecision(1) << megabytes(static_cast<double>(total.peakBytes)) << " MB\n";
+	}
+
+	size_t peakResidentBytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return counters.PeakWorkingSetSize;
+		return 0;
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+		return static_cast<size_t>(usage.ru_maxrss);
+#else
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+	}
+
+	// Ландшафт: сетка вершин с позициями, координатами текстуры и нормалями, треугольные грани
+	void writeTerrainObj(const std::string& filepath)
+	{
+		std::ofstream file{ filepath, std::ios::trunc };
+		const uint32_t side = TERRAIN_GRID + 1;
+		for (uint32_t z = 0; z < side; ++z)
+			for (uint32_t x = 0; x < side; ++x)
+			{
+				const float height = std::sin(x * .07f) * std::cos(z * .05f) * 4.f;
+				file << "v " << x * .5f << ' ' << height << ' ' << z * .5f << '\n';
+			}
+		for (uint32_t z = 0; z < side; ++z)
+			for (uint32_t x = 0; x < side; ++x)
+				file << "vt " << static_cast<float>(x) / TERRAIN_GRID << ' ' << static_cast<float>(z) / TERRAIN_GRID << '\n';
+		for (uint32_t z = 0; z < side; ++z)
+			for (uint32_t x = 0; x < side; ++x)
+			{
+				const float dx = std::cos(x * .07f) * std::cos(z * .05f) * .28f;
+				const float dz = -std::sin(x * .07f) * std::sin(z * .05f) * .2f;
+				const float length = std::sqrt(dx * dx + 1.f + dz * dz);
+				file << "vn " << -dx / length << ' ' << 1.f / length << ' ' << -dz / length << '\n';
+			}
+
+		file << "o Terrain\n";
+		auto corner = [&](uint32_t x, uint32_t z)
+		{
+			const uint32_t index = z * side + x + 1;
+			file << ' ' << index << '/' << index << '/' << index;
+		};
+		for (uint32_t z = 0; z < TERRAIN_GRID; ++z)
+			for (uint32_t x = 0; x < TERRAIN_GRID; ++x)
+			{
+				file << 'f'; corner(x, z); corner(x, z + 1); corner(x + 1, z); file << '\n';
+				file << 'f'; corner(x + 1, z); corner(x, z + 1); corner(x + 1, z + 1); file << '\n';
+			}
+	}
+
+	// Россыпь кубов: у каждого куба своя фигура, грани - четырёхугольники с плоскими нормалями (tinyobj их триангулирует)
+	void writeCubesObj(const std::string& filepath)
+	{
+		std::ofstream file{ filepath, std::ios::trunc };
+		std::mt19937 rng{ 42 };
+		std::uniform_real_distribution<float> position{ -200.f, 200.f };
+		std::uniform_real_distribution<float> size{ .2f, 2.f };
+
+		file << "vn -1 0 0\nvn 1 0 0\nvn 0 -1 0\nvn 0 1 0\nvn 0 0 -1\nvn 0 0 1\n";
+		const uint32_t faces[6][4] = { {0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6} };
+		for (uint32_t cube = 0; cube < CUBE_COUNT; ++cube)
+		{
+			const float cx = position(rng), cy = position(rng), cz = position(rng), half = size(rng);
+			file << "o Cube" << cube << '\n';
+			for (int corner = 0; corner < 8; ++corner)
+			{
+				file << "v " << (corner & 1 ? cx + half : cx - half) << ' ' << (corner & 2 ? cy + half : cy - half)
+					<< ' ' << (corner & 4 ? cz + half : cz - half) << '\n';
+			}
+			const uint32_t base = cube * 8 + 1;
+			for (uint32_t face = 0; face < 6; ++face)
+			{
+				file << 'f';
+				for (uint32_t corner : faces[face]) file << ' ' << base + corner << "//" << face + 1;
+				file << '\n';
+			}
+		}
+	}
+
+	uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0)
+	{
+		static const std::vector<uint32_t> table = []
+		{
+			std::vector<uint32_t> result(256);
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				uint32_t c = i;
+				for (int bit = 0; bit < 8; ++bit) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				result[i] = c;
+			}
+			return result;
+		}();
+		crc = ~crc;
+		for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	void appendBigEndian(std::vector<unsigned char>& out, uint32_t value)
+	{
+		for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<unsigned char>(value >> shift));
+	}
+
+	// PNG RGBA8 без фильтров строк и со сжатием deflate в режиме stored - минимум кода для файла, который читает stb_image
+	void writePng(const std::string& filepath, uint32_t width, uint32_t height, const std::vector<unsigned char>& rgba)
+	{
+		std::vector<unsigned char> raw;
+		raw.reserve(static_cast<size_t>(width * 4 + 1) * height);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			raw.push_back(0);
+			raw.insert(raw.end(), rgba.begin() + static_cast<size_t>(y) * width * 4, rgba.begin() + static_cast<size_t>(y + 1) * width * 4);
+		}
+
+		std::vector<unsigned char> zlib{ 0x78, 0x01 };
+		for (size_t offset = 0; offset < raw.size(); offset += 65535)
+		{
+			const uint16_t length = static_cast<uint16_t>(std::min<size_t>(65535, raw.size() - offset));
+			zlib.push_back(offset + length == raw.size() ? 1 : 0);
+			zlib.insert(zlib.end(), { static_cast<unsigned char>(length), static_cast<unsigned char>(length >> 8),
+				static_cast<unsigned char>(~length), static_cast<unsigned char>(static_cast<uint16_t>(~length) >> 8) });
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+		}
+		uint32_t a = 1, b = 0;
+		for (unsigned char c : raw) { a = (a + c) % 65521; b = (b + a) % 65521; }
+		appendBigEndian(zlib, (b << 16) | a);
+
+		std::vector<unsigned char> png{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		auto chunk = [&](const char* type, const std::vector<unsigned char>& data)
+		{
+			appendBigEndian(png, static_cast<uint32_t>(data.size()));
+			const size_t start = png.size();
+			png.insert(png.end(), type, type + 4);
+			png.insert(png.end(), data.begin(), data.end());
+			appendBigEndian(png, crc32(png.data() + start, png.size() - start));
+		};
+		std::vector<unsigned char> header;
+		appendBigEndian(header, width);
+		appendBigEndian(header, height);
+		header.insert(header.end(), { 8, 6, 0, 0, 0 });	// 8 бит на канал, RGBA
+		chunk("IHDR", header);
+		chunk("IDAT", zlib);
+		chunk("IEND", {});
+
+		std::ofstream file{ filepath, std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+	}
+
+	std::vector<unsigned char> makeImage(uint32_t width, uint32_t height, uint32_t seed)
+	{
+		std::mt19937 rng{ seed };
+		std::uniform_int_distribution<int> noise{ -24, 24 };
+		std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+		for (uint32_t y = 0; y < height; ++y)
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				unsigned char* pixel = rgba.data() + (static_cast<size_t>(y) * width + x) * 4;
+				pixel[0] = static_cast<unsigned char>(std::clamp(static_cast<int>(x * 255 / width) + noise(rng), 0, 255));
+				pixel[1] = static_cast<unsigned char>(std::clamp(static_cast<int>(y * 255 / height) + noise(rng), 0, 255));
+				pixel[2] = static_cast<unsigned char>(((x / 32 + y / 32) % 2) * 200 + 20);
+				pixel[3] = 255;
+			}
+		return rgba;
+	}
+
+	// Доля промахов FIFO-кэша вершин на треугольник (ACMR)
+	double averageCacheMissRatio(const std::vector<uint32_t>& indices)
+	{
+		if (indices.size() < 3) return 0.0;
+		std::deque<uint32_t> cache;
+		size_t misses = 0;
+		for (uint32_t index : indices)
+		{
+			if (std::find(cache.begin(), cache.end(), index) != cache.end()) continue;
+			++misses;
+			cache.push_back(index);
+			if (cache.size() > VERTEX_CACHE_SIZE) cache.pop_front();
+		}
+		return static_cast<double>(misses) / static_cast<double>(indices.size() / 3);
+	}
+
+	// Треугольники модели как отсортированные хэши содержимого вершин: не зависят от номеров вершин
+	// и от того, с какого угла начинается треугольник, но различают обход
+	std::vector<uint64_t> triangleHashes(const Builder& builder)
+	{
+		auto vertexHash = [](const vget::VgetModel::Vertex& vertex)
+		{
+			unsigned char bytes[sizeof(vget::VgetModel::Vertex)];
+			std::memcpy(bytes, &vertex, sizeof(bytes));
+			uint64_t hash = 1469598103934665603ull;
+			for (unsigned char c : bytes) hash = (hash ^ c) * 1099511628211ull;
+			return hash;
+		};
+
+		std::vector<uint64_t> result;
+		result.reserve(builder.indices.size() / 3);
+		for (size_t i = 0; i + 2 < builder.indices.size(); i += 3)
+		{
+			uint64_t corners[3] = { vertexHash(builder.vertices[builder.indices[i]]),
+				vertexHash(builder.vertices[builder.indices[i + 1]]), vertexHash(builder.vertices[builder.indices[i + 2]]) };
+			std::rotate(corners, std::min_element(corners, corners + 3), corners + 3);
+			result.push_back(corners[0] * 31 + corners[1] * 1000003 + corners[2] * 998244353);
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	bool isImageFile(const std::filesystem::path& path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+	}
+
+	// Контроль мип-уровней: однотонное изображение нечётного размера сохраняет цвет на всех уровнях,
+	// а шахматка из чёрного и белого усредняется до 188 (0.5 в линейном пространстве), а не до 128
+	bool checkMips()
+	{
+		bool valid = true;
+		ImageData flat{ 333, 77 };
+		flat.pixels.resize(static_cast<size_t>(flat.width) * flat.height * 4);
+		for (size_t i = 0; i < flat.pixels.size(); i += 4)
+		{
+			flat.pixels[i] = 200; flat.pixels[i + 1] = 120; flat.pixels[i + 2] = 37; flat.pixels[i + 3] = 255;
+		}
+		vget::VgetTexture::generateMips(flat);
+		if (flat.mipLevels != 9 || flat.pixels.size() != vget::VgetTexture::mipOffset(flat.width, flat.height, flat.mipLevels))
+		{
+			std::cerr << "Mip chain of a 333x77 image has wrong size!" << std::endl;
+			valid = false;
+		}
+		for (size_t i = 0; valid && i < flat.pixels.size(); i += 4)
+		{
+			if (flat.pixels[i] != 200 || flat.pixels[i + 1] != 120 || flat.pixels[i + 2] != 37 || flat.pixels[i + 3] != 255)
+			{
+				std::cerr << "Mip levels of a flat image change its color!" << std::endl;
+				valid = false;
+			}
+		}
+
+		ImageData checker{ 2, 2, 1, { 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255 } };
+		vget::VgetTexture::generateMips(checker);
+		const unsigned char* last = checker.pixels.data() + vget::VgetTexture::mipOffset(2, 2, 1);
+		if (checker.mipLevels != 2 || last[0] != 188 || last[3] != 255)
+		{
+			std::cerr << "Mip filter does not average in linear space!" << std::endl;
+			valid = false;
+		}
+		return valid;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace vget;
+	namespace fs = std::filesystem;
+
+	bool failed = !checkMips();
+
+	// Набор файлов: содержимое models/, сгенерированные файлы и аргументы командной строки
+	std::vector<std::string> modelPaths, imagePaths;
+	auto addFile = [&](const fs::path& path)
+	{
+		if (path.extension() == ".obj") modelPaths.push_back(path.string());
+		else if (isImageFile(path)) imagePaths.push_back(path.string());
+	};
+	if (fs::is_directory(MODELS_DIR))
+	{
+		std::vector<fs::path> files;
+		for (const auto& entry : fs::directory_iterator{ MODELS_DIR }) files.push_back(entry.path());
+		std::sort(files.begin(), files.end());
+		for (const auto& path : files) addFile(path);
+	}
+	else
+	{
+		std::cerr << "Models directory " << MODELS_DIR << " not found, only generated assets are measured" << std::endl;
+	}
+
+	const fs::path generatedDir = fs::temp_directory_path() / "vget_asset_pipeline_benchmark";
+	fs::create_directories(generatedDir);
+	const std::string terrainPath = (generatedDir / "terrain.obj").string();
+	const std::string cubesPath = (generatedDir / "cubes.obj").string();
+	writeTerrainObj(terrainPath);
+	writeCubesObj(cubesPath);
+	modelPaths.push_back(terrainPath);
+	modelPaths.push_back(cubesPath);
+
+	const std::pair<uint32_t, uint32_t> imageSizes[] = { { 2048, 2048 }, { 1024, 1024 }, { 1000, 600 } };
+	for (const auto& [width, height] : imageSizes)
+	{
+		const std::string path = (generatedDir / ("image_" + std::to_string(width) + "x" + std::to_string(height) + ".png")).string();
+		writePng(path, width, height, makeImage(width, height, width ^ height));
+		imagePaths.push_back(path);
+	}
+	for (int arg = 1; arg < argc; ++arg) addFile(argv[arg]);
+
+	// Модели
+	PhaseTotal parseTotal{}, weldTotal{}, optimizeTotal{};
+	std::cout << "Models (" << modelPaths.size() << " files), vertices are triangle corners on input\n";
+	for (const auto& path : modelPaths)
+	{
+		const double fileBytes = static_cast<double>(fs::file_size(path));
+
+		// Прогон без замера: размеры модели и проверка оптимизации индексов
+		Builder builder{};
+		try
+		{
+			builder.weldVertices(*Builder::parseObj(path));
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << path << ": " << e.what() << std::endl;
+			failed = true;
+			continue;
+		}
+		const size_t corners = builder.indices.size();
+		const size_t uniqueVertices = builder.vertices.size();
+		const std::vector<uint64_t> trianglesBefore = triangleHashes(builder);
+		const double acmrBefore = averageCacheMissRatio(builder.indices);
+		builder.optimizeIndices();
+		const double acmrAfter = averageCacheMissRatio(builder.indices);
+		if (triangleHashes(builder) != trianglesBefore || builder.vertices.size() != uniqueVertices)
+		{
+			std::cerr << path << ": index optimization changed the triangles!" << std::endl;
+			failed = true;
+		}
+		if (acmrAfter > acmrBefore + 1e-9)
+		{
+			std::cerr << path << ": index optimization made vertex cache hits worse!" << std::endl;
+			failed = true;
+		}
+
+		const uint32_t iterations = static_cast<uint32_t>(std::clamp<size_t>(TARGET_VERTICES / std::max<size_t>(corners, 1), 1, MAX_ITERATIONS));
+		Phase parse{}, weld{}, optimize{};
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			Builder timed{};
+			std::shared_ptr<const Builder::ObjFile> obj;
+			parse.add(measure([&] { obj = Builder::parseObj(path); }));
+			weld.add(measure([&] { timed.weldVertices(*obj); }));
+			obj.reset();	// как в loadModel: разобранный файл освобождается до оптимизации
+			optimize.add(measure([&] { timed.optimizeIndices(); }));
+		}
+
+		std::cout << fs::path{ path }.filename().string() << ": " << std::fixed << std::setprecision(2) << megabytes(fileBytes) << " MB, "
+			<< corners << " vertices -> " << uniqueVertices << " unique, " << builder.subObjectsInfo.size() << " shapes, ACMR "
+			<< std::setprecision(3) << acmrBefore << " -> " << acmrAfter << ", " << iterations << " iterations\n";
+		printPhase("parse", parse, iterations, fileBytes, static_cast<double>(corners), "verts", parseTotal);
+		printPhase("weld", weld, iterations, 0.0, static_cast<double>(corners), "verts", weldTotal);
+		printPhase("optimize", optimize, iterations, 0.0, static_cast<double>(corners), "verts", optimizeTotal);
+	}
+
+	// Изображения
+	PhaseTotal decodeTotal{}, mipsTotal{};
+	std::cout << "\nImages (" << imagePaths.size() << " files)\n";
+	for (const auto& path : imagePaths)
+	{
+		const double fileBytes = static_cast<double>(fs::file_size(path));
+		ImageData image = VgetTexture::loadImage(path, false);
+		if (image.pixels.empty())
+		{
+			std::cerr << path << ": failed to decode image" << std::endl;
+			failed = true;
+			continue;
+		}
+		const double pixels = static_cast<double>(image.width) * image.height;
+
+		const uint32_t iterations = static_cast<uint32_t>(std::clamp<size_t>(TARGET_VERTICES / std::max<size_t>(static_cast<size_t>(pixels), 1), 1, MAX_ITERATIONS));
+		Phase decode{}, mips{};
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			ImageData timed{};
+			decode.add(measure([&] { timed = VgetTexture::loadImage(path, false); }));
+			mips.add(measure([&] { VgetTexture::generateMips(timed); }));
+			image = std::move(timed);
+		}
+
+		std::cout << fs::path{ path }.filename().string() << ": " << std::fixed << std::setprecision(2) << megabytes(fileBytes) << " MB, "
+			<< image.width << "x" << image.height << ", " << image.mipLevels << " mip levels, " << iterations << " iterations\n";
+		printPhase("decode", decode, iterations, fileBytes, pixels, "pix", decodeTotal);
+		printPhase("mips", mips, iterations, 0.0, pixels, "pix", mipsTotal);
+	}
+
+	std::cout << "\nTotals per load\n";
+	printTotal("parse", parseTotal, "verts");
+	printTotal("weld", weldTotal, "verts");
+	printTotal("optimize", optimizeTotal, "verts");
+	printTotal("decode", decodeTotal, "pix");
+	printTotal("mips", mipsTotal, "pix");
+	std::cout << "  peak RSS:  " << std::setprecision(1) << megabytes(static_cast<double>(peakResidentBytes())) << " MB\n";
+
+	fs::remove_all(generatedDir);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+// Стресс-тест сортировки полупрозрачных билбордов (VgetBillboardBatch) на 100 тысячах точечных источников света.
+// Сравнивает покадровое время сбора, сортировки от дальних к ближним и записи в буфер экземпляров со старым
+// подходом через std::map по дистанции. Источники стоят на целочисленной сетке, поэтому многие из них равноудалены
+// от камеры: std::map теряет такие билборды, а стабильная сортировка должна сохранить их в порядке добавления.
+#include "vget_billboards.hpp"
+
+// std
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace
+{
+	constexpr int GRID_SIZE = 100;	// GRID_SIZE x GRID_SIZE x BILLBOARD_LAYERS источников
+	constexpr int BILLBOARD_LAYERS = 10;
+	constexpr int FRAME_COUNT = 60;
+
+	float distanceSquared(const vget::BillboardInstance& instance, const glm::vec3& cameraPosition)
+	{
+		const glm::vec3 offset = glm::vec3(instance.position) - cameraPosition;
+		return glm::dot(offset, offset);
+	}
+}
+
+int main()
+{
+	using namespace vget;
+
+	std::vector<BillboardInstance> sceneLights;
+	sceneLights.reserve(GRID_SIZE * GRID_SIZE * BILLBOARD_LAYERS);
+	for (int layer = 0; layer < BILLBOARD_LAYERS; ++layer)
+	{
+		for (int z = 0; z < GRID_SIZE; ++z)
+		{
+			for (int x = 0; x < GRID_SIZE; ++x)
+			{
+				BillboardInstance instance{};
+				instance.position = glm::vec4{ x - GRID_SIZE / 2.f, -static_cast<float>(layer), z - GRID_SIZE / 2.f, .1f };
+				instance.color = glm::vec4{ 1.f, 1.f, 1.f, static_cast<float>(sceneLights.size()) };	// w - номер источника
+				sceneLights.push_back(instance);
+			}
+		}
+	}
+
+	VgetBillboardBatch batch{};
+	batch.reserve(sceneLights.size());
+	std::vector<BillboardInstance> instanceBuffer(sceneLights.size());
+
+	bool failed = false;
+	double batchMs = 0.0, mapMs = 0.0;
+	size_t mapDrawn = 0;
+
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		// Камера стоит над узлом сетки, поэтому симметричные источники находятся на одинаковом расстоянии
+		const glm::vec3 cameraPosition{ static_cast<float>(frame % 7), 3.f, static_cast<float>(frame % 5) };
+
+		auto start = std::chrono::high_resolution_clock::now();
+		batch.clear();
+		for (const auto& light : sceneLights) batch.add(light);
+		batch.sortBackToFront(cameraPosition);
+		batch.copySorted(instanceBuffer.data());
+		batchMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		// Старый подход: std::map по квадрату дистанции и перебор в обратном порядке
+		start = std::chrono::high_resolution_clock::now();
+		std::map<float, uint32_t> sorted;
+		for (uint32_t i = 0; i < sceneLights.size(); ++i)
+		{
+			sorted[distanceSquared(sceneLights[i], cameraPosition)] = i;
+		}
+		size_t drawn = 0;
+		for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) drawn += sceneLights[it->second].position.w > 0.f;
+		mapMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		mapDrawn += drawn;
+
+		// От дальних к ближним, равноудалённые - в порядке добавления, и ни один билборд не потерян
+		for (size_t i = 1; i < instanceBuffer.size() && !failed; ++i)
+		{
+			const float previous = distanceSquared(instanceBuffer[i - 1], cameraPosition);
+			const float current = distanceSquared(instanceBuffer[i], cameraPosition);
+			if (current > previous || (current == previous && instanceBuffer[i].color.w <= instanceBuffer[i - 1].color.w))
+			{
+				std::cerr << "Frame " << frame << ": billboards " << i - 1 << " and " << i << " are out of order!" << std::endl;
+				failed = true;
+			}
+		}
+	}
+
+	std::cout << "Point light billboards, " << sceneLights.size() << " lights, " << FRAME_COUNT << " frames\n";
+	std::cout << "  radix sort batch:\t" << batchMs / FRAME_COUNT << " ms/frame, " << sceneLights.size() << " drawn\n";
+	std::cout << "  std::map:\t\t" << mapMs / FRAME_COUNT << " ms/frame, " << mapDrawn / FRAME_COUNT << " drawn\n";
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
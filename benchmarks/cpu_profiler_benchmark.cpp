@@ -0,0 +1,202 @@
+// Бенчмарк профайлера зон CPU (VgetCpuProfiler). Собирается с VGET_ENABLE_PROFILER.
+// Накладные расходы: стоимость одной зоны по сравнению с голым чтением часов в одном и нескольких потоках.
+// Стресс-проверки: экспорт трассы, пока потоки пишут в свои кольца (в файле только целые события), полные кольца
+// после переполнения и автозахват окна вокруг медленного кадра.
+#include "vget_cpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t OVERHEAD_ZONE_COUNT = 2000000;
+	constexpr uint32_t WRITER_THREAD_COUNT = 4;
+	constexpr uint32_t WRITER_ZONE_COUNT = vget::VgetCpuProfiler::EVENTS_PER_THREAD * 4;	// каждое кольцо переполняется
+	constexpr int CONCURRENT_EXPORT_COUNT = 5;
+	constexpr int FAST_FRAME_COUNT = 10;
+	constexpr double FAST_FRAME_MS = 1.0;
+	constexpr double SLOW_FRAME_MS = 20.0;
+	constexpr double SLOW_FRAME_THRESHOLD_MS = 10.0;
+
+	const char* const STRESS_ZONE = "Stress zone";
+	const char* const SLOW_ZONE = "Slow work";
+
+	double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	void spin(double ms)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		while (elapsedMs(start) < ms) {}
+	}
+
+	std::string readFile(const std::filesystem::path& path)
+	{
+		std::ifstream in{ path };
+		std::stringstream content;
+		content << in.rdbuf();
+		return content.str();
+	}
+
+	size_t countOccurrences(const std::string& text, const std::string& pattern)
+	{
+		size_t count = 0;
+		for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + pattern.size())) ++count;
+		return count;
+	}
+
+	// Трасса целиком: обрамление массива событий и только известные имена зон (затёртое событие дало бы мусор)
+	bool isWellFormed(const std::string& trace)
+	{
+		if (trace.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0) != 0) return false;
+		if (trace.size() < 3 || trace.compare(trace.size() - 3, 3, "]}\n") != 0) return false;
+		const size_t events = countOccurrences(trace, "\"pid\":1");
+		const size_t known = countOccurrences(trace, "\"name\":\"Stress zone\"") + countOccurrences(trace, "\"name\":\"thread_name\"") +
+			countOccurrences(trace, "\"name\":\"exportChromeTrace\"") + countOccurrences(trace, "\"name\":\"Overhead zone\"");
+		return events == known;
+	}
+
+	void measureOverhead(uint32_t threadCount)
+	{
+		auto run = [&](auto&& body)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			std::vector<std::thread> threads;
+			for (uint32_t t = 0; t < threadCount; ++t)
+			{
+				threads.emplace_back([&]()
+				{
+					for (uint32_t i = 0; i < OVERHEAD_ZONE_COUNT; ++i) body();
+				});
+			}
+			for (auto& thread : threads) thread.join();
+			return elapsedMs(start) * 1e6 / OVERHEAD_ZONE_COUNT;
+		};
+
+		std::atomic<uint64_t> sink{ 0 };
+		const double clockNs = run([&]()
+		{
+			sink.fetch_add(vget::VgetCpuProfiler::now() & 1, std::memory_order_relaxed);
+			sink.fetch_add(vget::VgetCpuProfiler::now() & 1, std::memory_order_relaxed);
+		});
+		const double zoneNs = run([&]() { VGET_PROFILE_ZONE("Overhead zone"); });
+		std::cout << "  " << threadCount << " thread(s):\tzone " << zoneNs << " ns, two clock reads " << clockNs << " ns\n";
+	}
+
+	bool stressConcurrentExport(const std::filesystem::path& directory)
+	{
+		std::atomic<uint32_t> finished{ 0 };
+		std::vector<std::thread> writers;
+		for (uint32_t t = 0; t < WRITER_THREAD_COUNT; ++t)
+		{
+			writers.emplace_back([&, t]()
+			{
+				VGET_PROFILE_THREAD_NAME("Writer " + std::to_string(t));
+				for (uint32_t i = 0; i < WRITER_ZONE_COUNT; ++i)
+				{
+					VGET_PROFILE_ZONE(STRESS_ZONE);
+				}
+				finished.fetch_add(1);
+				// Потоки живут до конца проверки, чтобы их кольца не достались следующим потокам
+				while (finished.load() != 0) std::this_thread::yield();
+			});
+		}
+
+		bool ok = true;
+		int exports = 0;
+		const auto start = std::chrono::high_resolution_clock::now();
+		while (finished.load() < WRITER_THREAD_COUNT || exports < CONCURRENT_EXPORT_COUNT)
+		{
+			const auto path = directory / ("concurrent_" + std::to_string(exports % CONCURRENT_EXPORT_COUNT) + ".json");
+			ok &= vget::VgetCpuProfiler::get().exportChromeTrace(path.string());
+			ok &= isWellFormed(readFile(path));
+			++exports;
+		}
+		const double ms = elapsedMs(start);
+
+		// После переполнения из каждого кольца читаются EVENTS_PER_THREAD - 1 последних событий
+		const auto fullPath = directory / "full.json";
+		ok &= vget::VgetCpuProfiler::get().exportChromeTrace(fullPath.string());
+		const std::string trace = readFile(fullPath);
+		const size_t stressZones = countOccurrences(trace, "\"name\":\"Stress zone\"");
+		const bool namesFound = countOccurrences(trace, "\"name\":\"Writer ") == WRITER_THREAD_COUNT;
+
+		finished = 0;
+		for (auto& writer : writers) writer.join();
+
+		std::cout << "  " << WRITER_THREAD_COUNT << " writers x " << WRITER_ZONE_COUNT << " zones, " << exports << " concurrent exports:\t" << ms << " ms\n";
+		if (!ok || stressZones != static_cast<size_t>(WRITER_THREAD_COUNT) * (vget::VgetCpuProfiler::EVENTS_PER_THREAD - 1) || !namesFound)
+		{
+			std::cerr << "profiler exported torn events or lost ring contents (" << stressZones << " stress zones)" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stressSlowFrameCapture(const std::filesystem::path& directory)
+	{
+		vget::VgetCpuProfiler& profiler = vget::VgetCpuProfiler::get();
+		profiler.setCaptureDirectory(directory.string() + "/");
+		profiler.setSlowFrameThreshold(SLOW_FRAME_THRESHOLD_MS);
+
+		const int frameCount = FAST_FRAME_COUNT + 1 + static_cast<int>(vget::VgetCpuProfiler::CAPTURE_FRAMES_AFTER) + 1;
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			VGET_PROFILE_FRAME();
+			if (frame == FAST_FRAME_COUNT)
+			{
+				VGET_PROFILE_ZONE(SLOW_ZONE);
+				spin(SLOW_FRAME_MS);
+			}
+			else
+			{
+				spin(FAST_FRAME_MS);
+			}
+		}
+		profiler.setSlowFrameThreshold(0.0);
+
+		const std::string capturePath = profiler.getLastCapturePath();
+		const std::string trace = capturePath.empty() ? std::string{} : readFile(capturePath);
+		const size_t frames = countOccurrences(trace, "\"name\":\"Frame\"");
+		const uint32_t expectedFrames = vget::VgetCpuProfiler::CAPTURE_FRAMES_BEFORE + 1 + vget::VgetCpuProfiler::CAPTURE_FRAMES_AFTER;
+
+		std::cout << "  slow frame capture:\t\t" << (capturePath.empty() ? "none" : capturePath) << ", " << frames << " frames\n";
+		if (capturePath.empty() || countOccurrences(trace, "\"name\":\"Slow work\"") != 1 || frames < expectedFrames || frames > expectedFrames + 1)
+		{
+			std::cerr << "profiler did not capture the window around the slow frame" << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	bool failed = false;
+	const auto directory = std::filesystem::temp_directory_path() / "vget_cpu_profiler_benchmark";
+	std::filesystem::create_directories(directory);
+
+	std::cout << "Zone overhead, " << OVERHEAD_ZONE_COUNT << " zones per thread\n";
+	measureOverhead(1);
+	measureOverhead(std::max(2u, std::thread::hardware_concurrency()));
+
+	std::cout << "CPU profiler stress tests\n";
+	failed |= !stressConcurrentExport(directory);
+	failed |= !stressSlowFrameCapture(directory);
+
+	std::filesystem::remove_all(directory);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
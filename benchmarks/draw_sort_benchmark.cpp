@@ -0,0 +1,98 @@
+// Бенчмарк сортировки пакетов отрисовки (radixSort) по 64-битным ключам.
+// Ключи моделируют реальный кадр: несколько пайплайнов, сотни материалов, тысячи моделей и случайная глубина.
+// Проверяет, что поразрядная сортировка стабильна и даёт тот же порядок, что и std::stable_sort.
+#include "vget_draw_queue.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr size_t PACKET_COUNT = 1'000'000;
+	constexpr int ITERATIONS = 10;
+
+	constexpr uint32_t PIPELINE_COUNT = 4;
+	constexpr uint32_t MATERIAL_COUNT = 300;
+	constexpr uint32_t MODEL_COUNT = 5'000;
+
+	template<typename Func>
+	double measureMs(const std::vector<vget::DrawPacket>& input, std::vector<vget::DrawPacket>& output, Func&& sort)
+	{
+		double totalMs = 0.0;
+		for (int i = 0; i < ITERATIONS; ++i)
+		{
+			output = input;
+			const auto start = std::chrono::high_resolution_clock::now();
+			sort(output);
+			totalMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+		return totalMs / ITERATIONS;
+	}
+}
+
+int main()
+{
+	using namespace vget;
+
+	std::mt19937 rng{ 42 };
+	std::uniform_int_distribution<uint32_t> model{ 0, MODEL_COUNT - 1 };
+	std::uniform_real_distribution<float> depth{ 0.f, 1.f };
+
+	std::vector<DrawPacket> packets;
+	packets.reserve(PACKET_COUNT);
+	const auto keyStart = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < PACKET_COUNT; ++i)
+	{
+		// Материал и пайплайн определяются моделью, как у реальных подобъектов
+		const uint32_t modelId = model(rng);
+		const uint32_t materialId = modelId % MATERIAL_COUNT;
+		packets.push_back(DrawPacket{ DrawKey::make(materialId % PIPELINE_COUNT, materialId, modelId, depth(rng)), static_cast<uint32_t>(i) });
+	}
+	const double keyMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - keyStart).count();
+
+	std::vector<DrawPacket> scratch;
+	std::vector<DrawPacket> radixSorted, stdSorted, stableSorted;
+	const double radixMs = measureMs(packets, radixSorted, [&scratch](std::vector<DrawPacket>& p) { radixSort(p, scratch); });
+	const double stdMs = measureMs(packets, stdSorted,
+		[](std::vector<DrawPacket>& p) { std::sort(p.begin(), p.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; }); });
+	const double stableMs = measureMs(packets, stableSorted,
+		[](std::vector<DrawPacket>& p) { std::stable_sort(p.begin(), p.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; }); });
+
+	bool failed = false;
+	for (size_t i = 0; i < PACKET_COUNT; ++i)
+	{
+		if (radixSorted[i].key != stableSorted[i].key || radixSorted[i].index != stableSorted[i].index)
+		{
+			std::cerr << "Radix sort differs from std::stable_sort at " << i << "!" << std::endl;
+			failed = true;
+			break;
+		}
+	}
+
+	// Очередь отрисовки считает переключения состояния до и после сортировки
+	VgetDrawQueue queue{};
+	queue.reserve(PACKET_COUNT);
+	for (const auto& packet : packets) queue.add(packet.key, packet.index);
+	queue.sort();
+	const DrawStats& stats = queue.getStats();
+	if (stats.draws != PACKET_COUNT || stats.stateChanges + stats.elided != countStateChanges(packets))
+	{
+		std::cerr << "Draw queue statistics are inconsistent!" << std::endl;
+		failed = true;
+	}
+
+	std::cout << "Draw packet sorting, " << PACKET_COUNT << " packets, " << ITERATIONS << " iterations\n";
+	std::cout << "  key generation:\t" << keyMs << " ms\n";
+	std::cout << "  radix sort:\t\t" << radixMs << " ms (" << radixMs / PACKET_COUNT * 1e6 << " ns/packet)\n";
+	std::cout << "  std::sort:\t\t" << stdMs << " ms\n";
+	std::cout << "  std::stable_sort:\t" << stableMs << " ms\n";
+	std::cout << "  state changes:\t" << stats.stateChanges + stats.elided << " unsorted -> " << stats.stateChanges
+		<< " sorted (" << stats.elided << " elided)\n";
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,238 @@
+// Бенчмарк хранилища сущностей на архетипах (VgetWorld).
+// Сцена: 100 тысяч объектов, из которых только 50 - точечные источники света. Сравнивает покадровый проход
+// по трансформациям всех объектов и сбор источников света в прежней схеме (толстые объекты в unordered_map
+// с компонентами в куче) с последовательным и параллельным перебором чанков архетипов.
+// Проверяет, что все варианты посещают одни и те же данные, что перенос сущности между архетипами сохраняет
+// компоненты и что после уничтожения сущности её дескриптор становится недействительным.
+#include "vget_game_object.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	constexpr size_t OBJECT_COUNT = 100'000;
+	constexpr size_t LIGHT_COUNT = 50;
+	constexpr int FRAME_COUNT = 100;
+	constexpr size_t CHURN_COUNT = 10'000;	// сущностей уничтожается и создаётся заново
+
+	// Игровой объект в прежнем виде: всё в одном объекте, необязательные компоненты - отдельные выделения в куче
+	struct LegacyObject
+	{
+		uint32_t id;
+		vget::TransformComponent transform{};
+		std::shared_ptr<vget::VgetModel> model{};
+		std::unique_ptr<vget::PointLightComponent> pointLight{};
+		glm::vec3 color{};
+		std::string name;
+	};
+
+	double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	bool nearlyEqual(double a, double b)
+	{
+		return std::abs(a - b) <= 1e-6 * std::max(1.0, std::abs(a));
+	}
+}
+
+int main()
+{
+	using namespace vget;
+
+	std::mt19937 rng{ 42 };
+	std::uniform_real_distribution<float> position{ -100.f, 100.f };
+
+	// Одинаковые сцены в обоих хранилищах
+	std::unordered_map<uint32_t, LegacyObject> legacy;
+	VgetWorld world;
+	VgetJobSystem jobSystem;
+	std::vector<Entity> entities;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+	{
+		const bool light = i % (OBJECT_COUNT / LIGHT_COUNT) == 0;
+		LegacyObject object{ i };
+		object.transform.translation = { position(rng), position(rng), position(rng) };
+		object.name = "Object" + std::to_string(i);
+		if (light) object.pointLight = std::make_unique<PointLightComponent>();
+		legacy.emplace(i, std::move(object));
+	}
+	const double legacyFillMs = elapsedMs(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+	{
+		const bool light = i % (OBJECT_COUNT / LIGHT_COUNT) == 0;
+		const Entity entity = light ? VgetGameObject::makePointLight(world, 1.f) : VgetGameObject::createGameObject(world);
+		world.getComponent<TransformComponent>(entity)->translation = legacy.at(i).transform.translation;
+		world.getComponent<TransformComponent>(entity)->scale = legacy.at(i).transform.scale;
+		entities.push_back(entity);
+	}
+	const double worldFillMs = elapsedMs(start);
+
+	// Покадровый проход: сдвиг всех объектов и сумма координат, затем сумма по источникам света
+	double legacyMs = 0.0, sequentialMs = 0.0, parallelMs = 0.0;
+	double legacySum = 0.0, sequentialSum = 0.0, parallelSum = 0.0;
+	double legacyLightSum = 0.0, sequentialLightSum = 0.0;
+	std::mutex sumMutex;
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		start = std::chrono::high_resolution_clock::now();
+		for (auto& kv : legacy)
+		{
+			kv.second.transform.translation.y += 1.f;
+			legacySum += kv.second.transform.translation.x + kv.second.transform.scale.x;
+		}
+		for (auto& kv : legacy)
+		{
+			if (kv.second.pointLight == nullptr) continue;
+			legacyLightSum += kv.second.transform.translation.y + kv.second.pointLight->lightIntensity;
+		}
+		legacyMs += elapsedMs(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		world.forEach<TransformComponent>([&](Entity, TransformComponent& transform)
+		{
+			transform.translation.y += 1.f;
+			sequentialSum += transform.translation.x + transform.scale.x;
+		});
+		world.forEach<TransformComponent, PointLightComponent>([&](Entity, TransformComponent& transform, PointLightComponent& light)
+		{
+			sequentialLightSum += transform.translation.y + light.lightIntensity;
+		});
+		sequentialMs += elapsedMs(start);
+
+		// Каждый поток копит сумму своего чанка и добавляет её в общую один раз
+		start = std::chrono::high_resolution_clock::now();
+		world.parallelForEachChunk<TransformComponent>(jobSystem, [&](const Entity*, uint32_t count, TransformComponent* transforms)
+		{
+			double chunkSum = 0.0;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				transforms[i].translation.z += 1.f;
+				chunkSum += transforms[i].translation.x + transforms[i].scale.x;
+			}
+			std::lock_guard<std::mutex> lock{ sumMutex };
+			parallelSum += chunkSum;
+		});
+		parallelMs += elapsedMs(start);
+	}
+
+	bool failed = false;
+	if (!nearlyEqual(legacySum, sequentialSum) || !nearlyEqual(legacySum, parallelSum)
+		|| !nearlyEqual(legacyLightSum, sequentialLightSum))
+	{
+		std::cerr << "Map and world iteration visited different data!" << std::endl;
+		failed = true;
+	}
+
+	// Последовательный проход сдвигал объекты по Y (как и проход по map), параллельный - по Z
+	for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+	{
+		const TransformComponent* transform = world.getComponent<TransformComponent>(entities[i]);
+		const glm::vec3& expected = legacy.at(i).transform.translation;
+		if (transform == nullptr || transform->translation.x != expected.x || transform->translation.y != expected.y
+			|| transform->translation.z != expected.z + FRAME_COUNT)
+		{
+			std::cerr << "Entity " << i << " has wrong transform!" << std::endl;
+			failed = true;
+			break;
+		}
+	}
+
+	// Перенос между архетипами: добавление и удаление метки не должно менять остальные компоненты
+	for (uint32_t i = 0; i < OBJECT_COUNT; i += 7)
+	{
+		world.addComponent(entities[i], OccluderComponent{});
+	}
+	for (uint32_t i = 0; i < OBJECT_COUNT; i += 14)
+	{
+		world.removeComponent<OccluderComponent>(entities[i]);
+	}
+	size_t expectedOccluders = 0;
+	for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+	{
+		const bool occluder = i % 7 == 0 && i % 14 != 0;
+		expectedOccluders += occluder;
+		const TransformComponent* transform = world.getComponent<TransformComponent>(entities[i]);
+		if (world.hasComponent<OccluderComponent>(entities[i]) != occluder || transform == nullptr
+			|| transform->translation.x != legacy.at(i).transform.translation.x
+			|| world.hasComponent<PointLightComponent>(entities[i]) != (legacy.at(i).pointLight != nullptr))
+		{
+			std::cerr << "Entity " << i << " lost components while changing archetype!" << std::endl;
+			failed = true;
+			break;
+		}
+	}
+	if (world.count<OccluderComponent>() != expectedOccluders)
+	{
+		std::cerr << "Wrong occluder count!" << std::endl;
+		failed = true;
+	}
+
+	// Массовое уничтожение случайных сущностей и создание новых на месте освободившихся ячеек
+	std::vector<Entity> destroyed = entities;
+	std::shuffle(destroyed.begin(), destroyed.end(), rng);
+	destroyed.resize(CHURN_COUNT);
+	size_t destroyedLights = 0;
+	for (const Entity entity : destroyed) destroyedLights += world.hasComponent<PointLightComponent>(entity);
+
+	start = std::chrono::high_resolution_clock::now();
+	for (const Entity entity : destroyed) world.destroyEntity(entity);
+	std::vector<Entity> created;
+	for (size_t i = 0; i < CHURN_COUNT; ++i)
+	{
+		created.push_back(i % 100 == 0 ? VgetGameObject::makePointLight(world) : VgetGameObject::createGameObject(world));
+	}
+	const double churnMs = elapsedMs(start);
+
+	for (const Entity entity : destroyed)
+	{
+		if (world.isAlive(entity) || world.getComponent<TransformComponent>(entity) != nullptr)
+		{
+			std::cerr << "Destroyed entity handle is still valid!" << std::endl;
+			failed = true;
+			break;
+		}
+	}
+	for (const Entity entity : created)
+	{
+		if (!world.isAlive(entity) || world.entityAt(entity.index) != entity || entity.generation == 0)
+		{
+			std::cerr << "Created entity did not reuse a freed slot with a new generation!" << std::endl;
+			failed = true;
+			break;
+		}
+	}
+	const size_t expectedLights = LIGHT_COUNT - destroyedLights + CHURN_COUNT / 100;
+	if (world.size() != OBJECT_COUNT || world.count<TransformComponent>() != OBJECT_COUNT
+		|| world.count<TransformComponent, PointLightComponent>() != expectedLights)
+	{
+		std::cerr << "Wrong entity count after churn!" << std::endl;
+		failed = true;
+	}
+
+	std::cout << "ECS, " << world.size() << " entities, " << expectedLights << " lights, " << FRAME_COUNT << " frames\n";
+	std::cout << "  fill map:\t\t" << legacyFillMs << " ms\n";
+	std::cout << "  fill world:\t\t" << worldFillMs << " ms\n";
+	std::cout << "  map iteration:\t" << legacyMs / FRAME_COUNT * 1e3 << " us/frame\n";
+	std::cout << "  world forEach:\t" << sequentialMs / FRAME_COUNT * 1e3 << " us/frame\n";
+	std::cout << "  world parallel:\t" << parallelMs / FRAME_COUNT * 1e3 << " us/frame (transforms only)\n";
+	std::cout << "  churn:\t\t" << churnMs << " ms (" << CHURN_COUNT << " destroyed + " << CHURN_COUNT << " created)\n";
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+// Бенчмарк конвейера кадров (VgetFramePipeline).
+// Стресс-проверки: снимки рендерятся строго по порядку и без пропусков, поток обновления никогда не пишет в снимок,
+// который в это время рендерится (при частых переключениях между однопоточным и двухпоточным режимом), а
+// исключение из потока рендера доходит до потока обновления.
+// Компромисс пропускной способности и задержки: кадры с искусственной нагрузкой обновления и рендера в обоих
+// режимах. В двухпоточном режиме время кадра стремится к большей из стадий, а задержка - к сумме стадий
+// плюс ожидание свободного снимка.
+#include "vget_frame_pipeline.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using Clock = vget::VgetFramePipeline::Clock;
+
+	constexpr uint32_t STRESS_FRAME_COUNT = 20000;
+	constexpr uint32_t MODE_SWITCH_INTERVAL = 1000;	// кадров между переключениями режима
+	constexpr uint32_t PAYLOAD_SIZE = 4096;
+	constexpr uint32_t FAILING_FRAME = 500;
+	constexpr uint32_t TIMING_FRAME_COUNT = 120;
+
+	double elapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Активное ожидание: нагрузка стадии, которая занимает ядро, а не спит
+	void spin(double ms)
+	{
+		const auto start = Clock::now();
+		while (elapsedMs(start) < ms) {}
+	}
+
+	struct Snapshot
+	{
+		uint64_t frame = 0;
+		std::vector<uint64_t> payload = std::vector<uint64_t>(PAYLOAD_SIZE);
+	};
+
+	uint32_t acquireSnapshot(vget::VgetFramePipeline& pipeline)
+	{
+		uint32_t snapshotIndex = 0;
+		while (!pipeline.acquire(snapshotIndex, std::chrono::milliseconds(1))) {}
+		return snapshotIndex;
+	}
+
+	bool stressOrdering()
+	{
+		std::array<Snapshot, vget::VgetFramePipeline::SNAPSHOT_COUNT> snapshots{};
+		std::atomic<bool> failed{ false };
+		uint64_t expectedFrame = 0;	// только поток рендера (или submit() в однопоточном режиме)
+
+		vget::VgetFramePipeline pipeline{ [&](uint32_t snapshotIndex)
+		{
+			const Snapshot& snapshot = snapshots[snapshotIndex];
+			if (snapshot.frame != expectedFrame) failed = true;
+			expectedFrame = snapshot.frame + 1;
+			// Если бы поток обновления писал в этот снимок, содержимое разошлось бы с номером кадра
+			for (int pass = 0; pass < 4; ++pass)
+			{
+				for (const uint64_t value : snapshot.payload)
+				{
+					if (value != snapshot.frame) failed = true;
+				}
+			}
+		} };
+
+		const auto start = Clock::now();
+		for (uint32_t frame = 0; frame < STRESS_FRAME_COUNT; ++frame)
+		{
+			if (frame % MODE_SWITCH_INTERVAL == 0) pipeline.setThreaded(frame / MODE_SWITCH_INTERVAL % 2 == 0);
+
+			const uint32_t snapshotIndex = acquireSnapshot(pipeline);
+			Snapshot& snapshot = snapshots[snapshotIndex];
+			snapshot.frame = frame;
+			std::fill(snapshot.payload.begin(), snapshot.payload.end(), frame);
+			pipeline.submit(snapshotIndex, Clock::now());
+		}
+		pipeline.waitIdle();
+		const double ms = elapsedMs(start);
+
+		std::cout << "  " << STRESS_FRAME_COUNT << " frames, mode switch every " << MODE_SWITCH_INTERVAL << ":\t" << ms << " ms\n";
+		if (failed || expectedFrame != STRESS_FRAME_COUNT)
+		{
+			std::cerr << "frame pipeline rendered snapshots out of order or while they were written" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stressRenderError()
+	{
+		uint32_t renderedFrames = 0;
+		vget::VgetFramePipeline pipeline{ [&](uint32_t)
+		{
+			if (++renderedFrames == FAILING_FRAME) throw std::runtime_error("render failed");
+		} };
+		pipeline.setThreaded(true);
+
+		bool caught = false;
+		uint32_t frame = 0;
+		try
+		{
+			for (; frame < FAILING_FRAME * 2; ++frame)
+			{
+				pipeline.submit(acquireSnapshot(pipeline), Clock::now());
+			}
+			pipeline.waitIdle();
+		}
+		catch (const std::runtime_error&)
+		{
+			caught = true;
+		}
+
+		// После ошибки конвейер продолжает работу в однопоточном режиме
+		const bool fellBack = !pipeline.isThreaded();
+		pipeline.submit(acquireSnapshot(pipeline), Clock::now());
+
+		std::cout << "  render error at frame " << FAILING_FRAME << ":\t\tcaught on frame " << frame << "\n";
+		if (!caught || !fellBack || renderedFrames != FAILING_FRAME + 1)
+		{
+			std::cerr << "frame pipeline did not report the render thread error" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	struct Timing
+	{
+		double frameMs;
+		double latencyMs;
+	};
+
+	Timing measure(bool threaded, double updateMs, double renderMs)
+	{
+		vget::VgetFramePipeline pipeline{ [&](uint32_t) { spin(renderMs); } };
+		pipeline.setThreaded(threaded);
+
+		const auto start = Clock::now();
+		for (uint32_t frame = 0; frame < TIMING_FRAME_COUNT; ++frame)
+		{
+			const uint32_t snapshotIndex = acquireSnapshot(pipeline);
+			const auto updateStart = Clock::now();
+			spin(updateMs);
+			pipeline.submit(snapshotIndex, updateStart);
+		}
+		pipeline.waitIdle();
+		return Timing{ elapsedMs(start) / TIMING_FRAME_COUNT, pipeline.getLatencyMs() };
+	}
+}
+
+int main()
+{
+	bool failed = false;
+
+	std::cout << "Frame pipeline stress tests\n";
+	failed |= !stressOrdering();
+	failed |= !stressRenderError();
+
+	// На одном ядре стадии не могут выполняться одновременно, и выигрыша не будет
+	std::cout << "Throughput and latency, " << TIMING_FRAME_COUNT << " frames, "
+		<< std::thread::hardware_concurrency() << " hardware threads\n";
+	const std::array<std::array<double, 2>, 3> stages{ { { 3.0, 3.0 }, { 1.5, 4.5 }, { 4.5, 1.5 } } };
+	for (const auto& stage : stages)
+	{
+		const Timing single = measure(false, stage[0], stage[1]);
+		const Timing threaded = measure(true, stage[0], stage[1]);
+		std::cout << "  update " << stage[0] << " ms, render " << stage[1] << " ms:\n";
+		std::cout << "    single thread:\t" << single.frameMs << " ms/frame, latency " << single.latencyMs << " ms\n";
+		std::cout << "    update + render:\t" << threaded.frameMs << " ms/frame, latency " << threaded.latencyMs << " ms\n";
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+// Бенчмарк пакетного отсечения по пирамиде видимости (CullingBatch) на 1М ограничивающих объёмов.
+// Сравнивает SIMD (SSE/AVX) и скалярную реализации и проверяет, что их результаты совпадают.
+#include "vget_camera.hpp"
+#include "vget_culling.hpp"
+
+// std
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr size_t BOUNDS_COUNT = 1'000'000;
+	constexpr int ITERATIONS = 20;
+
+	template <typename F>
+	double measureMs(F&& func)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < ITERATIONS; ++i) func();
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count() / ITERATIONS;
+	}
+}
+
+int main()
+{
+	using namespace vget;
+
+	// Объёмы случайно разбросаны в кубе 200x200x200 вокруг камеры, поэтому часть из них попадает в пирамиду, а часть - нет
+	std::mt19937 rng{ 42 };
+	std::uniform_real_distribution<float> position{ -100.f, 100.f };
+	std::uniform_real_distribution<float> size{ .1f, 2.f };
+
+	CullingBatch batch;
+	batch.reserve(BOUNDS_COUNT);
+	for (size_t i = 0; i < BOUNDS_COUNT; ++i)
+	{
+		const glm::vec3 center{ position(rng), position(rng), position(rng) };
+		const glm::vec3 extents{ size(rng), size(rng), size(rng) };
+		batch.add(Aabb{ center - extents, center + extents });
+	}
+
+	VgetCamera camera{};
+	camera.setViewYXZ(glm::vec3{ 0.f }, glm::vec3{ 0.f, .3f, 0.f });
+	camera.setPerspectiveProjection(glm::radians(50.f), 1280.f / 960.f, .1f, 100.f);
+	const Frustum frustum = camera.getFrustum();
+
+	std::vector<uint8_t> simdVisibility;
+	std::vector<uint8_t> scalarVisibility;
+	CullingStats simdStats{};
+	CullingStats scalarStats{};
+
+	const double simdMs = measureMs([&] { simdStats = batch.cull(frustum, simdVisibility); });
+	const double scalarMs = measureMs([&] { scalarStats = batch.cullScalar(frustum, scalarVisibility); });
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < BOUNDS_COUNT; ++i)
+	{
+		if (simdVisibility[i] != scalarVisibility[i]) ++mismatches;
+	}
+
+#if defined(__AVX__)
+	const char* simdName = "AVX";
+#elif defined(__SSE2__) || defined(_M_X64)
+	const char* simdName = "SSE";
+#else
+	const char* simdName = "scalar (no SIMD)";
+#endif
+
+	std::cout << "Frustum culling of " << BOUNDS_COUNT << " AABBs, average of " << ITERATIONS << " runs\n";
+	std::cout << "  " << simdName << ":\t" << simdMs << " ms (" << BOUNDS_COUNT / simdMs / 1000.0 << " M bounds/s)\n";
+	std::cout << "  scalar:\t" << scalarMs << " ms (" << BOUNDS_COUNT / scalarMs / 1000.0 << " M bounds/s)\n";
+	std::cout << "  speedup:\t" << scalarMs / simdMs << "x\n";
+	std::cout << "  visible: " << simdStats.visible << ", culled: " << simdStats.culled << "\n";
+
+	if (mismatches != 0 || simdStats.visible != scalarStats.visible)
+	{
+		std::cerr << "SIMD and scalar results differ in " << mismatches << " bounds!" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
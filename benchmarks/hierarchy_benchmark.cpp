@@ -0,0 +1,242 @@
+// Бенчмарк иерархии сцены (VgetSceneHierarchy).
+// Две иерархии по 100 тысяч узлов: глубокая (100 цепочек глубиной 1000) и широкая (корень, 1000 детей,
+// у каждого по 99 внуков). Каждый кадр изменяется 1% случайных узлов. Сравнивает пересчёт только изменённых
+// поддеревьев в одном и в нескольких потоках с полным пересчётом всей иерархии.
+// Проверяет, что мировые матрицы совпадают с произведением локальных матриц по цепочке родителей, что число
+// пересчитанных узлов равно размеру объединения изменённых поддеревьев, а также отвязку при уничтожении родителя
+// и запрет циклов.
+#include "vget_scene_hierarchy.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr int FRAME_COUNT = 50;
+	constexpr uint32_t DIRTY_PERCENT = 1;
+
+	double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	struct Scene
+	{
+		vget::VgetWorld world;
+		std::vector<vget::Entity> nodes;
+	};
+
+	vget::Entity createNode(Scene& scene, std::mt19937& rng, vget::Entity parent)
+	{
+		using namespace vget;
+		std::uniform_real_distribution<float> offset{ -0.01f, 0.01f };
+		const Entity entity = scene.world.createEntity(TransformComponent{});
+		TransformComponent& transform = *scene.world.getComponent<TransformComponent>(entity);
+		transform.translation = { offset(rng), 0.01f, offset(rng) };
+		transform.rotation = { offset(rng), offset(rng), offset(rng) };
+		transform.scale = glm::vec3{ 1.f };
+		if (parent.valid()) VgetSceneHierarchy::setParent(scene.world, entity, parent);
+		scene.nodes.push_back(entity);
+		return entity;
+	}
+
+	// Эталонная мировая матрица: произведение скалярно посчитанных локальных матриц от корня до узла
+	glm::mat4 referenceMatrix(vget::VgetWorld& world, vget::Entity entity)
+	{
+		using namespace vget;
+		glm::mat4 matrix = world.getComponent<TransformComponent>(entity)->mat4();
+		for (const ParentComponent* link = world.getComponent<ParentComponent>(entity);
+			link != nullptr && world.isAlive(link->parent);
+			link = world.getComponent<ParentComponent>(link->parent))
+		{
+			matrix = world.getComponent<TransformComponent>(link->parent)->mat4() * matrix;
+		}
+		return matrix;
+	}
+
+	bool matchesReference(Scene& scene, const char* name)
+	{
+		using namespace vget;
+		float maxError = 0.f;
+		for (uint32_t i = 0; i < scene.nodes.size(); i += 97)
+		{
+			const glm::mat4 expected = referenceMatrix(scene.world, scene.nodes[i]);
+			const glm::mat4& actual = scene.world.getComponent<TransformComponent>(scene.nodes[i])->worldMatrix;
+			for (int column = 0; column < 4; ++column)
+			{
+				for (int row = 0; row < 4; ++row)
+				{
+					maxError = std::max(maxError, std::abs(expected[column][row] - actual[column][row]));
+				}
+			}
+		}
+		if (maxError > 1e-3f)
+		{
+			std::cerr << name << ": world matrices differ from the reference by " << maxError << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// Число узлов в объединении поддеревьев изменённых узлов
+	uint32_t expectedUpdates(const vget::VgetSceneHierarchy& hierarchy, const std::vector<uint8_t>& dirtyNodes)
+	{
+		const auto& parents = hierarchy.getParents();
+		std::vector<uint8_t> changed(parents.size());
+		uint32_t count = 0;
+		for (size_t i = 0; i < parents.size(); ++i)
+		{
+			changed[i] = dirtyNodes[i] || (parents[i] >= 0 && changed[parents[i]]);
+			count += changed[i];
+		}
+		return count;
+	}
+
+	bool runScenario(Scene& scene, const char* name)
+	{
+		using namespace vget;
+		bool failed = false;
+		VgetJobSystem jobSystem;
+		VgetTransformBatch batch;
+		double buildMs = 0.0, fullMs = 0.0;
+		double partialMs[2] = {};
+		uint32_t nodeCount = 0;
+		std::mt19937 rng{ 7 };
+		std::uniform_int_distribution<size_t> pick{ 0, scene.nodes.size() - 1 };
+
+		// Иерархия снимает отметки об изменении, поэтому варианты идут по очереди, и каждый начинает с полного построения
+		for (int variant = 0; variant < 2; ++variant)
+		{
+			VgetSceneHierarchy hierarchy{ variant == 0 ? nullptr : &jobSystem };
+
+			// Первый проход строит порядок обхода и считает все матрицы
+			auto start = std::chrono::high_resolution_clock::now();
+			hierarchy.update(scene.world, batch);
+			if (variant == 0) buildMs = elapsedMs(start);
+			nodeCount = hierarchy.getNodeCount();
+
+			// Полный пересчёт: изменены все узлы
+			for (int frame = 0; variant == 0 && frame < FRAME_COUNT; ++frame)
+			{
+				for (const Entity node : scene.nodes) scene.world.markChanged<TransformComponent>(node);
+				start = std::chrono::high_resolution_clock::now();
+				hierarchy.update(scene.world, batch);
+				fullMs += elapsedMs(start);
+			}
+
+			// Изменение 1% узлов за кадр. Позиции узлов в порядке обхода нужны только для проверки счётчика.
+			const auto& order = hierarchy.getEntities();
+			std::vector<uint32_t> positionByIndex(scene.nodes.size(), ~0u);
+			for (uint32_t i = 0; i < order.size(); ++i) positionByIndex[order[i].index] = i;
+
+			for (int frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				std::vector<uint8_t> dirtyNodes(nodeCount, 0);
+				for (size_t i = 0; i < scene.nodes.size() * DIRTY_PERCENT / 100; ++i)
+				{
+					const Entity node = scene.nodes[pick(rng)];
+					scene.world.getComponent<TransformComponent>(node)->rotation.y += 0.001f;
+					scene.world.markChanged<TransformComponent>(node);
+					dirtyNodes[positionByIndex[node.index]] = 1;
+				}
+
+				start = std::chrono::high_resolution_clock::now();
+				hierarchy.update(scene.world, batch);
+				partialMs[variant] += elapsedMs(start);
+
+				if (hierarchy.getUpdatedCount() != expectedUpdates(hierarchy, dirtyNodes))
+				{
+					std::cerr << name << ": updated " << hierarchy.getUpdatedCount() << " nodes instead of "
+						<< expectedUpdates(hierarchy, dirtyNodes) << std::endl;
+					failed = true;
+				}
+			}
+			failed |= !matchesReference(scene, name);
+		}
+
+		std::cout << name << ", " << nodeCount << " nodes, " << DIRTY_PERCENT << "% dirty per frame\n";
+		std::cout << "  build:\t\t\t" << buildMs << " ms\n";
+		std::cout << "  full update:\t\t" << fullMs / FRAME_COUNT << " ms/frame\n";
+		std::cout << "  dirty subtrees, 1 thread:\t" << partialMs[0] / FRAME_COUNT << " ms/frame\n";
+		std::cout << "  dirty subtrees, parallel:\t" << partialMs[1] / FRAME_COUNT << " ms/frame\n";
+		return !failed;
+	}
+}
+
+int main()
+{
+	using namespace vget;
+	bool failed = false;
+	std::mt19937 rng{ 42 };
+
+	{
+		Scene deep;
+		for (int chain = 0; chain < 100; ++chain)
+		{
+			Entity parent{};
+			for (int depth = 0; depth < 1000; ++depth) parent = createNode(deep, rng, parent);
+		}
+		failed |= !runScenario(deep, "Deep hierarchy");
+	}
+
+	{
+		Scene wide;
+		const Entity root = createNode(wide, rng, Entity{});
+		for (int child = 0; child < 1000; ++child)
+		{
+			const Entity parent = createNode(wide, rng, root);
+			for (int grandChild = 0; grandChild < 99; ++grandChild) createNode(wide, rng, parent);
+		}
+		failed |= !runScenario(wide, "Wide hierarchy");
+	}
+
+	// Структурные изменения: цикл запрещён, а дети уничтоженного родителя становятся корнями
+	{
+		Scene scene;
+		const Entity a = createNode(scene, rng, Entity{});
+		const Entity b = createNode(scene, rng, a);
+		const Entity c = createNode(scene, rng, b);
+		bool threw = false;
+		try
+		{
+			VgetSceneHierarchy::setParent(scene.world, a, c);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		if (!threw)
+		{
+			std::cerr << "Hierarchy cycle was not rejected!" << std::endl;
+			failed = true;
+		}
+
+		VgetTransformBatch batch;
+		VgetSceneHierarchy hierarchy;
+		hierarchy.update(scene.world, batch);
+		scene.world.destroyEntity(b);
+		hierarchy.update(scene.world, batch);
+		TransformComponent& orphan = *scene.world.getComponent<TransformComponent>(c);
+		const glm::mat4 local = orphan.mat4();
+		float error = 0.f;
+		for (int column = 0; column < 4; ++column)
+		{
+			for (int row = 0; row < 4; ++row) error = std::max(error, std::abs(orphan.worldMatrix[column][row] - local[column][row]));
+		}
+		if (hierarchy.getNodeCount() != 1 || hierarchy.getParents()[0] != -1 || error > 1e-5f)
+		{
+			std::cerr << "Orphaned node was not turned into a root!" << std::endl;
+			failed = true;
+		}
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
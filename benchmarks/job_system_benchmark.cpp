@@ -0,0 +1,357 @@
+// Бенчмарк планировщика задач (VgetJobSystem, VgetTaskGraph).
+// Стресс-проверки под нагрузкой: сотни тысяч мелких задач, рекурсивное порождение задач из задач (кражи между
+// потоками), задачи из посторонних потоков, вложенные parallelFor и случайные графы зависимостей. Каждая
+// задача должна выполниться ровно один раз, а задача графа - только после всех своих зависимостей.
+// Масштабирование: время parallelFor над вычислительной нагрузкой при разном числе рабочих потоков и стоимость
+// мелких parallelFor по сравнению с запуском потоков на каждый вызов (как было в движке раньше).
+#include "vget_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t FLAT_JOB_COUNT = 200000;
+	constexpr uint32_t SPAWN_DEPTH = 16;			// 2^16 листьев рекурсивного порождения
+	constexpr uint32_t EXTERNAL_THREAD_COUNT = 4;
+	constexpr uint32_t EXTERNAL_JOB_COUNT = 20000;	// задач на каждый посторонний поток
+	constexpr uint32_t RANGE_SIZE = 1 << 20;
+	constexpr uint32_t GRAPH_TASK_COUNT = 200;
+	constexpr int GRAPH_RUN_COUNT = 50;
+	constexpr uint32_t WORKLOAD_SIZE = 1 << 22;
+	constexpr int SMALL_LOOP_COUNT = 1000;
+	constexpr uint32_t SMALL_LOOP_SIZE = 16384;
+
+	double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	struct SpawnState
+	{
+		vget::VgetJobSystem* jobSystem;
+		vget::VgetJobCounter counter;
+		std::atomic<uint32_t> leafCount{ 0 };
+	};
+
+	// Задача глубины depth порождает две задачи глубины depth - 1, листья считаются
+	void spawnTree(void* data, uint32_t depth, uint32_t)
+	{
+		auto& state = *static_cast<SpawnState*>(data);
+		if (depth == 0)
+		{
+			state.leafCount.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		state.jobSystem->run(&spawnTree, data, depth - 1, 0, state.counter);
+		state.jobSystem->run(&spawnTree, data, depth - 1, 0, state.counter);
+	}
+
+	float workload(uint32_t i)
+	{
+		const float x = static_cast<float>(i) * 1e-4f;
+		return std::sqrt(x) * std::sin(x) + std::cos(x * .5f);
+	}
+
+	bool stressFlatJobs(vget::VgetJobSystem& jobSystem)
+	{
+		std::atomic<uint64_t> sum{ 0 };
+		vget::VgetJobCounter counter;
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < FLAT_JOB_COUNT; ++i)
+		{
+			jobSystem.run([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); }, counter);
+		}
+		jobSystem.wait(counter);
+		const double ms = elapsedMs(start);
+
+		const uint64_t expected = static_cast<uint64_t>(FLAT_JOB_COUNT) * (FLAT_JOB_COUNT - 1) / 2;
+		std::cout << "  " << FLAT_JOB_COUNT << " flat jobs:\t\t" << ms << " ms (" << ms * 1e6 / FLAT_JOB_COUNT << " ns/job)\n";
+		if (sum != expected)
+		{
+			std::cerr << "Flat jobs: sum " << sum << " instead of " << expected << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stressSpawnTree(vget::VgetJobSystem& jobSystem)
+	{
+		SpawnState state{ &jobSystem };
+		const auto start = std::chrono::high_resolution_clock::now();
+		jobSystem.run(&spawnTree, &state, SPAWN_DEPTH, 0, state.counter);
+		jobSystem.wait(state.counter);
+		const double ms = elapsedMs(start);
+
+		const uint32_t expected = 1u << SPAWN_DEPTH;
+		std::cout << "  recursive spawn, " << 2 * expected - 1 << " jobs:\t" << ms << " ms\n";
+		if (state.leafCount != expected)
+		{
+			std::cerr << "Recursive spawn: " << state.leafCount << " leaves instead of " << expected << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stressExternalThreads(vget::VgetJobSystem& jobSystem)
+	{
+		// Посторонние потоки кладут задачи в общую очередь и ждут их, помогая выполнять чужие
+		std::atomic<uint32_t> failures{ 0 };
+		std::vector<std::thread> producers;
+		for (uint32_t producer = 0; producer < EXTERNAL_THREAD_COUNT; ++producer)
+		{
+			producers.emplace_back([&jobSystem, &failures, producer]()
+			{
+				std::vector<uint8_t> visited(EXTERNAL_JOB_COUNT, 0);
+				vget::VgetJobCounter counter;
+				for (uint32_t i = 0; i < EXTERNAL_JOB_COUNT; ++i)
+				{
+					jobSystem.run([&visited, i]() { ++visited[i]; }, counter);
+				}
+				jobSystem.wait(counter);
+				if (jobSystem.currentWorkerIndex() != ~0u) ++failures;
+				for (const uint8_t count : visited) failures += count != 1;
+			});
+		}
+		for (auto& producer : producers) producer.join();
+
+		if (failures != 0)
+		{
+			std::cerr << "External threads: " << failures << " jobs were lost or executed twice" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool stressParallelFor(vget::VgetJobSystem& jobSystem)
+	{
+		bool failed = false;
+		std::atomic<bool> oversizedRange{ false };
+		std::vector<std::atomic<uint8_t>> visited(RANGE_SIZE);
+		for (const uint32_t grainSize : { 1u, 7u, 1000u, RANGE_SIZE })
+		{
+			for (auto& count : visited) count.store(0, std::memory_order_relaxed);
+			jobSystem.parallelFor(0, RANGE_SIZE, grainSize, [&](uint32_t begin, uint32_t end)
+			{
+				if (end - begin > grainSize) oversizedRange = true;
+				for (uint32_t i = begin; i < end; ++i) visited[i].fetch_add(1, std::memory_order_relaxed);
+			});
+			for (uint32_t i = 0; i < RANGE_SIZE; ++i)
+			{
+				if (visited[i].load(std::memory_order_relaxed) == 1) continue;
+				std::cerr << "parallelFor (grain " << grainSize << "): index " << i << " visited "
+					<< +visited[i].load() << " times" << std::endl;
+				failed = true;
+				break;
+			}
+		}
+
+		if (oversizedRange)
+		{
+			std::cerr << "parallelFor passed a range larger than the grain size!" << std::endl;
+			failed = true;
+		}
+
+		// Вложенный parallelFor: внутренний цикл ждёт своих задач внутри задачи внешнего
+		constexpr uint32_t OUTER = 64, INNER = 4096;
+		std::vector<uint32_t> rowSums(OUTER, 0);
+		jobSystem.parallelFor(0, OUTER, 1, [&](uint32_t outerBegin, uint32_t outerEnd)
+		{
+			for (uint32_t row = outerBegin; row < outerEnd; ++row)
+			{
+				std::atomic<uint32_t> rowSum{ 0 };
+				jobSystem.parallelFor(0, INNER, 256, [&](uint32_t begin, uint32_t end)
+				{
+					rowSum.fetch_add(end - begin, std::memory_order_relaxed);
+				});
+				rowSums[row] = rowSum;
+			}
+		});
+		if (std::any_of(rowSums.begin(), rowSums.end(), [](uint32_t sum) { return sum != INNER; }))
+		{
+			std::cerr << "Nested parallelFor lost iterations!" << std::endl;
+			failed = true;
+		}
+		return !failed;
+	}
+
+	bool stressTaskGraphs(vget::VgetJobSystem& jobSystem)
+	{
+		bool failed = false;
+		std::mt19937 rng{ 42 };
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (int graphIndex = 0; graphIndex < 10; ++graphIndex)
+		{
+			// Случайный ациклический граф: рёбра идут только от меньшего номера к большему
+			vget::VgetTaskGraph graph;
+			std::atomic<uint32_t> clock{ 0 };
+			std::vector<uint32_t> startTimes(GRAPH_TASK_COUNT), finishTimes(GRAPH_TASK_COUNT);
+			std::vector<std::atomic<uint32_t>> runCounts(GRAPH_TASK_COUNT);
+			for (uint32_t task = 0; task < GRAPH_TASK_COUNT; ++task)
+			{
+				graph.addTask([&, task]()
+				{
+					startTimes[task] = clock++;
+					runCounts[task].fetch_add(1, std::memory_order_relaxed);
+					finishTimes[task] = clock++;
+				});
+			}
+			std::vector<std::pair<uint32_t, uint32_t>> edges;
+			std::uniform_int_distribution<uint32_t> pick{ 0, GRAPH_TASK_COUNT - 1 };
+			for (uint32_t edge = 0; edge < GRAPH_TASK_COUNT * 2; ++edge)
+			{
+				uint32_t a = pick(rng), b = pick(rng);
+				if (a == b) continue;
+				if (a > b) std::swap(a, b);
+				graph.addDependency(a, b);
+				edges.emplace_back(a, b);
+			}
+
+			for (int run = 0; run < GRAPH_RUN_COUNT; ++run)
+			{
+				graph.run(jobSystem);
+				for (const auto& edge : edges)
+				{
+					if (finishTimes[edge.first] > startTimes[edge.second])
+					{
+						std::cerr << "Task graph: task " << edge.second << " started before its dependency "
+							<< edge.first << " finished" << std::endl;
+						failed = true;
+						break;
+					}
+				}
+			}
+			for (uint32_t task = 0; task < GRAPH_TASK_COUNT; ++task)
+			{
+				if (runCounts[task] == static_cast<uint32_t>(GRAPH_RUN_COUNT)) continue;
+				std::cerr << "Task graph: task " << task << " ran " << runCounts[task] << " times" << std::endl;
+				failed = true;
+				break;
+			}
+			if (failed) break;
+		}
+		std::cout << "  10 random graphs x " << GRAPH_RUN_COUNT << " runs, " << GRAPH_TASK_COUNT << " tasks:\t" << elapsedMs(start) << " ms\n";
+
+		// Цикл в зависимостях обнаруживается до запуска
+		vget::VgetTaskGraph cyclic;
+		const auto a = cyclic.addTask({});
+		const auto b = cyclic.addTask({});
+		cyclic.addDependency(a, b);
+		cyclic.addDependency(b, a);
+		bool threw = false;
+		try
+		{
+			cyclic.run(jobSystem);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		if (!threw)
+		{
+			std::cerr << "Task graph cycle was not rejected!" << std::endl;
+			failed = true;
+		}
+		return !failed;
+	}
+
+	// Вычислительная нагрузка для проверки масштабирования; результат сверяется с последовательным
+	double runWorkload(vget::VgetJobSystem& jobSystem, std::vector<float>& output)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		jobSystem.parallelFor(0, WORKLOAD_SIZE, 4096, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++i) output[i] = workload(i);
+		});
+		return elapsedMs(start);
+	}
+
+	// Прежняя схема движка: потоки запускаются на каждый вызов и делят диапазон поровну
+	void threadPerCallFor(uint32_t threadCount, uint32_t count, std::vector<float>& output)
+	{
+		const uint32_t chunkSize = (count + threadCount - 1) / threadCount;
+		const auto func = [&](uint32_t begin, uint32_t end) { for (uint32_t i = begin; i < end; ++i) output[i] = workload(i); };
+		std::vector<std::thread> workers;
+		for (uint32_t chunk = 1; chunk < threadCount; ++chunk)
+		{
+			workers.emplace_back(func, std::min(count, chunk * chunkSize), std::min(count, (chunk + 1) * chunkSize));
+		}
+		func(0, std::min(count, chunkSize));
+		for (auto& worker : workers) worker.join();
+	}
+}
+
+int main()
+{
+	using namespace vget;
+	bool failed = false;
+	const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	{
+		// Потоков не меньше четырёх даже на машинах с малым числом ядер, чтобы очереди действительно соревновались
+		VgetJobSystem jobSystem{ std::max(4u, hardwareThreads) };
+		std::cout << "Job system stress tests, " << jobSystem.getWorkerCount() << " workers\n";
+		failed |= !stressFlatJobs(jobSystem);
+		failed |= !stressSpawnTree(jobSystem);
+		failed |= !stressExternalThreads(jobSystem);
+		failed |= !stressParallelFor(jobSystem);
+		failed |= !stressTaskGraphs(jobSystem);
+	}
+
+	std::vector<float> expected(WORKLOAD_SIZE), output(WORKLOAD_SIZE);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < WORKLOAD_SIZE; ++i) expected[i] = workload(i);
+	const double serialMs = elapsedMs(start);
+
+	std::cout << "parallelFor scalability, " << WORKLOAD_SIZE << " elements\n";
+	std::cout << "  serial loop:\t\t" << serialMs << " ms\n";
+	std::vector<uint32_t> workerCounts;
+	for (uint32_t count = 1; count < hardwareThreads; count *= 2) workerCounts.push_back(count);
+	workerCounts.push_back(hardwareThreads);
+	for (const uint32_t workerCount : workerCounts)
+	{
+		VgetJobSystem jobSystem{ workerCount, true };
+		runWorkload(jobSystem, output); // прогрев: потоки просыпаются, страницы вывода уже выделены
+		double ms = 0.0;
+		for (int run = 0; run < 5; ++run) ms += runWorkload(jobSystem, output);
+		ms /= 5;
+		std::cout << "  " << workerCount << " workers" << (jobSystem.isPinned() ? " (pinned)" : "") << ":\t"
+			<< ms << " ms (x" << serialMs / ms << ")\n";
+		if (output != expected)
+		{
+			std::cerr << workerCount << " workers: parallelFor result differs from the serial loop" << std::endl;
+			failed = true;
+		}
+	}
+
+	// Мелкие циклы каждый кадр: постоянные потоки против запуска потоков на вызов
+	{
+		VgetJobSystem jobSystem{ hardwareThreads };
+		start = std::chrono::high_resolution_clock::now();
+		for (int loop = 0; loop < SMALL_LOOP_COUNT; ++loop) threadPerCallFor(hardwareThreads, SMALL_LOOP_SIZE, output);
+		const double threadMs = elapsedMs(start);
+		start = std::chrono::high_resolution_clock::now();
+		for (int loop = 0; loop < SMALL_LOOP_COUNT; ++loop)
+		{
+			jobSystem.parallelFor(0, SMALL_LOOP_SIZE, 1024, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i) output[i] = workload(i);
+			});
+		}
+		const double jobMs = elapsedMs(start);
+		std::cout << SMALL_LOOP_COUNT << " small loops of " << SMALL_LOOP_SIZE << " elements, " << hardwareThreads << " threads\n";
+		std::cout << "  thread per call:\t" << threadMs / SMALL_LOOP_COUNT * 1000.0 << " us/loop\n";
+		std::cout << "  job system:\t\t" << jobMs / SMALL_LOOP_COUNT * 1000.0 << " us/loop\n";
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
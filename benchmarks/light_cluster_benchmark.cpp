@@ -0,0 +1,131 @@
+// Бенчмарк раскладки точечных источников света по кластерам (VgetLightClusters).
+// Сцена: тысячи источников света со случайными радиусами влияния, разбросанные вокруг вращающейся камеры.
+// Проверяет, что в списке каждого кластера нет источников, не пересекающих его объём (по полному перебору), и что
+// в точке внутри пирамиды видимости шейдер найдёт в её кластере все источники, сфера влияния которых её содержит.
+#include "vget_light_clusters.hpp"
+#include "vget_camera.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr size_t LIGHT_COUNT = 4'096;
+	constexpr int FRAME_COUNT = 120;
+	constexpr int VALIDATED_FRAME_STEP = 20;	// полный перебор - на каждом VALIDATED_FRAME_STEP кадре
+	constexpr size_t SAMPLE_POINT_COUNT = 20'000;
+
+	bool intersects(const vget::Aabb& box, const glm::vec3& center, float radius)
+	{
+		const glm::vec3 offset = glm::clamp(center, box.min, box.max) - center;
+		return glm::dot(offset, offset) <= radius * radius;
+	}
+}
+
+int main()
+{
+	using namespace vget;
+
+	std::mt19937 rng{ 42 };
+	std::uniform_real_distribution<float> spread{ -60.f, 60.f };
+	std::uniform_real_distribution<float> height{ -4.f, 4.f };
+	std::uniform_real_distribution<float> radius{ .5f, 4.f };
+	std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+
+	std::vector<PointLight> lights(LIGHT_COUNT);
+	for (auto& light : lights)
+	{
+		light.position = glm::vec4{ spread(rng), height(rng), spread(rng), radius(rng) };
+		light.color = glm::vec4{ 1.f, 1.f, 1.f, 1.f };
+	}
+
+	VgetCamera camera{};
+	camera.setPerspectiveProjection(glm::radians(50.f), 1280.f / 960.f, .1f, 100.f);
+
+	VgetLightClusters clusters{};
+	bool failed = false;
+	double buildMs = 0.0;
+	uint64_t assignedTotal = 0;
+	uint32_t maxClusterLights = 0;
+
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		camera.setViewYXZ(glm::vec3{ 0.f, 0.f, 0.f }, glm::vec3{ .1f * std::sin(frame * .05f), frame * .05f, 0.f });
+		const glm::mat4 view = camera.getView();
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		clusters.build(view, camera.getProjection(), lights);
+		buildMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		const auto& ranges = clusters.getClusterRanges();
+		const auto& indices = clusters.getLightIndices();
+		assignedTotal += indices.size();
+		for (const auto& range : ranges) maxClusterLights = std::max(maxClusterLights, range.y);
+
+		if (frame % VALIDATED_FRAME_STEP != 0) continue;
+
+		std::vector<glm::vec3> viewCenters(lights.size());
+		for (size_t i = 0; i < lights.size(); ++i)
+		{
+			viewCenters[i] = glm::vec3(view * glm::vec4(glm::vec3(lights[i].position), 1.f));
+		}
+
+		// Списки кластеров против полного перебора источников. Объём кластера (AABB) шире его ячейки пирамиды,
+		// а раскладка отбирает источники по проекции на экран, поэтому список может быть только подмножеством.
+		std::vector<uint32_t> expected;
+		for (uint32_t cluster = 0; cluster < VgetLightClusters::CLUSTER_COUNT; ++cluster)
+		{
+			expected.clear();
+			for (uint32_t i = 0; i < lights.size(); ++i)
+			{
+				if (intersects(clusters.getClusterBounds(cluster), viewCenters[i], lights[i].position.w)) expected.push_back(i);
+			}
+			const auto& range = ranges[cluster];
+			if (!std::includes(expected.begin(), expected.end(), indices.begin() + range.x, indices.begin() + range.x + range.y))
+			{
+				std::cerr << "Frame " << frame << ": cluster " << cluster << " lists a light that does not touch it!" << std::endl;
+				failed = true;
+				break;
+			}
+		}
+
+		// Случайные точки в пирамиде видимости: каждый источник, освещающий точку, должен быть в её кластере
+		const glm::mat4 projection = camera.getProjection();
+		const glm::vec4 depthParams = clusters.getDepthSliceParams();
+		for (size_t sample = 0; sample < SAMPLE_POINT_COUNT && !failed; ++sample)
+		{
+			const float depth = depthParams.z * std::pow(depthParams.w / depthParams.z, unit(rng));
+			const glm::vec3 point{
+				(unit(rng) * 2.f - 1.f) * depth / projection[0][0],
+				(unit(rng) * 2.f - 1.f) * depth / projection[1][1],
+				depth };
+			const auto& range = ranges[clusters.findCluster(point)];
+			for (uint32_t i = 0; i < lights.size(); ++i)
+			{
+				const glm::vec3 offset = viewCenters[i] - point;
+				if (glm::dot(offset, offset) > lights[i].position.w * lights[i].position.w) continue;
+				if (std::find(indices.begin() + range.x, indices.begin() + range.x + range.y, i) == indices.begin() + range.x + range.y)
+				{
+					std::cerr << "Frame " << frame << ": light " << i << " is missing from the cluster of a lit point!" << std::endl;
+					failed = true;
+					break;
+				}
+			}
+		}
+	}
+
+	std::cout << "Clustered lighting, " << VgetLightClusters::GRID_X << "x" << VgetLightClusters::GRID_Y << "x"
+		<< VgetLightClusters::GRID_Z << " clusters, " << LIGHT_COUNT << " lights, " << FRAME_COUNT << " frames\n";
+	std::cout << "  build:\t\t" << buildMs / FRAME_COUNT << " ms/frame\n";
+	std::cout << "  light indices:\t" << assignedTotal / FRAME_COUNT << " avg ("
+		<< static_cast<double>(assignedTotal) / FRAME_COUNT / VgetLightClusters::CLUSTER_COUNT << " lights/cluster, max "
+		<< maxClusterLights << ")\n";
+	std::cout << "  brute force:\t\t" << LIGHT_COUNT << " lights/fragment\n";
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+// Бенчмарк программного отсечения перекрытых объектов (VgetOcclusionCuller).
+// Сцена: большая стена и множество коробок-окклюдеров, за которыми расставлены проверяемые объекты.
+// Проверяет, что результат не зависит от количества потоков, и что явно перекрытый/видимый объекты классифицируются верно.
+#include "vget_occlusion.hpp"
+#include "vget_camera.hpp"
+
+// std
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr size_t OCCLUDER_BOX_COUNT = 2'000;
+	constexpr size_t OCCLUDEE_COUNT = 20'000;
+	constexpr int FRAME_COUNT = 60;
+
+	// Коробка из 12 треугольников
+	void appendBox(vget::OccluderMesh& mesh, const glm::vec3& min, const glm::vec3& max)
+	{
+		const uint32_t base = static_cast<uint32_t>(mesh.positions.size());
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			mesh.positions.push_back({ corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z });
+		}
+		const uint32_t faces[6][4] = { {0, 1, 3, 2}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 3, 7, 5} };
+		for (const auto& face : faces)
+		{
+			mesh.indices.insert(mesh.indices.end(), { base + face[0], base + face[1], base + face[2] });
+			mesh.indices.insert(mesh.indices.end(), { base + face[0], base + face[2], base + face[3] });
+		}
+	}
+
+	struct FrameResult
+	{
+		std::vector<float> depth;
+		std::vector<uint8_t> occluded;
+		uint32_t occludedCount = 0;
+	};
+
+	FrameResult runFrame(vget::VgetOcclusionCuller& culler, const vget::VgetCamera& camera,
+		const std::vector<vget::OccluderMesh>& occluders, const std::vector<vget::Aabb>& occludees)
+	{
+		culler.beginFrame(camera.getProjection() * camera.getView());
+		for (const auto& mesh : occluders) culler.addOccluder(mesh, glm::mat4{ 1.f });
+		culler.rasterize();
+
+		FrameResult result{};
+		result.depth = culler.getDepthBuffer();
+		result.occluded.resize(occludees.size());
+		for (size_t i = 0; i < occludees.size(); ++i)
+		{
+			result.occluded[i] = culler.isOccluded(occludees[i]);
+			result.occludedCount += result.occluded[i];
+		}
+		return result;
+	}
+}
+
+int main()
+{
+	using namespace vget;
+
+	std::mt19937 rng{ 42 };
+	std::uniform_real_distribution<float> spread{ -40.f, 40.f };
+	std::uniform_real_distribution<float> depth{ 12.f, 80.f };
+	std::uniform_real_distribution<float> occluderSize{ .3f, 2.f };
+	std::uniform_real_distribution<float> occludeeSize{ .1f, .8f };
+
+	// Окклюдеры: стена перед камерой и отдельный меш с множеством коробок позади неё
+	std::vector<OccluderMesh> occluders(2);
+	appendBox(occluders[0], glm::vec3{ -6.f, -6.f, 10.f }, glm::vec3{ 6.f, 6.f, 10.5f });
+	for (size_t i = 0; i < OCCLUDER_BOX_COUNT; ++i)
+	{
+		const glm::vec3 center{ spread(rng), spread(rng) * .25f, depth(rng) };
+		const glm::vec3 half{ occluderSize(rng), occluderSize(rng), occluderSize(rng) };
+		appendBox(occluders[1], center - half, center + half);
+	}
+
+	std::vector<Aabb> occludees;
+	occludees.reserve(OCCLUDEE_COUNT + 2);
+	// Контрольные объекты: прямо за стеной (должен быть перекрыт) и перед ней (должен быть виден)
+	occludees.push_back(Aabb{ glm::vec3{ -.5f, -.5f, 20.f }, glm::vec3{ .5f, .5f, 21.f } });
+	occludees.push_back(Aabb{ glm::vec3{ -.5f, -.5f, 5.f }, glm::vec3{ .5f, .5f, 6.f } });
+	for (size_t i = 0; i < OCCLUDEE_COUNT; ++i)
+	{
+		const glm::vec3 center{ spread(rng), spread(rng) * .25f, depth(rng) };
+		const glm::vec3 half{ occludeeSize(rng), occludeeSize(rng), occludeeSize(rng) };
+		occludees.push_back(Aabb{ center - half, center + half });
+	}
+
+	VgetCamera camera{};
+	camera.setPerspectiveProjection(glm::radians(50.f), 1280.f / 960.f, .1f, 100.f);
+
+	VgetJobSystem jobSystem{ std::max(2u, std::thread::hardware_concurrency()) };
+	VgetOcclusionCuller singleThreaded{};
+	VgetOcclusionCuller multiThreaded{ &jobSystem };
+
+	bool failed = false;
+	double singleMs = 0.0, multiMs = 0.0, testMs = 0.0;
+	uint64_t occludedTotal = 0;
+
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		// Камера покачивается из стороны в сторону, оставаясь перед стеной
+		const float yaw = .3f * std::sin(frame * .1f);
+		camera.setViewYXZ(glm::vec3{ 0.f }, glm::vec3{ 0.f, yaw, 0.f });
+
+		const FrameResult single = runFrame(singleThreaded, camera, occluders, occludees);
+		singleMs += singleThreaded.getRasterTimeMs();
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		const FrameResult multi = runFrame(multiThreaded, camera, occluders, occludees);
+		testMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		multiMs += multiThreaded.getRasterTimeMs();
+		occludedTotal += multi.occludedCount;
+
+		if (single.depth != multi.depth || single.occluded != multi.occluded)
+		{
+			std::cerr << "Frame " << frame << ": result depends on thread count!" << std::endl;
+			failed = true;
+		}
+		if (!multi.occluded[0] || multi.occluded[1])
+		{
+			std::cerr << "Frame " << frame << ": control objects are classified incorrectly!" << std::endl;
+			failed = true;
+		}
+	}
+	testMs -= multiMs;
+
+	std::cout << "Software occlusion culling, " << VgetOcclusionCuller::WIDTH << "x" << VgetOcclusionCuller::HEIGHT
+		<< " depth buffer, " << multiThreaded.getOccluderTriangleCount() << " occluder triangles, "
+		<< occludees.size() << " occludees, " << FRAME_COUNT << " frames\n";
+	std::cout << "  raster (1 thread):\t" << singleMs / FRAME_COUNT << " ms/frame\n";
+	std::cout << "  raster (" << multiThreaded.getThreadCount() << " threads):\t" << multiMs / FRAME_COUNT << " ms/frame\n";
+	std::cout << "  occlusion tests:\t" << testMs / FRAME_COUNT << " ms/frame ("
+		<< testMs / FRAME_COUNT / occludees.size() * 1e6 << " ns/test)\n";
+	std::cout << "  occluded:\t\t" << occludedTotal / FRAME_COUNT << " of " << occludees.size() << " avg\n";
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,220 @@
+// Бенчмарк запекания и использования потенциально видимых множеств (VgetPvs).
+// Сцена: анфилада комнат, соединённых дверными проёмами, которые попеременно смещены к разным стенам,
+// поэтому из комнаты видны только соседние. В каждой комнате расставлена мебель (подобъекты одного объекта).
+// Проверяет, что результат запекания не зависит от количества потоков, что файл читается без потерь,
+// и что мебель своей комнаты видима, а мебель дальней комнаты - нет.
+#include "vget_pvs.hpp"
+
+// std
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr int ROOM_COUNT = 6;
+	constexpr float ROOM_SIZE = 8.f;	// комната - квадрат ROOM_SIZE x ROOM_SIZE, x от i * ROOM_SIZE, z от -ROOM_SIZE / 2
+	constexpr float ROOM_HEIGHT = 3.f;
+	constexpr float WALL_THICKNESS = .2f;
+	constexpr float DOOR_HALF_WIDTH = .6f;
+	constexpr float DOOR_HEIGHT = 2.2f;
+	constexpr int FURNITURE_PER_ROOM = 8;
+	constexpr float PATH_STEP = .05f;
+
+	// Смещение дверного проёма в стене между комнатами i - 1 и i
+	float doorOffset(int room) { return room % 2 ? 2.5f : -2.5f; }
+
+	// Коробка из 12 треугольников
+	void appendBox(vget::VgetPvsBaker::Object& object, const glm::vec3& min, const glm::vec3& max)
+	{
+		const uint32_t base = static_cast<uint32_t>(object.positions.size());
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			object.positions.push_back({ corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z });
+		}
+		const uint32_t faces[6][4] = { {0, 1, 3, 2}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 3, 7, 5} };
+		for (const auto& face : faces)
+		{
+			object.indices.insert(object.indices.end(), { base + face[0], base + face[1], base + face[2] });
+			object.indices.insert(object.indices.end(), { base + face[0], base + face[2], base + face[3] });
+		}
+	}
+
+	// Поперечная стена в плоскости x = wallX; при hasDoor в ней вырезан проём шириной 2 * DOOR_HALF_WIDTH
+	void appendCrossWall(vget::VgetPvsBaker::Object& object, float wallX, bool hasDoor, float doorZ)
+	{
+		const float half = ROOM_SIZE * .5f;
+		const float x0 = wallX - WALL_THICKNESS * .5f, x1 = wallX + WALL_THICKNESS * .5f;
+		if (!hasDoor)
+		{
+			appendBox(object, { x0, 0.f, -half }, { x1, ROOM_HEIGHT, half });
+			return;
+		}
+		appendBox(object, { x0, 0.f, -half }, { x1, ROOM_HEIGHT, doorZ - DOOR_HALF_WIDTH });
+		appendBox(object, { x0, 0.f, doorZ + DOOR_HALF_WIDTH }, { x1, ROOM_HEIGHT, half });
+		appendBox(object, { x0, DOOR_HEIGHT, doorZ - DOOR_HALF_WIDTH }, { x1, ROOM_HEIGHT, doorZ + DOOR_HALF_WIDTH });
+	}
+
+	vget::VgetPvsBaker createScene()
+	{
+		vget::VgetPvsBaker baker{};
+		std::mt19937 rng{ 42 };
+		std::uniform_real_distribution<float> position{ -ROOM_SIZE * .5f + 1.f, ROOM_SIZE * .5f - 1.f };
+		std::uniform_real_distribution<float> size{ .2f, .6f };
+
+		const float half = ROOM_SIZE * .5f;
+		for (int room = 0; room < ROOM_COUNT; ++room)
+		{
+			const float roomX = room * ROOM_SIZE;
+
+			// Стены комнаты: пол, боковые стены и стена с проёмом в предыдущую комнату
+			vget::VgetPvsBaker::Object walls{};
+			walls.name = "Room" + std::to_string(room);
+			appendBox(walls, { roomX, -WALL_THICKNESS, -half }, { roomX + ROOM_SIZE, 0.f, half });
+			appendBox(walls, { roomX, 0.f, -half - WALL_THICKNESS }, { roomX + ROOM_SIZE, ROOM_HEIGHT, -half });
+			appendBox(walls, { roomX, 0.f, half }, { roomX + ROOM_SIZE, ROOM_HEIGHT, half + WALL_THICKNESS });
+			appendCrossWall(walls, roomX, room > 0, doorOffset(room));
+			if (room == ROOM_COUNT - 1) appendCrossWall(walls, roomX + ROOM_SIZE, false, 0.f);
+			baker.addObject(std::move(walls));
+
+			// Мебель: каждый предмет - отдельный подобъект
+			vget::VgetPvsBaker::Object furniture{};
+			furniture.name = "Furniture" + std::to_string(room);
+			for (int i = 0; i < FURNITURE_PER_ROOM; ++i)
+			{
+				const uint32_t indexStart = static_cast<uint32_t>(furniture.indices.size());
+				const glm::vec3 center{ roomX + half + position(rng), 0.f, position(rng) };
+				const glm::vec3 extent{ size(rng), 2.f * size(rng), size(rng) };
+				appendBox(furniture, { center.x - extent.x, 0.f, center.z - extent.z }, { center.x + extent.x, extent.y, center.z + extent.z });
+				furniture.subObjects.push_back(glm::uvec2{ indexStart, static_cast<uint32_t>(furniture.indices.size()) - indexStart });
+			}
+			baker.addObject(std::move(furniture));
+		}
+		return baker;
+	}
+
+	bool samePvs(const vget::VgetPvs& a, const vget::VgetPvs& b)
+	{
+		if (a.origin != b.origin || a.cellSize != b.cellSize || !(a.dimensions == b.dimensions) || a.itemCount != b.itemCount) return false;
+		if (a.uniqueSets != b.uniqueSets || a.cellSets != b.cellSets || a.objects.size() != b.objects.size()) return false;
+		for (size_t i = 0; i < a.objects.size(); ++i)
+		{
+			if (a.objects[i].name != b.objects[i].name || a.objects[i].firstItem != b.objects[i].firstItem ||
+				a.objects[i].itemCount != b.objects[i].itemCount) return false;
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	using namespace vget;
+
+	VgetPvsBaker::Settings settings{};
+	settings.navigableBounds = Aabb{ glm::vec3{ 0.f, .5f, -ROOM_SIZE * .5f }, glm::vec3{ ROOM_COUNT * ROOM_SIZE, 2.5f, ROOM_SIZE * .5f } };
+	settings.cellSize = 2.f;
+	settings.samplesPerCell = 8;
+	settings.samplesPerItem = 32;
+
+	bool failed = false;
+
+	VgetPvsBaker baker = createScene();
+	settings.threadCount = 1;
+	const VgetPvs singleThreaded = baker.bake(settings);
+	const double singleMs = baker.getStatistics().bakeTimeMs;
+
+	settings.threadCount = std::max(2u, std::thread::hardware_concurrency());
+	const VgetPvs pvs = baker.bake(settings);
+	const VgetPvsBaker::Statistics stats = baker.getStatistics();
+	if (!samePvs(singleThreaded, pvs))
+	{
+		std::cerr << "Bake result depends on thread count!" << std::endl;
+		failed = true;
+	}
+
+	// Сохранение и повторная загрузка
+	const std::string filepath = (std::filesystem::temp_directory_path() / "vget_pvs_benchmark.pvs").string();
+	pvs.save(filepath);
+	const auto fileSize = std::filesystem::file_size(filepath);
+	VgetPvs loaded{};
+	loaded.load(filepath);
+	std::filesystem::remove(filepath);
+	if (!samePvs(pvs, loaded))
+	{
+		std::cerr << "Loaded PVS differs from the saved one!" << std::endl;
+		failed = true;
+	}
+
+	// id объектов сцены совпадают с их порядком при запекании: RoomN = 2N, FurnitureN = 2N + 1
+	for (int room = 0; room < ROOM_COUNT; ++room)
+	{
+		loaded.bindObject(2 * room, "Room" + std::to_string(room));
+		loaded.bindObject(2 * room + 1, "Furniture" + std::to_string(room));
+	}
+
+	// Контроль: из центра первой комнаты видна её мебель и не видна мебель последней комнаты
+	loaded.selectCell(glm::vec3{ ROOM_SIZE * .5f, 1.5f, 0.f });
+	if (!loaded.isObjectVisible(1) || loaded.isObjectVisible(2 * ROOM_COUNT - 1))
+	{
+		std::cerr << "Control objects are classified incorrectly!" << std::endl;
+		failed = true;
+	}
+	for (uint32_t i = 0; i < FURNITURE_PER_ROOM; ++i)
+	{
+		if (!loaded.isSubObjectVisible(1, i))
+		{
+			std::cerr << "Furniture of the current room is hidden!" << std::endl;
+			failed = true;
+			break;
+		}
+	}
+
+	// Проход камеры через все комнаты по дверным проёмам: количество отрисовок (элементов) с PVS и без
+	uint64_t frames = 0, drawsWithPvs = 0, lookupDraws = 0;
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (float x = .5f; x < ROOM_COUNT * ROOM_SIZE - .5f; x += PATH_STEP)
+	{
+		const int room = static_cast<int>(x / ROOM_SIZE);
+		const float roomT = x / ROOM_SIZE - room;
+		// Камера идёт от проёма, через который вошла, к проёму в следующую комнату
+		const float fromZ = room > 0 ? doorOffset(room) : 0.f;
+		const float toZ = room + 1 < ROOM_COUNT ? doorOffset(room + 1) : 0.f;
+		loaded.selectCell(glm::vec3{ x, 1.5f, fromZ + (toZ - fromZ) * roomT });
+
+		for (uint32_t id = 0; id < 2 * ROOM_COUNT; ++id)
+		{
+			const uint32_t subObjects = id % 2 ? FURNITURE_PER_ROOM : 1;
+			for (uint32_t sub = 0; sub < subObjects; ++sub)
+			{
+				lookupDraws += loaded.isSubObjectVisible(id, sub);
+			}
+		}
+		for (uint32_t item = 0; item < loaded.itemCount; ++item)
+		{
+			drawsWithPvs += loaded.isItemVisible(loaded.getCurrentCell(), item);
+		}
+		++frames;
+	}
+	const double pathMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	if (lookupDraws != drawsWithPvs)
+	{
+		std::cerr << "Object lookups disagree with per-item visibility!" << std::endl;
+		failed = true;
+	}
+
+	std::cout << "PVS bake, " << ROOM_COUNT << " rooms, " << stats.itemCount << " items, " << stats.cellCount << " cells ("
+		<< pvs.dimensions.x << "x" << pvs.dimensions.y << "x" << pvs.dimensions.z << ")\n";
+	std::cout << "  bake (1 thread):\t" << singleMs << " ms\n";
+	std::cout << "  bake (" << settings.threadCount << " threads):\t" << stats.bakeTimeMs << " ms, " << stats.raysCast << " rays\n";
+	std::cout << "  unique sets:\t\t" << stats.uniqueSetCount << " of " << stats.cellCount << " cells\n";
+	std::cout << "  file size:\t\t" << fileSize << " bytes\n";
+	std::cout << "  camera path:\t\t" << frames << " frames, " << pathMs / frames * 1e3 << " us/frame lookups\n";
+	std::cout << "  draws per frame:\t" << static_cast<double>(drawsWithPvs) / frames << " with PVS / " << loaded.itemCount << " without\n";
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
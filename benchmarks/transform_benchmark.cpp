@@ -0,0 +1,176 @@
+// Бенчмарк пересчёта матриц трансформаций (VgetTransformBatch).
+// 1 миллион трансформаций со случайными сдвигами, масштабами и поворотами. Сравнивает прежний покадровый расчёт
+// mat4() + normalMatrix() для каждого объекта со скалярным и пакетным (векторизованный sincos по SoA массивам)
+// пересчётом кэша, а также пакетный пересчёт трансформаций VgetWorld, когда за кадр изменился только 1% из них.
+// Проверяет точность векторизованного sincos и совпадение кэшированных матриц со скалярным расчётом.
+#include "vget_transforms.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t TRANSFORM_COUNT = 1'000'000;
+	constexpr int FRAME_COUNT = 10;
+	constexpr uint32_t DIRTY_STRIDE = 100;	// в сценарии частичных изменений меняется каждая сотая трансформация
+
+	double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	float maxDifference(const glm::mat4& a, const glm::mat4& b)
+	{
+		float difference = 0.f;
+		for (int column = 0; column < 4; ++column)
+		{
+			for (int row = 0; row < 4; ++row)
+			{
+				difference = std::max(difference, std::abs(a[column][row] - b[column][row]));
+			}
+		}
+		return difference;
+	}
+}
+
+int main()
+{
+	using namespace vget;
+
+	std::mt19937 rng{ 42 };
+	std::uniform_real_distribution<float> position{ -100.f, 100.f };
+	std::uniform_real_distribution<float> angle{ -10.f, 10.f };
+	std::uniform_real_distribution<float> scale{ 0.5f, 2.f };
+
+	std::vector<TransformComponent> transforms(TRANSFORM_COUNT);
+	for (auto& transform : transforms)
+	{
+		transform.translation = { position(rng), position(rng), position(rng) };
+		transform.rotation = { angle(rng), angle(rng), angle(rng) };
+		transform.scale = { scale(rng), scale(rng), scale(rng) };
+	}
+
+	bool failed = false;
+
+	// Точность векторизованного sincos на широком диапазоне углов (включая хвост неполного вектора)
+	std::vector<float> angles(100'003);
+	for (size_t i = 0; i < angles.size(); ++i)
+	{
+		angles[i] = -1000.f + 2000.f * static_cast<float>(i) / static_cast<float>(angles.size());
+	}
+	std::vector<float> sines(angles.size()), cosines(angles.size());
+	sinCosBatch(angles.data(), sines.data(), cosines.data(), angles.size());
+	double maxSinCosError = 0.0;
+	for (size_t i = 0; i < angles.size(); ++i)
+	{
+		maxSinCosError = std::max(maxSinCosError, std::abs(sines[i] - std::sin(static_cast<double>(angles[i]))));
+		maxSinCosError = std::max(maxSinCosError, std::abs(cosines[i] - std::cos(static_cast<double>(angles[i]))));
+	}
+	if (maxSinCosError > 1e-5)
+	{
+		std::cerr << "Vectorized sincos is inaccurate: " << maxSinCosError << std::endl;
+		failed = true;
+	}
+
+	// Прежний путь: обе матрицы заново для каждого объекта в каждом кадре
+	std::vector<glm::mat4> modelMatrices(TRANSFORM_COUNT), normalMatrices(TRANSFORM_COUNT);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		for (uint32_t i = 0; i < TRANSFORM_COUNT; ++i)
+		{
+			modelMatrices[i] = transforms[i].mat4();
+			normalMatrices[i] = glm::mat4{ transforms[i].normalMatrix() };
+		}
+	}
+	const double recomputeMs = elapsedMs(start) / FRAME_COUNT;
+
+	// Скалярный пересчёт кэша всех трансформаций
+	start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		for (auto& transform : transforms) transform.updateMatrices();
+	}
+	const double scalarMs = elapsedMs(start) / FRAME_COUNT;
+
+	// Пакетный пересчёт кэша всех трансформаций
+	VgetTransformBatch batch;
+	uint32_t updated = 0;
+	double batchMs = 0.0;
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		start = std::chrono::high_resolution_clock::now();
+		updated = batch.update(transforms.data(), TRANSFORM_COUNT);
+		batchMs += elapsedMs(start);
+	}
+	batchMs /= FRAME_COUNT;
+	if (updated != TRANSFORM_COUNT)
+	{
+		std::cerr << "Batch updated " << updated << " transforms instead of " << TRANSFORM_COUNT << "!" << std::endl;
+		failed = true;
+	}
+
+	float maxMatrixError = 0.f;
+	for (uint32_t i = 0; i < TRANSFORM_COUNT; ++i)
+	{
+		maxMatrixError = std::max(maxMatrixError, maxDifference(transforms[i].worldMatrix, modelMatrices[i]));
+		maxMatrixError = std::max(maxMatrixError, maxDifference(transforms[i].worldNormalMatrix, normalMatrices[i]));
+	}
+	if (maxMatrixError > 1e-4f)
+	{
+		std::cerr << "Batched matrices differ from scalar ones: " << maxMatrixError << std::endl;
+		failed = true;
+	}
+
+	// Частичные изменения: пересчитываются только отмеченные в мире трансформации, остальные матрицы остаются прежними
+	VgetWorld world;
+	std::vector<Entity> entities(TRANSFORM_COUNT);
+	for (uint32_t i = 0; i < TRANSFORM_COUNT; ++i) entities[i] = world.createEntity(transforms[i]);
+	batch.update(world);
+
+	double partialMs = 0.0;
+	for (int frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		for (uint32_t i = frame; i < TRANSFORM_COUNT; i += DIRTY_STRIDE)
+		{
+			world.getComponent<TransformComponent>(entities[i])->rotation.y += 0.1f;
+			world.markChanged<TransformComponent>(entities[i]);
+		}
+		start = std::chrono::high_resolution_clock::now();
+		updated = batch.update(world);
+		partialMs += elapsedMs(start);
+
+		if (updated != (TRANSFORM_COUNT - frame + DIRTY_STRIDE - 1) / DIRTY_STRIDE)
+		{
+			std::cerr << "Batch updated " << updated << " transforms in a partial frame!" << std::endl;
+			failed = true;
+		}
+	}
+	partialMs /= FRAME_COUNT;
+
+	for (uint32_t i = 0; i < TRANSFORM_COUNT; ++i)
+	{
+		TransformComponent& transform = *world.getComponent<TransformComponent>(entities[i]);
+		if (world.isChanged<TransformComponent>(entities[i]) || maxDifference(transform.worldMatrix, transform.mat4()) > 1e-4f)
+		{
+			std::cerr << "Transform " << i << " has a stale cached matrix!" << std::endl;
+			failed = true;
+			break;
+		}
+	}
+
+	std::cout << "Transforms, " << TRANSFORM_COUNT << " objects, " << FRAME_COUNT << " frames\n";
+	std::cout << "  sincos max error:\t" << maxSinCosError << "\n";
+	std::cout << "  recompute every frame:\t" << recomputeMs << " ms/frame\n";
+	std::cout << "  scalar cache update:\t" << scalarMs << " ms/frame\n";
+	std::cout << "  batched cache update:\t" << batchMs << " ms/frame (" << recomputeMs / batchMs << "x)\n";
+	std::cout << "  batched, 1% dirty:\t" << partialMs << " ms/frame\n";
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
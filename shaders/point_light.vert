@@ -11,41 +11,36 @@ const vec2 OFFSETS[6] = vec2[](
   vec2(1.0, 1.0)
 );
 
+// Данные экземпляра билборда из буфера экземпляров (VgetBillboardBatch)
+layout (location = 0) in vec4 instancePosition; // w - радиус билборда
+layout (location = 1) in vec4 instanceColor;    // w - интенсивность цвета
+
 // Выходная переменная отступа, которая будет линейно интерполирована во frag шейдере
 layout (location = 0) out vec2 fragOffset;
+layout (location = 1) flat out vec4 fragColor;
  
-struct PointLight {
-	vec4 position; // w - игнорируется
-	vec4 color;    // w - интенсивность цвета
-};
-
 // Ubo объект такой же как и в simple shader
 layout(set = 0, binding = 0) uniform GlobalUBO {
 	mat4 projection;
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
+	vec4 clusterDepthParams; // slice = log(z) * x + y; z, w - ближняя и дальняя плоскости
+	vec4 screenSize;
 	int numLights;
 } ubo;
 
-// Пришедшая структура пуш-констант
-layout(push_constant) uniform Push {
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
-
 void main() {
 	fragOffset = OFFSETS[gl_VertexIndex]; // gl_VertexIndex хранит индекс текущей обрабатываемой вершины
+	fragColor = instanceColor;
 
 	// Извелечение векторов "вверх" и "вправо" из View матрицы (в данный момент это World Space)
 	vec3 cameraRightWorld = {ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]};
 	vec3 cameraUpWorld = {ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]};
 
 	// Вычисление позиции вершины билборда в мировом пространстве
-	vec3 positionWorld = push.position.xyz + push.radius * fragOffset.x * cameraRightWorld
-		+ push.radius * fragOffset.y * cameraUpWorld;
+	vec3 positionWorld = instancePosition.xyz + instancePosition.w * fragOffset.x * cameraRightWorld
+		+ instancePosition.w * fragOffset.y * cameraUpWorld;
 
 	// Перевод положения полученной вершины Point Light билборда в каноническое пространство
 	gl_Position = ubo.projection * ubo.view * vec4(positionWorld, 1.0);
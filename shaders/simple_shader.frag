@@ -9,7 +9,7 @@ layout (location = 3) in vec2 fragUv;
 layout (location = 0) out vec4 outColor;
 
 struct PointLight {
-	vec4 position; // w - игнорируется
+	vec4 position; // w - радиус влияния
 	vec4 color;    // w - интенсивность цвета
 };
 
@@ -23,10 +23,33 @@ layout(set = 0, binding = 0) uniform GlobalUBO {
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
+	vec4 clusterDepthParams; // slice = log(z) * x + y; z, w - ближняя и дальняя плоскости
+	vec4 screenSize;
 	int numLights;
 } ubo;
 
+// Кластерное освещение: все источники света сцены, и для каждого кластера - диапазон в списке индексов источников,
+// влияющих на его объём. Размеры сетки и формула среза совпадают с VgetLightClusters.
+layout(std430, set = 0, binding = 1) readonly buffer PointLightBuffer {
+	PointLight pointLights[];
+};
+layout(std430, set = 0, binding = 2) readonly buffer ClusterRangeBuffer {
+	uvec2 clusterRanges[]; // x - отступ в lightIndices, y - количество источников
+};
+layout(std430, set = 0, binding = 3) readonly buffer LightIndexBuffer {
+	uint lightIndices[];
+};
+
+const uvec3 CLUSTER_GRID = uvec3(16, 9, 24);
+
+uint clusterIndex() {
+	float viewDepth = max((ubo.view * vec4(fragPosWorld, 1.0)).z, ubo.clusterDepthParams.z);
+	uvec3 cluster;
+	cluster.xy = min(uvec2(gl_FragCoord.xy / ubo.screenSize.xy * vec2(CLUSTER_GRID.xy)), CLUSTER_GRID.xy - 1);
+	cluster.z = min(uint(max(log(viewDepth) * ubo.clusterDepthParams.x + ubo.clusterDepthParams.y, 0.0)), CLUSTER_GRID.z - 1);
+	return cluster.x + cluster.y * CLUSTER_GRID.x + cluster.z * CLUSTER_GRID.x * CLUSTER_GRID.y;
+}
+
 // Directional Lighting
 //vec3 DIRECTION_TO_LIGHT = normalize(textureUbo.directionalLightPosition.xyz);
 
@@ -45,12 +68,17 @@ void main() {
 	// Вклад направленного источника света в рассеянное освещение
 	//diffuseLight += max(dot(surfaceNormal, DIRECTION_TO_LIGHT), 0) + textureUbo.directionalLightIntensity;
 
-	// В цикле считаем вклад каждого Point Light'а на сцене в результирующее рассеянное освещение фрагмента
-	for (int i = 0; i < ubo.numLights; ++i) {
-		PointLight light = ubo.pointLights[i]; // берём текущий точечный источник света
+	// В цикле считаем вклад каждого Point Light'а из кластера фрагмента в результирующее рассеянное освещение
+	uvec2 range = clusterRanges[clusterIndex()];
+	for (uint i = range.x; i < range.x + range.y; ++i) {
+		PointLight light = pointLights[lightIndices[i]]; // берём текущий точечный источник света
 
 		vec3 directionToLight = light.position.xyz - fragPosWorld; // ещё ненормализованное направление к ист. света
-		float attenuation = 1.0 / dot(directionToLight, directionToLight); // фактор ослабевания интенсивности света = 1 / квадрат расстояния до источника
+		float distanceSquared = dot(directionToLight, directionToLight);
+		// Фактор ослабевания = 1 / квадрат расстояния до источника, плавно сведённый к нулю на радиусе влияния,
+		// чтобы на границах кластеров не было видно обрезанного освещения
+		float falloff = clamp(1.0 - pow(distanceSquared / (light.position.w * light.position.w), 2.0), 0.0, 1.0);
+		float attenuation = falloff * falloff / distanceSquared;
 		directionToLight = normalize(directionToLight);
 
 		// косинус угла падения
@@ -22,11 +22,6 @@ layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragUv;
 
-struct PointLight {
-	vec4 position; // w - игнорируется
-	vec4 color;    // w - интенсивность цвета
-};
-
 // Тип, который получает данные из унифицированного буфера с ubo объектом внутри.
 // Такой read only buffer передаётся через набор дескрипторов, в котором он содержится
 // по указанной привязке.
@@ -35,7 +30,8 @@ layout(set = 0, binding = 0) uniform GlobalUBO {
 	mat4 view;
 	mat4 invView;
 	vec4 ambientLightColor;
-	PointLight pointLights[10];
+	vec4 clusterDepthParams; // slice = log(z) * x + y; z, w - ближняя и дальняя плоскости
+	vec4 screenSize;
 	int numLights;
 } ubo;
 
@@ -45,6 +41,7 @@ layout(push_constant) uniform Push {
 	mat4 modelMatrix;
 	mat4 normalMatrix;
 	int textureIndex;
+	int samplerIndex;
 	vec3 diffuseColor;
 } push;
 
@@ -4,9 +4,12 @@
 #include "systems/simple_render_system.hpp"
 #include "systems/texture_render_system.hpp"
 #include "systems/point_light_system.hpp"
+#include "systems/light_cluster_system.hpp"
 #include "vget_camera.hpp"
 #include "keyboard_movement_controller.hpp"
 #include "vget_buffer.hpp"
+#include "vget_cpu_profiler.hpp"
+#include "vget_texture_table.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS			  // Функции GLM будут работать с радианами, а не градусами
@@ -21,8 +24,11 @@
 #include <stdexcept>
 #include <cassert>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <numeric>
+#include <filesystem>
+#include <iostream>
 
 #define MAX_FRAME_TIME 0.5f
 
@@ -34,15 +40,30 @@ namespace vget
 		globalPool = VgetDescriptorPool::Builder(vgetDevice)
 			.setMaxSets(VgetSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VgetSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * VgetSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.build();
 
+		// Пока стриминга и вытеснения ресурсов нет, превышение бюджета памяти только сообщается в лог
+		vgetDevice.getMemoryTracker().setBudgetFraction(MEMORY_BUDGET_FRACTION);
+		vgetDevice.getMemoryTracker().addOverBudgetCallback([](const MemoryBudgetEvent& event)
+		{
+			std::cerr << "memory heap " << event.heapIndex << " is over budget: " << (event.usage >> 20)
+				<< " MiB used, limit " << (event.limit >> 20) << " MiB" << std::endl;
+		});
+
 		loadGameObjects();
+		loadPvs();
 	}
 
 	FirstApp::~FirstApp() {}
 
 	void FirstApp::run()
 	{
+		VGET_PROFILE_THREAD_NAME("Update");
+#ifdef VGET_ENABLE_PROFILER
+		VgetCpuProfiler::get().setSlowFrameThreshold(SLOW_FRAME_THRESHOLD_MS);
+#endif
+
 		// Создание Uniform Buffer'ов. По одному на каждый одновременно рисующийся кадр.
 		std::vector<std::unique_ptr<VgetBuffer>> uboBuffers(VgetSwapChain::MAX_FRAMES_IN_FLIGHT);
 		for (int i = 0; i < uboBuffers.size(); ++i)
@@ -53,7 +74,9 @@ namespace vget
 				1,
 				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 				// Здесь не исп. HOST_COHERENT свойство, чтобы продемонстрировать flush сброс памяти в девайс
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				1,
+				MemoryTag{ MemoryCategory::Uniform, "GlobalUbo" }
 			);
 			uboBuffers[i]->map();
 		}
@@ -61,6 +84,10 @@ namespace vget
 		// Создаётся глобальная схема набора дескрипторов (действует на всё приложение)
 		auto globalSetLayout = VgetDescriptorSetLayout::Builder(vgetDevice)
 			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			// источники света, диапазоны кластеров и индексы источников для кластерного освещения
+			.addBinding(LightClusterSystem::LIGHTS_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(LightClusterSystem::CLUSTER_RANGES_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(LightClusterSystem::LIGHT_INDICES_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
 			.build();
 
 		// Выделение наборов дескрипторов из пула
@@ -78,22 +105,25 @@ namespace vget
 		TextureRenderSystem textureRenderSystem{
 			vgetDevice,
 			vgetRenderer.getSwapChainRenderPass(),
-			globalSetLayout->getDescriptorSetLayout(),
-			FrameInfo{0, 0, nullptr, VgetCamera{}, nullptr, gameObjects}
+			globalSetLayout->getDescriptorSetLayout()
 		};
 		PointLightSystem pointLightSystem{
 			vgetDevice,
 			vgetRenderer.getSwapChainRenderPass(),
 			globalSetLayout->getDescriptorSetLayout()
 		};
+		LightClusterSystem lightClusterSystem{ vgetDevice, *globalSetLayout, *globalPool };
 
 		VgetCamera camera{};
 		// установка положения "теоретической камеры"
 		//camera.setViewDirection(glm::vec3{0.f}, glm::vec3{0.5f, 0.f, 1.f});
 		//camera.setViewTarget(glm::vec3{-3.f, -3.f, 23.f}, {.0f, .0f, 1.5f});
 
-		auto viewerObject = VgetGameObject::createGameObject(); // объект без модели для хранения текущего состояния камеры
+		TransformComponent viewerTransform{}; // трансформация без модели для хранения текущего состояния камеры
 		KeyboardMovementController cameraController{};
+		VgetCameraPath cameraPath{};	// путь камеры, записываемый по флажку в интерфейсе
+		float cameraPathTime = 0.f;
+		VgetRenderStatsCsv renderStatsCsv{};	// открыт, пока в окне статистики рендера включена выгрузка
 
 		VgetImgui vgetImgui{
 			vgetWindow,
@@ -102,15 +132,141 @@ namespace vget
 			VgetSwapChain::MAX_FRAMES_IN_FLIGHT,
 			camera,
 			cameraController,
-			gameObjects
+			world
 		};
+		vgetImgui.maxRecordThreads = static_cast<int>(jobSystem.getWorkerCount());
+		vgetImgui.recordThreadCount = vgetImgui.maxRecordThreads;
+
+		// Области профайлера GPU: системы рендера и интерфейс в порядке их записи в проход
+		passRecorder.setGpuProfiler(&gpuProfiler);
+		const uint32_t simpleRenderScope = gpuProfiler.addScope("SimpleRenderSystem");
+		const uint32_t textureRenderScope = gpuProfiler.addScope("TextureRenderSystem");
+		const uint32_t pointLightScope = gpuProfiler.addScope("PointLightSystem");
+		const uint32_t imguiScope = gpuProfiler.addScope("ImGui");
+
+		// Обновление сцены перед записью команд - граф задач. Дерево объёмов и буфер глубины окклюдеров зависят
+		// от готовых мировых матриц, но не друг от друга, а выбор ячейки PVS зависит только от камеры.
+		VgetTaskGraph updateGraph{};
+		const auto transformsTask = updateGraph.addTask([&]()
+		{
+			// Сначала иерархия: ей нужны отметки об изменении, чтобы пересчитать поддеревья изменённых узлов
+			sceneHierarchy.update(world, transformBatch);
+			transformBatch.update(world);
+		});
+		const auto sceneTreeTask = updateGraph.addTask([&]() { updateSceneTree(); });
+		const auto occludersTask = updateGraph.addTask([&]() { rasterizeOccluders(camera); });
+		updateGraph.addTask([&]() { pvs.selectCell(camera.getPosition()); });
+		updateGraph.addDependency(transformsTask, sceneTreeTask);
+		updateGraph.addDependency(transformsTask, occludersTask);
+
+		// Стадия рендера конвейера кадров: загрузка данных кадра, запись команд из снимка и отправка кадра.
+		// Выполняется в потоке рендера или, в однопоточном режиме, прямо в потоке обновления.
+		std::array<RenderSnapshot, VgetFramePipeline::SNAPSHOT_COUNT> snapshots{};
+		std::atomic<float> aspectRatio{ vgetRenderer.getAspectRatio() };
+		VgetFramePipeline framePipeline{ [&](uint32_t snapshotIndex)
+		{
+			RenderSnapshot& snapshot = snapshots[snapshotIndex];
+			// В однопоточном режиме рендер идёт в потоке обновления, но его счётчики относятся к кадру рендера
+			VgetRenderStats::CounterSideScope renderSide{ CounterSide::Render };
+			auto commandBuffer = vgetRenderer.beginFrame(); // beginFrame() вернёт nullptr, если требуется пересоздание SwapChain'а
+			if (commandBuffer == nullptr)
+			{
+				aspectRatio = vgetRenderer.getAspectRatio();
+				return;
+			}
+			// Кадр, ранее использовавший этот индекс, завершён: таблица текстур может вернуть освобождённые слоты
+			vgetDevice.getTextureTable().beginFrame();
+
+			int frameIndex = vgetRenderer.getFrameIndex();
+			FrameInfo frameInfo {frameIndex, snapshot.frameTime, commandBuffer, passRecorder, snapshot.camera,
+				globalDescriptorSets[frameIndex], world, sceneTree, occlusionCuller, pvs, snapshotIndex};
+
+			// Запросы профайлера сбрасываются вне прохода рендера, а замеры кадра читаются без ожидания GPU
+			gpuProfiler.setStatisticsEnabled(snapshot.gpuStatisticsEnabled);
+			gpuProfiler.beginFrame(commandBuffer, frameIndex);
+
+			// Обновление данных внутри uniform buffer объектов для текущего кадра
+			GlobalUbo ubo{};
+			ubo.projection = snapshot.camera.getProjection();
+			ubo.view = snapshot.camera.getView();
+			ubo.inverseView = snapshot.camera.getInverseView();
+			lightClusterSystem.update(frameInfo, pointLightSystem.getLights(snapshotIndex), vgetRenderer.getSwapChainExtent(), ubo);
+			uboBuffers[frameIndex]->writeToBuffer(&ubo);
+			uboBuffers[frameIndex]->flush();
+			textureRenderSystem.update(frameInfo, snapshot.textureSystemUbo);
+
+			// RENDER SECTION
+			// Системы пишут проход во вторичные буферы из рабочих потоков, а основной буфер только исполняет их
+			passRecorder.setMaxThreads(snapshot.recordThreadCount);
+			passRecorder.beginFrame(frameIndex, vgetRenderer.getSwapChainRenderPass(),
+				vgetRenderer.getCurrentFramebuffer(), vgetRenderer.getSwapChainExtent());
+
+			// Порядок отрисовки объектов важен, так как сначала надо отрисовать непрозрачные объекты с помощью textureRenderSystem, а
+			// затем полупрозрачные билборды поинт лайтов с помощью PointLightSystem.
+			passRecorder.beginScope(simpleRenderScope);
+			simpleRenderSystem.renderGameObjects(frameInfo);
+			passRecorder.endScope();
+			passRecorder.beginScope(textureRenderScope);
+			textureRenderSystem.renderGameObjects(frameInfo);
+			passRecorder.endScope();
+			passRecorder.beginScope(pointLightScope);
+			pointLightSystem.render(frameInfo);
+			passRecorder.endScope();
+
+			// as last step in render pass, record the imgui draw commands
+			passRecorder.beginScope(imguiScope);
+			passRecorder.record(1, 1, [&](VgetCommandRecorder& recorder, uint32_t, uint32_t)
+			{
+				VgetImgui::render(recorder.getCommandBuffer(), snapshot.imguiDrawData);
+			});
+			passRecorder.endScope();
+
+			/* Начало и конец прохода рендера и кадра отделены друг от друга для упрощения в дальнейшем
+			   интеграции сразу нескольких проходов рендера (Render passes) для создания отражений,
+			   теней и эффектов пост-процесса. */
+			vgetRenderer.beginSwapChainRenderPass(commandBuffer, snapshot.clearColor, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			passRecorder.execute(commandBuffer);
+			vgetRenderer.endSwapChainRenderPass(commandBuffer);
+			gpuProfiler.endFrame(commandBuffer);
+			vgetRenderer.endFrame();
+			gpuProfiler.markSubmitted();
+
+			VGET_PROFILE_COUNTER("Secondary command buffers", passRecorder.getBufferCount());
+			VGET_PROFILE_COUNTER("Commands issued", passRecorder.getStats().issued);
+
+			// Статистика рендера остаётся в снимке: поток обновления прочитает её, когда снимок снова освободится
+			snapshot.renderStats.commandStats = passRecorder.getStats();
+			snapshot.renderStats.recordTimeMs = passRecorder.getRecordTimeMs();
+			snapshot.renderStats.bufferCount = passRecorder.getBufferCount();
+			snapshot.renderStats.lightClusterBuildTimeMs = lightClusterSystem.getClusters().getBuildTimeMs();
+			snapshot.renderStats.gpuTimings = gpuProfiler.getTimings();
+			VgetRenderStats::addCommandStats(passRecorder.getStats());
+			snapshot.renderStats.counters = VgetRenderStats::get().endFrame(snapshot.updateCounters);
+			aspectRatio = vgetRenderer.getAspectRatio(); // SwapChain мог быть пересоздан в endFrame()
+		} };
+		framePipeline.setThreaded(vgetImgui.threadedRendering);
 
 		auto currentTime = std::chrono::high_resolution_clock::now();
+		// Этот поток - стадия обновления: его счётчики рендера копятся в снимок, а не в рендерящийся кадр
+		VgetRenderStats::CounterSideScope updateSide{ CounterSide::Update };
 
-		// Обработка событий происходит, пока окно не должно быть закрыто.
+		// Стадия обновления. Обработка событий происходит, пока окно не должно быть закрыто.
 		while (!vgetWindow.shouldClose())
 		{
+			VGET_PROFILE_FRAME();
+
+			// Ожидание свободного снимка. Пока оба снимка заняты потоком рендера, обрабатываются события окна:
+			// без этого поток рендера, ждущий разворачивания окна для пересоздания SwapChain'а, не дождался бы его.
+			uint32_t snapshotIndex = 0;
+			{
+				VGET_PROFILE_ZONE("Acquire snapshot");
+				while (!framePipeline.acquire(snapshotIndex, std::chrono::milliseconds(EVENT_POLL_INTERVAL_MS)))
+				{
+					glfwPollEvents();
+				}
+			}
 			glfwPollEvents(); // Обработка событий из очереди (нажатие клавиш, взаимодействие с окном и т.п.)
+			RenderSnapshot& snapshot = snapshots[snapshotIndex];
 
 			// расчёт временного шага с момента последней итерации
 			auto newTime = std::chrono::high_resolution_clock::now();
@@ -122,15 +278,16 @@ namespace vget
 			frameTime = glm::min(frameTime, MAX_FRAME_TIME);
 
 			// двигаем/вращаем объект теоретической камеры в зависимости от ввода с клавиатуры
-			cameraController.moveInPlaneXZ(vgetWindow.getGLFWwindow(), frameTime, viewerObject);
-			camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+			cameraController.moveInPlaneXZ(vgetWindow.getGLFWwindow(), frameTime, viewerTransform);
+			camera.setViewYXZ(viewerTransform.translation, viewerTransform.rotation);
 
 			// Матрица ортогонального проецирования перестраивается каждый кадр, чтобы размеры ортогонального объёма просмотра
 			// всегда соответствовали текущему значению соотношения сторон окна.
 			// Aspect ratio подставляется именно в -left и right, чтобы соответствовать выражению: right - left = aspect * (bottom - top)
 			// И в таком случае ортогональный объём просмотра будет иметь такое же соотношение сторон, что и окно.
 			// Это избавляет отображаемый объект от искажений, связанных с соотношением сторон.
-			float aspect = vgetRenderer.getAspectRatio();
+			// Соотношение сторон берётся из SwapChain'а, которым владеет стадия рендера.
+			float aspect = aspectRatio;
 			//camera.setOrthographicProjection(-aspect, aspect, -1, 1, -1, 1);
 
 			// Установка матрицы проецирования перспективы.
@@ -140,56 +297,164 @@ namespace vget
 			// Это тип проецирования чаще всего используется в играх.
 			camera.setPerspectiveProjection(glm::radians(50.f), aspect, 0.1f, 100.f);
 
-			// отрисовка кадра
-			if (auto commandBuffer = vgetRenderer.beginFrame()) // beginFrame() вернёт nullptr, если требуется пересоздание SwapChain'а
+			vgetImgui.newFrame(); // tell imgui that we're starting a new frame
+
+			// Кадра в полёте у стадии обновления нет: она заполняет снимок, который отрендерится позже
+			FrameInfo frameInfo {-1, frameTime, VK_NULL_HANDLE, passRecorder, camera,
+				VK_NULL_HANDLE, world, sceneTree, occlusionCuller, pvs, snapshotIndex};
+
+			// UPDATE SECTION
+			// Матрицы пересчитываются только для трансформаций, изменённых с прошлого кадра
+			{
+				VGET_PROFILE_ZONE("Update scene");
+				updateGraph.run(jobSystem);
+			}
+			pointLightSystem.update(frameInfo);
+
+			// Отсечение и сортировка отрисовок в снимок кадра
+			simpleRenderSystem.prepare(frameInfo);
+			textureRenderSystem.prepare(frameInfo);
+
+			vgetImgui.cullingStats = simpleRenderSystem.getCullingStats();
+			vgetImgui.cullingStats += textureRenderSystem.getCullingStats();
+			vgetImgui.occlusionRasterTimeMs = occlusionCuller.getRasterTimeMs();
+			vgetImgui.occluderTriangleCount = occlusionCuller.getOccluderTriangleCount();
+			vgetImgui.pvsCell = pvs.getCurrentCell();
+			vgetImgui.drawStats = simpleRenderSystem.getDrawStats();
+			vgetImgui.drawStats += textureRenderSystem.getDrawStats();
+			vgetImgui.commandStats = snapshot.renderStats.commandStats;
+			vgetImgui.commandRecordTimeMs = snapshot.renderStats.recordTimeMs;
+			vgetImgui.commandBufferCount = snapshot.renderStats.bufferCount;
+			vgetImgui.lightCount = static_cast<uint32_t>(pointLightSystem.getLights(snapshotIndex).size());
+			vgetImgui.lightClusterBuildTimeMs = snapshot.renderStats.lightClusterBuildTimeMs;
+			vgetImgui.transformUpdateCount = transformBatch.getUpdatedCount();
+			vgetImgui.transformUpdateTimeMs = transformBatch.getUpdateTimeMs() + sceneHierarchy.getUpdateTimeMs();
+			vgetImgui.hierarchyNodeCount = sceneHierarchy.getNodeCount();
+			vgetImgui.hierarchyUpdateCount = sceneHierarchy.getUpdatedCount();
+			vgetImgui.frameLatencyMs = framePipeline.getLatencyMs();
+			vgetImgui.renderTimeMs = framePipeline.getRenderTimeMs();
+			vgetImgui.gpuTimings = snapshot.renderStats.gpuTimings;
+			vgetImgui.renderCounterHistory.push(snapshot.renderStats.counters);
+			vgetDevice.getMemoryTracker().updateBudget();
+
+			// Описание элементов интерфейса ImGUI для отрисовки
 			{
-				vgetImgui.newFrame(); // tell imgui that we're starting a new frame
-
-				int frameIndex = vgetRenderer.getFrameIndex();
-				FrameInfo frameInfo {frameIndex, frameTime, commandBuffer, camera,
-					globalDescriptorSets[frameIndex], gameObjects};
-
-				// UPDATE SECTION
-				// Обновление данных внутри uniform buffer объектов для текущего кадра
-				GlobalUbo ubo{};
-				ubo.projection = camera.getProjection();
-				ubo.view = camera.getView();
-				ubo.inverseView = camera.getInverseView();
-				pointLightSystem.update(frameInfo, ubo);
-				uboBuffers[frameIndex]->writeToBuffer(&ubo);
-				uboBuffers[frameIndex]->flush();
-				TextureSystemUbo textureSystemUbo{};
-				textureSystemUbo.directionalLightIntensity = vgetImgui.directionalLightIntensity;
-				textureSystemUbo.directionalLightPosition = vgetImgui.directionalLightPosition;
-				textureRenderSystem.update(frameInfo, textureSystemUbo);
-
-				// RENDER SECTION
-				/* Начало и конец прохода рендера и кадра отделены друг от друга для упрощения в дальнейшем
-				   интеграции сразу нескольких проходов рендера (Render passes) для создания отражений,
-				   теней и эффектов пост-процесса. */
-				vgetRenderer.beginSwapChainRenderPass(commandBuffer, vgetImgui.clear_color);
-
-				// Порядок отрисовки объектов важен, так как сначала надо отрисовать непрозрачные объекты с помощью textureRenderSystem, а
-				// затем полупрозрачные билборды поинт лайтов с помощью PointLightSystem.
-				simpleRenderSystem.renderGameObjects(frameInfo);
-				textureRenderSystem.renderGameObjects(frameInfo);
-				pointLightSystem.render(frameInfo);
-
-				// Описание элементов интерфейса ImGUI для отрисовки
+				VGET_PROFILE_ZONE("ImGui");
 				vgetImgui.runExample();
 				vgetImgui.showPointLightCreator();
 				vgetImgui.showModelsFromDirectory();
 				vgetImgui.enumerateObjectsInTheScene();
-				vgetImgui.render(commandBuffer); // as last step in render pass, record the imgui draw commands
+				vgetImgui.showGpuProfiler();
+				vgetImgui.showRenderStats();
+				vgetImgui.showMemoryBudget();
+			}
 
-				vgetRenderer.endSwapChainRenderPass(commandBuffer);
-				vgetRenderer.endFrame();
+			snapshot.frameTime = frameTime;
+			snapshot.camera = camera;
+			snapshot.textureSystemUbo = TextureSystemUbo{};
+			snapshot.textureSystemUbo.directionalLightIntensity = vgetImgui.directionalLightIntensity;
+			snapshot.textureSystemUbo.directionalLightPosition = vgetImgui.directionalLightPosition;
+			snapshot.clearColor = vgetImgui.clear_color;
+			snapshot.recordThreadCount = static_cast<uint32_t>(vgetImgui.recordThreadCount);
+			snapshot.gpuStatisticsEnabled = vgetImgui.gpuStatisticsEnabled;
+			vgetImgui.endFrame(snapshot.imguiDrawData);
+
+			// Запись пути камеры: ключ на каждый кадр, файл сохраняется, когда запись выключают
+			if (vgetImgui.recordCameraPath)
+			{
+				cameraPathTime = cameraPath.empty() ? 0.f : cameraPathTime + frameTime;
+				cameraPath.addKey(VgetCameraPath::Key{ cameraPathTime, viewerTransform.translation, viewerTransform.rotation });
+			}
+			else if (!cameraPath.empty())
+			{
+				cameraPath.save(CAMERA_PATH_FILEPATH);
+				cameraPath.clear();
+			}
+
+			// Выгрузка счётчиков рендера: файл перезаписывается при каждом включении
+			if (vgetImgui.writeRenderStatsCsv && !renderStatsCsv.isOpen() && !renderStatsCsv.open(RENDER_STATS_CSV_FILEPATH))
+			{
+				vgetImgui.writeRenderStatsCsv = false;
+			}
+			else if (!vgetImgui.writeRenderStatsCsv && renderStatsCsv.isOpen())
+			{
+				renderStatsCsv.close();
 			}
+			renderStatsCsv.write(snapshot.renderStats.counters);
+
+			// Счётчики, увеличенные при подготовке снимка, попадут в строку кадра, который его отрендерит
+			snapshot.updateCounters = VgetRenderStats::get().takeUpdateCounters();
+
+			// Задержка кадра отсчитывается от начала его обновления (момента опроса ввода)
+			framePipeline.submit(snapshotIndex, newTime);
+			framePipeline.setThreaded(vgetImgui.threadedRendering);
 		}
 
+		framePipeline.setThreaded(false);
+
 		vkDeviceWaitIdle(vgetDevice.device());  // ожидать завершения всех операций на GPU перед закрытием программы и очисткой всех ресурсов
 	}
 
+	void FirstApp::updateSceneTree()
+	{
+		world.forEach<TransformComponent, ModelComponent>([&](Entity entity, TransformComponent& transform, ModelComponent& model)
+		{
+			const Aabb worldBox = model.model->getBoundingBox().transformed(transform.worldMatrix);
+			auto proxy = sceneTreeProxies.find(entity.index);
+			if (proxy == sceneTreeProxies.end())
+			{
+				sceneTreeProxies.emplace(entity.index, sceneTree.createProxy(worldBox, entity.index));
+			}
+			else
+			{
+				// Неподвижные объекты остаются внутри своих толстых AABB, и дерево для них не перестраивается
+				sceneTree.moveProxy(proxy->second, worldBox);
+			}
+		});
+
+		// Удаление листьев объектов, которые пропали со сцены или лишились модели.
+		// Ячейку уничтоженной сущности может занять новая сущность с моделью - тогда лист просто переходит к ней.
+		if (sceneTreeProxies.size() != world.count<TransformComponent, ModelComponent>())
+		{
+			for (auto it = sceneTreeProxies.begin(); it != sceneTreeProxies.end();)
+			{
+				const Entity entity = world.entityAt(it->first);
+				if (!world.hasComponent<TransformComponent>(entity) || !world.hasComponent<ModelComponent>(entity))
+				{
+					sceneTree.destroyProxy(it->second);
+					it = sceneTreeProxies.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+	}
+
+	void FirstApp::rasterizeOccluders(const VgetCamera& camera)
+	{
+		occlusionCuller.beginFrame(camera.getProjection() * camera.getView());
+		world.forEach<TransformComponent, ModelComponent, OccluderComponent>(
+			[&](Entity, TransformComponent& transform, ModelComponent& model, OccluderComponent&)
+			{
+				occlusionCuller.addOccluder(model.model->getOccluderMesh(), transform.worldMatrix);
+			});
+		occlusionCuller.rasterize();
+	}
+
+	void FirstApp::loadPvs()
+	{
+		// PVS запекается офлайн утилитой pvs_baker. Без файла видимость не ограничивается.
+		if (!std::filesystem::exists(PVS_FILEPATH)) return;
+
+		pvs.load(PVS_FILEPATH);
+		world.forEach<NameComponent>([&](Entity entity, NameComponent& name)
+		{
+			pvs.bindObject(entity.index, name.name);
+		});
+	}
+
 	void FirstApp::loadGameObjects()
 	{
 		// Viking Room model
@@ -211,13 +476,14 @@ namespace vget
 		gameObjects.emplace(sponzaObj.getId(), std::move(sponzaObj));*/
 
 		// Living room model
-		std::shared_ptr<VgetModel> container = VgetModel::createModelFromFile(vgetDevice, "../models/living_room.obj");
-		auto containerObj = VgetGameObject::createGameObject("LivingRoom");
-		containerObj.model = container;
-		containerObj.transform.translation = {1.f, 1.0f, 20.f};
-		containerObj.transform.scale = glm::vec3(1.01f, 1.01f, 1.01f);
-		containerObj.transform.rotation = glm::vec3(3.15f, 0.f, 0.f);
-		gameObjects.emplace(containerObj.getId(), std::move(containerObj));
+		std::shared_ptr<VgetModel> container = VgetModel::createModelFromFile(vgetDevice, "../models/living_room.obj", &jobSystem);
+		auto containerObj = VgetGameObject::createGameObject(world, "LivingRoom");
+		auto& containerTransform = *world.getComponent<TransformComponent>(containerObj);
+		containerTransform.translation = {1.f, 1.0f, 20.f};
+		containerTransform.scale = glm::vec3(1.01f, 1.01f, 1.01f);
+		containerTransform.rotation = glm::vec3(3.15f, 0.f, 0.f);
+		world.addComponent(containerObj, ModelComponent{ container });
+		world.addComponent(containerObj, OccluderComponent{}); // стены комнаты перекрывают большую часть её содержимого
 
 		// Conference model
 		//std::shared_ptr<VgetModel> conference = VgetModel::createModelFromFile(vgetDevice, "../models/fireplace_room.obj");
@@ -5,9 +5,24 @@
 #include "vget_game_object.hpp"
 #include "vget_renderer.hpp"
 #include "vget_descriptors.hpp"
+#include "vget_camera.hpp"
+#include "vget_camera_path.hpp"
+#include "vget_aabb_tree.hpp"
+#include "vget_occlusion.hpp"
+#include "vget_pvs.hpp"
+#include "vget_pass_recorder.hpp"
+#include "vget_gpu_profiler.hpp"
+#include "vget_render_stats.hpp"
+#include "vget_transforms.hpp"
+#include "vget_scene_hierarchy.hpp"
+#include "vget_job_system.hpp"
+#include "vget_frame_pipeline.hpp"
+#include "vget_frame_info.hpp"
+#include "vget_imgui.hpp"
 
 // std
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace vget
@@ -17,6 +32,12 @@ namespace vget
 	public:
 		static constexpr int WIDTH = 1280;
 		static constexpr int HEIGHT = 960;
+		static constexpr const char* PVS_FILEPATH = "../models/living_room.pvs";
+		static constexpr double SLOW_FRAME_THRESHOLD_MS = 50.0;	// кадры дольше порога автоматически выгружаются в трассу профайлера CPU
+		static constexpr int EVENT_POLL_INTERVAL_MS = 5;	// обработка событий окна, пока стадия обновления ждёт снимок
+		static constexpr const char* CAMERA_PATH_FILEPATH = "camera_path.txt";	// записанный путь камеры для vget_bench
+		static constexpr const char* RENDER_STATS_CSV_FILEPATH = "render_stats.csv";	// покадровые счётчики рендера
+		static constexpr float MEMORY_BUDGET_FRACTION = 0.9f;	// доля бюджета кучи, выше которой срабатывают обработчики VgetMemoryTracker
 
 		FirstApp();
 		~FirstApp();
@@ -29,7 +50,39 @@ namespace vget
 		void run();
 
 	private:
+		// Снимок кадра, который стадия обновления передаёт стадии рендера (см. VgetFramePipeline). Отрисовки
+		// систем рендера с матрицами трансформаций и источники света лежат в самих системах под тем же индексом.
+		struct RenderSnapshot
+		{
+			float frameTime = 0.f;
+			VgetCamera camera{};
+			TextureSystemUbo textureSystemUbo{};
+			ImVec4 clearColor{};
+			uint32_t recordThreadCount = 0;
+			bool gpuStatisticsEnabled = false;
+			VgetImguiDrawData imguiDrawData{};
+			RenderCounterValues updateCounters{};	// счётчики рендера, увеличенные при подготовке снимка
+
+			// Заполняется стадией рендера после отправки кадра и читается стадией обновления,
+			// когда снимок снова освободится (поэтому отстаёт на число снимков)
+			struct RenderStats
+			{
+				CommandStats commandStats{};
+				double recordTimeMs = 0.0;
+				uint32_t bufferCount = 0;
+				double lightClusterBuildTimeMs = 0.0;
+				GpuTimings gpuTimings{};
+				RenderCounters counters{};
+			} renderStats{};
+		};
+
 		void loadGameObjects();
+		// Загрузка запечённых потенциально видимых множеств и сопоставление их с объектами сцены по именам
+		void loadPvs();
+		// Синхронизация иерархии объёмов сцены с трансформациями и составом игровых объектов
+		void updateSceneTree();
+		// Программная растеризация объектов-окклюдеров в буфер глубины для отсечения перекрытых объектов
+		void rasterizeOccluders(const VgetCamera& camera);
 
 		// Порядок объявления перменных-членов имеет значение. Так, они будут инициализироваться
 		// сверху вниз, а уничтожаться снизу вверх. Пул дескрипторов, таким образом, должен
@@ -37,8 +90,18 @@ namespace vget
 		VgetWindow vgetWindow{ WIDTH, HEIGHT, "VgetX Engine" };
 		VgetDevice vgetDevice{ vgetWindow };
 		VgetRenderer vgetRenderer{ vgetWindow, vgetDevice };
+		VgetJobSystem jobSystem{};	// планировщик задач движка; объявлен раньше систем, которые его используют
 
 		std::unique_ptr<VgetDescriptorPool> globalPool{};
-		VgetGameObject::Map gameObjects;
+		VgetWorld world{};
+		VgetTransformBatch transformBatch{};	// пересчёт матриц изменённых трансформаций раз в кадр
+		VgetSceneHierarchy sceneHierarchy{ &jobSystem };	// мировые матрицы сущностей с родителями
+
+		VgetAabbTree sceneTree{};
+		std::unordered_map<VgetGameObject::id_t, int32_t> sceneTreeProxies{}; // лист дерева для каждого объекта с моделью (по индексу сущности)
+		VgetOcclusionCuller occlusionCuller{ &jobSystem };
+		VgetPvs pvs{};
+		VgetGpuProfiler gpuProfiler{ vgetDevice, VgetSwapChain::MAX_FRAMES_IN_FLIGHT };	// замеры времени GPU по системам рендера
+		VgetPassRecorder passRecorder{ vgetDevice, jobSystem, VgetSwapChain::MAX_FRAMES_IN_FLIGHT };	// пулы и вторичные буферы команд потоков
 	};
 }
\ No newline at end of file
@@ -23,8 +23,8 @@ namespace vget
 			int mouseCamera = GLFW_MOUSE_BUTTON_RIGHT;
 		};
 
-		// gameObject - ссылка на контроллируемый объект
-		void moveInPlaneXZ(GLFWwindow* window, float dt, VgetGameObject& gameObject);
+		// transform - трансформация контроллируемого объекта
+		void moveInPlaneXZ(GLFWwindow* window, float dt, TransformComponent& transform);
 
 		KeyMappings keys{};
 		double halfWidth;
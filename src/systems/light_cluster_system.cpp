@@ -0,0 +1,87 @@
+#include "light_cluster_system.hpp"
+
+#include "../vget_swap_chain.hpp"
+#include "../vget_cpu_profiler.hpp"
+#include "../vget_render_stats.hpp"
+
+// std
+#include <cstring>
+
+namespace vget
+{
+	namespace
+	{
+		// Минимальная вместимость буфера в элементах: пустой буфер создать нельзя
+		constexpr size_t MIN_BUFFER_CAPACITY = 64;
+	}
+
+	LightClusterSystem::LightClusterSystem(VgetDevice& device, VgetDescriptorSetLayout& globalSetLayout, VgetDescriptorPool& globalPool)
+		: vgetDevice{ device }, globalSetLayout{ globalSetLayout }, globalPool{ globalPool }
+	{
+		frameBuffers.resize(VgetSwapChain::MAX_FRAMES_IN_FLIGHT);
+	}
+
+	bool LightClusterSystem::reserve(std::unique_ptr<VgetBuffer>& buffer, VkDeviceSize elementSize, size_t count)
+	{
+		if (buffer != nullptr && buffer->getInstanceCount() >= count) return false;
+
+		size_t capacity = MIN_BUFFER_CAPACITY;
+		while (capacity < count) capacity *= 2;
+
+		// Старый буфер этого кадра больше не используется GPU: beginFrame() дождался его fence
+		buffer = std::make_unique<VgetBuffer>(
+			vgetDevice,
+			elementSize,
+			static_cast<uint32_t>(capacity),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+			1,
+			MemoryTag{ MemoryCategory::Storage, "LightClusterSystem" }
+		);
+		buffer->map();
+		return true;
+	}
+
+	void LightClusterSystem::upload(VgetBuffer& buffer, const void* data, VkDeviceSize size)
+	{
+		if (size == 0) return;
+		std::memcpy(buffer.getMappedMemory(), data, static_cast<size_t>(size));
+		buffer.flush();
+		VgetRenderStats::add(RenderCounter::UploadBytes, size);
+	}
+
+	void LightClusterSystem::update(FrameInfo& frameInfo, const std::vector<PointLight>& lights, VkExtent2D extent, GlobalUbo& ubo)
+	{
+		VGET_PROFILE_ZONE("LightClusterSystem::update");
+		clusters.build(ubo.view, ubo.projection, lights);
+
+		const auto& clusterRanges = clusters.getClusterRanges();
+		const auto& lightIndices = clusters.getLightIndices();
+
+		auto& buffers = frameBuffers[frameInfo.frameIndex];
+		bool recreated = reserve(buffers.lights, sizeof(PointLight), lights.size());
+		recreated |= reserve(buffers.clusterRanges, sizeof(glm::uvec2), clusterRanges.size());
+		recreated |= reserve(buffers.lightIndices, sizeof(uint32_t), lightIndices.size());
+
+		upload(*buffers.lights, lights.data(), sizeof(PointLight) * lights.size());
+		upload(*buffers.clusterRanges, clusterRanges.data(), sizeof(glm::uvec2) * clusterRanges.size());
+		upload(*buffers.lightIndices, lightIndices.data(), sizeof(uint32_t) * lightIndices.size());
+
+		if (recreated)
+		{
+			auto lightsInfo = buffers.lights->descriptorInfo();
+			auto clusterRangesInfo = buffers.clusterRanges->descriptorInfo();
+			auto lightIndicesInfo = buffers.lightIndices->descriptorInfo();
+
+			VgetDescriptorWriter(globalSetLayout, globalPool)
+				.writeBuffer(LIGHTS_BINDING, &lightsInfo)
+				.writeBuffer(CLUSTER_RANGES_BINDING, &clusterRangesInfo)
+				.writeBuffer(LIGHT_INDICES_BINDING, &lightIndicesInfo)
+				.overwrite(frameInfo.globalDescriptorSet);
+		}
+
+		ubo.clusterDepthParams = clusters.getDepthSliceParams();
+		ubo.screenSize = glm::vec4{ static_cast<float>(extent.width), static_cast<float>(extent.height), 0.f, 0.f };
+		ubo.numLights = static_cast<int>(lights.size());
+	}
+}
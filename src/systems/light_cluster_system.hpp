@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../vget_device.hpp"
+#include "../vget_buffer.hpp"
+#include "../vget_descriptors.hpp"
+#include "../vget_frame_info.hpp"
+#include "../vget_light_clusters.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace vget
+{
+	// Система кластерного освещения. Каждый кадр раскладывает точечные источники света по кластерам пирамиды
+	// видимости камеры и загружает источники, диапазоны кластеров и списки индексов в SSBO глобального набора
+	// дескрипторов (bindings 1, 2, 3). Буферы у каждого кадра свои и растут по степеням двойки, поэтому количество
+	// источников света не ограничено, а дескрипторы перезаписываются только при пересоздании буферов.
+	class LightClusterSystem
+	{
+	public:
+		static constexpr uint32_t LIGHTS_BINDING = 1;
+		static constexpr uint32_t CLUSTER_RANGES_BINDING = 2;
+		static constexpr uint32_t LIGHT_INDICES_BINDING = 3;
+
+		LightClusterSystem(VgetDevice& device, VgetDescriptorSetLayout& globalSetLayout, VgetDescriptorPool& globalPool);
+
+		LightClusterSystem(const LightClusterSystem&) = delete;
+		LightClusterSystem& operator=(const LightClusterSystem&) = delete;
+
+		void update(FrameInfo& frameInfo, const std::vector<PointLight>& lights, VkExtent2D extent, GlobalUbo& ubo);
+
+		const VgetLightClusters& getClusters() const { return clusters; }
+
+	private:
+		struct FrameBuffers
+		{
+			std::unique_ptr<VgetBuffer> lights;
+			std::unique_ptr<VgetBuffer> clusterRanges;
+			std::unique_ptr<VgetBuffer> lightIndices;
+		};
+
+		// Пересоздание буфера, если в нём не помещается count элементов. Возвращает true, если буфер пересоздан.
+		bool reserve(std::unique_ptr<VgetBuffer>& buffer, VkDeviceSize elementSize, size_t count);
+		static void upload(VgetBuffer& buffer, const void* data, VkDeviceSize size);
+
+		VgetDevice& vgetDevice;
+		VgetDescriptorSetLayout& globalSetLayout;
+		VgetDescriptorPool& globalPool;
+
+		VgetLightClusters clusters{};
+		std::vector<FrameBuffers> frameBuffers;
+	};
+}
@@ -1,5 +1,9 @@
 #include "point_light_system.hpp"
 
+#include "../vget_swap_chain.hpp"
+#include "../vget_cpu_profiler.hpp"
+#include "../vget_render_stats.hpp"
+
 // libs
 #define GLM_FORCE_RADIANS			  // Функции GLM будут работать с радианами, а не градусами
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE   // GLM будет ожидать интервал нашего буфера глубины от 0 до 1 (например, для OpenGL используется интервал от -1 до 1)
@@ -10,22 +14,16 @@
 #include <stdexcept>
 #include <cassert>
 #include <array>
-#include <map>
+#include <cstddef>
 
 namespace vget
 {
-	struct PointLightPushConstants
-	{
-		glm::vec4 position{};
-		glm::vec4 color{};
-		float radius{};
-	};
-
 	PointLightSystem::PointLightSystem(VgetDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
 		: vgetDevice{device}
 	{
 		createPipelineLayout(globalSetLayout);
 		createPipeline(renderPass);
+		instanceBuffers.resize(VgetSwapChain::MAX_FRAMES_IN_FLIGHT);
 	}
 
 	PointLightSystem::~PointLightSystem()
@@ -35,12 +33,6 @@ namespace vget
 
 	void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
 	{
-		// описание диапазона пуш-констант
-		VkPushConstantRange pushConstantRange{};
-		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT; // доступ к данным констант из обоих шейдеров
-		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(PointLightPushConstants);
-
 		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout}; // вектор используемых схем для наборов дескрипторов
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
@@ -49,9 +41,9 @@ namespace vget
 		// Это могут быть текстуры или Uniform Buffer объекты.
 		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-		// PushConstant'ы используются для передачи в шейдерные программы небольшого количества данных.
-		pipelineLayoutInfo.pushConstantRangeCount = 1;
-		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+		// Данные билбордов приходят из буфера экземпляров, поэтому пуш-константы не используются
+		pipelineLayoutInfo.pushConstantRangeCount = 0;
+		pipelineLayoutInfo.pPushConstantRanges = nullptr;
 		if (vkCreatePipelineLayout(vgetDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
 		{
 			throw std::runtime_error("failed to create pipeline layout!");
@@ -65,8 +57,12 @@ namespace vget
 		PipelineConfigInfo pipelineConfig{};
 		VgetPipeline::defaultPipelineConfigInfo(pipelineConfig);
 		VgetPipeline::enableAlphaBlending(pipelineConfig);
-		pipelineConfig.bindingDescriptions.clear();   // массивы с привязками и атрибутами буфера вершин очищаем, т.к.
-		pipelineConfig.attributeDescriptions.clear(); // они не нужны в PointLightSystem с билбордами
+		// Вершины билборда генерируются в шейдере, а из буфера читаются только данные экземпляров (по одному на билборд)
+		pipelineConfig.bindingDescriptions = { {0, sizeof(BillboardInstance), VK_VERTEX_INPUT_RATE_INSTANCE} };
+		pipelineConfig.attributeDescriptions = {
+			{0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(BillboardInstance, position)},
+			{1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(BillboardInstance, color)}
+		};
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
 
@@ -77,8 +73,9 @@ namespace vget
 			pipelineConfig);
 	}
 
-	void PointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo)
+	void PointLightSystem::update(FrameInfo& frameInfo)
 	{
+		VGET_PROFILE_ZONE("PointLightSystem::update");
 		// матрица преобразования для вращения объектов точечного света
 		auto rotateLight = glm::rotate(
 			glm::mat4(1.f),	 // инициализируем единичную матрицу
@@ -86,81 +83,98 @@ namespace vget
 			{0.f, -1.f, 0.f} // ось вращения (y == -1, значит вращение вокруг Up-вектора)
 		);
 
-		int lightIndex = 0;
-		for (auto& kv : frameInfo.gameObjects)
-		{
-			auto& obj = kv.second;
-			if (obj.pointLight == nullptr) continue;
-
-			assert(lightIndex < MAX_LIGHTS && "Point Lights exceed maximum specified");
-
-			// todo: IF carouselEnabled == true { обновление позиции }
-
-			// обновление позиции PointLight'а в карусели, если она включена
-			if (obj.pointLight->carouselEnabled == true)
-				obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
-
-			// копируем текущие данные об объекте Point Light'а в Ubo структуру
-			ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
-			ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-
-			lightIndex += 1;
-		}
-
-		ubo.numLights = lightIndex;
+		// Перебираются только чанки сущностей с компонентом точечного света, а не вся сцена
+		auto& lights = this->lights[frameInfo.snapshotIndex];
+		auto& billboards = this->billboards[frameInfo.snapshotIndex];
+		lights.clear();
+		billboards.clear();
+		frameInfo.world.forEach<TransformComponent, PointLightComponent>(
+			[&](Entity entity, TransformComponent& transform, PointLightComponent& pointLight)
+			{
+				// обновление позиции PointLight'а в карусели, если она включена
+				if (pointLight.carouselEnabled == true)
+				{
+					transform.translation = glm::vec3(rotateLight * glm::vec4(transform.translation, 1.f));
+					frameInfo.world.markChanged<TransformComponent>(entity);
+				}
+
+				// Радиус влияния: расстояние, на котором освещённость intensity / d^2 падает до LIGHT_CUTOFF
+				const float maxColor = glm::max(pointLight.color.x, glm::max(pointLight.color.y, pointLight.color.z));
+				const float radius = glm::sqrt(glm::max(pointLight.lightIntensity * maxColor, 0.f) / LIGHT_CUTOFF);
+
+				// копируем текущие данные об объекте Point Light'а в буфер источников света
+				PointLight light{};
+				light.position = glm::vec4(transform.translation, radius);
+				light.color = glm::vec4(pointLight.color, pointLight.lightIntensity);
+				lights.push_back(light);
+
+				BillboardInstance instance{};
+				instance.position = glm::vec4(transform.translation, transform.scale.x);
+				instance.color = glm::vec4(pointLight.color, pointLight.lightIntensity);
+				billboards.add(instance);
+			});
+
+		// Сортировка билбордов по дистанции до камеры для поочерёдного порядка их отрисовки, начиная с дальних.
+		// Это нужно для дальнейшего правильного смешивания цветов в ColorBlend этапе.
+		billboards.sortBackToFront(frameInfo.camera.getPosition());
 	}
 
-	void PointLightSystem::render(FrameInfo& frameInfo)
+	void PointLightSystem::reserveInstanceBuffer(int frameIndex, size_t count)
 	{
-		// Автоматическа сортировка PointLight'ов в мапе по их дистанции до камеры.
-		// Это нужно для поочерёдного порядка их отрисовки, начиная с дальних билбордов,
-		// а затем для их дальнейшего правильного смешивания цветов в ColorBlend этапе.
-		std::map<float, VgetGameObject::id_t> sorted;
-		for (auto& kv : frameInfo.gameObjects)
-		{
-			auto& obj = kv.second;
-			if (obj.pointLight == nullptr) continue;
-
-			// вычисление дистанции до камеры
-			auto offset = frameInfo.camera.getPosition() - obj.transform.translation;
-			float disSquared = glm::dot(offset, offset);
-			sorted[disSquared] = obj.getId();
-		}
+		auto& buffer = instanceBuffers[frameIndex];
+		if (buffer != nullptr && buffer->getInstanceCount() >= count) return;
 
-		// render objects
-		vgetPipeline->bind(frameInfo.commandBuffer);  // прикрепление графического пайплайна к буферу команд
+		uint32_t capacity = 64;
+		while (capacity < count) capacity *= 2;
 
-		// привязываем набор дескрипторов к пайплайну
-		vkCmdBindDescriptorSets(
-			frameInfo.commandBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipelineLayout,
-			0,
+		buffer = std::make_unique<VgetBuffer>(
+			vgetDevice,
+			sizeof(BillboardInstance),
+			capacity,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
 			1,
-			&frameInfo.globalDescriptorSet,
-			0,
-			nullptr
+			MemoryTag{ MemoryCategory::Vertex, "PointLightSystem billboards" }
 		);
+		buffer->map();
+	}
 
-		// Отрисовываем билборды поинт лайтов в обратном порядке (от самого дальнего, до самого близкого к камере)
-		for (auto it = sorted.rbegin(); it != sorted.rend(); ++it)
+	void PointLightSystem::render(FrameInfo& frameInfo)
+	{
+		VGET_PROFILE_ZONE("PointLightSystem::render");
+		const auto& billboards = this->billboards[frameInfo.snapshotIndex];
+		if (billboards.empty()) return;
+
+		// Отсортированные билборды записываются сразу в буфер экземпляров текущего кадра
+		reserveInstanceBuffer(frameInfo.frameIndex, billboards.size());
+		auto& instanceBuffer = *instanceBuffers[frameInfo.frameIndex];
+		billboards.copySorted(static_cast<BillboardInstance*>(instanceBuffer.getMappedMemory()));
+		instanceBuffer.flush();
+		VgetRenderStats::add(RenderCounter::UploadBytes, billboards.size() * sizeof(BillboardInstance));
+
+		// Одна инстансированная отрисовка - один вторичный буфер
+		frameInfo.passRecorder.record(1, 1, [&](VgetCommandRecorder& recorder, uint32_t, uint32_t)
 		{
-			auto& obj = frameInfo.gameObjects.at(it->second);
-
-			PointLightPushConstants push{};
-			push.position = glm::vec4(obj.transform.translation, 1.f);
-			push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-			push.radius = obj.transform.scale.x;
+			// render objects
+			vgetPipeline->bind(recorder);  // прикрепление графического пайплайна к буферу команд
 
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
+			// привязываем набор дескрипторов к пайплайну
+			recorder.bindDescriptorSets(
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
 				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				0,
-				sizeof(PointLightPushConstants),
-				&push
+				1,
+				&frameInfo.globalDescriptorSet,
+				0,
+				nullptr
 			);
-			vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
-		}
+
+			VkBuffer buffers[] = { instanceBuffer.getBuffer() };
+			VkDeviceSize offsets[] = { 0 };
+			recorder.bindVertexBuffers(0, 1, buffers, offsets);
+
+			// Все билборды поинт лайтов рисуются одной командой: 6 вершин на экземпляр в порядке от дальних к ближним
+			recorder.draw(6, static_cast<uint32_t>(billboards.size()), 0, 0);
+		});
 	}
 }
\ No newline at end of file
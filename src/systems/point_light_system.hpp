@@ -5,8 +5,11 @@
 #include "../vget_game_object.hpp"
 #include "../vget_camera.hpp"
 #include "../vget_frame_info.hpp"
+#include "../vget_buffer.hpp"
+#include "../vget_billboards.hpp"
 
 // std
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -23,16 +26,30 @@ namespace vget
 		PointLightSystem(const PointLightSystem&) = delete;
 		PointLightSystem& operator=(const PointLightSystem&) = delete;
 
-		void update(FrameInfo& frameInfo, GlobalUbo& ubo);
+		// Освещённость, ниже которой вклад источника света отбрасывается. Определяет радиус влияния источника.
+		static constexpr float LIGHT_CUTOFF = .01f;
+
+		// Поток обновления: движение источников в карусели, сбор источников света и билбордов в снимок кадра
+		void update(FrameInfo& frameInfo);
+		// Поток рендера: загрузка билбордов снимка в буфер экземпляров кадра и их отрисовка
 		void render(FrameInfo& frameInfo);
 
+		// Источники света снимка кадра для раскладки по кластерам (заполняются в update())
+		const std::vector<PointLight>& getLights(uint32_t snapshotIndex) const { return lights[snapshotIndex]; }
+
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void createPipeline(VkRenderPass renderPass);
+		// Буфер экземпляров кадра растёт по степеням двойки; старый буфер этого кадра GPU уже не использует
+		void reserveInstanceBuffer(int frameIndex, size_t count);
 
 		VgetDevice& vgetDevice;
 
 		std::unique_ptr<VgetPipeline> vgetPipeline;
 		VkPipelineLayout pipelineLayout;
+
+		std::array<std::vector<PointLight>, VgetFramePipeline::SNAPSHOT_COUNT> lights;
+		std::array<VgetBillboardBatch, VgetFramePipeline::SNAPSHOT_COUNT> billboards;	// отсортированы от дальних к ближним
+		std::vector<std::unique_ptr<VgetBuffer>> instanceBuffers;	// по буферу экземпляров на каждый кадр в полёте
 	};
 }
\ No newline at end of file
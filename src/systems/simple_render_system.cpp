@@ -1,4 +1,5 @@
 #include "simple_render_system.hpp"
+#include "../vget_cpu_profiler.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS			  // Функции GLM будут работать с радианами, а не градусами
@@ -73,46 +74,110 @@ namespace vget
 			pipelineConfig);
 	}
 
-	void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo)
+	void SimpleRenderSystem::prepare(FrameInfo& frameInfo)
 	{
-		// render objects
-		vgetPipeline->bind(frameInfo.commandBuffer);  // прикрепление графического пайплайна к буферу команд
-
-		// привязываем набор дескрипторов к пайплайну
-		vkCmdBindDescriptorSets(
-			frameInfo.commandBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipelineLayout,
-			0,
-			1,
-			&frameInfo.globalDescriptorSet,
-			0,
-			nullptr
-		);
-
-		for (auto& kv : frameInfo.gameObjects)
+		VGET_PROFILE_ZONE("SimpleRenderSystem::prepare");
+		// Грубый отбор по толстым объёмам иерархии сцены: поддеревья вне пирамиды видимости отбрасываются целиком
+		const Frustum frustum = frameInfo.camera.getFrustum();
+		treeQueryResult.clear();
+		frameInfo.sceneTree.queryFrustum(frustum, treeQueryResult);
+
+		// Сбор объектов этой системы и их точных ограничивающих объёмов в мировом пространстве
+		cullingBatch.clear();
+		candidates.clear();
+		candidateBoxes.clear();
+		for (auto id : treeQueryResult)
 		{
-			auto& obj = kv.second; // ссылка на объект из мапы
+			const Entity entity = frameInfo.world.entityAt(id);
+			auto* transform = frameInfo.world.getComponent<TransformComponent>(entity);
+			auto* model = frameInfo.world.getComponent<ModelComponent>(entity);
 
 			// В данной системе рендерятся только объекты с моделями без материала (и, соответственно, текстур)
-			if (obj.model == nullptr || obj.model->getTextures().size() != 0) continue;
+			if (transform == nullptr || model == nullptr || model->model->getTextures().size() != 0) continue;
 
-			SimplePushConstantData push{};
-			push.modelMatrix = obj.transform.mat4();
-			push.normalMatrix = obj.transform.normalMatrix();
+			candidateBoxes.push_back(model->model->getBoundingBox().transformed(transform->worldMatrix));
+			cullingBatch.add(candidateBoxes.back());
+			candidates.push_back(Candidate{ id, transform, model->model.get() });
+		}
 
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				pipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(SimplePushConstantData),
-				&push);
+		// Пакетная проверка точных объёмов на пересечение с пирамидой видимости камеры.
+		// Статистика учитывает только объекты, прошедшие отбор по дереву.
+		cullingStats = cullingBatch.cull(frustum, visibility);
 
-			// прикрепление буфера вершин (модели) и буфера индексов к буферу команд (создание привязки)
-			obj.model->bind(frameInfo.commandBuffer);
-			// отрисовка буфера вершин
-			obj.model->draw(frameInfo.commandBuffer);
+		// Видимые объекты попадают в очередь отрисовки, отсортированную по модели и от ближних к дальним
+		const glm::mat4 viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+		drawQueue.clear();
+		for (size_t i = 0; i < candidates.size(); ++i)
+		{
+			if (!visibility[i]) continue;
+			if (!frameInfo.pvs.isObjectVisible(candidates[i].id))
+			{
+				--cullingStats.visible;
+				++cullingStats.pvsCulled;
+				continue;
+			}
+			if (frameInfo.occlusionCuller.isOccluded(candidateBoxes[i]))
+			{
+				--cullingStats.visible;
+				++cullingStats.occluded;
+				continue;
+			}
+			const float depth = DrawKey::depth(viewProjection, candidateBoxes[i].center());
+			drawQueue.add(DrawKey::make(PIPELINE_SORT_ID, 0, candidates[i].model->getId(), depth), static_cast<uint32_t>(i));
 		}
+		drawQueue.sort();
+
+		auto& draws = preparedDraws[frameInfo.snapshotIndex];
+		draws.clear();
+		for (const auto& packet : drawQueue.getPackets())
+		{
+			const auto& candidate = candidates[packet.index];
+			draws.push_back(Draw{ candidate.model, candidate.transform->worldMatrix, candidate.transform->worldNormalMatrix });
+		}
+	}
+
+	void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo)
+	{
+		VGET_PROFILE_ZONE("SimpleRenderSystem::renderGameObjects");
+		// Отсортированные отрисовки делятся на непрерывные диапазоны, каждый пишется своим потоком во вторичный буфер
+		const auto& draws = preparedDraws[frameInfo.snapshotIndex];
+		frameInfo.passRecorder.record(static_cast<uint32_t>(draws.size()), VgetPassRecorder::MIN_DRAWS_PER_BUFFER,
+			[&](VgetCommandRecorder& recorder, uint32_t begin, uint32_t end)
+		{
+			// render objects
+			vgetPipeline->bind(recorder);  // прикрепление графического пайплайна к буферу команд
+
+			// привязываем набор дескрипторов к пайплайну
+			recorder.bindDescriptorSets(
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				pipelineLayout,
+				0,
+				1,
+				&frameInfo.globalDescriptorSet,
+				0,
+				nullptr
+			);
+
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				const Draw& draw = draws[i];
+
+				SimplePushConstantData push{};
+				push.modelMatrix = draw.modelMatrix;
+				push.normalMatrix = draw.normalMatrix;
+
+				recorder.pushConstants(
+					pipelineLayout,
+					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+					0,
+					sizeof(SimplePushConstantData),
+					&push);
+
+				// прикрепление буфера вершин (модели) и буфера индексов к буферу команд (создание привязки)
+				draw.model->bind(recorder);
+				// отрисовка буфера вершин
+				draw.model->draw(recorder);
+			}
+		});
 	}
 }
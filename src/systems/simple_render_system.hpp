@@ -5,8 +5,11 @@
 #include "../vget_game_object.hpp"
 #include "../vget_camera.hpp"
 #include "../vget_frame_info.hpp"
+#include "../vget_culling.hpp"
+#include "../vget_draw_queue.hpp"
 
 // std
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -15,6 +18,8 @@ namespace vget
 	class SimpleRenderSystem
 	{
 	public:
+		static constexpr uint32_t PIPELINE_SORT_ID = 0;	// поле пайплайна в ключах сортировки отрисовок
+
 		SimpleRenderSystem(VgetDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
 		~SimpleRenderSystem();
 
@@ -23,8 +28,15 @@ namespace vget
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
+		// Подготовка снимка кадра в потоке обновления: отсечение и сортировка объектов, копирование их матриц.
+		// Из frameInfo используются только камера, мир, иерархия объёмов, окклюдеры, PVS и индекс снимка.
+		void prepare(FrameInfo& frameInfo);
+		// Запись отрисовок подготовленного снимка frameInfo.snapshotIndex (поток рендера)
 		void renderGameObjects(FrameInfo& frameInfo);
 
+		const CullingStats& getCullingStats() const { return cullingStats; }
+		const DrawStats& getDrawStats() const { return drawQueue.getStats(); }
+
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void createPipeline(VkRenderPass renderPass);
@@ -33,5 +45,31 @@ namespace vget
 
 		std::unique_ptr<VgetPipeline> vgetPipeline;
 		VkPipelineLayout pipelineLayout;
+
+		// Данные отсечения переиспользуются между кадрами, чтобы не выделять память каждый кадр
+		CullingBatch cullingBatch;
+		std::vector<uint8_t> visibility;
+		// Компоненты сущности-кандидата на отрисовку (действительны до конца кадра)
+		struct Candidate
+		{
+			uint32_t id;	// индекс сущности
+			TransformComponent* transform;
+			VgetModel* model;
+		};
+		std::vector<Candidate> candidates;
+		std::vector<Aabb> candidateBoxes;
+		std::vector<uint32_t> treeQueryResult;
+		CullingStats cullingStats{};
+		VgetDrawQueue drawQueue;
+
+		// Отрисовка снимка кадра в порядке очереди. Матрицы скопированы, поэтому поток обновления может менять
+		// трансформации следующего кадра, пока поток рендера записывает этот.
+		struct Draw
+		{
+			VgetModel* model;
+			glm::mat4 modelMatrix;
+			glm::mat4 normalMatrix;
+		};
+		std::array<std::vector<Draw>, VgetFramePipeline::SNAPSHOT_COUNT> preparedDraws;
 	};
 }
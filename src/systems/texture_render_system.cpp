@@ -1,5 +1,7 @@
 #include "texture_render_system.hpp"
+#include "../vget_cpu_profiler.hpp"
 #include "../vget_buffer.hpp"
+#include "../vget_texture_table.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS			  // Функции GLM будут работать с радианами, а не градусами
@@ -12,6 +14,7 @@
 #include <cassert>
 #include <array>
 #include <iostream>
+#include <cstddef>
 
 namespace vget
 {
@@ -22,15 +25,15 @@ namespace vget
 		glm::mat4 normalMatrix{1.f};
 		// далее идёт превышение минимально возможного размера данных для пуш константы => в потенциале нужно исправить этот момент
 		int textureIndex;
+		int samplerIndex;	// SamplerPreset, занимает выравнивание перед diffuseColor
 		alignas(16) glm::vec3 diffuseColor{};
 	};
 
-	TextureRenderSystem::TextureRenderSystem(VgetDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, FrameInfo frameInfo)
+	TextureRenderSystem::TextureRenderSystem(VgetDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
 		: vgetDevice{ device }
 	{
 		createUboBuffers();
-		fillModelsIds(frameInfo.gameObjects);
-		createDescriptorSets(frameInfo);
+		createDescriptorSets();
 		createPipelineLayout(globalSetLayout);
 		createPipeline(renderPass);
 	}
@@ -48,8 +51,11 @@ namespace vget
 		pushConstantRange.offset = 0;
 		pushConstantRange.size = sizeof(TextureSystemPushConstantData);
 
-		// вектор используемых схем для наборов дескрипторов
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, systemDescriptorSetLayout->getDescriptorSetLayout()};
+		// вектор используемых схем для наборов дескрипторов: глобальный, системный и таблица текстур
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{
+			globalSetLayout,
+			systemDescriptorSetLayout->getDescriptorSetLayout(),
+			vgetDevice.getTextureTable().getDescriptorSetLayout()};
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -75,10 +81,11 @@ namespace vget
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = pipelineLayout;
 
+		// Вариант шейдера фрагментов собирается из того же исходника с VGET_SEPARATE_SAMPLERS и должен совпадать со схемой таблицы текстур
 		vgetPipeline = std::make_unique<VgetPipeline>(
 			vgetDevice,
 			"./shaders/texture_shader.vert.spv",
-			"./shaders/texture_shader.frag.spv",
+			VgetTextureTable::SEPARATE_SAMPLERS ? "./shaders/texture_shader_separate.frag.spv" : "./shaders/texture_shader.frag.spv",
 			pipelineConfig);
 	}
 
@@ -91,76 +98,56 @@ namespace vget
 				sizeof(TextureSystemUbo),
 				1,
 				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				1,
+				MemoryTag{ MemoryCategory::Uniform, "TextureRenderSystem" }
 				);
 			uboBuffers[i]->map();
 		}
 	}
 
-	int TextureRenderSystem::fillModelsIds(VgetGameObject::Map& gameObjects)
+	bool TextureRenderSystem::syncModelEntities(VgetWorld& world)
 	{
-		modelObjectsIds.clear();
-		for (auto& kv : gameObjects)
+		const uint64_t version = world.getComponentVersion<ModelComponent>();
+		if (modelEntitiesVersion == version) return false;
+
+		modelEntities.clear();
+		world.forEach<TransformComponent, ModelComponent>([&](Entity entity, TransformComponent&, ModelComponent& model)
 		{
-			auto& obj = kv.second; // ссылка на объект из мапы
-			if (obj.model != nullptr && obj.model->getTextures().size() != 0) {
-				modelObjectsIds.push_back(kv.first); // в этой системе рендерятся только объекты с текстурами
-			}
-		}
-		return static_cast<int>(modelObjectsIds.size());
+			if (model.model->getTextures().size() != 0) modelEntities.push_back(entity);
+		});
+		modelEntitiesVersion = version;
+		return true;
 	}
 
-	void TextureRenderSystem::createDescriptorSets(FrameInfo& frameInfo)
+	void TextureRenderSystem::resolveModelObjects(VgetWorld& world)
 	{
-		int texturesCount = 0;
-		std::vector<VkDescriptorImageInfo> descriptorImageInfos;
-
-		for (auto& id : modelObjectsIds)
+		modelObjects.clear();
+		for (const Entity entity : modelEntities)
 		{
-			texturesCount += frameInfo.gameObjects[id].model->getTextures().size();
-
-			// Заполнение инфорамации по дескрипторам текстур для каждой модели
-			// todo сделать рефактор
-			for (auto& texture : frameInfo.gameObjects.at(id).model->getTextures())
-			{
-				if (texture != nullptr)
-				{
-					auto& imageInfo = texture->descriptorInfo();
-					descriptorImageInfos.push_back(imageInfo);
-				}
-				else
-				{
-					// todo: добавление объектов с текстурами не будет корректно работать, пока не будет исправлен этот момент
-					descriptorImageInfos.push_back(frameInfo.gameObjects.at(id).model->getTextures().at(0)->descriptorInfo());
-				}
-			}
+			modelObjects.push_back(ModelObject{
+				entity.index,
+				world.getComponent<TransformComponent>(entity),
+				world.getComponent<ModelComponent>(entity)->model.get() });
 		}
+	}
 
+	void TextureRenderSystem::createDescriptorSets()
+	{
 		systemDescriptorPool = VgetDescriptorPool::Builder(vgetDevice)
 			.setMaxSets(VgetSwapChain::MAX_FRAMES_IN_FLIGHT)
 			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VgetSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VgetSwapChain::MAX_FRAMES_IN_FLIGHT * texturesCount)
-			//.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VgetSwapChain::MAX_FRAMES_IN_FLIGHT * 1000)
 			.build();
 
 		systemDescriptorSetLayout = VgetDescriptorSetLayout::Builder(vgetDevice)
 			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
-			.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, texturesCount)
-			//.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1000)
 			.build();
 
 		for (int i = 0; i < systemDescriptorSets.size(); ++i)
 		{
-			// Запись количества текстур для каждого ubo буфера
-			TextureSystemUbo ubo{};
-			ubo.texturesCount = texturesCount;
-			uboBuffers[i]->writeToBuffer(&ubo);
-
 			auto bufferInfo = uboBuffers[i]->descriptorInfo();
-
 			VgetDescriptorWriter(*systemDescriptorSetLayout, *systemDescriptorPool)
 				.writeBuffer(0, &bufferInfo)
-				.writeImage(1, descriptorImageInfos.data(), texturesCount)
 				.build(systemDescriptorSets[i]);
 		}
 	}
@@ -170,67 +157,174 @@ namespace vget
 		uboBuffers[frameInfo.frameIndex]->writeToBuffer(&ubo);
 	}
 
-	void TextureRenderSystem::renderGameObjects(FrameInfo& frameInfo)
+	void TextureRenderSystem::prepare(FrameInfo& frameInfo)
 	{
-		vgetPipeline->bind(frameInfo.commandBuffer);  // прикрепление графического пайплайна к буферу команд
+		VGET_PROFILE_ZONE("TextureRenderSystem::prepare");
+		// Если состав сущностей с моделями изменился, то список объектов с текстурами пересоздаётся
+		syncModelEntities(frameInfo.world);
+		resolveModelObjects(frameInfo.world);
 
-		// Заполняется вектор id'шников объектов с текстурами и
-		// если их кол-во изменилось, то наборы дескрипторов для этих
-		// объектов пересоздаются.
-		if (prevModelCount != fillModelsIds(frameInfo.gameObjects)) {
-			createDescriptorSets(frameInfo);
+		// Первый проход отсечения - ограничивающие объёмы целых моделей
+		const Frustum frustum = frameInfo.camera.getFrustum();
+		objectCullingBatch.clear();
+		for (auto& obj : modelObjects)
+		{
+			objectCullingBatch.add(obj.model->getBoundingBox().transformed(obj.transform->worldMatrix));
 		}
-		prevModelCount = modelObjectsIds.size();
-
-		std::vector<VkDescriptorSet> descriptorSets{ frameInfo.globalDescriptorSet, systemDescriptorSets[frameInfo.frameIndex] };
-		// Привязываем наборы дескрипторов к пайплайну
-		vkCmdBindDescriptorSets(
-			frameInfo.commandBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			pipelineLayout,
-			0,
-			2,
-			descriptorSets.data(),
-			0,
-			nullptr
-		);
-
-		int textureIndexOffset = 0; // отступ в массиве текстур для текущего объекта
-		for (auto& id : modelObjectsIds)
+		objectCullingBatch.cull(frustum, objectVisibility);
+
+		// Второй проход - объёмы подобъектов видимых моделей. Подобъекты отсечённых моделей сразу идут в статистику.
+		cullingStats = CullingStats{};
+		subObjectCullingBatch.clear();
+		subObjectBoxes.clear();
+		for (size_t i = 0; i < modelObjects.size(); ++i)
 		{
-			auto& obj = frameInfo.gameObjects[id];
+			auto& obj = modelObjects[i];
+			if (!objectVisibility[i])
+			{
+				cullingStats.culled += static_cast<uint32_t>(obj.model->getSubObjectsInfo().size());
+				continue;
+			}
+			for (auto& info : obj.model->getSubObjectsInfo())
+			{
+				subObjectBoxes.push_back(info.bounds.transformed(obj.transform->worldMatrix));
+				subObjectCullingBatch.add(subObjectBoxes.back());
+			}
+		}
+		cullingStats += subObjectCullingBatch.cull(frustum, subObjectVisibility);
 
-			TextureSystemPushConstantData push{};
-			push.modelMatrix = obj.transform.mat4();
-			push.normalMatrix = obj.transform.normalMatrix();
+		// Третий проход - видимые подобъекты проверяются по PVS текущей ячейки, а затем по пирамиде глубины окклюдеров
+		size_t batchIndex = 0;
+		for (size_t i = 0; i < modelObjects.size(); ++i)
+		{
+			if (!objectVisibility[i]) continue;
+			const auto subObjectsCount = static_cast<uint32_t>(modelObjects[i].model->getSubObjectsInfo().size());
+			for (uint32_t subObject = 0; subObject < subObjectsCount; ++subObject, ++batchIndex)
+			{
+				if (!subObjectVisibility[batchIndex]) continue;
+				if (!frameInfo.pvs.isSubObjectVisible(modelObjects[i].id, subObject))
+				{
+					subObjectVisibility[batchIndex] = 0;
+					--cullingStats.visible;
+					++cullingStats.pvsCulled;
+				}
+				else if (frameInfo.occlusionCuller.isOccluded(subObjectBoxes[batchIndex]))
+				{
+					subObjectVisibility[batchIndex] = 0;
+					--cullingStats.visible;
+					++cullingStats.occluded;
+				}
+			}
+		}
 
-			// Отрисовка каждого подобъекта .obj модели по отдельности с передачей своего индекса текстуры
-			for (auto& info : obj.model->getSubObjectsInfo())
+		// Видимые подобъекты попадают в очередь отрисовки, отсортированную по текстуре, модели и от ближних к дальним
+		const glm::mat4 viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+		drawQueue.clear();
+		subObjectDraws.clear();
+		batchIndex = 0;
+		for (size_t i = 0; i < modelObjects.size(); ++i)
+		{
+			auto& obj = modelObjects[i];
+			if (!objectVisibility[i]) continue;
+
+			auto& subObjectsInfo = obj.model->getSubObjectsInfo();
+			for (uint32_t subObject = 0; subObject < subObjectsInfo.size(); ++subObject, ++batchIndex)
+			{
+				if (!subObjectVisibility[batchIndex]) continue;
+
+				// Слот текстуры в таблице для пуш константы. Если её нет у данного подобъекта, то будет передано -1.
+				const auto& info = subObjectsInfo[subObject];
+				const VgetTexture* texture = obj.model->getTextures().at(info.textureIndex).get();
+				const int textureIndex = texture != nullptr ? static_cast<int>(texture->getSlot()) : -1;
+				const int samplerIndex = texture != nullptr ? static_cast<int>(texture->getSamplerPreset()) : 0;
+
+				const float depth = DrawKey::depth(viewProjection, subObjectBoxes[batchIndex].center());
+				drawQueue.add(
+					DrawKey::make(PIPELINE_SORT_ID, static_cast<uint32_t>(textureIndex + 1), obj.model->getId(), depth),
+					static_cast<uint32_t>(subObjectDraws.size()));
+				subObjectDraws.push_back(SubObjectDraw{ static_cast<uint32_t>(i), subObject, textureIndex, samplerIndex });
+			}
+		}
+		drawQueue.sort();
+
+		PreparedFrame& prepared = preparedFrames[frameInfo.snapshotIndex];
+		prepared.draws.clear();
+		for (const auto& packet : drawQueue.getPackets())
+		{
+			const SubObjectDraw& draw = subObjectDraws[packet.index];
+			const auto& obj = modelObjects[draw.objectIndex];
+			prepared.draws.push_back(Draw{
+				obj.model, draw.subObjectIndex, draw.textureIndex, draw.samplerIndex,
+				obj.transform->worldMatrix, obj.transform->worldNormalMatrix });
+		}
+	}
+
+	void TextureRenderSystem::renderGameObjects(FrameInfo& frameInfo)
+	{
+		VGET_PROFILE_ZONE("TextureRenderSystem::renderGameObjects");
+		const PreparedFrame& prepared = preparedFrames[frameInfo.snapshotIndex];
+
+		// Отрисовка каждого подобъекта .obj модели по отдельности с передачей своего индекса текстуры.
+		// Отсортированные отрисовки делятся на непрерывные диапазоны, каждый пишется своим потоком во вторичный буфер.
+		const auto& draws = prepared.draws;
+		const VkDescriptorSet descriptorSets[] = {
+			frameInfo.globalDescriptorSet,
+			systemDescriptorSets[frameInfo.frameIndex],
+			vgetDevice.getTextureTable().getDescriptorSet() };
+		frameInfo.passRecorder.record(static_cast<uint32_t>(draws.size()), VgetPassRecorder::MIN_DRAWS_PER_BUFFER,
+			[&](VgetCommandRecorder& recorder, uint32_t begin, uint32_t end)
+		{
+			vgetPipeline->bind(recorder);  // прикрепление графического пайплайна к буферу команд
+
+			// Привязываем наборы дескрипторов к пайплайну
+			recorder.bindDescriptorSets(
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				pipelineLayout,
+				0,
+				3,
+				descriptorSets,
+				0,
+				nullptr
+			);
+
+			for (uint32_t i = begin; i < end; ++i)
 			{
-				// Передача в пуш константу индекса текстуры. Если её нет у данного подобъекта, то будет передано -1.
-				if (obj.model->getTextures().at(info.textureIndex) != nullptr)
-					push.textureIndex = textureIndexOffset + info.textureIndex;
-				else
+				const Draw& draw = draws[i];
+				const auto& info = draw.model->getSubObjectsInfo()[draw.subObjectIndex];
+
+				TextureSystemPushConstantData push{};
+				push.modelMatrix = draw.modelMatrix;
+				push.normalMatrix = draw.normalMatrix;
+				push.textureIndex = draw.textureIndex;
+				push.samplerIndex = draw.samplerIndex;
+				if (draw.textureIndex < 0)
 				{
-					push.textureIndex = -1;
-					push.diffuseColor = info.diffuseColor;	
+					push.diffuseColor = info.diffuseColor;
 				}
 
-				vkCmdPushConstants(
-					frameInfo.commandBuffer,
+				// Матрицы объекта и данные материала передаются отдельными диапазонами, чтобы рекордер мог отбросить
+				// повторную передачу матриц у подряд идущих подобъектов одного объекта
+				constexpr uint32_t materialOffset = offsetof(TextureSystemPushConstantData, textureIndex);
+				recorder.pushConstants(
 					pipelineLayout,
 					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 					0,
-					sizeof(TextureSystemPushConstantData),
+					materialOffset,
 					&push
 				);
+				recorder.pushConstants(
+					pipelineLayout,
+					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+					materialOffset,
+					sizeof(TextureSystemPushConstantData) - materialOffset,
+					&push.textureIndex
+				);
 
 				// прикрепление буфера вершин (модели) и буфера индексов к буферу команд (создание привязки)
-				obj.model->bind(frameInfo.commandBuffer);
+				draw.model->bind(recorder);
 				// отрисовка буфера вершин
-				obj.model->drawIndexed(frameInfo.commandBuffer, info.indexCount, info.indexStart);
+				draw.model->drawIndexed(recorder, info.indexCount, info.indexStart);
 			}
-			textureIndexOffset += obj.model->getTextures().size();
-		}
+		});
 	}
 }
\ No newline at end of file
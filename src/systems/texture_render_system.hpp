@@ -7,8 +7,11 @@
 #include "../vget_frame_info.hpp"
 #include "../vget_swap_chain.hpp"
 #include "../vget_descriptors.hpp"
+#include "../vget_culling.hpp"
+#include "../vget_draw_queue.hpp"
 
 // std
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -17,7 +20,9 @@ namespace vget
 	class TextureRenderSystem
 	{
 	public:
-		TextureRenderSystem(VgetDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, FrameInfo frameInfo);
+		static constexpr uint32_t PIPELINE_SORT_ID = 1;	// поле пайплайна в ключах сортировки отрисовок
+
+		TextureRenderSystem(VgetDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
 		~TextureRenderSystem();
 
 		// Избавляемся от copy operator и copy constrcutor, т.к. TextureRenderSystem хранит в себе указатели
@@ -26,27 +31,85 @@ namespace vget
 		TextureRenderSystem& operator=(const TextureRenderSystem&) = delete;
 
 		void update(FrameInfo& frameInfo, TextureSystemUbo& ubo);
+		// Подготовка снимка кадра в потоке обновления: синхронизация списка объектов с миром, отсечение,
+		// сортировка и копирование матриц. Используются только камера, мир, окклюдеры, PVS и индекс снимка.
+		void prepare(FrameInfo& frameInfo);
+		// Запись отрисовок подготовленного снимка frameInfo.snapshotIndex (поток рендера).
+		// Текстуры выбираются по слотам глобальной таблицы текстур девайса, поэтому состав моделей не важен.
 		void renderGameObjects(FrameInfo& frameInfo);
 
+		// Статистика отсечения по подобъектам моделей (объекты вне пирамиды видимости учитываются всеми своими подобъектами)
+		const CullingStats& getCullingStats() const { return cullingStats; }
+		const DrawStats& getDrawStats() const { return drawQueue.getStats(); }
+
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void createPipeline(VkRenderPass renderPass);
 		void createUboBuffers();
 
-		int fillModelsIds(VgetGameObject::Map& gameObjects);
-		void createDescriptorSets(FrameInfo& frameInfo);
+		// Пересборка списка сущностей с текстурированными моделями, если состав сущностей с моделями изменился.
+		// Возвращает true при изменении.
+		bool syncModelEntities(VgetWorld& world);
+		// Получение указателей на компоненты сущностей списка для текущего кадра
+		void resolveModelObjects(VgetWorld& world);
+		// Наборы дескрипторов системы с uniform-буфером каждого кадра; создаются один раз
+		void createDescriptorSets();
 
 		VgetDevice& vgetDevice;
 
 		std::unique_ptr<VgetPipeline> vgetPipeline;
 		VkPipelineLayout pipelineLayout;
 
-		std::vector<VgetGameObject::id_t> modelObjectsIds{};
-		size_t prevModelCount = 0;
+		std::vector<Entity> modelEntities{};	// в этой системе рендерятся только объекты с текстурами
+		uint64_t modelEntitiesVersion = 0;
+
+		struct ModelObject
+		{
+			uint32_t id;	// индекс сущности
+			TransformComponent* transform;
+			VgetModel* model;
+		};
+		std::vector<ModelObject> modelObjects{};	// компоненты modelEntities, действительны до конца кадра
 		std::vector<std::unique_ptr<VgetBuffer>> uboBuffers{ VgetSwapChain::MAX_FRAMES_IN_FLIGHT };
 
 		std::unique_ptr<VgetDescriptorPool> systemDescriptorPool;
 		std::unique_ptr<VgetDescriptorSetLayout> systemDescriptorSetLayout;
 		std::vector<VkDescriptorSet> systemDescriptorSets{ VgetSwapChain::MAX_FRAMES_IN_FLIGHT };
+
+		// Отсечение выполняется в два прохода: сначала по объёмам целых объектов,
+		// затем по объёмам подобъектов только тех объектов, которые оказались видимы.
+		CullingBatch objectCullingBatch;
+		CullingBatch subObjectCullingBatch;
+		std::vector<uint8_t> objectVisibility;
+		std::vector<uint8_t> subObjectVisibility;
+		std::vector<Aabb> subObjectBoxes;
+		CullingStats cullingStats{};
+
+		// Данные отрисовки видимого подобъекта, на которые ссылаются пакеты очереди
+		struct SubObjectDraw
+		{
+			uint32_t objectIndex;	// индекс в modelObjects
+			uint32_t subObjectIndex;
+			int textureIndex;		// слот текстуры в VgetTextureTable, -1 - без текстуры
+			int samplerIndex;		// SamplerPreset текстуры (выбирается шейдером только с раздельными выборщиками)
+		};
+		std::vector<SubObjectDraw> subObjectDraws;
+		VgetDrawQueue drawQueue;
+
+		// Снимок кадра: отрисовки в порядке очереди со скопированными матрицами
+		struct Draw
+		{
+			VgetModel* model;
+			uint32_t subObjectIndex;
+			int textureIndex;
+			int samplerIndex;
+			glm::mat4 modelMatrix;
+			glm::mat4 normalMatrix;
+		};
+		struct PreparedFrame
+		{
+			std::vector<Draw> draws;
+		};
+		std::array<PreparedFrame, VgetFramePipeline::SNAPSHOT_COUNT> preparedFrames;
 	};
 }
\ No newline at end of file
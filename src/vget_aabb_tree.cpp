@@ -0,0 +1,482 @@
+#include "vget_aabb_tree.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+
+namespace vget
+{
+	namespace
+	{
+		// Стек для обхода дерева без рекурсии. Небольшие глубины обходятся без выделения памяти в куче.
+		class TraversalStack
+		{
+		public:
+			void push(int32_t nodeId)
+			{
+				if (count == capacity)
+				{
+					std::vector<int32_t> grown(capacity * 2);
+					std::copy(data, data + count, grown.begin());
+					heapNodes.swap(grown);
+					data = heapNodes.data();
+					capacity *= 2;
+				}
+				data[count++] = nodeId;
+			}
+			int32_t pop() { return data[--count]; }
+			bool empty() const { return count == 0; }
+
+		private:
+			static constexpr size_t INLINE_CAPACITY = 128;
+
+			int32_t inlineNodes[INLINE_CAPACITY];
+			std::vector<int32_t> heapNodes;
+			int32_t* data = inlineNodes;
+			size_t count = 0;
+			size_t capacity = INLINE_CAPACITY;
+		};
+
+		enum class FrustumTest { OUTSIDE, INTERSECTS, INSIDE };
+
+		// В отличие от Frustum::intersects различает полностью видимые объёмы: всё их поддерево принимается без проверок
+		FrustumTest classify(const Frustum& frustum, const Aabb& box)
+		{
+			const glm::vec3 c = box.center();
+			const glm::vec3 e = box.extents();
+			FrustumTest result = FrustumTest::INSIDE;
+			for (const auto& plane : frustum.planes)
+			{
+				const float distance = plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w;
+				const float radius = glm::abs(plane.x) * e.x + glm::abs(plane.y) * e.y + glm::abs(plane.z) * e.z;
+				if (distance + radius < 0.f) return FrustumTest::OUTSIDE;
+				if (distance - radius < 0.f) result = FrustumTest::INTERSECTS;
+			}
+			return result;
+		}
+	}
+
+	VgetAabbTree::VgetAabbTree()
+	{
+		nodes.reserve(64);
+	}
+
+	int32_t VgetAabbTree::allocateNode()
+	{
+		if (freeList == NULL_NODE)
+		{
+			nodes.emplace_back();
+			return static_cast<int32_t>(nodes.size() - 1);
+		}
+
+		const int32_t nodeId = freeList;
+		freeList = nodes[nodeId].parent;
+		nodes[nodeId] = Node{};
+		return nodeId;
+	}
+
+	void VgetAabbTree::freeNode(int32_t nodeId)
+	{
+		nodes[nodeId] = Node{};
+		nodes[nodeId].parent = freeList;
+		nodes[nodeId].height = -1;
+		freeList = nodeId;
+	}
+
+	void VgetAabbTree::clear()
+	{
+		nodes.clear();
+		root = NULL_NODE;
+		freeList = NULL_NODE;
+		proxyCount = 0;
+	}
+
+	int32_t VgetAabbTree::createProxy(const Aabb& box, uint32_t userData)
+	{
+		const int32_t proxyId = allocateNode();
+		const glm::vec3 margin{ AABB_MARGIN };
+		nodes[proxyId].box = Aabb{ box.min - margin, box.max + margin };
+		nodes[proxyId].userData = userData;
+		nodes[proxyId].height = 0;
+
+		insertLeaf(proxyId);
+		++proxyCount;
+		return proxyId;
+	}
+
+	void VgetAabbTree::destroyProxy(int32_t proxyId)
+	{
+		assert(0 <= proxyId && proxyId < static_cast<int32_t>(nodes.size()) && nodes[proxyId].isLeaf() && "Invalid proxy id");
+		removeLeaf(proxyId);
+		freeNode(proxyId);
+		--proxyCount;
+	}
+
+	bool VgetAabbTree::moveProxy(int32_t proxyId, const Aabb& box, const glm::vec3& displacement)
+	{
+		assert(0 <= proxyId && proxyId < static_cast<int32_t>(nodes.size()) && nodes[proxyId].isLeaf() && "Invalid proxy id");
+
+		// Новый толстый AABB вытягивается в сторону движения, чтобы объект дольше оставался внутри него
+		const glm::vec3 margin{ AABB_MARGIN };
+		const glm::vec3 d = DISPLACEMENT_MULTIPLIER * displacement;
+		Aabb fatBox{ box.min - margin, box.max + margin };
+		fatBox.min += glm::min(d, glm::vec3{ 0.f });
+		fatBox.max += glm::max(d, glm::vec3{ 0.f });
+
+		const Aabb& treeBox = nodes[proxyId].box;
+		if (treeBox.contains(box))
+		{
+			// Объект всё ещё внутри своего толстого AABB. Лист переставляется, только если толстый объём
+			// стал намного больше нужного (например, объект остановился после быстрого движения).
+			const glm::vec3 hugeMargin{ 4.f * AABB_MARGIN };
+			const Aabb hugeBox{ fatBox.min - hugeMargin, fatBox.max + hugeMargin };
+			if (hugeBox.contains(treeBox)) return false;
+		}
+
+		removeLeaf(proxyId);
+		nodes[proxyId].box = fatBox;
+		insertLeaf(proxyId);
+		return true;
+	}
+
+	// Спуск от корня к месту вставки. На каждом узле сравнивается стоимость создания нового родителя
+	// для текущего узла со стоимостью спуска в каждого из потомков (площадь их расширенных объёмов плюс
+	// прирост площади всех предков, который "наследуется" при любом варианте спуска).
+	int32_t VgetAabbTree::findBestSibling(const Aabb& box) const
+	{
+		int32_t index = root;
+		while (!nodes[index].isLeaf())
+		{
+			const Node& node = nodes[index];
+			const float area = node.box.surfaceArea();
+			const float combinedArea = Aabb::merge(node.box, box).surfaceArea();
+
+			const float cost = 2.f * combinedArea;
+			const float inheritanceCost = 2.f * (combinedArea - area);
+
+			auto descendCost = [&](int32_t childId)
+			{
+				const Node& child = nodes[childId];
+				const float mergedArea = Aabb::merge(box, child.box).surfaceArea();
+				return child.isLeaf() ? mergedArea + inheritanceCost : mergedArea - child.box.surfaceArea() + inheritanceCost;
+			};
+			const float cost1 = descendCost(node.child1);
+			const float cost2 = descendCost(node.child2);
+
+			if (cost < cost1 && cost < cost2) break;
+			index = cost1 < cost2 ? node.child1 : node.child2;
+		}
+		return index;
+	}
+
+	void VgetAabbTree::insertLeaf(int32_t leaf)
+	{
+		if (root == NULL_NODE)
+		{
+			root = leaf;
+			nodes[root].parent = NULL_NODE;
+			return;
+		}
+
+		const int32_t sibling = findBestSibling(nodes[leaf].box);
+		const int32_t oldParent = nodes[sibling].parent;
+		const int32_t newParent = allocateNode(); // может перевыделить nodes, поэтому ссылки на узлы берутся после
+
+		nodes[newParent].parent = oldParent;
+		nodes[newParent].box = Aabb::merge(nodes[leaf].box, nodes[sibling].box);
+		nodes[newParent].height = nodes[sibling].height + 1;
+		nodes[newParent].child1 = sibling;
+		nodes[newParent].child2 = leaf;
+
+		if (oldParent != NULL_NODE)
+		{
+			if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+			else nodes[oldParent].child2 = newParent;
+		}
+		else
+		{
+			root = newParent;
+		}
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+
+		refitAncestors(newParent);
+	}
+
+	void VgetAabbTree::removeLeaf(int32_t leaf)
+	{
+		if (leaf == root)
+		{
+			root = NULL_NODE;
+			return;
+		}
+
+		const int32_t parent = nodes[leaf].parent;
+		const int32_t grandParent = nodes[parent].parent;
+		const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+		// Родитель удаляется, а его место занимает сосед удаляемого листа
+		if (grandParent != NULL_NODE)
+		{
+			if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+			else nodes[grandParent].child2 = sibling;
+			nodes[sibling].parent = grandParent;
+			freeNode(parent);
+			refitAncestors(grandParent);
+		}
+		else
+		{
+			root = sibling;
+			nodes[sibling].parent = NULL_NODE;
+			freeNode(parent);
+		}
+		nodes[leaf].parent = NULL_NODE;
+	}
+
+	void VgetAabbTree::refitAncestors(int32_t nodeId)
+	{
+		while (nodeId != NULL_NODE)
+		{
+			rotate(nodeId);
+
+			Node& node = nodes[nodeId];
+			const Node& child1 = nodes[node.child1];
+			const Node& child2 = nodes[node.child2];
+			node.box = Aabb::merge(child1.box, child2.box);
+			node.height = 1 + std::max(child1.height, child2.height);
+
+			nodeId = node.parent;
+		}
+	}
+
+	// Поворот узла A с потомками B и C: один из потомков меняется местами с "внуком" из другого поддерева
+	// (например, B с F, где F и G - потомки C), если это уменьшает площадь поверхности изменившегося потомка.
+	// Объём самого A от поворота не меняется.
+	void VgetAabbTree::rotate(int32_t nodeA)
+	{
+		const Node& a = nodes[nodeA];
+		if (a.isLeaf()) return;
+
+		const int32_t nodeB = a.child1;
+		const int32_t nodeC = a.child2;
+		const Node& b = nodes[nodeB];
+		const Node& c = nodes[nodeC];
+		if (b.isLeaf() && c.isLeaf()) return;
+
+		enum class Rotation { NONE, B_F, B_G, C_D, C_E };
+		Rotation bestRotation = Rotation::NONE;
+		float bestDiff = 0.f;
+
+		if (!c.isLeaf())
+		{
+			const float areaC = c.box.surfaceArea();
+			// B <-> F: новый C = B + G
+			const float diffBF = Aabb::merge(b.box, nodes[c.child2].box).surfaceArea() - areaC;
+			if (diffBF < bestDiff) { bestRotation = Rotation::B_F; bestDiff = diffBF; }
+			// B <-> G: новый C = B + F
+			const float diffBG = Aabb::merge(b.box, nodes[c.child1].box).surfaceArea() - areaC;
+			if (diffBG < bestDiff) { bestRotation = Rotation::B_G; bestDiff = diffBG; }
+		}
+		if (!b.isLeaf())
+		{
+			const float areaB = b.box.surfaceArea();
+			// C <-> D: новый B = C + E
+			const float diffCD = Aabb::merge(c.box, nodes[b.child2].box).surfaceArea() - areaB;
+			if (diffCD < bestDiff) { bestRotation = Rotation::C_D; bestDiff = diffCD; }
+			// C <-> E: новый B = C + D
+			const float diffCE = Aabb::merge(c.box, nodes[b.child1].box).surfaceArea() - areaB;
+			if (diffCE < bestDiff) { bestRotation = Rotation::C_E; bestDiff = diffCE; }
+		}
+
+		// Обмен потомка A (child) с внуком (grandChild), который лежит в поддереве другого потомка (other)
+		auto swapWithGrandChild = [this, nodeA](int32_t child, int32_t other, int32_t grandChild)
+		{
+			Node& aNode = nodes[nodeA];
+			Node& otherNode = nodes[other];
+			if (aNode.child1 == child) aNode.child1 = grandChild;
+			else aNode.child2 = grandChild;
+			if (otherNode.child1 == grandChild) otherNode.child1 = child;
+			else otherNode.child2 = child;
+			nodes[grandChild].parent = nodeA;
+			nodes[child].parent = other;
+
+			otherNode.box = Aabb::merge(nodes[otherNode.child1].box, nodes[otherNode.child2].box);
+			otherNode.height = 1 + std::max(nodes[otherNode.child1].height, nodes[otherNode.child2].height);
+		};
+
+		switch (bestRotation)
+		{
+		case Rotation::NONE: break;
+		case Rotation::B_F: swapWithGrandChild(nodeB, nodeC, nodes[nodeC].child1); break;
+		case Rotation::B_G: swapWithGrandChild(nodeB, nodeC, nodes[nodeC].child2); break;
+		case Rotation::C_D: swapWithGrandChild(nodeC, nodeB, nodes[nodeB].child1); break;
+		case Rotation::C_E: swapWithGrandChild(nodeC, nodeB, nodes[nodeB].child2); break;
+		}
+	}
+
+	float VgetAabbTree::getAreaRatio() const
+	{
+		if (root == NULL_NODE) return 0.f;
+
+		const float rootArea = nodes[root].box.surfaceArea();
+		float totalArea = 0.f;
+		for (const auto& node : nodes)
+		{
+			if (node.height <= 0) continue; // листья и свободные узлы
+			totalArea += node.box.surfaceArea();
+		}
+		return rootArea > 0.f ? totalArea / rootArea : 0.f;
+	}
+
+	void VgetAabbTree::validate() const
+	{
+#ifndef NDEBUG
+		size_t leafCount = 0;
+		std::function<void(int32_t)> validateNode = [&](int32_t nodeId)
+		{
+			const Node& node = nodes[nodeId];
+			if (node.isLeaf())
+			{
+				assert(node.height == 0 && "Leaf height must be 0");
+				++leafCount;
+				return;
+			}
+
+			const Node& child1 = nodes[node.child1];
+			const Node& child2 = nodes[node.child2];
+			assert(child1.parent == nodeId && child2.parent == nodeId && "Broken parent link");
+			assert(node.height == 1 + std::max(child1.height, child2.height) && "Wrong node height");
+			assert(node.box.contains(child1.box) && node.box.contains(child2.box) && "Node box does not enclose children");
+			validateNode(node.child1);
+			validateNode(node.child2);
+		};
+
+		if (root != NULL_NODE)
+		{
+			assert(nodes[root].parent == NULL_NODE && "Root must not have a parent");
+			validateNode(root);
+		}
+		assert(leafCount == proxyCount && "Leaf count does not match proxy count");
+#endif
+	}
+
+	void VgetAabbTree::appendSubtree(int32_t nodeId, std::vector<uint32_t>& result) const
+	{
+		TraversalStack stack;
+		stack.push(nodeId);
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.pop()];
+			if (node.isLeaf())
+			{
+				result.push_back(node.userData);
+				continue;
+			}
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+
+	void VgetAabbTree::queryAabb(const Aabb& box, std::vector<uint32_t>& result) const
+	{
+		if (root == NULL_NODE) return;
+
+		TraversalStack stack;
+		stack.push(root);
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.pop()];
+			if (!node.box.overlaps(box)) continue;
+
+			if (node.isLeaf())
+			{
+				result.push_back(node.userData);
+				continue;
+			}
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+
+	void VgetAabbTree::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& result) const
+	{
+		if (root == NULL_NODE) return;
+
+		const float radiusSquared = radius * radius;
+		TraversalStack stack;
+		stack.push(root);
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.pop()];
+
+			// расстояние от центра сферы до ближайшей точки объёма
+			const glm::vec3 closest = glm::clamp(center, node.box.min, node.box.max);
+			const glm::vec3 delta = closest - center;
+			if (glm::dot(delta, delta) > radiusSquared) continue;
+
+			if (node.isLeaf())
+			{
+				result.push_back(node.userData);
+				continue;
+			}
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+
+	void VgetAabbTree::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const
+	{
+		if (root == NULL_NODE) return;
+
+		TraversalStack stack;
+		stack.push(root);
+		while (!stack.empty())
+		{
+			const int32_t nodeId = stack.pop();
+			const Node& node = nodes[nodeId];
+
+			const FrustumTest test = classify(frustum, node.box);
+			if (test == FrustumTest::OUTSIDE) continue;
+			if (test == FrustumTest::INSIDE || node.isLeaf())
+			{
+				appendSubtree(nodeId, result);
+				continue;
+			}
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+
+	void VgetAabbTree::queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<uint32_t>& result) const
+	{
+		if (root == NULL_NODE) return;
+
+		// Метод плоскостей (slab test). Для нулевых компонент направления обратное значение равно бесконечности,
+		// что корректно обрабатывается сравнениями ниже.
+		const glm::vec3 inverseDirection = 1.f / direction;
+		TraversalStack stack;
+		stack.push(root);
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.pop()];
+
+			const glm::vec3 t1 = (node.box.min - origin) * inverseDirection;
+			const glm::vec3 t2 = (node.box.max - origin) * inverseDirection;
+			const glm::vec3 tNear = glm::min(t1, t2);
+			const glm::vec3 tFar = glm::max(t1, t2);
+			const float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+			const float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+			if (tEnter > tExit) continue;
+
+			if (node.isLeaf())
+			{
+				result.push_back(node.userData);
+				continue;
+			}
+			stack.push(node.child1);
+			stack.push(node.child2);
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "vget_bounds.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace vget
+{
+	// Динамическое дерево ограничивающих объёмов (BVH), которое обновляется инкрементально.
+	// Листья хранят "толстые" AABB - объём объекта, расширенный на запас AABB_MARGIN (и в сторону движения объекта),
+	// поэтому небольшие перемещения не требуют перестроения дерева. Место вставки нового листа выбирается
+	// по эвристике SAH, а после вставки и удаления узлы на пути к корню балансируются поворотами, уменьшающими
+	// суммарную площадь поверхности дочерних объёмов.
+	// Запросы не изменяют дерево и могут выполняться из нескольких потоков одновременно.
+	class VgetAabbTree
+	{
+	public:
+		static constexpr int32_t NULL_NODE = -1;
+		static constexpr float AABB_MARGIN = .1f;				// запас толстого AABB по каждой оси
+		static constexpr float DISPLACEMENT_MULTIPLIER = 4.f;	// во сколько кадров движения вперёд растягивается толстый AABB
+
+		VgetAabbTree();
+
+		// Создание листа для объекта с ограничивающим объёмом box. userData возвращается запросами (например, id объекта).
+		int32_t createProxy(const Aabb& box, uint32_t userData);
+		void destroyProxy(int32_t proxyId);
+		// Обновление объёма листа. Лист переставляется в дереве, только если новый объём вышел за пределы толстого AABB
+		// (или толстый AABB стал слишком большим). displacement - перемещение объекта за кадр. Возвращает true при перестановке.
+		bool moveProxy(int32_t proxyId, const Aabb& box, const glm::vec3& displacement = glm::vec3{ 0.f });
+		void clear();
+
+		uint32_t getUserData(int32_t proxyId) const { return nodes[proxyId].userData; }
+		const Aabb& getFatAabb(int32_t proxyId) const { return nodes[proxyId].box; }
+		size_t getProxyCount() const { return proxyCount; }
+		int32_t getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+		// Отношение суммарной площади внутренних узлов к площади корня - метрика качества дерева (чем меньше, тем лучше)
+		float getAreaRatio() const;
+		// Проверка структуры дерева (родители, высоты, вложенность объёмов) через assert
+		void validate() const;
+
+		// Запросы дописывают в result userData всех листьев, толстые AABB которых удовлетворяют условию
+		void queryAabb(const Aabb& box, std::vector<uint32_t>& result) const;
+		void querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& result) const;
+		void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& result) const;
+		// Листья, пересекаемые лучом origin + t * direction при 0 <= t <= maxDistance (direction не обязан быть нормализован)
+		void queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<uint32_t>& result) const;
+
+	private:
+		struct Node
+		{
+			Aabb box{};
+			uint32_t userData = 0;
+			int32_t parent = NULL_NODE;	// для свободных узлов - следующий узел в списке свободных
+			int32_t child1 = NULL_NODE;
+			int32_t child2 = NULL_NODE;
+			int32_t height = 0;			// 0 - лист, -1 - свободный узел
+
+			bool isLeaf() const { return child1 == NULL_NODE; }
+		};
+
+		int32_t allocateNode();
+		void freeNode(int32_t nodeId);
+
+		void insertLeaf(int32_t leaf);
+		void removeLeaf(int32_t leaf);
+		int32_t findBestSibling(const Aabb& box) const;
+		void rotate(int32_t nodeId);
+		// Пересчёт объёмов и высот от узла до корня с поворотами на каждом уровне
+		void refitAncestors(int32_t nodeId);
+
+		void appendSubtree(int32_t nodeId, std::vector<uint32_t>& result) const;
+
+		std::vector<Node> nodes;
+		int32_t root = NULL_NODE;
+		int32_t freeList = NULL_NODE;
+		size_t proxyCount = 0;
+	};
+}
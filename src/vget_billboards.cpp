@@ -0,0 +1,32 @@
+#include "vget_billboards.hpp"
+
+namespace vget
+{
+	void VgetBillboardBatch::reserve(size_t count)
+	{
+		instances.reserve(count);
+		packets.reserve(count);
+		scratch.reserve(count);
+	}
+
+	void VgetBillboardBatch::sortBackToFront(const glm::vec3& cameraPosition)
+	{
+		packets.resize(instances.size());
+		for (uint32_t i = 0; i < instances.size(); ++i)
+		{
+			const glm::vec3 offset = glm::vec3(instances[i].position) - cameraPosition;
+			// Инвертированный ключ: по возрастанию ключа идут сначала дальние билборды.
+			// Ключ занимает младшие 32 бита, и старшие разряды сортировка пропускает.
+			packets[i] = DrawPacket{ ~DrawKey::orderedFloat(glm::dot(offset, offset)), i };
+		}
+		radixSort(packets, scratch);
+	}
+
+	void VgetBillboardBatch::copySorted(BillboardInstance* destination) const
+	{
+		for (const auto& packet : packets)
+		{
+			*destination++ = instances[packet.index];
+		}
+	}
+}
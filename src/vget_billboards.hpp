@@ -0,0 +1,43 @@
+#pragma once
+
+#include "vget_draw_queue.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace vget
+{
+	// Данные одного экземпляра билборда в буфере экземпляров (instance buffer)
+	struct BillboardInstance
+	{
+		glm::vec4 position{};	// w - радиус билборда
+		glm::vec4 color{};		// w - интенсивность цвета
+	};
+
+	// Покадровый набор полупрозрачных билбордов, которые рисуются одной instanced-отрисовкой.
+	// Для правильного смешивания цветов билборды сортируются от дальних к ближним стабильной поразрядной сортировкой
+	// по квадрату расстояния до камеры, поэтому равноудалённые билборды сохраняют порядок добавления. Память
+	// переиспользуется между кадрами.
+	class VgetBillboardBatch
+	{
+	public:
+		void clear() { instances.clear(); }
+		void reserve(size_t count);
+		void add(const BillboardInstance& instance) { instances.push_back(instance); }
+		size_t size() const { return instances.size(); }
+		bool empty() const { return instances.empty(); }
+
+		void sortBackToFront(const glm::vec3& cameraPosition);
+		// Запись экземпляров в отсортированном порядке (например, сразу в отображённую память буфера экземпляров)
+		void copySorted(BillboardInstance* destination) const;
+
+		const std::vector<BillboardInstance>& getInstances() const { return instances; }
+		const std::vector<DrawPacket>& getOrder() const { return packets; }
+
+	private:
+		std::vector<BillboardInstance> instances;
+		std::vector<DrawPacket> packets;
+		std::vector<DrawPacket> scratch;
+	};
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS			  // Функции GLM будут работать с радианами, а не градусами
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE   // GLM будет ожидать интервал нашего буфера глубины от 0 до 1 (например, для OpenGL используется интервал от -1 до 1)
+#include <glm/glm.hpp>
+
+// std
+#include <limits>
+
+namespace vget
+{
+	// Ограничивающий объём, выровненный по осям координат (Axis-Aligned Bounding Box).
+	// По умолчанию пустой: min = +inf, max = -inf, поэтому первое же expand() задаёт корректные границы.
+	struct Aabb
+	{
+		glm::vec3 min{ std::numeric_limits<float>::max() };
+		glm::vec3 max{ -std::numeric_limits<float>::max() };
+
+		bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+		glm::vec3 center() const { return (min + max) * .5f; }
+		glm::vec3 extents() const { return (max - min) * .5f; } // половина размеров по каждой оси
+
+		void expand(const glm::vec3& point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void expand(const Aabb& other)
+		{
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		bool contains(const Aabb& other) const
+		{
+			return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+				other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+		}
+
+		bool overlaps(const Aabb& other) const
+		{
+			return min.x <= other.max.x && other.min.x <= max.x &&
+				min.y <= other.max.y && other.min.y <= max.y &&
+				min.z <= other.max.z && other.min.z <= max.z;
+		}
+
+		// Площадь поверхности объёма - основа эвристики SAH (Surface Area Heuristic) при построении иерархий
+		float surfaceArea() const
+		{
+			const glm::vec3 d = max - min;
+			return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		static Aabb merge(const Aabb& a, const Aabb& b)
+		{
+			return Aabb{ glm::min(a.min, b.min), glm::max(a.max, b.max) };
+		}
+
+		// Перевод AABB из пространства модели в мировое пространство (метод Арво).
+		// Центр переводится матрицей целиком, а полуразмеры - абсолютными значениями её линейной части,
+		// поэтому результат снова выровнен по осям и полностью охватывает повёрнутый исходный объём.
+		Aabb transformed(const glm::mat4& m) const
+		{
+			const glm::vec3 c = glm::vec3(m * glm::vec4(center(), 1.f));
+			const glm::vec3 e = extents();
+			const glm::vec3 worldExtents{
+				glm::abs(m[0][0]) * e.x + glm::abs(m[1][0]) * e.y + glm::abs(m[2][0]) * e.z,
+				glm::abs(m[0][1]) * e.x + glm::abs(m[1][1]) * e.y + glm::abs(m[2][1]) * e.z,
+				glm::abs(m[0][2]) * e.x + glm::abs(m[1][2]) * e.y + glm::abs(m[2][2]) * e.z,
+			};
+			return Aabb{ c - worldExtents, c + worldExtents };
+		}
+	};
+
+	// Пирамида видимости камеры, заданная шестью плоскостями в мировом пространстве.
+	// Плоскость хранится как (nx, ny, nz, d), нормаль направлена внутрь объёма: точка p внутри, если dot(n, p) + d >= 0.
+	struct Frustum
+	{
+		enum Side { LEFT = 0, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, COUNT };
+
+		glm::vec4 planes[COUNT];
+
+		// Проверка AABB на пересечение с пирамидой видимости (скалярный вариант для единичных проверок)
+		bool intersects(const Aabb& box) const
+		{
+			const glm::vec3 c = box.center();
+			const glm::vec3 e = box.extents();
+			for (const auto& plane : planes)
+			{
+				const float distance = plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w;
+				const float radius = glm::abs(plane.x) * e.x + glm::abs(plane.y) * e.y + glm::abs(plane.z) * e.z;
+				if (distance + radius < 0.f) return false;
+			}
+			return true;
+		}
+	};
+}
@@ -6,6 +6,7 @@
  */
 
 #include "vget_buffer.hpp"
+#include "vget_render_stats.hpp"
 
 // std
 #include <cassert>
@@ -37,7 +38,8 @@ namespace vget
 		uint32_t instanceCount,
 		VkBufferUsageFlags usageFlags,
 		VkMemoryPropertyFlags memoryPropertyFlags,
-		VkDeviceSize minOffsetAlignment)
+		VkDeviceSize minOffsetAlignment,
+		const MemoryTag& tag)
 		: lveDevice{device},
 		  instanceSize{instanceSize},
 		  instanceCount{instanceCount},
@@ -46,14 +48,14 @@ namespace vget
 	{
 		alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
 		bufferSize = alignmentSize * instanceCount;
-		device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+		device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory, tag);
 	}
 
 	VgetBuffer::~VgetBuffer()
 	{
 		unmap();
 		vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-		vkFreeMemory(lveDevice.device(), memory, nullptr);
+		lveDevice.freeMemory(memory);
 	}
 
 	/**
@@ -116,6 +118,7 @@ namespace vget
 			memOffset += offset;
 			memcpy(memOffset, data, size);
 		}
+		VgetRenderStats::add(RenderCounter::UploadBytes, size == VK_WHOLE_SIZE ? bufferSize : size);
 	}
 
 	/**
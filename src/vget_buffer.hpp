@@ -13,7 +13,8 @@ namespace vget
 			uint32_t instanceCount,
 			VkBufferUsageFlags usageFlags,
 			VkMemoryPropertyFlags memoryPropertyFlags,
-			VkDeviceSize minOffsetAlignment = 1);
+			VkDeviceSize minOffsetAlignment = 1,
+			const MemoryTag& tag = {});	// категория по умолчанию выводится из usageFlags
 		~VgetBuffer();
 
 		VgetBuffer(const VgetBuffer&) = delete;
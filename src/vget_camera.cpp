@@ -115,4 +115,28 @@ namespace vget
 		inverseViewMatrix[3][1] = position.y;
 		inverseViewMatrix[3][2] = position.z;
 	}
+
+	Frustum VgetCamera::getFrustum() const
+	{
+		// Метод Грибба-Хартманна: плоскости отсечения получаются сложением и вычитанием строк
+		// матрицы clip = projection * view. GLM хранит матрицы по столбцам, поэтому строка i - это (m[0][i], m[1][i], m[2][i], m[3][i]).
+		const glm::mat4 clip = projectionMatrix * viewMatrix;
+		auto row = [&clip](int i) { return glm::vec4{clip[0][i], clip[1][i], clip[2][i], clip[3][i]}; };
+
+		Frustum frustum{};
+		frustum.planes[Frustum::LEFT] = row(3) + row(0);
+		frustum.planes[Frustum::RIGHT] = row(3) - row(0);
+		frustum.planes[Frustum::BOTTOM] = row(3) + row(1);
+		frustum.planes[Frustum::TOP] = row(3) - row(1);
+		// Диапазон глубины [0;1] (GLM_FORCE_DEPTH_ZERO_TO_ONE), поэтому ближняя плоскость задаётся одной третьей строкой
+		frustum.planes[Frustum::NEAR_PLANE] = row(2);
+		frustum.planes[Frustum::FAR_PLANE] = row(3) - row(2);
+
+		// Нормализация плоскостей, чтобы dot(n, p) + d давал настоящее расстояние со знаком
+		for (auto& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE   // GLM будет ожидать интервал нашего буфера глубины от 0 до 1 (например, для OpenGL используется интервал от -1 до 1)
 #include <glm/glm.hpp>
 
+#include "vget_bounds.hpp"
+
 namespace vget
 {
 	class VgetCamera
@@ -31,6 +33,9 @@ namespace vget
 		const glm::mat4& getInverseView() const {return inverseViewMatrix;}
 		const glm::vec3 getPosition() const {return glm::vec3(inverseViewMatrix[3]);}
 
+		// Извлечение шести плоскостей пирамиды видимости из текущих матриц проекции и просмотра (в мировом пространстве)
+		Frustum getFrustum() const;
+
 	private:
 		glm::mat4 projectionMatrix{1.f}; // матрица проекции перспективы
 		glm::mat4 viewMatrix{1.f}; // матрица просмотра (камеры)
@@ -0,0 +1,124 @@
+#include "vget_camera_path.hpp"
+
+// std
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace vget
+{
+	namespace
+	{
+		// Кривая Катмулла-Рома между p1 и p2 (t в [0, 1]), p0 и p3 задают касательные
+		glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+		{
+			const float t2 = t * t;
+			const float t3 = t2 * t;
+			return 0.5f * (2.f * p1 + (p2 - p0) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 + (3.f * p1 - p0 - 3.f * p2 + p3) * t3);
+		}
+	}
+
+	void VgetCameraPath::addKey(const Key& key)
+	{
+		if (!keys.empty() && key.time < keys.back().time) return;
+		keys.push_back(key);
+	}
+
+	VgetCameraPath::Key VgetCameraPath::sample(float time) const
+	{
+		if (keys.empty()) return Key{ time };
+		if (time <= keys.front().time) return Key{ time, keys.front().position, keys.front().rotation };
+		if (time >= keys.back().time) return Key{ time, keys.back().position, keys.back().rotation };
+
+		// Первый ключ позже time: отрезок [next - 1, next]
+		const auto next = std::upper_bound(keys.begin(), keys.end(), time, [](float value, const Key& key) { return value < key.time; });
+		const size_t i2 = static_cast<size_t>(next - keys.begin());
+		const size_t i1 = i2 - 1;
+		const float span = keys[i2].time - keys[i1].time;
+		const float t = span > 0.f ? (time - keys[i1].time) / span : 0.f;
+
+		Key result{ time };
+		if (interpolation == Interpolation::Linear)
+		{
+			result.position = glm::mix(keys[i1].position, keys[i2].position, t);
+			result.rotation = glm::mix(keys[i1].rotation, keys[i2].rotation, t);
+		}
+		else
+		{
+			// На краях пути недостающая контрольная точка повторяет крайнюю
+			const size_t i0 = i1 > 0 ? i1 - 1 : i1;
+			const size_t i3 = std::min(i2 + 1, keys.size() - 1);
+			result.position = catmullRom(keys[i0].position, keys[i1].position, keys[i2].position, keys[i3].position, t);
+			result.rotation = catmullRom(keys[i0].rotation, keys[i1].rotation, keys[i2].rotation, keys[i3].rotation, t);
+		}
+		return result;
+	}
+
+	void VgetCameraPath::load(const std::string& filepath)
+	{
+		std::ifstream file{ filepath };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		keys.clear();
+		interpolation = Interpolation::Linear;
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(file, line))
+		{
+			++lineNumber;
+			std::istringstream stream{ line };
+			std::string command;
+			if (!(stream >> command) || command[0] == '#') continue;
+
+			if (command == "interpolation")
+			{
+				std::string value;
+				stream >> value;
+				if (value == "linear") interpolation = Interpolation::Linear;
+				else if (value == "spline") interpolation = Interpolation::CatmullRom;
+				else throw std::runtime_error("unknown camera path interpolation '" + value + "' in " + filepath);
+			}
+			else if (command == "key")
+			{
+				Key key{};
+				stream >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.rotation.x >> key.rotation.y >> key.rotation.z;
+				if (!stream || (!keys.empty() && key.time < keys.back().time))
+				{
+					throw std::runtime_error("invalid camera path key at " + filepath + ":" + std::to_string(lineNumber));
+				}
+				keys.push_back(key);
+			}
+			else
+			{
+				throw std::runtime_error("unknown camera path command '" + command + "' in " + filepath);
+			}
+		}
+
+		if (keys.empty())
+		{
+			throw std::runtime_error("camera path has no keys: " + filepath);
+		}
+	}
+
+	void VgetCameraPath::save(const std::string& filepath) const
+	{
+		std::ofstream file{ filepath, std::ios::trunc };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		file << "# vget camera path: key <time> <position xyz> <rotation xyz>\n";
+		file << "interpolation " << (interpolation == Interpolation::Linear ? "linear" : "spline") << '\n';
+		file.precision(9);
+		for (const auto& key : keys)
+		{
+			file << "key " << key.time << ' ' << key.position.x << ' ' << key.position.y << ' ' << key.position.z << ' '
+				<< key.rotation.x << ' ' << key.rotation.y << ' ' << key.rotation.z << '\n';
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <string>
+#include <vector>
+
+namespace vget
+{
+	// Путь камеры для воспроизводимых замеров: ключи положения и поворота (углы YXZ, как у VgetCamera::setViewYXZ)
+	// по времени. Записанный путь (Linear) хранит ключ каждого кадра, между ключами - линейная интерполяция.
+	// Сплайн (CatmullRom) проходит через редкие контрольные точки по кривой Катмулла-Рома.
+	//
+	// Текстовый формат файла (строки с # - комментарии):
+	//   interpolation linear|spline
+	//   key <time> <px> <py> <pz> <rx> <ry> <rz>
+	class VgetCameraPath
+	{
+	public:
+		enum class Interpolation { Linear, CatmullRom };
+
+		struct Key
+		{
+			float time = 0.f;	// секунды от начала пути, ключи идут по возрастанию
+			glm::vec3 position{};
+			glm::vec3 rotation{};
+		};
+
+		void setInterpolation(Interpolation value) { interpolation = value; }
+		Interpolation getInterpolation() const { return interpolation; }
+		// Ключ с временем меньше последнего отбрасывается
+		void addKey(const Key& key);
+		void clear() { keys.clear(); }
+
+		bool empty() const { return keys.empty(); }
+		size_t getKeyCount() const { return keys.size(); }
+		float getStartTime() const { return keys.empty() ? 0.f : keys.front().time; }
+		float getDuration() const { return keys.empty() ? 0.f : keys.back().time - keys.front().time; }
+
+		// Положение камеры в момент time (вне пути - крайний ключ)
+		Key sample(float time) const;
+
+		void load(const std::string& filepath);
+		void save(const std::string& filepath) const;
+
+	private:
+		Interpolation interpolation = Interpolation::Linear;
+		std::vector<Key> keys;
+	};
+}
@@ -0,0 +1,168 @@
+#include "vget_command_recorder.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace vget
+{
+	void VgetCommandRecorder::begin(VkCommandBuffer commandBuffer)
+	{
+		this->commandBuffer = commandBuffer;
+		stats = CommandStats{};
+		invalidate();
+	}
+
+	void VgetCommandRecorder::invalidate()
+	{
+		for (auto& bindPoint : bindPoints)
+		{
+			bindPoint = BindPointState{};
+		}
+		std::fill(std::begin(vertexBuffers), std::end(vertexBuffers), VK_NULL_HANDLE);
+		std::fill(std::begin(vertexOffsets), std::end(vertexOffsets), 0);
+		indexBuffer = VK_NULL_HANDLE;
+		indexOffset = 0;
+		pushLayout = VK_NULL_HANDLE;
+		pushStages = 0;
+		pushBegin = pushEnd = 0;
+	}
+
+	void VgetCommandRecorder::bindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline)
+	{
+		if (static_cast<uint32_t>(bindPoint) < TRACKED_BIND_POINTS)
+		{
+			VkPipeline& bound = bindPoints[bindPoint].pipeline;
+			if (bound == pipeline)
+			{
+				++stats.elided;
+				return;
+			}
+			bound = pipeline;
+		}
+		vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
+		++stats.issued;
+		++stats.pipelineBinds;
+	}
+
+	void VgetCommandRecorder::bindDescriptorSets(
+		VkPipelineBindPoint bindPoint,
+		VkPipelineLayout layout,
+		uint32_t firstSet,
+		uint32_t descriptorSetCount,
+		const VkDescriptorSet* descriptorSets,
+		uint32_t dynamicOffsetCount,
+		const uint32_t* dynamicOffsets)
+	{
+		const bool tracked = static_cast<uint32_t>(bindPoint) < TRACKED_BIND_POINTS && firstSet + descriptorSetCount <= MAX_DESCRIPTOR_SETS;
+		if (tracked)
+		{
+			BindPointState& state = bindPoints[bindPoint];
+
+			// Наборы с динамическими смещениями не сравниваются: смещения могут меняться при тех же наборах
+			if (dynamicOffsetCount == 0 && state.layout == layout &&
+				std::equal(descriptorSets, descriptorSets + descriptorSetCount, state.descriptorSets + firstSet))
+			{
+				++stats.elided;
+				return;
+			}
+
+			// Привязка с другой схемой может сделать недействительными ранее привязанные наборы, поэтому они забываются
+			if (state.layout != layout)
+			{
+				std::fill(std::begin(state.descriptorSets), std::end(state.descriptorSets), VK_NULL_HANDLE);
+				state.layout = layout;
+			}
+			for (uint32_t i = 0; i < descriptorSetCount; ++i)
+			{
+				state.descriptorSets[firstSet + i] = dynamicOffsetCount == 0 ? descriptorSets[i] : VK_NULL_HANDLE;
+			}
+		}
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, firstSet, descriptorSetCount, descriptorSets, dynamicOffsetCount, dynamicOffsets);
+		++stats.issued;
+		++stats.descriptorSetBinds;
+	}
+
+	void VgetCommandRecorder::bindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets)
+	{
+		if (firstBinding + bindingCount <= MAX_VERTEX_BINDINGS)
+		{
+			if (std::equal(buffers, buffers + bindingCount, vertexBuffers + firstBinding) &&
+				std::equal(offsets, offsets + bindingCount, vertexOffsets + firstBinding))
+			{
+				++stats.elided;
+				return;
+			}
+			std::copy(buffers, buffers + bindingCount, vertexBuffers + firstBinding);
+			std::copy(offsets, offsets + bindingCount, vertexOffsets + firstBinding);
+		}
+		vkCmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, buffers, offsets);
+		++stats.issued;
+		++stats.vertexBufferBinds;
+	}
+
+	void VgetCommandRecorder::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+	{
+		if (indexBuffer == buffer && indexOffset == offset && this->indexType == indexType)
+		{
+			++stats.elided;
+			return;
+		}
+		indexBuffer = buffer;
+		indexOffset = offset;
+		this->indexType = indexType;
+		vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+		++stats.issued;
+		++stats.indexBufferBinds;
+	}
+
+	void VgetCommandRecorder::pushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values)
+	{
+		if (offset + size <= MAX_PUSH_CONSTANTS_SIZE)
+		{
+			const bool sameTarget = pushLayout == layout && pushStages == stageFlags;
+			if (sameTarget && offset >= pushBegin && offset + size <= pushEnd && std::memcmp(pushData + offset, values, size) == 0)
+			{
+				++stats.elided;
+				return;
+			}
+
+			// Достоверный диапазон расширяется, если новый примыкает к нему, иначе начинается заново
+			if (sameTarget && offset <= pushEnd && offset + size >= pushBegin)
+			{
+				pushBegin = std::min(pushBegin, offset);
+				pushEnd = std::max(pushEnd, offset + size);
+			}
+			else
+			{
+				pushLayout = layout;
+				pushStages = stageFlags;
+				pushBegin = offset;
+				pushEnd = offset + size;
+			}
+			std::memcpy(pushData + offset, values, size);
+		}
+		vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, size, values);
+		++stats.issued;
+		stats.pushConstantBytes += size;
+	}
+
+	void VgetCommandRecorder::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+	{
+		vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+		++stats.issued;
+		++stats.draws;
+		stats.instances += instanceCount;
+		stats.triangles += static_cast<uint64_t>(vertexCount / 3) * instanceCount;
+	}
+
+	void VgetCommandRecorder::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+	{
+		vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+		++stats.issued;
+		++stats.draws;
+		stats.instances += instanceCount;
+		stats.triangles += static_cast<uint64_t>(indexCount / 3) * instanceCount;
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+
+namespace vget
+{
+	// Счётчики команд, прошедших через VgetCommandRecorder
+	struct CommandStats
+	{
+		uint32_t issued = 0;	// записано в буфер команд
+		uint32_t elided = 0;	// отброшено как повторяющее уже установленное состояние
+
+		// Записанные команды по видам (для VgetRenderStats)
+		uint32_t draws = 0;
+		uint32_t instances = 0;
+		uint64_t triangles = 0;		// пайплайны движка рисуют списками треугольников: три вершины (индекса) на треугольник
+		uint32_t pipelineBinds = 0;
+		uint32_t descriptorSetBinds = 0;
+		uint32_t vertexBufferBinds = 0;
+		uint32_t indexBufferBinds = 0;
+		uint32_t pushConstantBytes = 0;
+
+		CommandStats& operator+=(const CommandStats& other)
+		{
+			issued += other.issued;
+			elided += other.elided;
+			draws += other.draws;
+			instances += other.instances;
+			triangles += other.triangles;
+			pipelineBinds += other.pipelineBinds;
+			descriptorSetBinds += other.descriptorSetBinds;
+			vertexBufferBinds += other.vertexBufferBinds;
+			indexBufferBinds += other.indexBufferBinds;
+			pushConstantBytes += other.pushConstantBytes;
+			return *this;
+		}
+	};
+
+	// Тонкая обёртка над VkCommandBuffer, которая помнит текущее привязанное состояние (пайплайн, наборы дескрипторов,
+	// буферы вершин и индексов, содержимое пуш-констант) и не записывает команды, которые его не меняют.
+	// Состояние действует в пределах одного буфера команд: begin() вызывается после начала записи каждого буфера,
+	// а invalidate() - если между вызовами рекордера команды записывались напрямую в VkCommandBuffer.
+	class VgetCommandRecorder
+	{
+	public:
+		static constexpr uint32_t MAX_DESCRIPTOR_SETS = 8;
+		static constexpr uint32_t MAX_VERTEX_BINDINGS = 4;
+		static constexpr uint32_t MAX_PUSH_CONSTANTS_SIZE = 256;
+
+		// Начало записи в новый буфер команд: сброс отслеживаемого состояния и счётчиков
+		void begin(VkCommandBuffer commandBuffer);
+		// Сброс отслеживаемого состояния без сброса счётчиков
+		void invalidate();
+
+		VkCommandBuffer getCommandBuffer() const { return commandBuffer; }
+		const CommandStats& getStats() const { return stats; }
+
+		void bindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+		void bindDescriptorSets(
+			VkPipelineBindPoint bindPoint,
+			VkPipelineLayout layout,
+			uint32_t firstSet,
+			uint32_t descriptorSetCount,
+			const VkDescriptorSet* descriptorSets,
+			uint32_t dynamicOffsetCount = 0,
+			const uint32_t* dynamicOffsets = nullptr);
+		void bindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets);
+		void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+		void pushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values);
+
+		// Команды отрисовки записываются всегда
+		void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+		void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+
+	private:
+		// Отслеживаются графическая и вычислительная точки привязки, для остальных команды записываются всегда
+		static constexpr uint32_t TRACKED_BIND_POINTS = 2;
+
+		struct BindPointState
+		{
+			VkPipeline pipeline;
+			VkPipelineLayout layout;	// схема, с которой были привязаны наборы дескрипторов
+			VkDescriptorSet descriptorSets[MAX_DESCRIPTOR_SETS];
+		};
+
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		CommandStats stats{};
+
+		BindPointState bindPoints[TRACKED_BIND_POINTS]{};
+		VkBuffer vertexBuffers[MAX_VERTEX_BINDINGS]{};
+		VkDeviceSize vertexOffsets[MAX_VERTEX_BINDINGS]{};
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		VkDeviceSize indexOffset = 0;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+		// Копия последних записанных пуш-констант; достоверен только диапазон [pushBegin, pushEnd)
+		VkPipelineLayout pushLayout = VK_NULL_HANDLE;
+		VkShaderStageFlags pushStages = 0;
+		uint32_t pushBegin = 0;
+		uint32_t pushEnd = 0;
+		uint8_t pushData[MAX_PUSH_CONSTANTS_SIZE]{};
+	};
+}
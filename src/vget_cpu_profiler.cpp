@@ -0,0 +1,231 @@
+#include "vget_cpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace vget
+{
+	namespace
+	{
+		// Имена зон - литералы из кода, но __func__ и пути к файлам могут содержать символы, требующие экранирования
+		void writeJsonString(std::ofstream& out, const char* text)
+		{
+			out << '"';
+			for (const char* c = text; *c != '\0'; ++c)
+			{
+				if (*c == '"' || *c == '\\') out << '\\';
+				if (static_cast<unsigned char>(*c) >= 0x20) out << *c;
+			}
+			out << '"';
+		}
+
+		// Chrome trace ожидает микросекунды
+		void writeMicroseconds(std::ofstream& out, uint64_t ns)
+		{
+			out << ns / 1000 << '.' << static_cast<char>('0' + ns / 100 % 10) << static_cast<char>('0' + ns / 10 % 10) << static_cast<char>('0' + ns % 10);
+		}
+	}
+
+	VgetCpuProfiler::VgetCpuProfiler() {}
+
+	VgetCpuProfiler& VgetCpuProfiler::get()
+	{
+		static VgetCpuProfiler profiler{};
+		return profiler;
+	}
+
+	uint64_t VgetCpuProfiler::now()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - get().epoch).count());
+	}
+
+	void VgetCpuProfiler::zone(const char* name, uint64_t startNs, uint64_t endNs)
+	{
+		threadBuffer().push(name, startNs, endNs - startNs, EventType::Zone);
+	}
+
+	void VgetCpuProfiler::counter(const char* name, double value)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		threadBuffer().push(name, now(), bits, EventType::Counter);
+	}
+
+	void VgetCpuProfiler::setThreadName(const std::string& name)
+	{
+		ThreadBuffer& buffer = threadBuffer();
+		VgetCpuProfiler& profiler = get();
+		std::lock_guard<std::mutex> lock{ profiler.registryMutex };
+		buffer.threadName = name;
+	}
+
+	VgetCpuProfiler::ThreadBuffer& VgetCpuProfiler::threadBuffer()
+	{
+		thread_local ThreadRegistration registration{};
+		return *registration.buffer;
+	}
+
+	VgetCpuProfiler::ThreadRegistration::ThreadRegistration() : buffer{ get().acquireBuffer() } {}
+
+	VgetCpuProfiler::ThreadRegistration::~ThreadRegistration()
+	{
+		buffer->inUse.store(false, std::memory_order_release);
+	}
+
+	VgetCpuProfiler::ThreadBuffer* VgetCpuProfiler::acquireBuffer()
+	{
+		std::lock_guard<std::mutex> lock{ registryMutex };
+		// Кольцо завершившегося потока достаётся новому вместе со старыми событиями
+		for (auto& buffer : buffers)
+		{
+			bool expected = false;
+			if (buffer->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+			{
+				buffer->threadName.clear();
+				return buffer.get();
+			}
+		}
+
+		buffers.push_back(std::make_unique<ThreadBuffer>());
+		ThreadBuffer* buffer = buffers.back().get();
+		buffer->threadId = static_cast<uint32_t>(buffers.size());
+		buffer->inUse.store(true, std::memory_order_relaxed);
+		return buffer;
+	}
+
+	void VgetCpuProfiler::ThreadBuffer::push(const char* name, uint64_t start, uint64_t payload, EventType type)
+	{
+		const uint64_t index = writeIndex.load(std::memory_order_relaxed);
+		// Парный барьер к acquire в read(): если читатель увидел хоть одно поле нового события, то и его
+		// повторное чтение writeIndex увидит не меньше index, и перезаписанная ячейка будет отброшена.
+		// Без барьера на слабых моделях памяти (ARM) записи полей могут обогнать предыдущую публикацию.
+		std::atomic_thread_fence(std::memory_order_release);
+		Event& event = events[index & (EVENTS_PER_THREAD - 1)];
+		event.name.store(name, std::memory_order_relaxed);
+		event.start.store(start, std::memory_order_relaxed);
+		event.payload.store(payload, std::memory_order_relaxed);
+		event.type.store(type, std::memory_order_relaxed);
+		writeIndex.store(index + 1, std::memory_order_release);
+	}
+
+	void VgetCpuProfiler::ThreadBuffer::read(std::vector<EventCopy>& out) const
+	{
+		const uint64_t end = writeIndex.load(std::memory_order_acquire);
+		const uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+		const size_t firstCopy = out.size();
+		for (uint64_t index = begin; index < end; ++index)
+		{
+			const Event& event = events[index & (EVENTS_PER_THREAD - 1)];
+			out.push_back(EventCopy{
+				event.name.load(std::memory_order_relaxed),
+				event.start.load(std::memory_order_relaxed),
+				event.payload.load(std::memory_order_relaxed),
+				event.type.load(std::memory_order_relaxed) });
+		}
+
+		// Пока события копировались, владелец мог записать новые поверх самых старых. Событие writeIndex
+		// (ещё не опубликованное) пишется в ячейку события writeIndex - EVENTS_PER_THREAD, поэтому и оно отбрасывается.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t after = writeIndex.load(std::memory_order_relaxed);
+		const uint64_t validBegin = after >= EVENTS_PER_THREAD ? after - EVENTS_PER_THREAD + 1 : 0;
+		if (validBegin > begin)
+		{
+			const size_t overwritten = static_cast<size_t>(std::min(validBegin, end) - begin);
+			out.erase(out.begin() + firstCopy, out.begin() + firstCopy + overwritten);
+		}
+	}
+
+	void VgetCpuProfiler::frameMark()
+	{
+		const uint64_t frameEnd = now();
+		const uint32_t ringSize = static_cast<uint32_t>(frameStarts.size());
+		if (frameCount > 0)
+		{
+			const uint64_t frameStart = frameStarts[(frameCount - 1) % ringSize];
+			zone("Frame", frameStart, frameEnd);
+			lastFrameMs = static_cast<double>(frameEnd - frameStart) * 1e-6;
+
+			if (captureFramesLeft > 0)
+			{
+				if (--captureFramesLeft == 0)
+				{
+					lastCapturePath = captureDirectory + "vget_slow_frame_" + std::to_string(slowFrameNumber) + ".json";
+					exportChromeTrace(lastCapturePath, captureBeginNs, frameEnd);
+					skipSlowCheck = true;
+				}
+			}
+			else if (skipSlowCheck)
+			{
+				skipSlowCheck = false;
+			}
+			else if (slowFrameThresholdMs > 0.0 && lastFrameMs > slowFrameThresholdMs)
+			{
+				// В кольце начал кадров лежат CAPTURE_FRAMES_BEFORE кадров до медленного (если их уже столько было)
+				const uint64_t firstFrame = frameCount > CAPTURE_FRAMES_BEFORE + 1 ? frameCount - CAPTURE_FRAMES_BEFORE - 1 : 0;
+				captureBeginNs = frameStarts[firstFrame % ringSize];
+				slowFrameNumber = frameCount - 1;
+				captureFramesLeft = CAPTURE_FRAMES_AFTER;
+			}
+		}
+
+		frameStarts[frameCount % ringSize] = frameEnd;
+		++frameCount;
+	}
+
+	bool VgetCpuProfiler::exportChromeTrace(const std::string& path, uint64_t beginNs, uint64_t endNs)
+	{
+		VGET_PROFILE_FUNCTION();
+		std::ofstream out{ path, std::ios::trunc };
+		if (!out) return false;
+
+		std::vector<EventCopy> events;
+		std::lock_guard<std::mutex> lock{ registryMutex };
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		bool first = true;
+		auto separator = [&]()
+		{
+			if (!first) out << ",\n";
+			first = false;
+		};
+
+		for (const auto& buffer : buffers)
+		{
+			separator();
+			out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+			const std::string name = buffer->threadName.empty() ? "Thread " + std::to_string(buffer->threadId) : buffer->threadName;
+			writeJsonString(out, name.c_str());
+			out << "}}";
+
+			events.clear();
+			buffer->read(events);
+			for (const auto& event : events)
+			{
+				if (event.name == nullptr) continue;
+				const uint64_t eventEnd = event.type == EventType::Zone ? event.start + event.payload : event.start;
+				if (eventEnd < beginNs || event.start > endNs) continue;
+
+				separator();
+				out << "{\"name\":";
+				writeJsonString(out, event.name);
+				out << ",\"pid\":1,\"tid\":" << buffer->threadId << ",\"ts\":";
+				writeMicroseconds(out, event.start);
+				if (event.type == EventType::Zone)
+				{
+					out << ",\"ph\":\"X\",\"dur\":";
+					writeMicroseconds(out, event.payload);
+					out << '}';
+				}
+				else
+				{
+					double value;
+					std::memcpy(&value, &event.payload, sizeof(value));
+					out << ",\"ph\":\"C\",\"args\":{\"value\":" << value << "}}";
+				}
+			}
+		}
+		out << "]}\n";
+		return static_cast<bool>(out);
+	}
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Инструментация CPU. Макросы компилируются, только если определён VGET_ENABLE_PROFILER (опция CMake
+// VGET_ENABLE_PROFILER или отладочная сборка), иначе они не оставляют в коде ни вызовов, ни переменных.
+// Имена зон и счётчиков должны жить всю программу (строковые литералы): профайлер хранит только указатели.
+#ifdef VGET_ENABLE_PROFILER
+#define VGET_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VGET_PROFILE_CONCAT(a, b) VGET_PROFILE_CONCAT_IMPL(a, b)
+// Зона от объявления до конца области видимости
+#define VGET_PROFILE_ZONE(name) ::vget::VgetProfileZone VGET_PROFILE_CONCAT(vgetProfileZone, __LINE__){ name }
+#define VGET_PROFILE_FUNCTION() VGET_PROFILE_ZONE(__func__)
+// Значение счётчика в текущий момент (на трассе - график)
+#define VGET_PROFILE_COUNTER(name, value) ::vget::VgetCpuProfiler::counter(name, static_cast<double>(value))
+// Имя текущего потока на трассе (копируется, может быть временной строкой)
+#define VGET_PROFILE_THREAD_NAME(name) ::vget::VgetCpuProfiler::setThreadName(name)
+// Граница кадров: вызывается из одного потока раз в кадр
+#define VGET_PROFILE_FRAME() ::vget::VgetCpuProfiler::get().frameMark()
+#else
+#define VGET_PROFILE_ZONE(name) ((void)0)
+#define VGET_PROFILE_FUNCTION() ((void)0)
+#define VGET_PROFILE_COUNTER(name, value) ((void)0)
+#define VGET_PROFILE_THREAD_NAME(name) ((void)0)
+#define VGET_PROFILE_FRAME() ((void)0)
+#endif
+
+namespace vget
+{
+	// Профайлер зон CPU. Каждый поток пишет события в своё кольцо без блокировок и без выделений памяти;
+	// старые события затираются новыми. Экспорт в формат Chrome trace (chrome://tracing, Perfetto) читает кольца
+	// всех потоков, не останавливая их: события, затёртые во время чтения, отбрасываются.
+	// Автозахват: если кадр (между вызовами frameMark()) длится дольше порога, то через CAPTURE_FRAMES_AFTER кадров
+	// в файл выгружается окно от CAPTURE_FRAMES_BEFORE кадров до медленного до последнего из последующих.
+	class VgetCpuProfiler
+	{
+	public:
+		static constexpr uint32_t EVENTS_PER_THREAD = 1 << 15;	// степень двойки; экспорт видит на одно событие меньше
+		static constexpr uint32_t CAPTURE_FRAMES_BEFORE = 2;
+		static constexpr uint32_t CAPTURE_FRAMES_AFTER = 2;	// не меньше одного: захват выгружается в одном из следующих кадров
+
+		static VgetCpuProfiler& get();
+
+		VgetCpuProfiler(const VgetCpuProfiler&) = delete;
+		VgetCpuProfiler& operator=(const VgetCpuProfiler&) = delete;
+
+		// Наносекунды от создания профайлера
+		static uint64_t now();
+		static void zone(const char* name, uint64_t startNs, uint64_t endNs);
+		static void counter(const char* name, double value);
+		static void setThreadName(const std::string& name);
+
+		void frameMark();
+		// Порог автозахвата в миллисекундах (0 - выключен) и каталог для файлов захвата
+		void setSlowFrameThreshold(double ms) { slowFrameThresholdMs = ms; }
+		double getSlowFrameThreshold() const { return slowFrameThresholdMs; }
+		void setCaptureDirectory(const std::string& directory) { captureDirectory = directory; }
+		// Последний записанный файл захвата (пустая строка - захватов ещё не было)
+		const std::string& getLastCapturePath() const { return lastCapturePath; }
+		double getLastFrameMs() const { return lastFrameMs; }
+
+		// Выгрузка событий из интервала [beginNs, endNs] всех потоков. false - файл не открылся.
+		bool exportChromeTrace(const std::string& path, uint64_t beginNs = 0, uint64_t endNs = UINT64_MAX);
+
+	private:
+		enum class EventType : uint32_t { Zone, Counter };
+
+		// Поля событий атомарные (relaxed): экспорт читает кольцо одновременно с потоком-владельцем
+		struct Event
+		{
+			std::atomic<const char*> name{ nullptr };
+			std::atomic<uint64_t> start{ 0 };
+			std::atomic<uint64_t> payload{ 0 };	// длительность зоны или биты значения счётчика
+			std::atomic<EventType> type{ EventType::Zone };
+		};
+
+		struct EventCopy
+		{
+			const char* name;
+			uint64_t start;
+			uint64_t payload;
+			EventType type;
+		};
+
+		struct ThreadBuffer
+		{
+			std::array<Event, EVENTS_PER_THREAD> events{};
+			std::atomic<uint64_t> writeIndex{ 0 };	// всего записано событий; публикуется с release
+			std::atomic<bool> inUse{ false };		// кольцо занято живым потоком (кольца завершившихся переиспользуются)
+			uint32_t threadId = 0;					// номер потока на трассе
+			std::string threadName;					// под registryMutex
+
+			void push(const char* name, uint64_t start, uint64_t payload, EventType type);
+			// Копия событий, которые не затирались во время чтения
+			void read(std::vector<EventCopy>& out) const;
+		};
+
+		// Регистрация кольца потока при первом событии и его освобождение при завершении потока
+		struct ThreadRegistration
+		{
+			ThreadRegistration();
+			~ThreadRegistration();
+			ThreadBuffer* buffer;
+		};
+
+		VgetCpuProfiler();
+		static ThreadBuffer& threadBuffer();
+		ThreadBuffer* acquireBuffer();
+
+		const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+		std::mutex registryMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+		// Состояние кадров принадлежит потоку, который вызывает frameMark()
+		std::array<uint64_t, CAPTURE_FRAMES_BEFORE + 1> frameStarts{};	// начала последних кадров по кругу
+		uint64_t frameCount = 0;
+		double lastFrameMs = 0.0;
+		double slowFrameThresholdMs = 0.0;
+		uint32_t captureFramesLeft = 0;	// кадров до выгрузки запланированного захвата
+		uint64_t captureBeginNs = 0;
+		uint64_t slowFrameNumber = 0;
+		bool skipSlowCheck = false;		// кадр с выгрузкой захвата сам медленный и не проверяется
+		std::string captureDirectory;
+		std::string lastCapturePath;
+	};
+
+	// Зона профайлера на время жизни объекта (см. VGET_PROFILE_ZONE)
+	class VgetProfileZone
+	{
+	public:
+		explicit VgetProfileZone(const char* name) : name{ name }, start{ VgetCpuProfiler::now() } {}
+		~VgetProfileZone() { VgetCpuProfiler::zone(name, start, VgetCpuProfiler::now()); }
+
+		VgetProfileZone(const VgetProfileZone&) = delete;
+		VgetProfileZone& operator=(const VgetProfileZone&) = delete;
+
+	private:
+		const char* name;
+		uint64_t start;
+	};
+}
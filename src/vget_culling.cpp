@@ -0,0 +1,169 @@
+#include "vget_culling.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+// SIMD intrinsics
+#if defined(__AVX__)
+#include <immintrin.h>
+#define VGET_CULLING_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VGET_CULLING_SSE
+#endif
+
+namespace vget
+{
+	void CullingBatch::clear()
+	{
+		centerX.clear(); centerY.clear(); centerZ.clear();
+		extentX.clear(); extentY.clear(); extentZ.clear();
+	}
+
+	void CullingBatch::reserve(size_t count)
+	{
+		centerX.reserve(count); centerY.reserve(count); centerZ.reserve(count);
+		extentX.reserve(count); extentY.reserve(count); extentZ.reserve(count);
+	}
+
+	uint32_t CullingBatch::add(const Aabb& box)
+	{
+		const glm::vec3 c = box.center();
+		const glm::vec3 e = box.extents();
+		centerX.push_back(c.x); centerY.push_back(c.y); centerZ.push_back(c.z);
+		extentX.push_back(e.x); extentY.push_back(e.y); extentZ.push_back(e.z);
+		return static_cast<uint32_t>(centerX.size() - 1);
+	}
+
+	// Объём отсекается, если хотя бы для одной плоскости расстояние от центра меньше -r,
+	// где r = |nx|*ex + |ny|*ey + |nz|*ez - проекция полуразмеров на нормаль плоскости.
+	void CullingBatch::cullRangeScalar(const Frustum& frustum, size_t begin, size_t end, uint8_t* visibility) const
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			uint8_t inside = 1;
+			for (const auto& plane : frustum.planes)
+			{
+				// порядок сложений совпадает с SIMD веткой, чтобы результаты были побитово одинаковыми
+				const float distance = (plane.x * centerX[i] + plane.y * centerY[i]) + (plane.z * centerZ[i] + plane.w);
+				const float radius = (std::abs(plane.x) * extentX[i] + std::abs(plane.y) * extentY[i]) + std::abs(plane.z) * extentZ[i];
+				if (distance + radius < 0.f)
+				{
+					inside = 0;
+					break;
+				}
+			}
+			visibility[i] = inside;
+		}
+	}
+
+	CullingStats CullingBatch::cullScalar(const Frustum& frustum, std::vector<uint8_t>& visibility) const
+	{
+		const size_t count = size();
+		visibility.resize(count);
+		cullRangeScalar(frustum, 0, count, visibility.data());
+
+		CullingStats stats{};
+		stats.visible = static_cast<uint32_t>(std::count(visibility.begin(), visibility.end(), uint8_t{1}));
+		stats.culled = static_cast<uint32_t>(count) - stats.visible;
+		return stats;
+	}
+
+	CullingStats CullingBatch::cull(const Frustum& frustum, std::vector<uint8_t>& visibility) const
+	{
+		const size_t count = size();
+		visibility.resize(count);
+		uint8_t* out = visibility.data();
+		size_t i = 0;
+
+#if defined(VGET_CULLING_AVX)
+		// Компоненты плоскостей заранее размножаются по всем 8 дорожкам регистра
+		__m256 px[Frustum::COUNT], py[Frustum::COUNT], pz[Frustum::COUNT], pw[Frustum::COUNT];
+		__m256 ax[Frustum::COUNT], ay[Frustum::COUNT], az[Frustum::COUNT];
+		for (int p = 0; p < Frustum::COUNT; ++p)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			px[p] = _mm256_set1_ps(plane.x); ax[p] = _mm256_set1_ps(std::abs(plane.x));
+			py[p] = _mm256_set1_ps(plane.y); ay[p] = _mm256_set1_ps(std::abs(plane.y));
+			pz[p] = _mm256_set1_ps(plane.z); az[p] = _mm256_set1_ps(std::abs(plane.z));
+			pw[p] = _mm256_set1_ps(plane.w);
+		}
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 cx = _mm256_loadu_ps(&centerX[i]);
+			const __m256 cy = _mm256_loadu_ps(&centerY[i]);
+			const __m256 cz = _mm256_loadu_ps(&centerZ[i]);
+			const __m256 ex = _mm256_loadu_ps(&extentX[i]);
+			const __m256 ey = _mm256_loadu_ps(&extentY[i]);
+			const __m256 ez = _mm256_loadu_ps(&extentZ[i]);
+
+			__m256 outside = _mm256_setzero_ps();
+			for (int p = 0; p < Frustum::COUNT; ++p)
+			{
+				const __m256 distance = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(px[p], cx), _mm256_mul_ps(py[p], cy)),
+					_mm256_add_ps(_mm256_mul_ps(pz[p], cz), pw[p]));
+				const __m256 radius = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)),
+					_mm256_mul_ps(az[p], ez));
+				// distance + radius < 0  =>  объём целиком за плоскостью
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+
+			const int mask = _mm256_movemask_ps(outside);
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				out[i + lane] = static_cast<uint8_t>(((mask >> lane) & 1) ^ 1);
+			}
+		}
+#elif defined(VGET_CULLING_SSE)
+		__m128 px[Frustum::COUNT], py[Frustum::COUNT], pz[Frustum::COUNT], pw[Frustum::COUNT];
+		__m128 ax[Frustum::COUNT], ay[Frustum::COUNT], az[Frustum::COUNT];
+		for (int p = 0; p < Frustum::COUNT; ++p)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			px[p] = _mm_set1_ps(plane.x); ax[p] = _mm_set1_ps(std::abs(plane.x));
+			py[p] = _mm_set1_ps(plane.y); ay[p] = _mm_set1_ps(std::abs(plane.y));
+			pz[p] = _mm_set1_ps(plane.z); az[p] = _mm_set1_ps(std::abs(plane.z));
+			pw[p] = _mm_set1_ps(plane.w);
+		}
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 cx = _mm_loadu_ps(&centerX[i]);
+			const __m128 cy = _mm_loadu_ps(&centerY[i]);
+			const __m128 cz = _mm_loadu_ps(&centerZ[i]);
+			const __m128 ex = _mm_loadu_ps(&extentX[i]);
+			const __m128 ey = _mm_loadu_ps(&extentY[i]);
+			const __m128 ez = _mm_loadu_ps(&extentZ[i]);
+
+			__m128 outside = _mm_setzero_ps();
+			for (int p = 0; p < Frustum::COUNT; ++p)
+			{
+				const __m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(px[p], cx), _mm_mul_ps(py[p], cy)),
+					_mm_add_ps(_mm_mul_ps(pz[p], cz), pw[p]));
+				const __m128 radius = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)),
+					_mm_mul_ps(az[p], ez));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+			}
+
+			const int mask = _mm_movemask_ps(outside);
+			out[i + 0] = static_cast<uint8_t>(((mask >> 0) & 1) ^ 1);
+			out[i + 1] = static_cast<uint8_t>(((mask >> 1) & 1) ^ 1);
+			out[i + 2] = static_cast<uint8_t>(((mask >> 2) & 1) ^ 1);
+			out[i + 3] = static_cast<uint8_t>(((mask >> 3) & 1) ^ 1);
+		}
+#endif
+		// Хвост пакета, не кратный ширине SIMD регистра, проверяется скалярно
+		cullRangeScalar(frustum, i, count, out);
+
+		CullingStats stats{};
+		stats.visible = static_cast<uint32_t>(std::count(visibility.begin(), visibility.end(), uint8_t{1}));
+		stats.culled = static_cast<uint32_t>(count) - stats.visible;
+		return stats;
+	}
+}
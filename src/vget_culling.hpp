@@ -0,0 +1,53 @@
+#pragma once
+
+#include "vget_bounds.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace vget
+{
+	// Итоги отсечения за кадр (или за одну проверку пакета)
+	struct CullingStats
+	{
+		uint32_t visible = 0;
+		uint32_t culled = 0;
+		uint32_t occluded = 0;	// прошли отсечение по пирамиде видимости, но перекрыты окклюдерами (не входят в visible)
+		uint32_t pvsCulled = 0;	// прошли отсечение по пирамиде видимости, но не видимы из текущей ячейки PVS (не входят в visible)
+
+		CullingStats& operator+=(const CullingStats& other)
+		{
+			visible += other.visible;
+			culled += other.culled;
+			occluded += other.occluded;
+			pvsCulled += other.pvsCulled;
+			return *this;
+		}
+	};
+
+	// Пакет ограничивающих объёмов в раскладке Structure of Arrays.
+	// Центры и полуразмеры AABB хранятся в отдельных массивах по каждой оси, благодаря чему
+	// проверка на пересечение с пирамидой видимости выполняется сразу для 4 (SSE) или 8 (AVX) объёмов.
+	class CullingBatch
+	{
+	public:
+		void clear();
+		void reserve(size_t count);
+		// Добавление объёма в пакет. Возвращает его индекс в массиве видимости
+		uint32_t add(const Aabb& box);
+		size_t size() const { return centerX.size(); }
+
+		// Заполняет visibility (1 - видим, 0 - отсечён) для каждого объёма пакета.
+		// Использует AVX при сборке с __AVX__, иначе SSE, а на прочих архитектурах - скалярный код.
+		CullingStats cull(const Frustum& frustum, std::vector<uint8_t>& visibility) const;
+		// Эталонная скалярная реализация (для сравнения в бенчмарке и на платформах без SIMD)
+		CullingStats cullScalar(const Frustum& frustum, std::vector<uint8_t>& visibility) const;
+
+	private:
+		void cullRangeScalar(const Frustum& frustum, size_t begin, size_t end, uint8_t* visibility) const;
+
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> extentX, extentY, extentZ;
+	};
+}
@@ -1,4 +1,5 @@
 ﻿#include "vget_descriptors.hpp"
+#include "vget_render_stats.hpp"
 
 // std
 #include <cassert>
@@ -12,7 +13,8 @@ namespace vget
 		uint32_t binding,
 		VkDescriptorType descriptorType,
 		VkShaderStageFlags stageFlags,
-		uint32_t count)
+		uint32_t count,
+		const VkSampler* immutableSamplers)
 	{
 		assert(bindings.count(binding) == 0 && "Binding already in use");
 		VkDescriptorSetLayoutBinding layoutBinding{};
@@ -20,32 +22,65 @@ namespace vget
 		layoutBinding.descriptorType = descriptorType;
 		layoutBinding.descriptorCount = count;
 		layoutBinding.stageFlags = stageFlags;
+		layoutBinding.pImmutableSamplers = immutableSamplers;
 		bindings[binding] = layoutBinding;
 		return *this;
 	}
 
+	VgetDescriptorSetLayout::Builder& VgetDescriptorSetLayout::Builder::setBindingFlags(
+		uint32_t binding,
+		VkDescriptorBindingFlags flags)
+	{
+		assert(bindings.count(binding) == 1 && "Binding flags must follow the binding");
+		bindingFlags[binding] = flags;
+		return *this;
+	}
+
+	VgetDescriptorSetLayout::Builder& VgetDescriptorSetLayout::Builder::setLayoutFlags(VkDescriptorSetLayoutCreateFlags flags)
+	{
+		layoutFlags = flags;
+		return *this;
+	}
+
 	std::unique_ptr<VgetDescriptorSetLayout> VgetDescriptorSetLayout::Builder::build() const
 	{
-		return std::make_unique<VgetDescriptorSetLayout>(lveDevice, bindings);
+		return std::make_unique<VgetDescriptorSetLayout>(lveDevice, bindings, bindingFlags, layoutFlags);
 	}
 
 	// *************** Descriptor Set Layout *********************
 
 	VgetDescriptorSetLayout::VgetDescriptorSetLayout(
-		VgetDevice& lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+		VgetDevice& lveDevice,
+		std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+		const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags,
+		VkDescriptorSetLayoutCreateFlags layoutFlags)
 		: lveDevice{lveDevice}, bindings{bindings}
 	{
 		std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+		std::vector<VkDescriptorBindingFlags> setLayoutBindingFlags{};
 		for (auto& kv : bindings)
 		{
 			setLayoutBindings.push_back(kv.second);
+			auto flags = bindingFlags.find(kv.first);
+			setLayoutBindingFlags.push_back(flags != bindingFlags.end() ? flags->second : 0);
 		}
 
 		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
 		descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptorSetLayoutInfo.flags = layoutFlags;
 		descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
 		descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
 
+		// Флаги привязок передаются, только если они заданы: без VK_EXT_descriptor_indexing структура не нужна
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		if (!bindingFlags.empty())
+		{
+			bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+			bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+			bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+			descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+		}
+
 		if (vkCreateDescriptorSetLayout(
 			lveDevice.device(),
 			&descriptorSetLayoutInfo,
@@ -149,10 +184,116 @@ namespace vget
 		vkResetDescriptorPool(lveDevice.device(), descriptorPool, 0);
 	}
 
+	// *************** Descriptor Allocator Builder *********************
+
+	VgetDescriptorAllocator::Builder& VgetDescriptorAllocator::Builder::addPoolSize(
+		VkDescriptorType descriptorType, uint32_t count)
+	{
+		poolSizes.push_back({descriptorType, count});
+		return *this;
+	}
+
+	VgetDescriptorAllocator::Builder& VgetDescriptorAllocator::Builder::setPoolFlags(
+		VkDescriptorPoolCreateFlags flags)
+	{
+		poolFlags = flags;
+		return *this;
+	}
+
+	VgetDescriptorAllocator::Builder& VgetDescriptorAllocator::Builder::setMaxSets(uint32_t count)
+	{
+		maxSets = count;
+		return *this;
+	}
+
+	std::unique_ptr<VgetDescriptorAllocator> VgetDescriptorAllocator::Builder::build() const
+	{
+		return std::make_unique<VgetDescriptorAllocator>(lveDevice, maxSets, poolFlags, poolSizes);
+	}
+
+	// *************** Descriptor Allocator *********************
+
+	VgetDescriptorAllocator::VgetDescriptorAllocator(
+		VgetDevice& lveDevice,
+		uint32_t maxSets,
+		VkDescriptorPoolCreateFlags poolFlags,
+		const std::vector<VkDescriptorPoolSize>& poolSizes)
+		: lveDevice{lveDevice}, maxSets{maxSets}, poolFlags{poolFlags}, poolSizes{poolSizes}
+	{
+	}
+
+	VgetDescriptorAllocator::~VgetDescriptorAllocator()
+	{
+		for (VkDescriptorPool descriptorPool : usedPools) vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+		for (VkDescriptorPool descriptorPool : freePools) vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+	}
+
+	bool VgetDescriptorAllocator::allocateDescriptor(
+		const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptorSet)
+	{
+		if (currentPool == VK_NULL_HANDLE) currentPool = acquirePool();
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = currentPool;
+		allocInfo.pSetLayouts = &descriptorSetLayout;
+		allocInfo.descriptorSetCount = 1;
+		if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &descriptorSet) == VK_SUCCESS) return true;
+
+		// Исчерпание пула сообщается как VK_ERROR_OUT_OF_POOL_MEMORY или VK_ERROR_FRAGMENTED_POOL, а без
+		// VK_KHR_maintenance1 - любой ошибкой выделения, поэтому при любой неудаче берётся следующий пул.
+		// Неудача на пустом пуле значит, что набор в пул этого размера не помещается.
+		currentPool = acquirePool();
+		allocInfo.descriptorPool = currentPool;
+		return vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, &descriptorSet) == VK_SUCCESS;
+	}
+
+	void VgetDescriptorAllocator::reset()
+	{
+		for (VkDescriptorPool descriptorPool : usedPools)
+		{
+			vkResetDescriptorPool(lveDevice.device(), descriptorPool, 0);
+			freePools.push_back(descriptorPool);
+		}
+		usedPools.clear();
+		currentPool = VK_NULL_HANDLE;
+	}
+
+	VkDescriptorPool VgetDescriptorAllocator::acquirePool()
+	{
+		VkDescriptorPool descriptorPool;
+		if (!freePools.empty())
+		{
+			descriptorPool = freePools.back();
+			freePools.pop_back();
+		}
+		else
+		{
+			VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+			descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+			descriptorPoolInfo.pPoolSizes = poolSizes.data();
+			descriptorPoolInfo.maxSets = maxSets;
+			descriptorPoolInfo.flags = poolFlags;
+
+			if (vkCreateDescriptorPool(lveDevice.device(), &descriptorPoolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create descriptor pool!");
+			}
+		}
+		usedPools.push_back(descriptorPool);
+		return descriptorPool;
+	}
+
 	// *************** Descriptor Writer *********************
 
 	VgetDescriptorWriter::VgetDescriptorWriter(VgetDescriptorSetLayout& setLayout, VgetDescriptorPool& pool)
-		: setLayout{setLayout}, pool{pool}
+		: setLayout{setLayout}, pool{&pool}
+	{
+	}
+
+	VgetDescriptorWriter::VgetDescriptorWriter(VgetDescriptorSetLayout& setLayout, VgetDescriptorAllocator& allocator)
+		: setLayout{setLayout}, allocator{&allocator}
 	{
 	}
 
@@ -204,7 +345,9 @@ namespace vget
 
 	bool VgetDescriptorWriter::build(VkDescriptorSet& set)
 	{
-		bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
+		bool success = pool != nullptr
+			? pool->allocateDescriptor(setLayout.getDescriptorSetLayout(), set)
+			: allocator->allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
 		if (!success)
 		{
 			return false;
@@ -221,6 +364,143 @@ namespace vget
 		{
 			write.dstSet = set;
 		}
-		vkUpdateDescriptorSets(pool.lveDevice.device(), writes.size(), writes.data(), 0, nullptr);
+		vkUpdateDescriptorSets(setLayout.lveDevice.device(), writes.size(), writes.data(), 0, nullptr);
+		VgetRenderStats::add(RenderCounter::DescriptorWrites, writes.size());
+	}
+
+	// *************** Descriptor Update Template Builder *********************
+
+	VgetDescriptorUpdateTemplate::Builder& VgetDescriptorUpdateTemplate::Builder::addBinding(
+		uint32_t binding, size_t offset, uint32_t count, size_t stride)
+	{
+		VkDescriptorUpdateTemplateEntry entry{};
+		entry.dstBinding = binding;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = count;
+		entry.offset = offset;
+		entry.stride = stride;	// 0 заменяется размером структуры типа дескриптора при создании шаблона
+		entries.push_back(entry);
+		return *this;
+	}
+
+	std::unique_ptr<VgetDescriptorUpdateTemplate> VgetDescriptorUpdateTemplate::Builder::build() const
+	{
+		return std::make_unique<VgetDescriptorUpdateTemplate>(lveDevice, setLayout, entries);
+	}
+
+	// *************** Descriptor Update Template *********************
+
+	namespace
+	{
+		// Структура, которой описывается дескриптор данного типа
+		enum class DescriptorInfoKind { Buffer, TexelBuffer, Image };
+
+		DescriptorInfoKind descriptorInfoKind(VkDescriptorType type)
+		{
+			switch (type)
+			{
+			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+				return DescriptorInfoKind::Buffer;
+			case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+			case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+				return DescriptorInfoKind::TexelBuffer;
+			default:
+				return DescriptorInfoKind::Image;
+			}
+		}
+
+		size_t descriptorInfoSize(VkDescriptorType type)
+		{
+			switch (descriptorInfoKind(type))
+			{
+			case DescriptorInfoKind::Buffer: return sizeof(VkDescriptorBufferInfo);
+			case DescriptorInfoKind::TexelBuffer: return sizeof(VkBufferView);
+			default: return sizeof(VkDescriptorImageInfo);
+			}
+		}
+	}
+
+	VgetDescriptorUpdateTemplate::VgetDescriptorUpdateTemplate(
+		VgetDevice& lveDevice,
+		VgetDescriptorSetLayout& setLayout,
+		std::vector<VkDescriptorUpdateTemplateEntry> entries)
+		: lveDevice{lveDevice}, entries{std::move(entries)}
+	{
+		for (auto& entry : this->entries)
+		{
+			assert(setLayout.bindings.count(entry.dstBinding) == 1 && "Layout does not contain specified binding");
+			const auto& bindingDescription = setLayout.bindings[entry.dstBinding];
+			assert(entry.descriptorCount <= bindingDescription.descriptorCount && "Template entry exceeds binding's descriptor count");
+
+			entry.descriptorType = bindingDescription.descriptorType;
+			if (entry.stride == 0) entry.stride = descriptorInfoSize(entry.descriptorType);
+		}
+
+		if (lveDevice.createDescriptorUpdateTemplate == nullptr) return;
+
+		VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+		templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(this->entries.size());
+		templateInfo.pDescriptorUpdateEntries = this->entries.data();
+		templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		templateInfo.descriptorSetLayout = setLayout.getDescriptorSetLayout();
+
+		if (lveDevice.createDescriptorUpdateTemplate(lveDevice.device(), &templateInfo, nullptr, &updateTemplate) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create descriptor update template!");
+		}
+	}
+
+	VgetDescriptorUpdateTemplate::~VgetDescriptorUpdateTemplate()
+	{
+		if (updateTemplate != VK_NULL_HANDLE)
+		{
+			lveDevice.destroyDescriptorUpdateTemplate(lveDevice.device(), updateTemplate, nullptr);
+		}
+	}
+
+	void VgetDescriptorUpdateTemplate::update(VkDescriptorSet set, const void* data) const
+	{
+		VgetRenderStats::add(RenderCounter::DescriptorWrites, entries.size());
+		if (updateTemplate != VK_NULL_HANDLE)
+		{
+			lveDevice.updateDescriptorSetWithTemplate(lveDevice.device(), set, updateTemplate, data);
+			return;
+		}
+
+		// Запасной путь: по записи на каждый элемент, т.к. шаг в структуре данных может не совпадать с размером info
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		std::vector<VkWriteDescriptorSet> writes;
+		for (const auto& entry : entries)
+		{
+			for (uint32_t i = 0; i < entry.descriptorCount; ++i)
+			{
+				const void* info = bytes + entry.offset + i * entry.stride;
+				VkWriteDescriptorSet write{};
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.dstSet = set;
+				write.dstBinding = entry.dstBinding;
+				write.dstArrayElement = entry.dstArrayElement + i;
+				write.descriptorCount = 1;
+				write.descriptorType = entry.descriptorType;
+				switch (descriptorInfoKind(entry.descriptorType))
+				{
+				case DescriptorInfoKind::Buffer:
+					write.pBufferInfo = static_cast<const VkDescriptorBufferInfo*>(info);
+					break;
+				case DescriptorInfoKind::TexelBuffer:
+					write.pTexelBufferView = static_cast<const VkBufferView*>(info);
+					break;
+				default:
+					write.pImageInfo = static_cast<const VkDescriptorImageInfo*>(info);
+					break;
+				}
+				writes.push_back(write);
+			}
+		}
+		vkUpdateDescriptorSets(lveDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 	}
 }
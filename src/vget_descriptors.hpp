@@ -19,12 +19,17 @@ namespace vget
 		public:
 			Builder(VgetDevice& lveDevice) : lveDevice{lveDevice} {}
 
-			// Добавление новой привязки дескрпитора в мапу
+			// Добавление новой привязки дескрпитора в мапу. immutableSamplers - count неизменяемых выборщиков
+			// для привязок SAMPLER и COMBINED_IMAGE_SAMPLER, массив должен жить до вызова build()
 			Builder& addBinding(
 				uint32_t binding,
 				VkDescriptorType descriptorType,
 				VkShaderStageFlags stageFlags,
-				uint32_t count = 1);
+				uint32_t count = 1,
+				const VkSampler* immutableSamplers = nullptr);
+			// Флаги привязки из VK_EXT_descriptor_indexing (частичная привязка, обновление после привязки)
+			Builder& setBindingFlags(uint32_t binding, VkDescriptorBindingFlags flags);
+			Builder& setLayoutFlags(VkDescriptorSetLayoutCreateFlags flags);
 			// Создание экземпляра VgetDescriptorSetLayout на основе текущей мапы привязок
 			std::unique_ptr<VgetDescriptorSetLayout> build() const;
 
@@ -32,9 +37,15 @@ namespace vget
 			VgetDevice& lveDevice;
 			// Мапа с информацией по каждой привязке. На основе этой мапы строится VgetDescriptorSetLayout
 			std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+			std::unordered_map<uint32_t, VkDescriptorBindingFlags> bindingFlags{};
+			VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
 		};
 
-		VgetDescriptorSetLayout(VgetDevice& lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+		VgetDescriptorSetLayout(
+			VgetDevice& lveDevice,
+			std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+			const std::unordered_map<uint32_t, VkDescriptorBindingFlags>& bindingFlags = {},
+			VkDescriptorSetLayoutCreateFlags layoutFlags = 0);
 		~VgetDescriptorSetLayout();
 		VgetDescriptorSetLayout(const VgetDescriptorSetLayout&) = delete;
 		VgetDescriptorSetLayout& operator=(const VgetDescriptorSetLayout&) = delete;
@@ -47,6 +58,7 @@ namespace vget
 		std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings;
 
 		friend class VgetDescriptorWriter;
+		friend class VgetDescriptorUpdateTemplate;
 	};
 
 	// Класс обёртка над VkDescriptorPool для удобного управления им
@@ -97,12 +109,68 @@ namespace vget
 		friend class VgetDescriptorWriter;
 	};
 
+	// Растущий распределитель наборов дескрипторов. Пулы одного размера выстраиваются в цепочку: когда текущий
+	// исчерпан, берётся следующий (ранее сброшенный или новый), поэтому выделение не упирается в размер пула.
+	// reset() сбрасывает все пулы разом - так распределитель обслуживает наборы, живущие один кадр: по одному
+	// распределителю на кадр в полёте со сбросом в начале кадра, после ожидания его fence.
+	// Не потокобезопасен, как и сами пулы дескрипторов.
+	class VgetDescriptorAllocator
+	{
+	public:
+		class Builder
+		{
+		public:
+			Builder(VgetDevice& lveDevice) : lveDevice{ lveDevice } {}
+
+			Builder& addPoolSize(VkDescriptorType descriptorType, uint32_t count); // кол-во дескрипторов заданного типа в одном пуле цепочки
+			Builder& setPoolFlags(VkDescriptorPoolCreateFlags flags);
+			Builder& setMaxSets(uint32_t count);							// наборов в одном пуле цепочки
+			std::unique_ptr<VgetDescriptorAllocator> build() const;
+
+		private:
+			VgetDevice& lveDevice;
+			std::vector<VkDescriptorPoolSize> poolSizes{};
+			uint32_t maxSets = 1000;
+			VkDescriptorPoolCreateFlags poolFlags = 0;
+		};
+
+		VgetDescriptorAllocator(
+			VgetDevice& lveDevice,
+			uint32_t maxSets,
+			VkDescriptorPoolCreateFlags poolFlags,
+			const std::vector<VkDescriptorPoolSize>& poolSizes);
+		~VgetDescriptorAllocator();
+		VgetDescriptorAllocator(const VgetDescriptorAllocator&) = delete;
+		VgetDescriptorAllocator& operator=(const VgetDescriptorAllocator&) = delete;
+
+		// Выделение набора с переходом на следующий пул при исчерпании текущего.
+		// false - набор не помещается даже в пустой пул (схема требует больше дескрипторов, чем размер пула).
+		bool allocateDescriptor(const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor);
+
+		// Сброс всех пулов цепочки; выделенные из них наборы становятся недействительными
+		void reset();
+
+		uint32_t getPoolCount() const { return static_cast<uint32_t>(usedPools.size() + freePools.size()); }
+
+	private:
+		VkDescriptorPool acquirePool();
+
+		VgetDevice& lveDevice;
+		uint32_t maxSets;
+		VkDescriptorPoolCreateFlags poolFlags;
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		VkDescriptorPool currentPool = VK_NULL_HANDLE;
+		std::vector<VkDescriptorPool> usedPools;	// выделялись с последнего сброса, включая текущий
+		std::vector<VkDescriptorPool> freePools;	// сброшенные, готовые к повторному использованию
+	};
+
 	// Класс для лёгкого создания самих дескрипторов. Он выделяет набор дескрипторов
 	// из пула и записывет необходимую информацию для каждого из дескрипторов набора.
 	class VgetDescriptorWriter
 	{
 	public:
 		VgetDescriptorWriter(VgetDescriptorSetLayout& setLayout, VgetDescriptorPool& pool);
+		VgetDescriptorWriter(VgetDescriptorSetLayout& setLayout, VgetDescriptorAllocator& allocator);
 
 		VgetDescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
 		VgetDescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* imageInfo, uint32_t count = 1);
@@ -112,7 +180,50 @@ namespace vget
 
 	private:
 		VgetDescriptorSetLayout& setLayout;
-		VgetDescriptorPool& pool;
+		VgetDescriptorPool* pool = nullptr;				// источник наборов для build() - пул или распределитель
+		VgetDescriptorAllocator* allocator = nullptr;
 		std::vector<VkWriteDescriptorSet> writes;
 	};
+
+	// Шаблон обновления набора дескрипторов (VK_KHR_descriptor_update_template). Привязки схемы один раз описываются
+	// смещениями в структуре данных пользователя, после чего весь набор пишется одним вызовом прямо из этой структуры,
+	// без сборки VkWriteDescriptorSet'ов на каждую запись. Подходит для наборов, которые пишутся часто.
+	// Если расширение не поддерживается, шаблон сам собирает записи по тем же смещениям.
+	class VgetDescriptorUpdateTemplate
+	{
+	public:
+		class Builder
+		{
+		public:
+			Builder(VgetDevice& lveDevice, VgetDescriptorSetLayout& setLayout) : lveDevice{ lveDevice }, setLayout{ setLayout } {}
+
+			// offset - смещение VkDescriptorBufferInfo, VkDescriptorImageInfo или VkBufferView привязки в структуре данных;
+			// stride - шаг между элементами массива, 0 - элементы лежат подряд
+			Builder& addBinding(uint32_t binding, size_t offset, uint32_t count = 1, size_t stride = 0);
+			std::unique_ptr<VgetDescriptorUpdateTemplate> build() const;
+
+		private:
+			VgetDevice& lveDevice;
+			VgetDescriptorSetLayout& setLayout;
+			std::vector<VkDescriptorUpdateTemplateEntry> entries{};
+		};
+
+		VgetDescriptorUpdateTemplate(
+			VgetDevice& lveDevice,
+			VgetDescriptorSetLayout& setLayout,
+			std::vector<VkDescriptorUpdateTemplateEntry> entries);
+		~VgetDescriptorUpdateTemplate();
+		VgetDescriptorUpdateTemplate(const VgetDescriptorUpdateTemplate&) = delete;
+		VgetDescriptorUpdateTemplate& operator=(const VgetDescriptorUpdateTemplate&) = delete;
+
+		// Запись всех привязок шаблона в набор из структуры data
+		void update(VkDescriptorSet set, const void* data) const;
+		// false - расширение не поддерживается и update() пишет набор через vkUpdateDescriptorSets
+		bool isNative() const { return updateTemplate != VK_NULL_HANDLE; }
+
+	private:
+		VgetDevice& lveDevice;
+		std::vector<VkDescriptorUpdateTemplateEntry> entries;
+		VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+	};
 }
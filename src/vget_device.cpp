@@ -1,6 +1,10 @@
 #include "vget_device.hpp"
+#include "vget_render_stats.hpp"
+#include "vget_texture_table.hpp"
+#include "vget_sampler_cache.hpp"
 
 // std headers
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -53,7 +57,7 @@ namespace vget
 	}
 
 	// class member functions
-	VgetDevice::VgetDevice(VgetWindow& window) : window{window}
+	VgetDevice::VgetDevice(VgetWindow& window) : window{&window}
 	{
 		createInstance(); // инициализация Vulkan API
 		setupDebugMessenger(); // инициализация слоя проверок, чтобы отлавливать ошибки во время отладки
@@ -61,10 +65,25 @@ namespace vget
 		pickPhysicalDevice(); // выбор физического девайса (GPU)
 		createLogicalDevice(); // создание логического девайса (выбор технических особенностей GPU для работы с ними)
 		createCommandPool(); // создание пула команд
+		samplerCache = std::make_unique<VgetSamplerCache>(*this);
+		textureTable = std::make_unique<VgetTextureTable>(*this);
+	}
+
+	VgetDevice::VgetDevice()
+	{
+		createInstance();
+		setupDebugMessenger();
+		pickPhysicalDevice(); // без поверхности подходит любой девайс с графической очередью
+		createLogicalDevice();
+		createCommandPool();
+		samplerCache = std::make_unique<VgetSamplerCache>(*this);
+		textureTable = std::make_unique<VgetTextureTable>(*this);
 	}
 
 	VgetDevice::~VgetDevice()
 	{
+		textureTable.reset();
+		samplerCache.reset();
 		vkDestroyCommandPool(device_, commandPool, nullptr);
 		vkDestroyDevice(device_, nullptr);
 
@@ -97,6 +116,10 @@ namespace vget
 		createInfo.pApplicationInfo = &appInfo;
 
 		auto extensions = getRequiredExtensions();
+		// Нужно для запроса возможностей индексирования дескрипторов и бюджета памяти.
+		// Без него ни один девайс не пройдёт проверку isDeviceSuitable.
+		properties2Enabled = isInstanceExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+		if (properties2Enabled) extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 		createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 		createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -135,8 +158,16 @@ namespace vget
 		std::vector<VkPhysicalDevice> devices(deviceCount);
 		vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
 
+		// VGET_PHYSICAL_DEVICE - подстрока имени девайса, например "llvmpipe", чтобы выбрать программный
+		// ICD (lavapipe) на машине, где есть и настоящий GPU
+		const char* requestedName = std::getenv("VGET_PHYSICAL_DEVICE");
+
 		for (const auto &device : devices)
 		{
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(device, &deviceProperties);
+			if (requestedName != nullptr && std::strstr(deviceProperties.deviceName, requestedName) == nullptr) continue;
+
 			if (isDeviceSuitable(device))
 			{
 				physicalDevice = device;
@@ -151,6 +182,14 @@ namespace vget
 
 		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
 		std::cout << "physical device: " << properties.deviceName << std::endl;
+
+		// Лимиты индексирования дескрипторов (их поддержку проверил isDeviceSuitable)
+		auto getProperties2 = (PFN_vkGetPhysicalDeviceProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR");
+		descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &descriptorIndexingProperties;
+		getProperties2(physicalDevice, &properties2);
 	}
 
 	void VgetDevice::createLogicalDevice()
@@ -172,8 +211,29 @@ namespace vget
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures = {}; // возможности ус-ва для активации
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		// Статистика конвейера для профайлера GPU необязательна и включается, только если поддерживается
+		deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+		enabledFeatures = deviceFeatures;
+
+		// Возможности индексирования дескрипторов для таблицы текстур: массив без размера в шейдере,
+		// частично заполненный и обновляемый после привязки
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+		indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+
+		// С цепочкой структур возможностей базовые передаются через VkPhysicalDeviceFeatures2, а pEnabledFeatures пуст
+		VkPhysicalDeviceFeatures2 deviceFeatures2{};
+		deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		deviceFeatures2.pNext = &indexingFeatures;
+		deviceFeatures2.features = deviceFeatures;
 
 		VkDeviceCreateInfo createInfo = {}; // структура для создания логического ус-ва
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -181,9 +241,15 @@ namespace vget
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-		createInfo.pEnabledFeatures = &deviceFeatures;
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		createInfo.pNext = &deviceFeatures2;
+		createInfo.pEnabledFeatures = nullptr;
+		std::vector<const char*> extensions = getDeviceExtensions();
+		const bool memoryBudgetEnabled = properties2Enabled && isDeviceExtensionAvailable(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if (memoryBudgetEnabled) extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		const bool updateTemplateEnabled = isDeviceExtensionAvailable(physicalDevice, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+		if (updateTemplateEnabled) extensions.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		createInfo.ppEnabledExtensionNames = extensions.data();
 
 		// Слои проверок уровня девайса теперь являются устаревшими, но их всё равно стоит указывать для сохранения
 		// совместимости со старыми реализациями. Слои берутся такие же, как и для экземпляра.
@@ -203,8 +269,22 @@ namespace vget
 		}
 
 		// Получение дескрипторов для созданных вместе с девайсом очередей
+		// (без окна семейство отображения совпадает с графическим, см. findQueueFamilies)
 		vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
 		vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+		auto getMemoryProperties2 = memoryBudgetEnabled
+			? (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR")
+			: nullptr;
+		memoryTracker.init(physicalDevice, getMemoryProperties2);
+		memoryTracker.updateBudget();
+
+		if (updateTemplateEnabled)
+		{
+			createDescriptorUpdateTemplate = (PFN_vkCreateDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(device_, "vkCreateDescriptorUpdateTemplateKHR");
+			destroyDescriptorUpdateTemplate = (PFN_vkDestroyDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(device_, "vkDestroyDescriptorUpdateTemplateKHR");
+			updateDescriptorSetWithTemplate = (PFN_vkUpdateDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(device_, "vkUpdateDescriptorSetWithTemplateKHR");
+		}
 	}
 
 	// Создание пула комманд, из которого выделяются буферы команд
@@ -226,7 +306,7 @@ namespace vget
 		}
 	}
 
-	void VgetDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+	void VgetDevice::createSurface() { window->createWindowSurface(instance, &surface_); }
 
 	bool VgetDevice::isDeviceSuitable(VkPhysicalDevice device)
 	{
@@ -234,8 +314,9 @@ namespace vget
 
 		bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-		bool swapChainAdequate = false;
-		if (extensionsSupported)
+		// Без окна цепь обмена не создаётся, и её поддержка не проверяется
+		bool swapChainAdequate = isHeadless();
+		if (extensionsSupported && !isHeadless())
 		{
 			SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
 			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -244,7 +325,25 @@ namespace vget
 		VkPhysicalDeviceFeatures supportedFeatures;
 		vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
-		return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+		return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy &&
+			checkDescriptorIndexingSupport(device);
+	}
+
+	bool VgetDevice::checkDescriptorIndexingSupport(VkPhysicalDevice device)
+	{
+		if (!properties2Enabled) return false;
+		auto getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR");
+		if (getFeatures2 == nullptr) return false;
+
+		VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &indexingFeatures;
+		getFeatures2(device, &features);
+
+		return indexingFeatures.runtimeDescriptorArray && indexingFeatures.descriptorBindingPartiallyBound &&
+			indexingFeatures.descriptorBindingSampledImageUpdateAfterBind && indexingFeatures.descriptorBindingUpdateUnusedWhilePending;
 	}
 
 	// Заполнение информации для создания дескриптора отладочного мессенджера
@@ -307,13 +406,17 @@ namespace vget
 	// Формирование и возврат вектора требуемых для работы нашего движка расширений
 	std::vector<const char *> VgetDevice::getRequiredExtensions()
 	{
-		// Встроенная в GLFW функция создаёт массив с расширениями, которые понадобятся нам для
-		// взаимодействия с системой окон операционной системы.
-		uint32_t glfwExtensionCount = 0;
-		const char **glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		std::vector<const char *> extensions;
 
-		std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		// Встроенная в GLFW функция создаёт массив с расширениями, которые понадобятся нам для
+		// взаимодействия с системой окон операционной системы. Без окна GLFW не инициализирован и не нужен.
+		if (!isHeadless())
+		{
+			uint32_t glfwExtensionCount = 0;
+			const char **glfwExtensions;
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		// добавление расширения для слоя проверок
 		if (enableValidationLayers) {
@@ -362,6 +465,7 @@ namespace vget
 		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
 		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
+		const std::vector<const char*> deviceExtensions = getDeviceExtensions();
 		std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
 		for (const auto &extension : availableExtensions)
@@ -372,6 +476,42 @@ namespace vget
 		return requiredExtensions.empty();
 	}
 
+	bool VgetDevice::isInstanceExtensionAvailable(const char* extension)
+	{
+		uint32_t extensionCount = 0;
+		vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+		for (const auto& properties : extensions)
+		{
+			if (strcmp(properties.extensionName, extension) == 0) return true;
+		}
+		return false;
+	}
+
+	bool VgetDevice::isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extension)
+	{
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+		for (const auto& properties : extensions)
+		{
+			if (strcmp(properties.extensionName, extension) == 0) return true;
+		}
+		return false;
+	}
+
+	// Расширения девайса: без окна расширение цепи обмена не требуется (программные ICD его могут и не иметь)
+	std::vector<const char*> VgetDevice::getDeviceExtensions() const
+	{
+		std::vector<const char*> extensions = descriptorIndexingExtensions;
+		if (!isHeadless()) extensions.insert(extensions.end(), deviceExtensions.begin(), deviceExtensions.end());
+		return extensions;
+	}
+
 	// Функция для заполнения структуры, которая хранит индексы нужных нам семейств очередей
 	QueueFamilyIndices VgetDevice::findQueueFamilies(VkPhysicalDevice device)
 	{
@@ -393,9 +533,17 @@ namespace vget
 				indices.graphicsFamilyHasValue = true;
 			}
 
-			// Добавление индекса семейства, которое поддерживает команды отображения
+			// Добавление индекса семейства, которое поддерживает команды отображения.
+			// Без окна отображения нет: его роль формально играет графическое семейство.
 			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+			if (isHeadless())
+			{
+				presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+			}
+			else
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+			}
 			if (queueFamily.queueCount > 0 && presentSupport)
 			{
 				indices.presentFamily = i;
@@ -480,7 +628,8 @@ namespace vget
 		VkBufferUsageFlags usage,
 		VkMemoryPropertyFlags properties,
 		VkBuffer &buffer,
-		VkDeviceMemory &bufferMemory)
+		VkDeviceMemory &bufferMemory,
+		const MemoryTag& tag)
 	{
 		// Создание буфера
 		VkBufferCreateInfo bufferInfo{};
@@ -507,6 +656,9 @@ namespace vget
 		if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
 			throw std::runtime_error("failed to allocate vertex buffer memory!");
 		}
+		MemoryTag bufferTag = tag;
+		if (bufferTag.category == MemoryCategory::Unknown) bufferTag.category = VgetMemoryTracker::categoryFromBufferUsage(usage);
+		memoryTracker.onAllocate(bufferMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, bufferTag);
 
 		// Связывание объектов буфера и памяти девайса.
 		vkBindBufferMemory(device_, buffer, bufferMemory, 0);
@@ -521,7 +673,10 @@ namespace vget
 		allocInfo.commandBufferCount = 1;
 
 		VkCommandBuffer commandBuffer;
-		vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+		{
+			std::lock_guard<std::mutex> lock{ queueMutex };
+			vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+		}
 
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -540,8 +695,10 @@ namespace vget
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer;
 
+		std::lock_guard<std::mutex> lock{ queueMutex };
 		vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
 		vkQueueWaitIdle(graphicsQueue_);
+		VgetRenderStats::add(RenderCounter::QueueSubmits);
 
 		vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 	}
@@ -591,7 +748,8 @@ namespace vget
 		const VkImageCreateInfo& imageInfo,
 		VkMemoryPropertyFlags properties,
 		VkImage& image,
-		VkDeviceMemory& imageMemory)
+		VkDeviceMemory& imageMemory,
+		const MemoryTag& tag)
 	{
 		if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS)
 		{
@@ -612,6 +770,9 @@ namespace vget
 		{
 			throw std::runtime_error("failed to allocate image memory!");
 		}
+		MemoryTag imageTag = tag;
+		if (imageTag.category == MemoryCategory::Unknown) imageTag.category = VgetMemoryTracker::categoryFromImageUsage(imageInfo.usage);
+		memoryTracker.onAllocate(imageMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, imageTag);
 
 		// Связывание объектов изображения и памяти девайса
 		if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS)
@@ -620,4 +781,10 @@ namespace vget
 		}
 	}
 
+	void VgetDevice::freeMemory(VkDeviceMemory memory)
+	{
+		memoryTracker.onFree(memory);
+		vkFreeMemory(device_, memory, nullptr);
+	}
+
 }  // namespace lve
\ No newline at end of file
@@ -2,8 +2,11 @@
 #pragma once
 
 #include "vget_window.hpp"
+#include "vget_memory_tracker.hpp"
 
 // std lib headers
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -27,6 +30,9 @@ namespace vget
 		bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 	};
 
+	class VgetTextureTable;
+	class VgetSamplerCache;
+
 	class VgetDevice
 	{
 	public:
@@ -37,6 +43,9 @@ namespace vget
 #endif
 
 		VgetDevice(VgetWindow& window);
+		//    (headless):  ,   ,    .
+		//      (VgetOffscreenTarget),     ICD (lavapipe).
+		VgetDevice();
 		~VgetDevice();
 
 		// Not copyable or movable
@@ -48,11 +57,21 @@ namespace vget
 		VkCommandPool getCommandPool() { return commandPool; }
 		VkDevice device() { return device_; }
 		VkSurfaceKHR surface() { return surface_; }
+		bool isHeadless() const { return window == nullptr; }
 		VkQueue graphicsQueue() { return graphicsQueue_; }
 		VkQueue presentQueue() { return presentQueue_; }
+		//        .   ,  
+		//       (    )    .
+		std::mutex& getQueueMutex() { return queueMutex; }
 		VkInstance getInstance() { return instance; }
 		VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
 		uint32_t getGraphicsQueueFamily() { return findPhysicalQueueFamilies().graphicsFamily; }
+		//     ;   ,   VK_EXT_memory_budget
+		VgetMemoryTracker& getMemoryTracker() { return memoryTracker; }
+		//   ,      VgetTexture
+		VgetTextureTable& getTextureTable() { return *textureTable; }
+		//     
+		VgetSamplerCache& getSamplerCache() { return *samplerCache; }
 
 		SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
 		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -65,7 +84,8 @@ namespace vget
 			VkBufferUsageFlags usage,
 			VkMemoryPropertyFlags properties,
 			VkBuffer& buffer,
-			VkDeviceMemory& bufferMemory);
+			VkDeviceMemory& bufferMemory,
+			const MemoryTag& tag = {});
 		VkCommandBuffer beginSingleTimeCommands();
 		void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -76,9 +96,18 @@ namespace vget
 			const VkImageCreateInfo& imageInfo,
 			VkMemoryPropertyFlags properties,
 			VkImage& image,
-			VkDeviceMemory& imageMemory);
+			VkDeviceMemory& imageMemory,
+			const MemoryTag& tag = {});
+		//  ,  createBuffer  createImageWithInfo,     
+		void freeMemory(VkDeviceMemory memory);
 
 		VkPhysicalDeviceProperties properties;
+		VkPhysicalDeviceFeatures enabledFeatures{}; // ,     -
+		VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties{}; //       
+		//  VK_KHR_descriptor_update_template (. VgetDescriptorUpdateTemplate), nullptr -   
+		PFN_vkCreateDescriptorUpdateTemplateKHR createDescriptorUpdateTemplate = nullptr;
+		PFN_vkDestroyDescriptorUpdateTemplateKHR destroyDescriptorUpdateTemplate = nullptr;
+		PFN_vkUpdateDescriptorSetWithTemplateKHR updateDescriptorSetWithTemplate = nullptr;
 
 	private:
 		void createInstance();
@@ -96,21 +125,33 @@ namespace vget
 		void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
 		void hasGlfwRequiredInstanceExtensions();
 		bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+		//  VK_EXT_descriptor_indexing,      
+		bool checkDescriptorIndexingSupport(VkPhysicalDevice device);
+		bool isInstanceExtensionAvailable(const char* extension);
+		bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extension);
+		std::vector<const char*> getDeviceExtensions() const;
 		SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
 		VkInstance instance;
 		VkDebugUtilsMessengerEXT debugMessenger;
 		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-		VgetWindow& window;
+		VgetWindow* window = nullptr; // nullptr -   
 		VkCommandPool commandPool;
 
 		VkDevice device_;
-		VkSurfaceKHR surface_;
+		VkSurfaceKHR surface_ = VK_NULL_HANDLE;
 		VkQueue graphicsQueue_;
 		VkQueue presentQueue_;
+		std::mutex queueMutex;
+		VgetMemoryTracker memoryTracker;
+		bool properties2Enabled = false; //  VK_KHR_get_physical_device_properties2 (    VK_EXT_memory_budget)
+		std::unique_ptr<VgetSamplerCache> samplerCache;
+		std::unique_ptr<VgetTextureTable> textureTable;
 
 		//   VK_LAYER_KHRONOS_validation     
 		const std::vector<const char*> validationLayers = {"VK_LAYER_KHRONOS_validation"};
 		const std::vector<const char*> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+		//    :      
+		const std::vector<const char*> descriptorIndexingExtensions = {VK_KHR_MAINTENANCE3_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME};
 	};
 } // namespace lve
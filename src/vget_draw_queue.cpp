@@ -0,0 +1,82 @@
+#include "vget_draw_queue.hpp"
+
+// std
+#include <array>
+
+namespace vget
+{
+	void radixSort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch)
+	{
+		constexpr int RADIX_BITS = 11;
+		constexpr int BUCKET_COUNT = 1 << RADIX_BITS;
+		constexpr int PASS_COUNT = (64 + RADIX_BITS - 1) / RADIX_BITS;
+
+		const size_t count = packets.size();
+		if (count < 2) return;
+
+		std::array<std::array<uint32_t, BUCKET_COUNT>, PASS_COUNT> histograms{};
+		for (const auto& packet : packets)
+		{
+			for (int pass = 0; pass < PASS_COUNT; ++pass)
+			{
+				++histograms[pass][(packet.key >> (pass * RADIX_BITS)) & (BUCKET_COUNT - 1)];
+			}
+		}
+
+		scratch.resize(count);
+		DrawPacket* source = packets.data();
+		DrawPacket* destination = scratch.data();
+		for (int pass = 0; pass < PASS_COUNT; ++pass)
+		{
+			auto& histogram = histograms[pass];
+			const int shift = pass * RADIX_BITS;
+
+			// Если у всех ключей этот разряд одинаков, проход ничего не меняет
+			if (histogram[(source[0].key >> shift) & (BUCKET_COUNT - 1)] == count) continue;
+
+			// Гистограмма превращается в смещения начала каждой корзины
+			uint32_t offset = 0;
+			for (auto& bucket : histogram)
+			{
+				const uint32_t bucketSize = bucket;
+				bucket = offset;
+				offset += bucketSize;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				destination[histogram[(source[i].key >> shift) & (BUCKET_COUNT - 1)]++] = source[i];
+			}
+			std::swap(source, destination);
+		}
+
+		// После нечётного количества выполненных проходов результат лежит в scratch
+		if (source != packets.data())
+		{
+			packets.swap(scratch);
+		}
+	}
+
+	uint32_t countStateChanges(const std::vector<DrawPacket>& packets)
+	{
+		uint32_t changes = 0;
+		uint64_t previousState = ~uint64_t{ 0 };
+		for (const auto& packet : packets)
+		{
+			const uint64_t state = packet.key & DrawKey::STATE_MASK;
+			changes += state != previousState;
+			previousState = state;
+		}
+		return changes;
+	}
+
+	void VgetDrawQueue::sort()
+	{
+		const uint32_t submissionOrderChanges = countStateChanges(packets);
+		radixSort(packets, scratch);
+
+		stats.draws = static_cast<uint32_t>(packets.size());
+		stats.stateChanges = countStateChanges(packets);
+		stats.elided = submissionOrderChanges - stats.stateChanges;
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS			  // Функции GLM будут работать с радианами, а не градусами
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE   // GLM будет ожидать интервал нашего буфера глубины от 0 до 1 (например, для OpenGL используется интервал от -1 до 1)
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace vget
+{
+	// 64-битный ключ сортировки отрисовок. Старшие поля важнее младших, поэтому после сортировки по возрастанию
+	// отрисовки сгруппированы по пайплайну, внутри него по материалу, затем по модели, а одинаковые - от ближних к дальним.
+	// [63..56] пайплайн | [55..40] материал | [39..24] модель | [23..0] глубина
+	namespace DrawKey
+	{
+		constexpr uint32_t PIPELINE_BITS = 8;
+		constexpr uint32_t MATERIAL_BITS = 16;
+		constexpr uint32_t MODEL_BITS = 16;
+		constexpr uint32_t DEPTH_BITS = 24;
+
+		constexpr uint32_t DEPTH_SHIFT = 0;
+		constexpr uint32_t MODEL_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+		constexpr uint32_t MATERIAL_SHIFT = MODEL_SHIFT + MODEL_BITS;
+		constexpr uint32_t PIPELINE_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+
+		// Поля, смена которых требует смены состояния при записи команд (всё, кроме глубины)
+		constexpr uint64_t STATE_MASK = ~((uint64_t{ 1 } << MODEL_SHIFT) - 1);
+
+		// depth - нормализованная глубина [0; 1]; значения за пределами диапазона прижимаются к границам.
+		// Поля шире своего количества бит обрезаются: это влияет только на группировку, но не на корректность.
+		inline uint64_t make(uint32_t pipeline, uint32_t material, uint32_t model, float depth)
+		{
+			const float clamped = depth > 0.f ? (depth < 1.f ? depth : 1.f) : 0.f;
+			const uint64_t quantizedDepth = static_cast<uint64_t>(clamped * static_cast<float>((1u << DEPTH_BITS) - 1));
+			return (static_cast<uint64_t>(pipeline & ((1u << PIPELINE_BITS) - 1)) << PIPELINE_SHIFT) |
+				(static_cast<uint64_t>(material & ((1u << MATERIAL_BITS) - 1)) << MATERIAL_SHIFT) |
+				(static_cast<uint64_t>(model & ((1u << MODEL_BITS) - 1)) << MODEL_SHIFT) |
+				(quantizedDepth << DEPTH_SHIFT);
+		}
+
+		// Отображение float в беззнаковое целое с сохранением порядка (для поразрядной сортировки по вещественному ключу):
+		// у положительных чисел выставляется знаковый бит, у отрицательных инвертируются все биты.
+		inline uint32_t orderedFloat(float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+		}
+
+		// Глубина точки в пространстве отсечения [0; 1]. Точки позади камеры считаются ближайшими.
+		inline float depth(const glm::mat4& viewProjection, const glm::vec3& point)
+		{
+			const glm::vec4 clip = viewProjection * glm::vec4(point, 1.f);
+			return clip.w > 0.f ? clip.z / clip.w : 0.f;
+		}
+	}
+
+	// Пакет отрисовки: ключ сортировки и индекс данных отрисовки, которые хранит сама система рендера
+	struct DrawPacket
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	// Итоги сортировки отрисовок за кадр
+	struct DrawStats
+	{
+		uint32_t draws = 0;
+		uint32_t stateChanges = 0;	// переключений пайплайна/материала/модели в отсортированном порядке
+		uint32_t elided = 0;		// переключений, которых удалось избежать по сравнению с порядком добавления
+
+		DrawStats& operator+=(const DrawStats& other)
+		{
+			draws += other.draws;
+			stateChanges += other.stateChanges;
+			elided += other.elided;
+			return *this;
+		}
+	};
+
+	// Стабильная поразрядная сортировка (LSD radix sort) пакетов по ключу: 6 проходов по 11 бит.
+	// Гистограммы всех разрядов считаются за один проход по данным, а разряды, одинаковые у всех ключей, пропускаются.
+	// scratch - буфер для промежуточных результатов, переиспользуемый между вызовами.
+	void radixSort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch);
+
+	// Количество переключений состояния (изменений полей STATE_MASK ключа) при отрисовке пакетов в данном порядке
+	uint32_t countStateChanges(const std::vector<DrawPacket>& packets);
+
+	// Покадровая очередь отрисовок одной системы рендера. Память пакетов переиспользуется между кадрами.
+	class VgetDrawQueue
+	{
+	public:
+		void clear() { packets.clear(); }
+		void reserve(size_t count) { packets.reserve(count); scratch.reserve(count); }
+		void add(uint64_t key, uint32_t index) { packets.push_back(DrawPacket{ key, index }); }
+		size_t size() const { return packets.size(); }
+
+		// Сортировка пакетов по ключу с подсчётом статистики переключений состояния
+		void sort();
+
+		const std::vector<DrawPacket>& getPackets() const { return packets; }
+		const DrawStats& getStats() const { return stats; }
+
+	private:
+		std::vector<DrawPacket> packets;
+		std::vector<DrawPacket> scratch;
+		DrawStats stats{};
+	};
+}
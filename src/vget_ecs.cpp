@@ -0,0 +1,175 @@
+#include "vget_ecs.hpp"
+
+namespace vget
+{
+	namespace detail
+	{
+		uint32_t nextComponentTypeId()
+		{
+			static std::atomic<uint32_t> nextId{ 0 };
+			return nextId++;
+		}
+	}
+
+	VgetWorld::VgetWorld()
+	{
+		getArchetype(0); // архетип сущностей без компонентов
+	}
+
+	Archetype& VgetWorld::getArchetype(ComponentMask mask)
+	{
+		auto found = archetypesByMask.find(mask);
+		if (found != archetypesByMask.end()) return *found->second;
+
+		auto archetype = std::make_unique<Archetype>();
+		archetype->mask = mask;
+		archetype->columnIndices.fill(-1);
+		for (uint32_t typeId = 0; typeId < MAX_COMPONENT_TYPES; ++typeId)
+		{
+			if (!(mask & (ComponentMask{ 1 } << typeId))) continue;
+			archetype->columnIndices[typeId] = static_cast<int8_t>(archetype->typeIds.size());
+			archetype->typeIds.push_back(typeId);
+		}
+
+		Archetype& result = *archetype;
+		archetypes.push_back(archetype.get());
+		archetypesByMask.emplace(mask, std::move(archetype));
+		return result;
+	}
+
+	Entity VgetWorld::allocateEntity()
+	{
+		uint32_t index;
+		if (!freeIndices.empty())
+		{
+			index = freeIndices.back();
+			freeIndices.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32_t>(records.size());
+			records.emplace_back();
+		}
+		++aliveCount;
+		return Entity{ index, records[index].generation };
+	}
+
+	std::pair<EntityChunk*, uint32_t> VgetWorld::appendRow(Archetype& archetype, Entity entity)
+	{
+		if (archetype.chunks.empty() || archetype.chunks.back()->size() == CHUNK_CAPACITY)
+		{
+			auto chunk = std::make_unique<EntityChunk>();
+			chunk->entities.reserve(CHUNK_CAPACITY);
+			for (uint32_t typeId : archetype.typeIds)
+			{
+				chunk->columns.push_back(columnPrototypes[typeId]->createEmpty(CHUNK_CAPACITY));
+			}
+			archetype.chunks.push_back(std::move(chunk));
+		}
+
+		++structureVersion;
+		EntityChunk* chunk = archetype.chunks.back().get();
+		const uint32_t row = chunk->size();
+		chunk->entities.push_back(entity);
+		++archetype.entityCount;
+
+		auto& record = records[entity.index];
+		record.archetype = &archetype;
+		record.chunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+		record.row = row;
+		return { chunk, row };
+	}
+
+	void VgetWorld::removeRow(Archetype& archetype, uint32_t chunkIndex, uint32_t row)
+	{
+		++structureVersion;
+		EntityChunk& chunk = *archetype.chunks[chunkIndex];
+		EntityChunk& lastChunk = *archetype.chunks.back();
+		const uint32_t lastRow = lastChunk.size() - 1;
+
+		if (&chunk != &lastChunk || row != lastRow)
+		{
+			for (size_t column = 0; column < chunk.columns.size(); ++column)
+			{
+				chunk.columns[column]->assignFrom(*lastChunk.columns[column], lastRow, row);
+			}
+			const Entity moved = lastChunk.entities[lastRow];
+			chunk.entities[row] = moved;
+			records[moved.index].chunk = chunkIndex;
+			records[moved.index].row = row;
+		}
+
+		for (auto& column : lastChunk.columns) column->popBack();
+		lastChunk.entities.pop_back();
+		if (lastChunk.entities.empty()) archetype.chunks.pop_back();
+		--archetype.entityCount;
+	}
+
+	void VgetWorld::moveEntity(Entity entity, ComponentMask mask)
+	{
+		const EntityRecord source = records[entity.index];
+		Archetype& sourceArchetype = *source.archetype;
+		Archetype& destination = getArchetype(mask);
+		EntityChunk& sourceChunk = *sourceArchetype.chunks[source.chunk];
+
+		EntityChunk* chunk = appendRow(destination, entity).first;
+		for (uint32_t typeId : destination.typeIds)
+		{
+			const int8_t sourceColumn = sourceArchetype.columnIndices[typeId];
+			if (sourceColumn < 0) continue;
+			chunk->columns[destination.columnIndices[typeId]]->pushFrom(*sourceChunk.columns[sourceColumn], source.row);
+		}
+
+		// appendRow() уже записал новое положение сущности, а removeRow() обновит только перенесённую на её место
+		removeRow(sourceArchetype, source.chunk, source.row);
+	}
+
+	void VgetWorld::destroyEntity(Entity entity)
+	{
+		if (!isAlive(entity)) return;
+
+		auto& record = records[entity.index];
+		for (uint32_t typeId : record.archetype->typeIds)
+		{
+			++componentVersions[typeId];
+			// ячейка достанется новой сущности, которая не должна унаследовать отметку об изменении
+			if (trackedMask & (ComponentMask{ 1 } << typeId)) resetChangedBit(typeId, entity.index);
+		}
+		removeRow(*record.archetype, record.chunk, record.row);
+
+		record.archetype = nullptr;
+		++record.generation;
+		freeIndices.push_back(entity.index);
+		--aliveCount;
+	}
+
+	bool VgetWorld::isAlive(Entity entity) const
+	{
+		return entity.index < records.size() && records[entity.index].archetype != nullptr
+			&& records[entity.index].generation == entity.generation;
+	}
+
+	void VgetWorld::setChangedBit(uint32_t typeId, Entity entity)
+	{
+		ChangeSet& changes = changeSets[typeId];
+		const size_t word = entity.index / 64;
+		const uint64_t bit = uint64_t{ 1 } << (entity.index % 64);
+		if (word >= changes.bits.size()) changes.bits.resize(std::max(word + 1, records.size() / 64 + 1), 0);
+		if (changes.bits[word] & bit) return;
+		changes.bits[word] |= bit;
+		changes.entities.push_back(entity);
+	}
+
+	void VgetWorld::resetChangedBit(uint32_t typeId, uint32_t index)
+	{
+		ChangeSet& changes = changeSets[typeId];
+		const size_t word = index / 64;
+		if (word < changes.bits.size()) changes.bits[word] &= ~(uint64_t{ 1 } << (index % 64));
+	}
+
+	Entity VgetWorld::entityAt(uint32_t index) const
+	{
+		if (index >= records.size() || records[index].archetype == nullptr) return Entity{};
+		return Entity{ index, records[index].generation };
+	}
+}
@@ -0,0 +1,375 @@
+#pragma once
+
+#include "vget_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vget
+{
+	// Дескриптор сущности: индекс ячейки в таблице сущностей и поколение этой ячейки.
+	// После уничтожения сущности поколение ячейки увеличивается, поэтому старые дескрипторы становятся недействительными,
+	// даже если ячейка уже занята новой сущностью.
+	struct Entity
+	{
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+
+		uint32_t index = INVALID_INDEX;
+		uint32_t generation = 0;
+
+		bool valid() const { return index != INVALID_INDEX; }
+		bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const Entity& other) const { return !(*this == other); }
+	};
+
+	using ComponentMask = uint64_t;
+	constexpr uint32_t MAX_COMPONENT_TYPES = 64;
+
+	namespace detail
+	{
+		uint32_t nextComponentTypeId();
+	}
+
+	// Уникальный номер типа компонента, выдаётся при первом обращении к типу
+	template <typename T>
+	uint32_t componentTypeId()
+	{
+		static const uint32_t id = detail::nextComponentTypeId();
+		return id;
+	}
+
+	template <typename... Ts>
+	ComponentMask componentMask()
+	{
+		return (ComponentMask{ 0 } | ... | (ComponentMask{ 1 } << componentTypeId<Ts>()));
+	}
+
+	// Компоненты с полем static constexpr bool TRACK_CHANGES = true отслеживаются VgetWorld::markChanged():
+	// изменённые сущности хранятся вне компонента, поэтому системам не нужно читать каждый компонент ради флага.
+	template <typename T, typename = void>
+	struct TracksChanges : std::false_type {};
+
+	template <typename T>
+	struct TracksChanges<T, std::void_t<decltype(T::TRACK_CHANGES)>> : std::bool_constant<T::TRACK_CHANGES> {};
+
+	// Столбец компонентов одного типа внутри чанка. Виртуальные методы нужны только для структурных изменений
+	// (перенос сущности между архетипами и удаление), а перебор идёт по типизированному массиву.
+	class ComponentColumn
+	{
+	public:
+		virtual ~ComponentColumn() = default;
+		virtual std::unique_ptr<ComponentColumn> createEmpty(uint32_t capacity) const = 0;
+		// Добавление в конец компонента, перемещённого из строки row другого столбца того же типа
+		virtual void pushFrom(ComponentColumn& source, uint32_t row) = 0;
+		virtual void assignFrom(ComponentColumn& source, uint32_t sourceRow, uint32_t row) = 0;
+		virtual void popBack() = 0;
+	};
+
+	template <typename T>
+	class TypedComponentColumn : public ComponentColumn
+	{
+	public:
+		std::unique_ptr<ComponentColumn> createEmpty(uint32_t capacity) const override
+		{
+			auto column = std::make_unique<TypedComponentColumn<T>>();
+			column->data.reserve(capacity);
+			return column;
+		}
+		void pushFrom(ComponentColumn& source, uint32_t row) override
+		{
+			data.push_back(std::move(static_cast<TypedComponentColumn<T>&>(source).data[row]));
+		}
+		void assignFrom(ComponentColumn& source, uint32_t sourceRow, uint32_t row) override
+		{
+			data[row] = std::move(static_cast<TypedComponentColumn<T>&>(source).data[sourceRow]);
+		}
+		void popBack() override { data.pop_back(); }
+
+		std::vector<T> data;
+	};
+
+	// Чанк архетипа: до CHUNK_CAPACITY сущностей, компоненты каждого типа лежат отдельным непрерывным массивом (SoA)
+	struct EntityChunk
+	{
+		std::vector<Entity> entities;
+		std::vector<std::unique_ptr<ComponentColumn>> columns;	// в порядке типов архетипа
+
+		uint32_t size() const { return static_cast<uint32_t>(entities.size()); }
+	};
+
+	// Архетип - набор сущностей с одинаковым составом компонентов. Все чанки, кроме последнего, заполнены полностью.
+	struct Archetype
+	{
+		ComponentMask mask = 0;
+		std::vector<uint32_t> typeIds;	// номера типов компонентов по возрастанию
+		std::array<int8_t, MAX_COMPONENT_TYPES> columnIndices{};	// номер столбца для типа компонента, -1 - нет
+		std::vector<std::unique_ptr<EntityChunk>> chunks;
+		uint32_t entityCount = 0;
+
+		template <typename T>
+		T* columnData(EntityChunk& chunk) const
+		{
+			const int8_t column = columnIndices[componentTypeId<T>()];
+			assert(column >= 0 && "Archetype has no such component");
+			return static_cast<TypedComponentColumn<T>&>(*chunk.columns[column]).data.data();
+		}
+	};
+
+	// Хранилище сущностей на архетипах. Сущности с одинаковым набором компонентов хранятся вместе в чанках
+	// фиксированного размера, поэтому системы перебирают плотные массивы компонентов без обращения по указателям.
+	// Добавление и удаление компонента переносит сущность в другой архетип (структурное изменение); во время перебора
+	// структурные изменения запрещены, а указатели на компоненты действительны только до следующего такого изменения.
+	class VgetWorld
+	{
+	public:
+		static constexpr uint32_t CHUNK_CAPACITY = 1024;
+
+		VgetWorld();
+
+		VgetWorld(const VgetWorld&) = delete;
+		VgetWorld& operator=(const VgetWorld&) = delete;
+
+		template <typename... Ts>
+		Entity createEntity(Ts... components)
+		{
+			(registerComponent<Ts>(), ...);
+			Archetype& archetype = getArchetype(componentMask<Ts...>());
+			const Entity entity = allocateEntity();
+			const auto location = appendRow(archetype, entity);
+			(static_cast<TypedComponentColumn<Ts>&>(*location.first->columns[archetype.columnIndices[componentTypeId<Ts>()]])
+				.data.push_back(std::move(components)), ...);
+			(++componentVersions[componentTypeId<Ts>()], ...);
+			(markAdded<Ts>(entity), ...);
+			return entity;
+		}
+
+		void destroyEntity(Entity entity);
+		bool isAlive(Entity entity) const;
+		// Действующий дескриптор сущности, занимающей ячейку index (недействительный, если ячейка свободна)
+		Entity entityAt(uint32_t index) const;
+		size_t size() const { return aliveCount; }
+
+		template <typename T>
+		T& addComponent(Entity entity, T component)
+		{
+			registerComponent<T>();
+			assert(isAlive(entity) && "Entity is not alive");
+			const uint32_t typeId = componentTypeId<T>();
+			markAdded<T>(entity);
+			if (records[entity.index].archetype->mask & (ComponentMask{ 1 } << typeId))
+			{
+				T& existing = *getComponent<T>(entity);
+				existing = std::move(component);
+				return existing;
+			}
+			moveEntity(entity, records[entity.index].archetype->mask | (ComponentMask{ 1 } << typeId));
+			const auto& record = records[entity.index];
+			auto& column = static_cast<TypedComponentColumn<T>&>(
+				*record.archetype->chunks[record.chunk]->columns[record.archetype->columnIndices[typeId]]);
+			column.data.push_back(std::move(component));
+			++componentVersions[typeId];
+			return column.data.back();
+		}
+
+		template <typename T>
+		void removeComponent(Entity entity)
+		{
+			assert(isAlive(entity) && "Entity is not alive");
+			const ComponentMask bit = ComponentMask{ 1 } << componentTypeId<T>();
+			if (!(records[entity.index].archetype->mask & bit)) return;
+			moveEntity(entity, records[entity.index].archetype->mask & ~bit);
+			++componentVersions[componentTypeId<T>()];
+			if constexpr (TracksChanges<T>::value) resetChanged<T>(entity);
+		}
+
+		// Отметка об изменении компонента T сущности (только для компонентов с TRACK_CHANGES). Сущность попадает
+		// в список изменённых один раз до clearChanged<T>(), а флаг хранится в битовом массиве по индексу сущности.
+		// Добавление компонента отмечает его автоматически. Не потокобезопасно, как и структурные изменения.
+		template <typename T>
+		void markChanged(Entity entity)
+		{
+			static_assert(TracksChanges<T>::value, "Component does not track changes");
+			assert(hasComponent<T>(entity) && "Entity has no such component");
+			setChangedBit(componentTypeId<T>(), entity);
+		}
+
+		template <typename T>
+		bool isChanged(Entity entity) const
+		{
+			static_assert(TracksChanges<T>::value, "Component does not track changes");
+			const ChangeSet& changes = changeSets[componentTypeId<T>()];
+			const size_t word = entity.index / 64;
+			return isAlive(entity) && word < changes.bits.size() && (changes.bits[word] >> (entity.index % 64)) & 1;
+		}
+
+		// Снятие отметки с одной сущности: она остаётся в списке, но isChanged() для неё возвращает false
+		template <typename T>
+		void resetChanged(Entity entity) { resetChangedBit(componentTypeId<T>(), entity.index); }
+
+		// Сущности, отмеченные с последнего clearChanged<T>(). Список может содержать уничтоженные сущности
+		// и сущности со снятой отметкой - перед использованием их нужно проверить через isChanged<T>().
+		template <typename T>
+		const std::vector<Entity>& getChanged() const { return changeSets[componentTypeId<T>()].entities; }
+
+		template <typename T>
+		void clearChanged()
+		{
+			ChangeSet& changes = changeSets[componentTypeId<T>()];
+			for (const Entity entity : changes.entities) resetChangedBit(componentTypeId<T>(), entity.index);
+			changes.entities.clear();
+		}
+
+		// nullptr, если сущность мертва или компонента у неё нет
+		template <typename T>
+		T* getComponent(Entity entity)
+		{
+			if (!isAlive(entity)) return nullptr;
+			const auto& record = records[entity.index];
+			const int8_t column = record.archetype->columnIndices[componentTypeId<T>()];
+			if (column < 0) return nullptr;
+			return &static_cast<TypedComponentColumn<T>&>(*record.archetype->chunks[record.chunk]->columns[column]).data[record.row];
+		}
+
+		template <typename T>
+		bool hasComponent(Entity entity) const
+		{
+			return isAlive(entity) && (records[entity.index].archetype->mask & (ComponentMask{ 1 } << componentTypeId<T>()));
+		}
+
+		// Номер изменения состава сущностей с компонентом T (добавление/удаление компонента, создание/уничтожение сущности).
+		// Системы, кэширующие данные по таким сущностям, сравнивают его с сохранённым.
+		template <typename T>
+		uint64_t getComponentVersion() const { return componentVersions[componentTypeId<T>()]; }
+		// Номер любого структурного изменения. Пока он не изменился, указатели на компоненты остаются действительными.
+		uint64_t getStructureVersion() const { return structureVersion; }
+
+		template <typename... Ts>
+		size_t count() const
+		{
+			const ComponentMask mask = componentMask<Ts...>();
+			size_t result = 0;
+			for (const Archetype* archetype : archetypes)
+			{
+				if ((archetype->mask & mask) == mask) result += archetype->entityCount;
+			}
+			return result;
+		}
+
+		// Перебор сущностей, у которых есть все компоненты Ts: func(Entity, Ts&...)
+		template <typename... Ts, typename Func>
+		void forEach(Func&& func)
+		{
+			forEachChunk<Ts...>([&](const Entity* entities, uint32_t count, Ts*... components)
+			{
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					func(entities[i], components[i]...);
+				}
+			});
+		}
+
+		// Перебор по чанкам: func(const Entity* entities, uint32_t count, Ts*... components)
+		template <typename... Ts, typename Func>
+		void forEachChunk(Func&& func)
+		{
+			const ComponentMask mask = componentMask<Ts...>();
+			for (Archetype* archetype : archetypes)
+			{
+				if ((archetype->mask & mask) != mask) continue;
+				for (auto& chunk : archetype->chunks)
+				{
+					func(chunk->entities.data(), chunk->size(), archetype->template columnData<Ts>(*chunk)...);
+				}
+			}
+		}
+
+		// Параллельный перебор по чанкам: каждый чанк - отдельный элемент parallelFor планировщика задач.
+		// Func вызывается из нескольких потоков одновременно и может изменять только компоненты своего чанка.
+		template <typename... Ts, typename Func>
+		void parallelForEachChunk(VgetJobSystem& jobSystem, Func&& func)
+		{
+			const ComponentMask mask = componentMask<Ts...>();
+			std::vector<std::pair<Archetype*, EntityChunk*>> chunks;
+			for (Archetype* archetype : archetypes)
+			{
+				if ((archetype->mask & mask) != mask) continue;
+				for (auto& chunk : archetype->chunks) chunks.emplace_back(archetype, chunk.get());
+			}
+
+			jobSystem.parallelFor(0, static_cast<uint32_t>(chunks.size()), 1, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					Archetype& archetype = *chunks[i].first;
+					EntityChunk& chunk = *chunks[i].second;
+					func(chunk.entities.data(), chunk.size(), archetype.template columnData<Ts>(chunk)...);
+				}
+			});
+		}
+
+	private:
+		struct EntityRecord
+		{
+			uint32_t generation = 0;
+			Archetype* archetype = nullptr;	// nullptr - ячейка свободна
+			uint32_t chunk = 0;
+			uint32_t row = 0;
+		};
+
+		// Изменённые сущности одного типа компонента: бит на индекс сущности и список для обхода без поиска по битам
+		struct ChangeSet
+		{
+			std::vector<uint64_t> bits;
+			std::vector<Entity> entities;
+		};
+
+		template <typename T>
+		void registerComponent()
+		{
+			const uint32_t typeId = componentTypeId<T>();
+			assert(typeId < MAX_COMPONENT_TYPES && "Too many component types");
+			if (!columnPrototypes[typeId]) columnPrototypes[typeId] = std::make_unique<TypedComponentColumn<T>>();
+			if constexpr (TracksChanges<T>::value) trackedMask |= ComponentMask{ 1 } << typeId;
+		}
+
+		template <typename T>
+		void markAdded(Entity entity)
+		{
+			if constexpr (TracksChanges<T>::value) setChangedBit(componentTypeId<T>(), entity);
+		}
+
+		void setChangedBit(uint32_t typeId, Entity entity);
+		void resetChangedBit(uint32_t typeId, uint32_t index);
+
+		Archetype& getArchetype(ComponentMask mask);
+		Entity allocateEntity();
+		// Резервирование строки в конце архетипа (столбцы заполняет вызывающий). Возвращает чанк и номер строки.
+		std::pair<EntityChunk*, uint32_t> appendRow(Archetype& archetype, Entity entity);
+		// Удаление строки: на её место переносится последняя сущность архетипа
+		void removeRow(Archetype& archetype, uint32_t chunk, uint32_t row);
+		// Перенос сущности в архетип с маской mask. Общие компоненты перемещаются, лишние уничтожаются, а столбцы
+		// новых компонентов остаются короче на одну строку - их дополняет вызывающий.
+		void moveEntity(Entity entity, ComponentMask mask);
+
+		std::vector<EntityRecord> records;
+		std::vector<uint32_t> freeIndices;
+		size_t aliveCount = 0;
+
+		std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypesByMask;
+		std::vector<Archetype*> archetypes;
+		std::array<std::unique_ptr<ComponentColumn>, MAX_COMPONENT_TYPES> columnPrototypes;
+		std::array<uint64_t, MAX_COMPONENT_TYPES> componentVersions{};
+		uint64_t structureVersion = 0;
+		std::array<ChangeSet, MAX_COMPONENT_TYPES> changeSets;
+		ComponentMask trackedMask = 0;	// типы компонентов с TRACK_CHANGES
+	};
+}
@@ -2,30 +2,35 @@
 
 #include "vget_camera.hpp"
 #include "vget_game_object.hpp"
+#include "vget_aabb_tree.hpp"
+#include "vget_occlusion.hpp"
+#include "vget_pvs.hpp"
+#include "vget_pass_recorder.hpp"
+#include "vget_frame_pipeline.hpp"
+#include "vget_light_clusters.hpp"
 
 // lib
 #include <vulkan/vulkan.h>
 
 namespace vget
 {
-#define MAX_LIGHTS 10
-
-	struct PointLight
-	{
-		glm::vec4 position{}; // w - игнорируется
-		glm::vec4 color{};	  // w - интенсивность цвета
-	};
-
 	// Структура, хранящая нужную для отрисовки кадра информацию.
 	// Используется для удобной передачи множества аргументов в функции отрисовки.
+	// Поток обновления заполняет снимок кадра (prepare/update систем) без кадра в полёте: frameIndex = -1, буфера
+	// команд и глобального набора дескрипторов ещё нет. Поток рендера читает снимок и не обращается к миру сцены.
 	struct FrameInfo
 	{
 		int frameIndex;
 		float frameTime;
 		VkCommandBuffer commandBuffer;
+		VgetPassRecorder& passRecorder;	// параллельная запись прохода во вторичные буферы команд
 		VgetCamera& camera;
 		VkDescriptorSet globalDescriptorSet;
-		VgetGameObject::Map& gameObjects;
+		VgetWorld& world;	// сущности сцены с компонентами
+		VgetAabbTree& sceneTree;	// иерархия мировых объёмов объектов с моделями (userData - индекс сущности)
+		const VgetOcclusionCuller& occlusionCuller;	// буфер глубины окклюдеров текущего кадра
+		const VgetPvs& pvs;	// запечённая видимость статичной сцены; текущая ячейка выбрана по позиции камеры
+		uint32_t snapshotIndex = 0;	// снимок кадра VgetFramePipeline, в который пишет поток обновления и из которого читает поток рендера
 	};
 
 	struct GlobalUbo // global uniform buffer object
@@ -35,7 +40,9 @@ namespace vget
 		glm::mat4 inverseView{ 1.f };
 		//alignas(16) glm::vec3 lightDirection = glm::normalize(glm::vec3{1.f, -3.f, -1.f});
 		glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .02f }; // [r, g, b, w]
-		PointLight pointLights[MAX_LIGHTS];
+		// Сами источники света лежат в SSBO (set 0, binding 1) и разложены по кластерам (bindings 2, 3).
+		glm::vec4 clusterDepthParams{}; // параметры среза кластеров по глубине (VgetLightClusters::getDepthSliceParams)
+		glm::vec4 screenSize{};	// x, y - размер кадра в пикселях
 		int numLights; // кол-во активных точечных источников света
 	};
 
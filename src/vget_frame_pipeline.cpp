@@ -0,0 +1,182 @@
+#include "vget_frame_pipeline.hpp"
+#include "vget_cpu_profiler.hpp"
+
+// std
+#include <cassert>
+
+namespace vget
+{
+	VgetFramePipeline::VgetFramePipeline(RenderFunction renderFunction) : renderFunction{ std::move(renderFunction) } {}
+
+	VgetFramePipeline::~VgetFramePipeline()
+	{
+		stopRenderThread();
+	}
+
+	bool VgetFramePipeline::acquire(uint32_t& snapshotIndex, std::chrono::milliseconds timeout)
+	{
+		std::unique_lock<std::mutex> lock{ mutex };
+		// Свободен снимок, следующий за отправленными: все снимки перед ним по кругу ещё в полёте
+		const bool acquired = condition.wait_for(lock, timeout, [&]()
+		{
+			return inFlightCount < SNAPSHOT_COUNT || renderError != nullptr;
+		});
+		rethrowRenderError();
+		if (!acquired) return false;
+
+		snapshotIndex = nextWrite;
+		return true;
+	}
+
+	void VgetFramePipeline::submit(uint32_t snapshotIndex, Clock::time_point updateStart)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			assert(snapshotIndex == nextWrite && inFlightCount < SNAPSHOT_COUNT && "Snapshot must be acquired before submit");
+			updateStarts[snapshotIndex] = updateStart;
+			nextWrite = (nextWrite + 1) % SNAPSHOT_COUNT;
+			++inFlightCount;
+			if (renderThread.joinable())
+			{
+				++pendingCount;
+				condition.notify_all();
+				return;
+			}
+		}
+
+		// Однопоточный режим: снимок рендерится сразу. При ошибке снимок тоже освобождается, как и в потоке
+		// рендера, иначе следующий acquire() после перехваченного исключения ждал бы его вечно.
+		try
+		{
+			render(snapshotIndex);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			nextRender = nextWrite;
+			--inFlightCount;
+			throw;
+		}
+		std::lock_guard<std::mutex> lock{ mutex };
+		nextRender = nextWrite;
+		--inFlightCount;
+	}
+
+	void VgetFramePipeline::waitIdle()
+	{
+		std::unique_lock<std::mutex> lock{ mutex };
+		condition.wait(lock, [&]() { return inFlightCount == 0 || renderError != nullptr; });
+		rethrowRenderError();
+	}
+
+	void VgetFramePipeline::setThreaded(bool threaded)
+	{
+		if (threaded == isThreaded()) return;
+		if (!threaded)
+		{
+			stopRenderThread();
+			std::lock_guard<std::mutex> lock{ mutex };
+			rethrowRenderError();
+			return;
+		}
+		renderThread = std::thread{ [this]() { renderLoop(); } };
+	}
+
+	double VgetFramePipeline::getLatencyMs() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return latencyCount == 0 ? 0.0 : latencySum / latencyCount;
+	}
+
+	double VgetFramePipeline::getRenderTimeMs() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return renderTimeMs;
+	}
+
+	void VgetFramePipeline::renderLoop()
+	{
+		VGET_PROFILE_THREAD_NAME("Render");
+		while (true)
+		{
+			uint32_t snapshotIndex;
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				condition.wait(lock, [&]() { return pendingCount > 0 || stopping; });
+				// Остановка дожидается рендера уже отправленных снимков
+				if (pendingCount == 0) return;
+				snapshotIndex = nextRender;
+				nextRender = (nextRender + 1) % SNAPSHOT_COUNT;
+				--pendingCount;
+			}
+
+			try
+			{
+				render(snapshotIndex);
+			}
+			catch (...)
+			{
+				// Ошибка передаётся потоку обновления, а поток рендера завершается
+				std::lock_guard<std::mutex> lock{ mutex };
+				renderError = std::current_exception();
+				pendingCount = 0;
+				inFlightCount = 0;
+				nextRender = nextWrite;
+				condition.notify_all();
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			--inFlightCount;
+			condition.notify_all();
+		}
+	}
+
+	void VgetFramePipeline::render(uint32_t snapshotIndex)
+	{
+		const auto start = Clock::now();
+		{
+			VGET_PROFILE_ZONE("Render snapshot");
+			renderFunction(snapshotIndex);
+		}
+		const auto end = Clock::now();
+
+		std::lock_guard<std::mutex> lock{ mutex };
+		renderTimeMs = std::chrono::duration<double, std::milli>(end - start).count();
+		const double latencyMs = std::chrono::duration<double, std::milli>(end - updateStarts[snapshotIndex]).count();
+		if (latencyCount == LATENCY_WINDOW)
+		{
+			latencySum -= latencies[latencyIndex];
+		}
+		else
+		{
+			++latencyCount;
+		}
+		latencies[latencyIndex] = latencyMs;
+		latencySum += latencyMs;
+		latencyIndex = (latencyIndex + 1) % LATENCY_WINDOW;
+	}
+
+	void VgetFramePipeline::stopRenderThread()
+	{
+		if (!renderThread.joinable()) return;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			stopping = true;
+			condition.notify_all();
+		}
+		renderThread.join();
+		stopping = false;
+	}
+
+	void VgetFramePipeline::rethrowRenderError()
+	{
+		if (renderError == nullptr) return;
+		// Ошибка бросается один раз: после неё конвейер работает в однопоточном режиме. Поток рендера
+		// после записи ошибки уже не захватывает мьютекс, поэтому его можно дождаться под ним.
+		if (renderThread.joinable()) renderThread.join();
+		std::exception_ptr error = renderError;
+		renderError = nullptr;
+		std::rethrow_exception(error);
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+// std
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace vget
+{
+	// Конвейер кадров из двух стадий: пока поток рендера записывает и отправляет кадр N, поток обновления
+	// моделирует кадр N+1. Стадии обмениваются снимками кадра (камера, источники света, подготовленные отрисовки
+	// с матрицами трансформаций), которых два: поток обновления пишет в свободный снимок, поток рендера читает
+	// отправленный. Сами снимки хранит приложение, конвейер раздаёт их индексы и следит, чтобы снимок не
+	// перезаписывался во время рендера. Снимки рендерятся строго по порядку и без пропусков.
+	// В однопоточном режиме снимок рендерится прямо в submit(), как в обычном последовательном цикле.
+	class VgetFramePipeline
+	{
+	public:
+		static constexpr uint32_t SNAPSHOT_COUNT = 2;
+		static constexpr uint32_t LATENCY_WINDOW = 60;	// кадров в скользящем среднем задержки
+
+		using Clock = std::chrono::high_resolution_clock;
+		// Рендер снимка с данным индексом: из потока рендера или из submit() в однопоточном режиме
+		using RenderFunction = std::function<void(uint32_t snapshotIndex)>;
+
+		explicit VgetFramePipeline(RenderFunction renderFunction);
+		// Останавливает поток рендера, дождавшись рендера уже отправленных снимков
+		~VgetFramePipeline();
+
+		VgetFramePipeline(const VgetFramePipeline&) = delete;
+		VgetFramePipeline& operator=(const VgetFramePipeline&) = delete;
+
+		// Получение индекса свободного снимка для записи. false - снимок не освободился за timeout (поток
+		// обновления тем временем может обработать события окна). Исключение из потока рендера бросается здесь.
+		bool acquire(uint32_t& snapshotIndex, std::chrono::milliseconds timeout);
+		// Отправка заполненного снимка на рендер. Задержка кадра отсчитывается от updateStart - начала его обновления.
+		void submit(uint32_t snapshotIndex, Clock::time_point updateStart);
+		// Ожидание рендера всех отправленных снимков
+		void waitIdle();
+
+		// Переключение между двухпоточным и однопоточным режимом (с ожиданием отправленных снимков)
+		void setThreaded(bool threaded);
+		bool isThreaded() const { return renderThread.joinable(); }
+
+		// Задержка кадра от начала обновления до отправки его буфера команд в очередь, скользящее среднее
+		double getLatencyMs() const;
+		// Время рендера последнего снимка: запись команд, загрузка данных кадра и отправка
+		double getRenderTimeMs() const;
+
+	private:
+		void renderLoop();
+		void render(uint32_t snapshotIndex);
+		void stopRenderThread();
+		void rethrowRenderError();
+
+		RenderFunction renderFunction;
+		std::thread renderThread;
+
+		mutable std::mutex mutex;
+		std::condition_variable condition;
+		uint32_t nextWrite = 0;		// следующий снимок для записи; снимки идут по кругу
+		uint32_t nextRender = 0;	// следующий снимок для рендера
+		uint32_t pendingCount = 0;	// отправлены, но ещё не взяты на рендер
+		uint32_t inFlightCount = 0;	// отправлены, но ещё не отрендерены
+		bool stopping = false;
+		std::exception_ptr renderError;
+		std::array<Clock::time_point, SNAPSHOT_COUNT> updateStarts{};
+
+		std::array<double, LATENCY_WINDOW> latencies{};
+		uint32_t latencyIndex = 0;
+		uint32_t latencyCount = 0;
+		double latencySum = 0.0;
+		double renderTimeMs = 0.0;
+	};
+}
@@ -2,81 +2,131 @@
 
 namespace vget
 {
-	glm::mat4 TransformComponent::mat4()
+	namespace
 	{
-		// Ниже представлено оптимизированное создание матрицы афинных преобразований.
+		// Построение матрицы аффинных преобразований по синусам и косинусам углов поворота.
 		// Она конструируется по столбцам. Первые три столбца это линейные преобразования,
 		// а четвёртый столбец - вектор для сдвига объекта (translation).
 		// Выражения для поворота по углам Эйлера (YXZ последовательность Тейта-Брайана)
 		// взяты из википедии. Эти выражения получены после перемножения матриц всех трёх элементарных вращений.
-		const float c3 = glm::cos(rotation.z);
-	    const float s3 = glm::sin(rotation.z);
-	    const float c2 = glm::cos(rotation.x);
-	    const float s2 = glm::sin(rotation.x);
-	    const float c1 = glm::cos(rotation.y);
-	    const float s1 = glm::sin(rotation.y);
-	    return glm::mat4{
-	        {
-	            scale.x * (c1 * c3 + s1 * s2 * s3),
-	            scale.x * (c2 * s3),
-	            scale.x * (c1 * s2 * s3 - c3 * s1),
-	            0.0f,
-	        },
-	        {
-	            scale.y * (c3 * s1 * s2 - c1 * s3),
-	            scale.y * (c2 * c3),
-	            scale.y * (c1 * c3 * s2 + s1 * s3),
-	            0.0f,
-	        },
-	        {
-	            scale.z * (c2 * s1),
-	            scale.z * (-s2),
-	            scale.z * (c1 * c2),
-	            0.0f,
-	        },
-	        {translation.x, translation.y, translation.z, 1.0f}};
+		// Индексы: 1 - поворот вокруг Y, 2 - вокруг X, 3 - вокруг Z.
+		glm::mat4 composeMatrix(const glm::vec3& scale, const glm::vec3& translation,
+			float s1, float c1, float s2, float c2, float s3, float c3)
+		{
+		    return glm::mat4{
+		        {
+		            scale.x * (c1 * c3 + s1 * s2 * s3),
+		            scale.x * (c2 * s3),
+		            scale.x * (c1 * s2 * s3 - c3 * s1),
+		            0.0f,
+		        },
+		        {
+		            scale.y * (c3 * s1 * s2 - c1 * s3),
+		            scale.y * (c2 * c3),
+		            scale.y * (c1 * c3 * s2 + s1 * s3),
+		            0.0f,
+		        },
+		        {
+		            scale.z * (c2 * s1),
+		            scale.z * (-s2),
+		            scale.z * (c1 * c2),
+		            0.0f,
+		        },
+		        {translation.x, translation.y, translation.z, 1.0f}};
+		}
+
+		// В отличие от матрицы преобр. для вершин, здесь нет операции сдвига, так как он
+		// не влияет на нормали. Следовательно, матрица сократилась до 3x3.
+		// Матрица масштабирования должна быть обратная.
+		glm::mat3 composeNormalMatrix(const glm::vec3& scale, float s1, float c1, float s2, float c2, float s3, float c3)
+		{
+			const glm::vec3 invScale = 1.0f / scale;
+		    return glm::mat3{
+		        {
+		            invScale.x * (c1 * c3 + s1 * s2 * s3),
+		            invScale.x * (c2 * s3),
+		            invScale.x * (c1 * s2 * s3 - c3 * s1),
+		        },
+		        {
+		            invScale.y * (c3 * s1 * s2 - c1 * s3),
+		            invScale.y * (c2 * c3),
+		            invScale.y * (c1 * c3 * s2 + s1 * s3),
+		        },
+		        {
+		            invScale.z * (c2 * s1),
+		            invScale.z * (-s2),
+		            invScale.z * (c1 * c2),
+		        }
+			};
+		}
 	}
 
-	glm::mat3 TransformComponent::normalMatrix()
+	glm::mat4 TransformComponent::mat4()
 	{
-		const float c3 = glm::cos(rotation.z);
-	    const float s3 = glm::sin(rotation.z);
-	    const float c2 = glm::cos(rotation.x);
-	    const float s2 = glm::sin(rotation.x);
-	    const float c1 = glm::cos(rotation.y);
-	    const float s1 = glm::sin(rotation.y);
+		return composeMatrix(scale, translation,
+			glm::sin(rotation.y), glm::cos(rotation.y),
+			glm::sin(rotation.x), glm::cos(rotation.x),
+			glm::sin(rotation.z), glm::cos(rotation.z));
+	}
 
-		// Матрица масштабирования должна быть обратная
-		const glm::vec3 invScale = 1.0f / scale;
+	glm::mat3 TransformComponent::normalMatrix()
+	{
+		return composeNormalMatrix(scale,
+			glm::sin(rotation.y), glm::cos(rotation.y),
+			glm::sin(rotation.x), glm::cos(rotation.x),
+			glm::sin(rotation.z), glm::cos(rotation.z));
+	}
 
-		// В отличие от матрицы преобр. для вершин, здесь нет операции сдвига, так как он
-		// не влияет на нормали. Следовательно, матрица сократилась до 3x3.
-	    return glm::mat3{
-	        {
-	            invScale.x * (c1 * c3 + s1 * s2 * s3),
-	            invScale.x * (c2 * s3),
-	            invScale.x * (c1 * s2 * s3 - c3 * s1),
-	        },
-	        {
-	            invScale.y * (c3 * s1 * s2 - c1 * s3),
-	            invScale.y * (c2 * c3),
-	            invScale.y * (c1 * c3 * s2 + s1 * s3),
-	        },
-	        {
-	            invScale.z * (c2 * s1),
-	            invScale.z * (-s2),
-	            invScale.z * (c1 * c2),
-	        }
+	void TransformComponent::setMatrices(const glm::vec3& sines, const glm::vec3& cosines)
+	{
+		// Столбцы матрицы поворота общие для обеих матриц, поэтому считаются один раз, а затем
+		// умножаются на масштаб или на обратный масштаб (те же выражения, что и в composeMatrix())
+		const float s1 = sines.y, c1 = cosines.y;
+		const float s2 = sines.x, c2 = cosines.x;
+		const float s3 = sines.z, c3 = cosines.z;
+		const glm::vec3 rotationColumns[3] = {
+			{ c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1 },
+			{ c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3 },
+			{ c2 * s1, -s2, c1 * c2 }
 		};
+
+		for (int column = 0; column < 3; ++column)
+		{
+			const float columnScale = scale[column];
+			const float columnInvScale = 1.0f / scale[column];
+			worldMatrix[column] = glm::vec4{ rotationColumns[column] * columnScale, 0.0f };
+			worldNormalMatrix[column] = glm::vec4{ rotationColumns[column] * columnInvScale, 0.0f };
+		}
+		worldMatrix[3] = glm::vec4{ translation, 1.0f };
+		worldNormalMatrix[3] = glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f };
 	}
 
-	VgetGameObject VgetGameObject::makePointLight(float intensity, float radius, glm::vec3 color)
+	void TransformComponent::updateMatrices()
 	{
-		VgetGameObject gameObj = VgetGameObject::createGameObject("PointLight");
-		gameObj.color = color;
-		gameObj.transform.scale.x = radius;  // радиус видимого билборда сохраняется в X-компоненту scale'а
-		gameObj.pointLight = std::make_unique<PointLightComponent>();
-		gameObj.pointLight->lightIntensity = intensity;
-		return gameObj;
+		setMatrices(
+			{ glm::sin(rotation.x), glm::sin(rotation.y), glm::sin(rotation.z) },
+			{ glm::cos(rotation.x), glm::cos(rotation.y), glm::cos(rotation.z) });
+	}
+
+	namespace VgetGameObject
+	{
+		Entity createGameObject(VgetWorld& world, const std::string& name)
+		{
+			const Entity entity = world.createEntity(TransformComponent{}, NameComponent{});
+			world.getComponent<NameComponent>(entity)->name = name + std::to_string(entity.index);
+			return entity;
+		}
+
+		Entity makePointLight(VgetWorld& world, float intensity, float radius, glm::vec3 color)
+		{
+			const Entity entity = createGameObject(world, "PointLight");
+			world.getComponent<TransformComponent>(entity)->scale.x = radius;  // радиус видимого билборда сохраняется в X-компоненту scale'а
+
+			PointLightComponent pointLight{};
+			pointLight.lightIntensity = intensity;
+			pointLight.color = color;
+			world.addComponent(entity, pointLight);
+			return entity;
+		}
 	}
 }
\ No newline at end of file
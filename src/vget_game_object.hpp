@@ -1,13 +1,14 @@
 #pragma once
 
 #include "vget_model.hpp"
+#include "vget_ecs.hpp"
 
 // libs
 #include <glm/gtc/matrix_transform.hpp>
 
 // std
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
 #include <string>
 
 namespace vget
@@ -18,6 +19,20 @@ namespace vget
 		glm::vec3 scale{ .1f, .1f, .1f }; // вектор со значениями для масштабирования
 		glm::vec3 rotation{};
 
+		// Кэшированные матрицы, которые системы рендера используют вместо пересчёта каждый кадр.
+		// Их пересчитывает VgetTransformBatch для изменённых трансформаций, поэтому код, изменивший
+		// translation, scale или rotation, должен вызвать world.markChanged<TransformComponent>(entity).
+		// Отметки хранятся в VgetWorld, а не в компоненте: поиск изменённых не читает сами трансформации.
+		static constexpr bool TRACK_CHANGES = true;
+
+		glm::mat4 worldMatrix{ 1.f };
+		glm::mat4 worldNormalMatrix{ 1.f };	// матрица нормали, сразу расширенная до mat4 для пуш констант
+
+		// Запись кэшированных матриц по заранее посчитанным синусам и косинусам углов rotation (покомпонентно)
+		void setMatrices(const glm::vec3& sines, const glm::vec3& cosines);
+		// Скалярный пересчёт кэшированных матриц одной трансформации
+		void updateMatrices();
+
 		// Построение матрицы аффинного преобразования следующим произведением = translate * Ry * Rx * Rz * scale
 		// У произведения матриц нет коммутативного свойства, поэтому порядок множителей важен.
 		// Представить преобразование можно "прочитав" произведение справа налево (сначала выполнится изменение размеров,
@@ -32,51 +47,39 @@ namespace vget
 	struct PointLightComponent
 	{
 		float lightIntensity = 1.0f;
+		glm::vec3 color{ 1.f };
 		bool carouselEnabled = false;
 	};
 
-	class VgetGameObject
+	struct ModelComponent
 	{
-	public:
-		using id_t = unsigned int; // псевдоним для типа
-		using Map = std::unordered_map<id_t, VgetGameObject>;
-
-		VgetGameObject() = default; // Просит компилятор, хотя такой конструктор не используется
-
-		// статичный метод, который выпускает новый экземпляр игрового объекта
-		static VgetGameObject createGameObject(std::string name = "Object")
-		{
-			static id_t currentId = 0;
-			return VgetGameObject{ currentId++, name };
-		}
-
-		// Метод для создания PointLight объекта
-		static VgetGameObject makePointLight(float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
-
-		// RAII
-		VgetGameObject(const VgetGameObject&) = delete;
-		VgetGameObject& operator=(const VgetGameObject&) = delete;
-		
-		// move constructor is default (используется для работы со ссылкой на объект через std::move)
-		// например, чтобы добавить экземпляр объекта в коллекцию
-		VgetGameObject(VgetGameObject&&) = default;
-		VgetGameObject& operator=(VgetGameObject&&) = default;
-
-		const id_t getId() { return id; }
-		const std::string getName() { return name; }
-
-		glm::vec3 color{};
-		TransformComponent transform{};
-
-		// Опциональные компоненты объекта в виде указателей.
-		// Эти компоненты сигнализируют то, может ли данный объект исп. в конкретной системе движка.
 		std::shared_ptr<VgetModel> model{};
-		std::unique_ptr<PointLightComponent> pointLight = nullptr;
+	};
 
-	private:
-		VgetGameObject(id_t objId, std::string name) : id{objId}, name{name} { this->name.append(std::to_string(this->id)); }
+	// Метка: модель объекта растеризуется в буфер глубины VgetOcclusionCuller и перекрывает объекты позади себя
+	struct OccluderComponent {};
 
-		id_t id;
+	struct NameComponent
+	{
 		std::string name;
 	};
-}
+
+	// Родитель в иерархии сцены. TransformComponent такой сущности задаёт положение относительно родителя,
+	// а мировые матрицы считает VgetSceneHierarchy. Связи задаются через VgetSceneHierarchy::setParent().
+	struct ParentComponent
+	{
+		Entity parent{};
+	};
+
+	// Игровой объект - сущность VgetWorld с компонентами. Функции ниже создают типовые объекты сцены.
+	// Индекс сущности служит id объекта для иерархии объёмов сцены и PVS.
+	namespace VgetGameObject
+	{
+		using id_t = uint32_t;
+
+		// Объект с трансформацией и именем (к имени добавляется id объекта)
+		Entity createGameObject(VgetWorld& world, const std::string& name = "Object");
+		// Метод для создания PointLight объекта
+		Entity makePointLight(VgetWorld& world, float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+	}
+}
\ No newline at end of file
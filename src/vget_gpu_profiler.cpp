@@ -0,0 +1,232 @@
+#include "vget_gpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace vget
+{
+	namespace
+	{
+		constexpr uint32_t STATISTIC_COUNT = static_cast<uint32_t>(PipelineStatistic::Count);
+		constexpr VkQueryPipelineStatisticFlags STATISTIC_FLAGS =
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+	}
+
+	VgetGpuProfiler::VgetGpuProfiler(VgetDevice& device, uint32_t framesInFlight) : vgetDevice{ device }, frames(framesInFlight)
+	{
+		timings.scopes.push_back(GpuScopeTiming{ "Frame" });
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(vgetDevice.getPhysicalDevice(), &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(vgetDevice.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+		const uint32_t validBits = queueFamilies[vgetDevice.getGraphicsQueueFamily()].timestampValidBits;
+		timestampPeriod = vgetDevice.properties.limits.timestampPeriod;
+
+		// Без меток времени профайлер остаётся рабочим, но ничего не замеряет
+		if (validBits != 0 && timestampPeriod > 0.0f)
+		{
+			timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+			VkQueryPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			poolInfo.queryCount = framesInFlight * MAX_SCOPES * 2;
+			if (vkCreateQueryPool(vgetDevice.device(), &poolInfo, nullptr, &timestampQueryPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create timestamp query pool!");
+			}
+		}
+
+		if (vgetDevice.enabledFeatures.pipelineStatisticsQuery)
+		{
+			VkQueryPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			poolInfo.queryCount = framesInFlight * MAX_STATISTICS_QUERIES;
+			poolInfo.pipelineStatistics = STATISTIC_FLAGS;
+			if (vkCreateQueryPool(vgetDevice.device(), &poolInfo, nullptr, &statisticsQueryPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create pipeline statistics query pool!");
+			}
+		}
+
+		timings.timestampsSupported = isTimestampSupported();
+		timings.statisticsSupported = isStatisticsSupported();
+	}
+
+	VgetGpuProfiler::~VgetGpuProfiler()
+	{
+		if (timestampQueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(vgetDevice.device(), timestampQueryPool, nullptr);
+		if (statisticsQueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(vgetDevice.device(), statisticsQueryPool, nullptr);
+	}
+
+	uint32_t VgetGpuProfiler::addScope(const std::string& name)
+	{
+		if (timings.scopes.size() == MAX_SCOPES)
+		{
+			throw std::runtime_error("too many GPU profiler scopes!");
+		}
+		timings.scopes.push_back(GpuScopeTiming{ name });
+		return static_cast<uint32_t>(timings.scopes.size() - 1);
+	}
+
+	void VgetGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex)
+	{
+		this->frameIndex = frameIndex;
+		FrameQueries& frame = frames[frameIndex];
+		if (frame.submitted)
+		{
+			readTimestamps(frameIndex);
+			readStatistics(frameIndex);
+		}
+
+		const uint32_t scopeCount = static_cast<uint32_t>(timings.scopes.size());
+		if (isTimestampSupported())
+		{
+			vkCmdResetQueryPool(commandBuffer, timestampQueryPool, frameIndex * MAX_SCOPES * 2, scopeCount * 2);
+		}
+		statisticsRecording = timings.statisticsEnabled;
+		if (statisticsRecording)
+		{
+			vkCmdResetQueryPool(commandBuffer, statisticsQueryPool, frameIndex * MAX_STATISTICS_QUERIES, MAX_STATISTICS_QUERIES);
+		}
+		frame.scopeWritten.fill(false);
+		frame.statisticsCount = 0;
+		frame.submitted = false;
+
+		writeScopeBegin(commandBuffer, FRAME_SCOPE);
+	}
+
+	void VgetGpuProfiler::endFrame(VkCommandBuffer commandBuffer)
+	{
+		writeScopeEnd(commandBuffer, FRAME_SCOPE);
+	}
+
+	void VgetGpuProfiler::markSubmitted()
+	{
+		frames[frameIndex].submitted = true;
+	}
+
+	void VgetGpuProfiler::writeScopeBegin(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (!isTimestampSupported()) return;
+		assert(scope < timings.scopes.size() && "Unknown GPU profiler scope");
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, (frameIndex * MAX_SCOPES + scope) * 2);
+	}
+
+	void VgetGpuProfiler::writeScopeEnd(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (!isTimestampSupported()) return;
+		assert(scope < timings.scopes.size() && "Unknown GPU profiler scope");
+		// BOTTOM_OF_PIPE: метка пишется, когда завершены все предыдущие команды очереди
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, (frameIndex * MAX_SCOPES + scope) * 2 + 1);
+		frames[frameIndex].scopeWritten[scope] = true;
+	}
+
+	uint32_t VgetGpuProfiler::beginStatistics(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (!statisticsRecording) return NO_QUERY;
+		FrameQueries& frame = frames[frameIndex];
+		const uint32_t slot = frame.statisticsCount.fetch_add(1, std::memory_order_relaxed);
+		if (slot >= MAX_STATISTICS_QUERIES) return NO_QUERY;
+
+		frame.statisticsScopes[slot] = scope;
+		const uint32_t query = frameIndex * MAX_STATISTICS_QUERIES + slot;
+		vkCmdBeginQuery(commandBuffer, statisticsQueryPool, query, 0);
+		return query;
+	}
+
+	void VgetGpuProfiler::endStatistics(VkCommandBuffer commandBuffer, uint32_t query)
+	{
+		if (query == NO_QUERY) return;
+		vkCmdEndQuery(commandBuffer, statisticsQueryPool, query);
+	}
+
+	void VgetGpuProfiler::readTimestamps(int frameIndex)
+	{
+		if (!isTimestampSupported()) return;
+		const FrameQueries& frame = frames[frameIndex];
+		const uint32_t scopeCount = static_cast<uint32_t>(timings.scopes.size());
+
+		// Пары (значение, доступность) для начала и конца каждой области. Без WAIT_BIT: недоступные
+		// результаты (кадр отброшен при пересоздании SwapChain'а) пропускаются, а не ожидаются.
+		std::vector<uint64_t> results(static_cast<size_t>(scopeCount) * 4);
+		const VkResult result = vkGetQueryPoolResults(vgetDevice.device(), timestampQueryPool, frameIndex * MAX_SCOPES * 2, scopeCount * 2,
+			results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (result != VK_SUCCESS && result != VK_NOT_READY) return;
+
+		for (uint32_t scope = 0; scope < scopeCount; ++scope)
+		{
+			if (!frame.scopeWritten[scope]) continue;
+			const uint64_t* begin = &results[scope * 4];
+			const uint64_t* end = begin + 2;
+			if (begin[1] == 0 || end[1] == 0) continue;
+			const uint64_t ticks = (end[0] - begin[0]) & timestampMask;
+			pushTiming(timings.scopes[scope], static_cast<float>(static_cast<double>(ticks) * timestampPeriod * 1e-6));
+		}
+	}
+
+	void VgetGpuProfiler::readStatistics(int frameIndex)
+	{
+		const FrameQueries& frame = frames[frameIndex];
+		const uint32_t queryCount = std::min(frame.statisticsCount.load(std::memory_order_relaxed), MAX_STATISTICS_QUERIES);
+		for (auto& scope : timings.scopes) scope.statistics.fill(0);
+		if (queryCount == 0) return;
+
+		constexpr uint32_t stride = STATISTIC_COUNT + 1;	// счётчики и доступность
+		std::vector<uint64_t> results(static_cast<size_t>(queryCount) * stride);
+		const VkResult result = vkGetQueryPoolResults(vgetDevice.device(), statisticsQueryPool, frameIndex * MAX_STATISTICS_QUERIES, queryCount,
+			results.size() * sizeof(uint64_t), results.data(), stride * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (result != VK_SUCCESS && result != VK_NOT_READY) return;
+
+		// Статистика кадра - сумма статистики областей
+		auto& frameStatistics = timings.scopes[FRAME_SCOPE].statistics;
+		for (uint32_t query = 0; query < queryCount; ++query)
+		{
+			const uint64_t* values = &results[query * stride];
+			if (values[STATISTIC_COUNT] == 0 || frame.statisticsScopes[query] == FRAME_SCOPE) continue;
+			auto& scopeStatistics = timings.scopes[frame.statisticsScopes[query]].statistics;
+			for (uint32_t i = 0; i < STATISTIC_COUNT; ++i)
+			{
+				scopeStatistics[i] += values[i];
+				frameStatistics[i] += values[i];
+			}
+		}
+	}
+
+	void VgetGpuProfiler::pushTiming(GpuScopeTiming& scope, float ms)
+	{
+		const uint32_t size = GpuScopeTiming::HISTORY_SIZE;
+		if (scope.historyCount < size)
+		{
+			scope.history[(scope.historyOffset + scope.historyCount++) % size] = ms;
+		}
+		else
+		{
+			scope.history[scope.historyOffset] = ms;
+			scope.historyOffset = (scope.historyOffset + 1) % size;
+		}
+
+		float sum = 0.0f;
+		float maxMs = 0.0f;
+		for (uint32_t i = 0; i < scope.historyCount; ++i)
+		{
+			const float value = scope.history[(scope.historyOffset + i) % size];
+			sum += value;
+			maxMs = std::max(maxMs, value);
+		}
+		scope.lastMs = ms;
+		++scope.sampleCount;
+		scope.averageMs = sum / scope.historyCount;
+		scope.maxMs = maxMs;
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "vget_device.hpp"
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vget
+{
+	// Счётчики статистики конвейера, которые собирает профайлер (порядок совпадает с битами PIPELINE_STATISTICS)
+	enum class PipelineStatistic : uint32_t
+	{
+		InputVertices,
+		InputPrimitives,
+		VertexShaderInvocations,
+		ClippingPrimitives,
+		FragmentShaderInvocations,
+		Count
+	};
+
+	// Замеры одной области профайлера за последние кадры
+	struct GpuScopeTiming
+	{
+		static constexpr uint32_t HISTORY_SIZE = 120;	// кадров в истории и скользящем среднем
+
+		std::string name;
+		float lastMs = 0.0f;
+		float averageMs = 0.0f;
+		float maxMs = 0.0f;
+		std::array<float, HISTORY_SIZE> history{};	// кольцо замеров, самый старый - по historyOffset
+		uint32_t historyOffset = 0;
+		uint32_t historyCount = 0;
+		uint64_t sampleCount = 0;	// всего прочитанных замеров: по его изменению видно, что lastMs обновился
+		std::array<uint64_t, static_cast<size_t>(PipelineStatistic::Count)> statistics{};	// за последний прочитанный кадр
+	};
+
+	// Результаты профайлера для отображения. Копируются в снимок кадра, поэтому не ссылаются на профайлер.
+	struct GpuTimings
+	{
+		bool timestampsSupported = false;
+		bool statisticsSupported = false;
+		bool statisticsEnabled = false;
+		std::vector<GpuScopeTiming> scopes;	// первой идёт область всего кадра
+	};
+
+	// Профайлер GPU на запросах VkQueryPool: метки времени в начале и конце каждой области (системы рендера,
+	// интерфейса и всего кадра) и, по желанию, статистика конвейера по областям.
+	// У каждого кадра в полёте свой диапазон запросов. Результаты кадра читаются, когда этот кадр начинается
+	// снова - его забор уже пройден, поэтому чтение не ждёт GPU, а замеры отстают на число кадров в полёте.
+	// Если очередь не поддерживает метки времени (timestampPeriod или timestampValidBits равны нулю), профайлер
+	// ничего не записывает, а timestampsSupported в результатах остаётся false.
+	class VgetGpuProfiler
+	{
+	public:
+		static constexpr uint32_t MAX_SCOPES = 16;
+		static constexpr uint32_t MAX_STATISTICS_QUERIES = 256;	// запросов статистики на кадр (по одному на вторичный буфер)
+		static constexpr uint32_t FRAME_SCOPE = 0;				// область всего кадра, создаётся конструктором
+		static constexpr uint32_t NO_QUERY = ~0u;
+
+		VgetGpuProfiler(VgetDevice& device, uint32_t framesInFlight);
+		~VgetGpuProfiler();
+
+		VgetGpuProfiler(const VgetGpuProfiler&) = delete;
+		VgetGpuProfiler& operator=(const VgetGpuProfiler&) = delete;
+
+		// Регистрация области до первого кадра. Возвращает её индекс для writeScopeBegin() и writeScopeEnd().
+		uint32_t addScope(const std::string& name);
+
+		bool isTimestampSupported() const { return timestampQueryPool != VK_NULL_HANDLE; }
+		bool isStatisticsSupported() const { return statisticsQueryPool != VK_NULL_HANDLE; }
+		void setStatisticsEnabled(bool enabled) { timings.statisticsEnabled = enabled && isStatisticsSupported(); }
+
+		// Начало кадра в основном буфере вне прохода рендера: чтение результатов прошлого использования
+		// запросов этого кадра, их сброс и метка начала кадра
+		void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+		// Метка конца кадра после прохода рендера
+		void endFrame(VkCommandBuffer commandBuffer);
+		// Буфер кадра отправлен в очередь (после VgetRenderer::endFrame()). Только запросы отправленного кадра
+		// читаются при следующем beginFrame() с тем же индексом: у неотправленного сброс и метки не выполнены.
+		void markSubmitted();
+
+		// Метки начала и конца области. Каждая записывается не больше одного раза за кадр.
+		void writeScopeBegin(VkCommandBuffer commandBuffer, uint32_t scope);
+		void writeScopeEnd(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		// Запрос статистики конвейера вокруг команд одного буфера, относящихся к области. Можно вызывать из
+		// нескольких потоков. NO_QUERY - статистика выключена или запросы кадра закончились.
+		uint32_t beginStatistics(VkCommandBuffer commandBuffer, uint32_t scope);
+		void endStatistics(VkCommandBuffer commandBuffer, uint32_t query);
+
+		const GpuTimings& getTimings() const { return timings; }
+
+	private:
+		struct FrameQueries
+		{
+			std::array<bool, MAX_SCOPES> scopeWritten{};	// обе метки области записаны в этом кадре
+			std::array<uint32_t, MAX_STATISTICS_QUERIES> statisticsScopes{};
+			std::atomic<uint32_t> statisticsCount{ 0 };
+			bool submitted = false;	// буфер с запросами кадра отправлен в очередь, и их результаты можно читать
+		};
+
+		void readTimestamps(int frameIndex);
+		void readStatistics(int frameIndex);
+		void pushTiming(GpuScopeTiming& scope, float ms);
+
+		VgetDevice& vgetDevice;
+		VkQueryPool timestampQueryPool = VK_NULL_HANDLE;	// [кадр * MAX_SCOPES * 2 + область * 2 + начало/конец]
+		VkQueryPool statisticsQueryPool = VK_NULL_HANDLE;	// [кадр * MAX_STATISTICS_QUERIES + запрос]
+		float timestampPeriod = 0.0f;	// наносекунд на единицу метки
+		uint64_t timestampMask = 0;		// значимые биты метки
+
+		std::vector<FrameQueries> frames;
+		int frameIndex = 0;
+		bool statisticsRecording = false;	// статистика включена в текущем кадре (сброшена в beginFrame)
+		GpuTimings timings{};
+	};
+}
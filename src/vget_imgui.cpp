@@ -2,6 +2,8 @@
 
 #include "vget_device.hpp"
 #include "vget_window.hpp"
+#include "vget_cpu_profiler.hpp"
+#include "vget_texture_table.hpp"
 
 // libs
 #include <imgui.h>
@@ -12,6 +14,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // std
+#include <algorithm>
 #include <stdexcept>
 #include <fstream>
 #include <filesystem>
@@ -27,8 +30,8 @@ namespace vget {
     // using.
     VgetImgui::VgetImgui(
         VgetWindow& window, VgetDevice& device, VkRenderPass renderPass,
-        uint32_t imageCount, VgetCamera& camera, KeyboardMovementController& kmc, VgetGameObject::Map& gameObjects)
-        : vgetDevice{ device }, camera{ camera }, kmc{ kmc }, gameObjects{ gameObjects } {
+        uint32_t imageCount, VgetCamera& camera, KeyboardMovementController& kmc, VgetWorld& world)
+        : vgetDevice{ device }, camera{ camera }, kmc{ kmc }, world{ world } {
         // set up a descriptor pool stored on this instance, see header for more comments on this.
         VkDescriptorPoolSize pool_sizes[] = {
             {VK_DESCRIPTOR_TYPE_SAMPLER, 1000},
@@ -110,12 +113,36 @@ namespace vget {
     }
 
     // this tells imgui that we're done setting up the current frame,
-    // then gets the draw data from imgui and uses it to record to the provided
-    // command buffer the necessary draw commands
-    void VgetImgui::render(VkCommandBuffer commandBuffer) {
+    // then copies the draw data from imgui into the frame snapshot
+    void VgetImgui::endFrame(VgetImguiDrawData& drawData) {
         ImGui::Render();
-        ImDrawData* drawdata = ImGui::GetDrawData();
-        ImGui_ImplVulkan_RenderDrawData(drawdata, commandBuffer);
+        drawData.capture(*ImGui::GetDrawData());
+    }
+
+    // uses the copied draw data to record to the provided command buffer the necessary draw commands
+    void VgetImgui::render(VkCommandBuffer commandBuffer, VgetImguiDrawData& drawData) {
+        ImGui_ImplVulkan_RenderDrawData(drawData.get(), commandBuffer);
+    }
+
+    VgetImguiDrawData::~VgetImguiDrawData() {
+        clear();
+    }
+
+    void VgetImguiDrawData::capture(const ImDrawData& source) {
+        clear();
+        drawData = source;
+        for (int i = 0; i < source.CmdListsCount; ++i) {
+            drawLists.push_back(source.CmdLists[i]->CloneOutput());
+        }
+        drawData.CmdLists = drawLists.data();
+    }
+
+    void VgetImguiDrawData::clear() {
+        for (ImDrawList* drawList : drawLists) {
+            IM_DELETE(drawList);
+        }
+        drawLists.clear();
+        drawData.Clear();
     }
 
     void VgetImgui::runExample() {
@@ -151,6 +178,67 @@ namespace vget {
                 "Application average %.3f ms/frame (%.1f FPS)",
                 1000.0f / ImGui::GetIO().Framerate,
                 ImGui::GetIO().Framerate);
+            ImGui::Text(
+                "Frustum culling: %u visible / %u culled",
+                cullingStats.visible,
+                cullingStats.culled);
+            ImGui::Text(
+                "Occlusion culling: %u occluded, raster %.3f ms (%u triangles)",
+                cullingStats.occluded,
+                occlusionRasterTimeMs,
+                occluderTriangleCount);
+            ImGui::Text(
+                "PVS: %u culled, cell %d",
+                cullingStats.pvsCulled,
+                pvsCell);
+            ImGui::Text(
+                "Draw sorting: %u draws, %u state changes (%u elided)",
+                drawStats.draws,
+                drawStats.stateChanges,
+                drawStats.elided);
+            ImGui::Text(
+                "Command recorder: %u issued, %u elided",
+                commandStats.issued,
+                commandStats.elided);
+            ImGui::Text(
+                "Command recording: %.3f ms, %u secondary buffers",
+                commandRecordTimeMs,
+                commandBufferCount);
+            ImGui::SliderInt("Recording threads", &recordThreadCount, 1, maxRecordThreads);
+            ImGui::Text(
+                "Frame latency: %.3f ms (update to submit), render stage %.3f ms",
+                frameLatencyMs,
+                renderTimeMs);
+            ImGui::Checkbox("Threaded rendering", &threadedRendering);
+            ImGui::Checkbox("Record camera path", &recordCameraPath);
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("Saved to camera_path.txt for vget_bench when unchecked");
+#ifdef VGET_ENABLE_PROFILER
+            {
+                // Трасса пишется в рабочий каталог; кадры дольше порога выгружаются автоматически
+                VgetCpuProfiler& profiler = VgetCpuProfiler::get();
+                float slowFrameThresholdMs = static_cast<float>(profiler.getSlowFrameThreshold());
+                if (ImGui::SliderFloat("Slow frame capture, ms", &slowFrameThresholdMs, 0.0f, 200.0f)) {
+                    profiler.setSlowFrameThreshold(slowFrameThresholdMs);
+                }
+                if (ImGui::Button("Export CPU trace")) {
+                    profiler.exportChromeTrace("vget_trace.json");
+                }
+                if (!profiler.getLastCapturePath().empty()) {
+                    ImGui::SameLine();
+                    ImGui::Text("last slow frame: %s", profiler.getLastCapturePath().c_str());
+                }
+            }
+#endif
+            ImGui::Text(
+                "Clustered lighting: %u lights, build %.3f ms",
+                lightCount,
+                lightClusterBuildTimeMs);
+            ImGui::Text(
+                "Transforms: %u updated, %.3f ms; hierarchy: %u of %u nodes updated",
+                transformUpdateCount,
+                transformUpdateTimeMs,
+                hierarchyUpdateCount,
+                hierarchyNodeCount);
             ImGui::End();
         }
 
@@ -186,8 +274,7 @@ namespace vget {
 
         if (ImGui::Button("Add Point Light"))
         {
-            VgetGameObject pointLight = VgetGameObject::makePointLight(pointLightIntensity, pointLightRadius, pointLightColor);
-            gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+            VgetGameObject::makePointLight(world, pointLightIntensity, pointLightRadius, pointLightColor);
         }
 
         ImGui::End();
@@ -229,10 +316,28 @@ namespace vget {
 
             if (ImGui::Button("Add to the scene")) {
                 std::shared_ptr<VgetModel> model = VgetModel::createModelFromFile(vgetDevice, objectsPaths.at(item_current_idx));
-                auto newObj = VgetGameObject::createGameObject();
-                newObj.model = model;
-                gameObjects.emplace(newObj.getId(), std::move(newObj));
+                Entity newObj = VgetGameObject::createGameObject(world);
+                world.addComponent(newObj, ModelComponent{ model });
             }
+
+            // Экземпляры создаются без имени, чтобы не заполнять список объектов сцены.
+            // Модели с текстурами не подходят: система текстур кладёт текстуры каждого объекта в общий набор дескрипторов.
+            ImGui::SameLine();
+            if (ImGui::Button("Add 100k instances")) {
+                std::shared_ptr<VgetModel> model = VgetModel::createModelFromFile(vgetDevice, objectsPaths.at(item_current_idx));
+                if (model->getTextures().size() == 0) {
+                    for (int x = 0; x < STRESS_GRID_X; ++x)
+                        for (int y = 0; y < STRESS_GRID_Y; ++y)
+                            for (int z = 0; z < STRESS_GRID_Z; ++z)
+                            {
+                                TransformComponent transform{};
+                                transform.translation = STRESS_GRID_SPACING * glm::vec3(
+                                    x - STRESS_GRID_X / 2, -y, z - STRESS_GRID_Z / 2);
+                                world.createEntity(transform, ModelComponent{ model });
+                            }
+                }
+            }
+            if (ImGui::IsItemHovered()) ImGui::SetTooltip("Stress grid for command recording (models without textures only)");
         }
         ImGui::End();
     }
@@ -240,50 +345,298 @@ namespace vget {
     void VgetImgui::enumerateObjectsInTheScene()
     {
         if (ImGui::Begin("All Objects")) {
-            static int item_current_idx = 0; // Здесь список подобен тому, что есть в Object Loader'е
+            static Entity selected{}; // Здесь список подобен тому, что есть в Object Loader'е
             if (ImGui::BeginListBox("All Objects", ImVec2(-FLT_MIN, 10 * ImGui::GetTextLineHeightWithSpacing())))
             {
-                for (auto& obj : gameObjects)
+                world.forEach<NameComponent>([&](Entity entity, NameComponent& name)
                 {
-                    const bool is_selected = (item_current_idx == obj.second.getId());
-                    if (ImGui::Selectable(obj.second.getName().c_str(), is_selected)) {
-                        item_current_idx = obj.second.getId();
+                    const bool is_selected = (selected == entity);
+                    if (ImGui::Selectable(name.name.c_str(), is_selected)) {
+                        selected = entity;
                     }
 
                     if (is_selected) { ImGui::SetItemDefaultFocus(); }
-                }
+                });
                 ImGui::EndListBox();
             }
 
-            if (gameObjects[item_current_idx].pointLight != nullptr) {
-                inspectObject(gameObjects[item_current_idx], true);
+            // дескриптор уничтоженной сущности перестаёт быть действительным, и инспектор просто не показывается
+            if (world.isAlive(selected)) {
+                inspectObject(selected);
             }
-            else {
-                inspectObject(gameObjects[item_current_idx], false);
+        }
+        ImGui::End();
+    }
+
+    void VgetImgui::showGpuProfiler()
+    {
+        if (!ImGui::Begin("GPU Profiler"))
+        {
+            ImGui::End();
+            return;
+        }
+
+        if (!gpuTimings.timestampsSupported)
+        {
+            ImGui::Text("GPU timestamps are not supported by the graphics queue");
+        }
+        else if (!gpuTimings.scopes.empty())
+        {
+            const GpuScopeTiming& frame = gpuTimings.scopes[VgetGpuProfiler::FRAME_SCOPE];
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "frame %.3f ms (max %.3f)", frame.averageMs, frame.maxMs);
+            ImGui::PlotLines("##GPU frame time", frame.history.data(), static_cast<int>(frame.historyCount),
+                static_cast<int>(frame.historyOffset), overlay, 0.0f, frame.maxMs * 1.2f, ImVec2(-FLT_MIN, 80.0f));
+
+            if (ImGui::BeginTable("GPU timings", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+            {
+                ImGui::TableSetupColumn("Scope");
+                ImGui::TableSetupColumn("Last, ms");
+                ImGui::TableSetupColumn("Average, ms");
+                ImGui::TableSetupColumn("Max, ms");
+                ImGui::TableHeadersRow();
+                for (const auto& scope : gpuTimings.scopes)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", scope.name.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", scope.lastMs);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", scope.averageMs);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", scope.maxMs);
+                }
+                ImGui::EndTable();
             }
         }
+
+        if (!gpuTimings.statisticsSupported)
+        {
+            ImGui::Text("Pipeline statistics queries are not supported by the device");
+            ImGui::End();
+            return;
+        }
+
+        ImGui::Checkbox("Pipeline statistics", &gpuStatisticsEnabled);
+        if (gpuStatisticsEnabled && ImGui::BeginTable("GPU statistics", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Scope");
+            ImGui::TableSetupColumn("Vertices");
+            ImGui::TableSetupColumn("Primitives");
+            ImGui::TableSetupColumn("VS invocations");
+            ImGui::TableSetupColumn("Clipped primitives");
+            ImGui::TableSetupColumn("FS invocations");
+            ImGui::TableHeadersRow();
+            for (const auto& scope : gpuTimings.scopes)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", scope.name.c_str());
+                for (const uint64_t value : scope.statistics)
+                {
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%llu", static_cast<unsigned long long>(value));
+                }
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+    void VgetImgui::showRenderStats()
+    {
+        if (!ImGui::Begin("Render Statistics"))
+        {
+            ImGui::End();
+            return;
+        }
+
+        ImGui::Checkbox("Write CSV", &writeRenderStatsCsv);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("One row per rendered frame, the file is overwritten when enabled");
+        }
+        const VgetTextureTable& textureTable = vgetDevice.getTextureTable();
+        ImGui::Text("Texture table slots: %u / %u", textureTable.getUsedCount(), textureTable.getCapacity());
+        ImGui::Text("Cached samplers: %u%s", vgetDevice.getSamplerCache().getSamplerCount(),
+            VgetTextureTable::SEPARATE_SAMPLERS ? " (separate immutable samplers)" : "");
+
+        const char* names[RENDER_COUNTER_COUNT];
+        for (size_t i = 0; i < RENDER_COUNTER_COUNT; ++i)
+        {
+            names[i] = VgetRenderStats::getName(static_cast<RenderCounter>(i));
+        }
+        ImGui::Combo("Plot", &selectedRenderCounter, names, static_cast<int>(RENDER_COUNTER_COUNT));
+
+        const auto selected = static_cast<RenderCounter>(selectedRenderCounter);
+        std::array<float, RenderCounterHistory::FRAME_COUNT> history{};
+        const uint32_t count = renderCounterHistory.fill(selected, history);
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "avg %.1f (max %llu)", renderCounterHistory.average(selected),
+            static_cast<unsigned long long>(renderCounterHistory.max(selected)));
+        ImGui::PlotLines("##Render counter", history.data(), static_cast<int>(count), 0, overlay,
+            0.0f, static_cast<float>(renderCounterHistory.max(selected)) * 1.2f + 1.0f, ImVec2(-FLT_MIN, 80.0f));
+
+        if (ImGui::BeginTable("Render counters", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Counter");
+            ImGui::TableSetupColumn("Last");
+            ImGui::TableSetupColumn("Average");
+            ImGui::TableSetupColumn("Max");
+            ImGui::TableHeadersRow();
+            const RenderCounters& last = renderCounterHistory.getLast();
+            for (size_t i = 0; i < RENDER_COUNTER_COUNT; ++i)
+            {
+                const auto counter = static_cast<RenderCounter>(i);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", names[i]);
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(last[counter]));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", renderCounterHistory.average(counter));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(renderCounterHistory.max(counter)));
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+    void VgetImgui::showMemoryBudget()
+    {
+        if (!ImGui::Begin("Memory Budget"))
+        {
+            ImGui::End();
+            return;
+        }
+
+        constexpr double MIB = 1024.0 * 1024.0;
+        VgetMemoryTracker& tracker = vgetDevice.getMemoryTracker();
+        const MemoryStats stats = tracker.getStats();
+        ImGui::Text("VK_EXT_memory_budget: %s", stats.budgetExtension ? "yes" : "no (usage is engine allocations, budget is heap size)");
+
+        float budgetFraction = tracker.getBudgetFraction();
+        if (ImGui::SliderFloat("Budget fraction", &budgetFraction, 0.1f, 1.0f, "%.2f"))
+        {
+            tracker.setBudgetFraction(budgetFraction);
+        }
+
+        if (ImGui::BeginTable("Memory heaps", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Heap");
+            ImGui::TableSetupColumn("Engine, MiB");
+            ImGui::TableSetupColumn("Usage, MiB");
+            ImGui::TableSetupColumn("Budget, MiB");
+            ImGui::TableSetupColumn("Limit, MiB");
+            ImGui::TableSetupColumn("Usage / limit");
+            ImGui::TableHeadersRow();
+            for (size_t i = 0; i < stats.heaps.size(); ++i)
+            {
+                const MemoryHeapStats& heap = stats.heaps[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%zu %s", i, (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "device" : "host");
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f (%u)", heap.allocated / MIB, heap.allocationCount);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", heap.usage / MIB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", heap.budget / MIB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", heap.limit / MIB);
+                ImGui::TableNextColumn();
+                const float fraction = heap.limit > 0 ? static_cast<float>(static_cast<double>(heap.usage) / heap.limit) : 0.0f;
+                if (heap.overBudget) ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(0.9f, 0.2f, 0.2f, 1.0f));
+                ImGui::ProgressBar(std::min(fraction, 1.0f), ImVec2(-FLT_MIN, 0.0f));
+                if (heap.overBudget) ImGui::PopStyleColor();
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::BeginTable("Memory categories", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Category");
+            ImGui::TableSetupColumn("MiB");
+            ImGui::TableSetupColumn("Allocations");
+            ImGui::TableHeadersRow();
+            for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+            {
+                if (stats.categoryAllocations[i] == 0) continue;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", VgetMemoryTracker::getCategoryName(static_cast<MemoryCategory>(i)));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", stats.categoryBytes[i] / MIB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", stats.categoryAllocations[i]);
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::CollapsingHeader("Assets") &&
+            ImGui::BeginTable("Memory owners", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0.0f, 200.0f)))
+        {
+            ImGui::TableSetupScrollFreeze(0, 1);
+            ImGui::TableSetupColumn("Owner");
+            ImGui::TableSetupColumn("MiB");
+            ImGui::TableSetupColumn("Allocations");
+            ImGui::TableHeadersRow();
+            for (const MemoryOwnerStats& owner : stats.owners)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", owner.owner.empty() ? "(untagged)" : owner.owner.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", owner.bytes / MIB);
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", owner.allocationCount);
+            }
+            ImGui::EndTable();
+        }
         ImGui::End();
     }
 
-    void VgetImgui::inspectObject(VgetGameObject& object, bool isPointLight)
+    void VgetImgui::inspectObject(Entity entity)
     {
         if (ImGui::Begin("Inspector")) {
             /*if (Scene::selectedEntity != nullptr) {
                 Scene::InspectEntity(Scene::selectedEntity);
             }*/
-            if (ImGui::CollapsingHeader("Transform Component", ImGuiTreeNodeFlags_DefaultOpen)) {
-                ImGui::DragFloat3("Position", glm::value_ptr(object.transform.translation), 0.02f);
-                ImGui::DragFloat3("Scale", glm::value_ptr(object.transform.scale), 0.02f);
-                ImGui::DragFloat3("Rotation", glm::value_ptr(object.transform.rotation), 0.02f);
+            TransformComponent* transform = world.getComponent<TransformComponent>(entity);
+            if (transform != nullptr) {
+                if (ImGui::CollapsingHeader("Transform Component", ImGuiTreeNodeFlags_DefaultOpen)) {
+                    bool changed = ImGui::DragFloat3("Position", glm::value_ptr(transform->translation), 0.02f);
+                    changed |= ImGui::DragFloat3("Scale", glm::value_ptr(transform->scale), 0.02f);
+                    changed |= ImGui::DragFloat3("Rotation", glm::value_ptr(transform->rotation), 0.02f);
+                    if (changed) world.markChanged<TransformComponent>(entity);
+                }
+                const ParentComponent* link = world.getComponent<ParentComponent>(entity);
+                const TransformComponent* parentTransform =
+                    link != nullptr ? world.getComponent<TransformComponent>(link->parent) : nullptr;
+                renderTransformGizmo(entity, *transform, parentTransform != nullptr ? parentTransform->worldMatrix : glm::mat4{ 1.f });
             }
-            renderTransformGizmo(object.transform);
 
-            if (isPointLight) {
+            if (world.hasComponent<ModelComponent>(entity)) {
+                if (ImGui::CollapsingHeader("Model Component", ImGuiTreeNodeFlags_DefaultOpen)) {
+                    bool occluder = world.hasComponent<OccluderComponent>(entity);
+                    if (ImGui::Checkbox("Occluder", &occluder)) {
+                        // сущность переходит в архетип с окклюдером или из него, поэтому transform дальше не используется
+                        if (occluder) world.addComponent(entity, OccluderComponent{});
+                        else world.removeComponent<OccluderComponent>(entity);
+                    }
+                }
+            }
+
+            PointLightComponent* pointLight = world.getComponent<PointLightComponent>(entity);
+            if (pointLight != nullptr) {
                 if (ImGui::CollapsingHeader("PointLight Component", ImGuiTreeNodeFlags_DefaultOpen)) {
-                    ImGui::SliderFloat("Light intensity", &object.pointLight->lightIntensity, .0f, 500.0f);
-                    ImGui::SliderFloat("Light radius", &object.transform.scale.x, 0.01f, 10.0f);
-                    ImGui::ColorEdit3("Light color", (float*)&object.color);
-                    ImGui::Checkbox("Demo Carousel Enabled", &object.pointLight->carouselEnabled);
+                    ImGui::SliderFloat("Light intensity", &pointLight->lightIntensity, .0f, 500.0f);
+                    TransformComponent& lightTransform = *world.getComponent<TransformComponent>(entity);
+                    if (ImGui::SliderFloat("Light radius", &lightTransform.scale.x, 0.01f, 10.0f)) world.markChanged<TransformComponent>(entity);
+                    ImGui::ColorEdit3("Light color", (float*)&pointLight->color);
+                    ImGui::Checkbox("Demo Carousel Enabled", &pointLight->carouselEnabled);
                 }
             }
             /*if (entity->entityType == EntityType::Model) {
@@ -297,7 +650,7 @@ namespace vget {
         ImGui::End();
     }
 
-    void VgetImgui::renderTransformGizmo(TransformComponent& transform)
+    void VgetImgui::renderTransformGizmo(Entity entity, TransformComponent& transform, const glm::mat4& parentMatrix)
     {
         ImGuizmo::BeginFrame();
         static ImGuizmo::OPERATION currentGizmoOperation = ImGuizmo::ROTATE;
@@ -337,31 +690,33 @@ namespace vget {
             currentGizmoMode = ImGuizmo::LOCAL;
         }
 
-        glm::mat4 modelMat = transform.mat4();
+        glm::mat4 modelMat = transform.worldMatrix;
         glm::mat4 deltaMat{};
         glm::mat4 guizmoProj(camera.getProjection());
         guizmoProj[1][1] *= -1;
 
         ImGuiIO& io = ImGui::GetIO();
         ImGuizmo::SetRect(0, 0, io.DisplaySize.x, io.DisplaySize.y);
-        ImGuizmo::Manipulate(glm::value_ptr(camera.getView()), glm::value_ptr(guizmoProj), currentGizmoOperation,
+        const bool manipulated = ImGuizmo::Manipulate(glm::value_ptr(camera.getView()), glm::value_ptr(guizmoProj), currentGizmoOperation,
             currentGizmoMode, glm::value_ptr(modelMat), glm::value_ptr(deltaMat), nullptr);
 
-        /*if (transform.parent != nullptr) {
-            modelMat = glm::inverse(transform.parent->GetMatrix()) * modelMat;
-        }
-        transform.transform = modelMat;*/
-
         /*glm::vec3 deltaTranslation{};
         glm::vec3 deltaRotation{};
         glm::vec3 deltaScale{};*/
         /*ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(deltaMat), glm::value_ptr(deltaTranslation),
             glm::value_ptr(deltaRotation), glm::value_ptr(deltaScale));*/
 
-        glm::vec3 empty{};
+        // Трансформация разбирается обратно на компоненты только тогда, когда гизмо действительно её изменило,
+        // иначе кэшированные матрицы объекта пересчитывались бы каждый кадр
+        if (manipulated) {
+            // Гизмо работает с мировой матрицей, а компоненты трансформации задаются относительно родителя
+            modelMat = glm::inverse(parentMatrix) * modelMat;
+            glm::vec3 empty{};
 
-        ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(modelMat), glm::value_ptr(transform.translation),
-            glm::value_ptr(empty), glm::value_ptr(transform.scale));
+            ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(modelMat), glm::value_ptr(transform.translation),
+                glm::value_ptr(empty), glm::value_ptr(transform.scale));
+            world.markChanged<TransformComponent>(entity);
+        }
 
         // Преобразование градусов в радианы.
         // todo: поворот дёргается. нужен фикс
@@ -5,6 +5,11 @@
 #include "vget_game_object.hpp"
 #include "vget_camera.hpp"
 #include "keyboard_movement_controller.hpp"
+#include "vget_culling.hpp"
+#include "vget_draw_queue.hpp"
+#include "vget_command_recorder.hpp"
+#include "vget_gpu_profiler.hpp"
+#include "vget_render_stats.hpp"
 
 // libs
 #include <imgui.h>
@@ -15,6 +20,7 @@
 // std
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 // This whole class is only necessary right now because it needs to manage the descriptor pool
 // because we haven't set one up anywhere else in the application, and we manage the
@@ -27,10 +33,32 @@ namespace vget {
 		if (err < 0) abort();
 	}
 
+	// Копия данных отрисовки ImGui для снимка кадра. ImGui перезаписывает свои списки отрисовки в следующем
+	// NewFrame(), а поток рендера записывает команды позже, поэтому списки копируются в потоке обновления.
+	// Копии создаются и освобождаются в потоке обновления (аллокатор ImGui ведёт счётчики без синхронизации).
+	class VgetImguiDrawData {
+	public:
+		VgetImguiDrawData() = default;
+		~VgetImguiDrawData();
+
+		VgetImguiDrawData(const VgetImguiDrawData&) = delete;
+		VgetImguiDrawData& operator=(const VgetImguiDrawData&) = delete;
+
+		// Копирование данных отрисовки с освобождением предыдущей копии
+		void capture(const ImDrawData& source);
+		ImDrawData* get() { return &drawData; }
+
+	private:
+		void clear();
+
+		ImDrawData drawData{};
+		std::vector<ImDrawList*> drawLists;
+	};
+
 	class VgetImgui {
 	public:
 		VgetImgui(VgetWindow& window, VgetDevice& device, VkRenderPass renderPass,
-			uint32_t imageCount, VgetCamera& camera, KeyboardMovementController& kmc, VgetGameObject::Map& gameObjects);
+			uint32_t imageCount, VgetCamera& camera, KeyboardMovementController& kmc, VgetWorld& world);
 		~VgetImgui();
 
 		VgetImgui() = default;
@@ -38,7 +66,10 @@ namespace vget {
 
 		void newFrame();
 
-		void render(VkCommandBuffer commandBuffer);
+		// Завершение описания интерфейса кадра и копирование его данных отрисовки в снимок (поток обновления)
+		void endFrame(VgetImguiDrawData& drawData);
+		// Запись команд отрисовки интерфейса из снимка (поток рендера)
+		static void render(VkCommandBuffer commandBuffer, VgetImguiDrawData& drawData);
 
 		// Example state
 		bool show_demo_window = false;
@@ -48,8 +79,15 @@ namespace vget {
 		void showPointLightCreator();
 		void showModelsFromDirectory();
 		void enumerateObjectsInTheScene();
-		void inspectObject(VgetGameObject& object, bool isPointLight);
-		void renderTransformGizmo(TransformComponent& transform);
+		// Окно профайлера GPU: таблица областей, график времени кадра и статистика конвейера
+		void showGpuProfiler();
+		// Окно счётчиков рендера: последний кадр, среднее и максимум по истории, график выбранного счётчика
+		void showRenderStats();
+		// Окно памяти девайса: использование куч против бюджета, память по категориям и по ассетам
+		void showMemoryBudget();
+		void inspectObject(Entity entity);
+		// parentMatrix - мировая матрица родителя в иерархии сцены (единичная у объектов без родителя)
+		void renderTransformGizmo(Entity entity, TransformComponent& transform, const glm::mat4& parentMatrix);
 
 		// data
 		float directionalLightIntensity = .0f;
@@ -62,11 +100,44 @@ namespace vget {
 		float pointLightRadius = .0f;
 		glm::vec3 pointLightColor{};
 
+		// статистика отсечения по пирамиде видимости за последний кадр (заполняется приложением)
+		CullingStats cullingStats{};
+		double occlusionRasterTimeMs = 0.0;
+		uint32_t occluderTriangleCount = 0;
+		DrawStats drawStats{};	// статистика сортировки отрисовок за последний кадр
+		CommandStats commandStats{};	// записанные и отброшенные команды систем рендера за последний кадр
+		uint32_t lightCount = 0;	// точечные источники света, разложенные по кластерам
+		double lightClusterBuildTimeMs = 0.0;
+		uint32_t transformUpdateCount = 0;	// трансформации, матрицы которых пересчитаны в этом кадре
+		double transformUpdateTimeMs = 0.0;
+		uint32_t hierarchyNodeCount = 0;	// узлы иерархии сцены и те из них, чьи мировые матрицы пересчитаны в этом кадре
+		uint32_t hierarchyUpdateCount = 0;
+		int32_t pvsCell = -1;	// ячейка PVS, в которой находится камера (-1 - вне сетки или PVS не загружен)
+		double commandRecordTimeMs = 0.0;	// время параллельной записи вторичных буферов систем рендера
+		uint32_t commandBufferCount = 0;	// вторичные буферы, записанные за последний кадр
+		int recordThreadCount = 1;	// потоки записи команд, выбранные ползунком
+		int maxRecordThreads = 1;	// верхняя граница ползунка (число рабочих потоков планировщика)
+		bool threadedRendering = true;	// рендер в отдельном потоке (VgetFramePipeline), иначе однопоточный цикл
+		double frameLatencyMs = 0.0;	// от начала обновления кадра до отправки его в очередь, скользящее среднее
+		double renderTimeMs = 0.0;	// запись и отправка кадра в потоке рендера
+		GpuTimings gpuTimings{};	// замеры профайлера GPU (отстают на число кадров в полёте)
+		bool gpuStatisticsEnabled = false;	// сбор статистики конвейера, выбранный в окне профайлера
+		bool recordCameraPath = false;	// запись пути камеры для vget_bench (сохраняется при выключении)
+		RenderCounterHistory renderCounterHistory{};	// счётчики рендера последних кадров
+		int selectedRenderCounter = 0;	// счётчик, показанный на графике
+		bool writeRenderStatsCsv = false;	// покадровая выгрузка счётчиков в CSV
+
+		// Нагрузочная сетка экземпляров выбранной модели для замеров записи команд (STRESS_GRID_X * Y * Z отрисовок)
+		static constexpr int STRESS_GRID_X = 100;
+		static constexpr int STRESS_GRID_Y = 10;
+		static constexpr int STRESS_GRID_Z = 100;
+		static constexpr float STRESS_GRID_SPACING = .5f;
+
 	private:
 		VgetDevice& vgetDevice;
 		VgetCamera& camera;
 		KeyboardMovementController& kmc;
-		VgetGameObject::Map& gameObjects;
+		VgetWorld& world;
 
 		VkDescriptorPool descriptorPool; // ImGui's descriptor pool
 	};
@@ -0,0 +1,372 @@
+#include "vget_job_system.hpp"
+#include "vget_cpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+// закрепление потоков за ядрами
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace vget
+{
+	namespace
+	{
+		// Планировщик и индекс рабочего потока, которому принадлежит текущий поток
+		thread_local const VgetJobSystem* currentOwner = nullptr;
+		thread_local uint32_t currentOwnerIndex = ~0u;
+
+		// Генератор xorshift для выбора жертвы кражи: у каждого потока свой, без синхронизации
+		uint32_t nextRandom()
+		{
+			thread_local uint32_t state = 0x9E3779B9u ^ static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		void invokeFunction(void* data, uint32_t, uint32_t)
+		{
+			(*static_cast<std::function<void()>*>(data))();
+		}
+	}
+
+	VgetJobSystem::WorkStealingDeque::WorkStealingDeque()
+		: buffer{ new std::atomic<Job*>[DEQUE_CAPACITY] }
+	{
+	}
+
+	bool VgetJobSystem::WorkStealingDeque::push(Job* job)
+	{
+		const int64_t b = bottom.load(std::memory_order_relaxed);
+		const int64_t t = top.load(std::memory_order_acquire);
+		if (b - t >= static_cast<int64_t>(DEQUE_CAPACITY)) return false;
+
+		buffer[b & (DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+		// release публикует содержимое задачи для потоков, которые прочитают новое значение bottom
+		bottom.store(b + 1, std::memory_order_release);
+		return true;
+	}
+
+	VgetJobSystem::Job* VgetJobSystem::WorkStealingDeque::pop()
+	{
+		const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		// Уменьшение bottom должно стать видимым до чтения top: иначе вор и владелец заберут одну задачу
+		bottom.store(b, std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_seq_cst);
+
+		if (t > b)
+		{
+			// очередь пуста
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = buffer[b & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+		if (t == b)
+		{
+			// Последняя задача: владелец соревнуется с ворами за неё тем же CAS, что и воры
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	VgetJobSystem::Job* VgetJobSystem::WorkStealingDeque::steal()
+	{
+		int64_t t = top.load(std::memory_order_seq_cst);
+		const int64_t b = bottom.load(std::memory_order_seq_cst);
+		if (t >= b) return nullptr;
+
+		Job* job = buffer[t & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+		// Неудачный CAS - задачу забрал владелец или другой вор
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+		return job;
+	}
+
+	VgetJobSystem::VgetJobSystem(uint32_t workerCount, bool pinThreads)
+		: workerCount{ workerCount != 0 ? workerCount : std::max(1u, std::thread::hardware_concurrency()) }
+	{
+		for (uint32_t i = 0; i < this->workerCount; ++i) deques.push_back(std::make_unique<WorkStealingDeque>());
+
+		previousOwner = currentOwner;
+		previousOwnerIndex = currentOwnerIndex;
+		currentOwner = this;
+		currentOwnerIndex = 0;
+
+		pinned = pinThreads && this->workerCount > 1;
+		threads.reserve(this->workerCount - 1);
+		for (uint32_t i = 1; i < this->workerCount; ++i)
+		{
+			threads.emplace_back(&VgetJobSystem::workerLoop, this, i);
+			if (pinThreads) pinned &= pinThread(threads.back(), i % std::max(1u, std::thread::hardware_concurrency()));
+		}
+	}
+
+	VgetJobSystem::~VgetJobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ sleepMutex };
+			stopping = true;
+		}
+		wakeCondition.notify_all();
+		for (auto& thread : threads) thread.join();
+
+		// Задачи, которые никто не дождался, выполняются здесь, чтобы не потерять их счётчики и память
+		while (executeOne(0)) {}
+
+		if (currentOwner == this)
+		{
+			currentOwner = previousOwner;
+			currentOwnerIndex = previousOwnerIndex;
+		}
+	}
+
+	uint32_t VgetJobSystem::currentWorkerIndex() const
+	{
+		return currentOwner == this ? currentOwnerIndex : ~0u;
+	}
+
+	void VgetJobSystem::run(std::function<void()> function, VgetJobCounter& counter)
+	{
+		Job* job = new Job{};
+		job->function = std::move(function);
+		job->entry = &invokeFunction;
+		job->data = &job->function;
+		job->counter = &counter;
+		submit(job);
+	}
+
+	void VgetJobSystem::run(JobEntry entry, void* data, uint32_t begin, uint32_t end, VgetJobCounter& counter)
+	{
+		Job* job = new Job{};
+		job->entry = entry;
+		job->data = data;
+		job->begin = begin;
+		job->end = end;
+		job->counter = &counter;
+		submit(job);
+	}
+
+	void VgetJobSystem::submit(Job* job)
+	{
+		job->counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+		const uint32_t workerIndex = currentWorkerIndex();
+		if (workerIndex != ~0u)
+		{
+			// Переполненная очередь: задача выполняется сразу, что заодно ограничивает глубину порождения задач
+			if (!deques[workerIndex]->push(job))
+			{
+				execute(job);
+				return;
+			}
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock{ injectedMutex };
+			injectedJobs.push_back(job);
+			injectedCount.fetch_add(1, std::memory_order_release);
+		}
+
+		queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+		if (sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+		{
+			// Захват мьютекса гарантирует, что засыпающий поток либо уже ждёт, либо ещё увидит новую задачу
+			{
+				std::lock_guard<std::mutex> lock{ sleepMutex };
+			}
+			wakeCondition.notify_one();
+		}
+	}
+
+	void VgetJobSystem::wait(VgetJobCounter& counter)
+	{
+		const uint32_t workerIndex = currentWorkerIndex();
+		while (!counter.done())
+		{
+			if (!executeOne(workerIndex)) std::this_thread::yield();
+		}
+	}
+
+	bool VgetJobSystem::executeOne(uint32_t workerIndex)
+	{
+		Job* job = workerIndex != ~0u ? deques[workerIndex]->pop() : nullptr;
+		if (job == nullptr) job = stealJob(workerIndex);
+		if (job == nullptr && injectedCount.load(std::memory_order_acquire) > 0)
+		{
+			std::lock_guard<std::mutex> lock{ injectedMutex };
+			if (!injectedJobs.empty())
+			{
+				job = injectedJobs.front();
+				injectedJobs.pop_front();
+				injectedCount.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+		if (job == nullptr) return false;
+
+		queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		execute(job);
+		return true;
+	}
+
+	VgetJobSystem::Job* VgetJobSystem::stealJob(uint32_t workerIndex)
+	{
+		// Обход очередей начинается со случайной, чтобы воры не соревновались за одну и ту же жертву
+		const uint32_t start = nextRandom() % workerCount;
+		for (uint32_t i = 0; i < workerCount; ++i)
+		{
+			const uint32_t victim = (start + i) % workerCount;
+			if (victim == workerIndex) continue;
+			if (Job* job = deques[victim]->steal()) return job;
+		}
+		return nullptr;
+	}
+
+	void VgetJobSystem::execute(Job* job)
+	{
+		job->entry(job->data, job->begin, job->end);
+		VgetJobCounter* counter = job->counter;
+		delete job;
+		// После уменьшения счётчика ожидающий поток может уничтожить данные задачи
+		counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	void VgetJobSystem::workerLoop(uint32_t workerIndex)
+	{
+		currentOwner = this;
+		currentOwnerIndex = workerIndex;
+		VGET_PROFILE_THREAD_NAME("Worker " + std::to_string(workerIndex));
+
+		uint32_t idleCount = 0;
+		while (true)
+		{
+			if (executeOne(workerIndex))
+			{
+				idleCount = 0;
+				continue;
+			}
+			if (stopping.load(std::memory_order_acquire)) break;
+			if (++idleCount < IDLE_SPIN_COUNT)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock{ sleepMutex };
+			sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+			wakeCondition.wait(lock, [this]()
+			{
+				return queuedJobs.load(std::memory_order_seq_cst) > 0 || stopping.load(std::memory_order_relaxed);
+			});
+			sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+			idleCount = 0;
+		}
+	}
+
+	bool VgetJobSystem::pinThread(std::thread& thread, uint32_t core)
+	{
+#if defined(_WIN32)
+		if (core >= sizeof(DWORD_PTR) * 8) return false;
+		return SetThreadAffinityMask(thread.native_handle(), DWORD_PTR{ 1 } << core) != 0;
+#elif defined(__linux__)
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(core, &cpuSet);
+		return pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+		(void)thread;
+		(void)core;
+		return false;
+#endif
+	}
+
+	VgetTaskGraph::TaskId VgetTaskGraph::addTask(std::function<void()> function)
+	{
+		tasks.emplace_back();
+		tasks.back().function = std::move(function);
+		validated = false;
+		return static_cast<TaskId>(tasks.size() - 1);
+	}
+
+	void VgetTaskGraph::addDependency(TaskId before, TaskId after)
+	{
+		if (before >= tasks.size() || after >= tasks.size())
+		{
+			throw std::runtime_error("failed to add task dependency: unknown task!");
+		}
+		tasks[before].successors.push_back(after);
+		++tasks[after].dependencyCount;
+		validated = false;
+	}
+
+	void VgetTaskGraph::clear()
+	{
+		tasks.clear();
+		validated = false;
+	}
+
+	void VgetTaskGraph::validate()
+	{
+		// Алгоритм Кана: если не все задачи удаётся упорядочить, в графе есть цикл и часть задач никогда не запустится
+		std::vector<uint32_t> remaining(tasks.size());
+		std::vector<TaskId> ready;
+		for (TaskId i = 0; i < tasks.size(); ++i)
+		{
+			remaining[i] = tasks[i].dependencyCount;
+			if (remaining[i] == 0) ready.push_back(i);
+		}
+		size_t ordered = 0;
+		while (!ready.empty())
+		{
+			const TaskId task = ready.back();
+			ready.pop_back();
+			++ordered;
+			for (const TaskId successor : tasks[task].successors)
+			{
+				if (--remaining[successor] == 0) ready.push_back(successor);
+			}
+		}
+		if (ordered != tasks.size()) throw std::runtime_error("failed to run task graph: dependency cycle!");
+		validated = true;
+	}
+
+	void VgetTaskGraph::run(VgetJobSystem& jobSystem)
+	{
+		if (!validated) validate();
+
+		this->jobSystem = &jobSystem;
+		for (Task& task : tasks) task.remainingDependencies.store(task.dependencyCount, std::memory_order_relaxed);
+		for (TaskId i = 0; i < tasks.size(); ++i)
+		{
+			if (tasks[i].dependencyCount == 0) jobSystem.run(&VgetTaskGraph::executeTask, this, i, i + 1, counter);
+		}
+		jobSystem.wait(counter);
+	}
+
+	void VgetTaskGraph::executeTask(void* data, uint32_t task, uint32_t)
+	{
+		auto& graph = *static_cast<VgetTaskGraph*>(data);
+		Task& current = graph.tasks[task];
+		if (current.function) current.function();
+
+		// Последняя завершённая зависимость запускает задачу. Счётчик графа увеличивается до завершения текущей задачи,
+		// поэтому run() не вернёт управление раньше времени.
+		for (const TaskId successor : current.successors)
+		{
+			if (graph.tasks[successor].remainingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				graph.jobSystem->run(&VgetTaskGraph::executeTask, data, successor, successor + 1, graph.counter);
+			}
+		}
+	}
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vget
+{
+	// Счётчик незавершённых задач. Запуск задачи со счётчиком увеличивает его, а завершение задачи - уменьшает.
+	// VgetJobSystem::wait ждёт обнуления счётчика. Счётчик должен жить до конца ожидания.
+	class VgetJobCounter
+	{
+	public:
+		VgetJobCounter() = default;
+		VgetJobCounter(const VgetJobCounter&) = delete;
+		VgetJobCounter& operator=(const VgetJobCounter&) = delete;
+
+		bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class VgetJobSystem;
+		std::atomic<uint32_t> pending{ 0 };
+	};
+
+	// Планировщик задач с перехватом работы (work stealing). У каждого рабочего потока своя двусторонняя очередь
+	// Чейза-Лева: владелец кладёт и забирает задачи с нижнего конца без блокировок, а свободные потоки крадут
+	// с верхнего конца самые старые (и обычно самые крупные) задачи. Задачи из потоков, не принадлежащих
+	// планировщику, попадают в общую очередь под мьютексом.
+	// Поток, создавший планировщик, считается рабочим потоком с индексом 0: задачи, запущенные из него, идут
+	// в его очередь, а wait() выполняет чужие задачи, пока ждёт свои. Задачи не должны бросать исключения.
+	class VgetJobSystem
+	{
+	public:
+		// Точка входа задачи без выделения std::function: entry(data, begin, end)
+		using JobEntry = void (*)(void* data, uint32_t begin, uint32_t end);
+
+		static constexpr uint32_t DEQUE_CAPACITY = 4096;	// степень двойки; при переполнении задача выполняется сразу
+		static constexpr uint32_t IDLE_SPIN_COUNT = 64;		// попыток найти задачу перед засыпанием потока
+
+		// workerCount - число рабочих потоков вместе с создающим (0 - по числу аппаратных потоков).
+		// pinThreads - закрепить запущенные потоки за ядрами (поток i за ядром i), если платформа это поддерживает.
+		explicit VgetJobSystem(uint32_t workerCount = 0, bool pinThreads = false);
+		~VgetJobSystem();
+
+		VgetJobSystem(const VgetJobSystem&) = delete;
+		VgetJobSystem& operator=(const VgetJobSystem&) = delete;
+
+		void run(std::function<void()> function, VgetJobCounter& counter);
+		void run(JobEntry entry, void* data, uint32_t begin, uint32_t end, VgetJobCounter& counter);
+		// Ожидание обнуления счётчика. Ожидающий поток тем временем выполняет задачи из очередей.
+		void wait(VgetJobCounter& counter);
+
+		// Параллельный вызов func(rangeBegin, rangeEnd) для поддиапазонов [begin; end) размером не больше grainSize.
+		// Диапазон делится пополам по мере необходимости: вызывающий поток обрабатывает левую половину, а правая
+		// остаётся в его очереди для других потоков. Возвращает управление после обработки всего диапазона.
+		template <typename Func>
+		void parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, Func&& func)
+		{
+			if (begin >= end) return;
+			grainSize = grainSize == 0 ? 1 : grainSize;
+			if (end - begin <= grainSize || workerCount == 1)
+			{
+				func(begin, end);
+				return;
+			}
+
+			using Function = std::remove_reference_t<Func>;
+			ParallelForState<Function> state{ this, &func, grainSize, {} };
+			ParallelForState<Function>::execute(&state, begin, end);
+			wait(state.counter);
+		}
+
+		uint32_t getWorkerCount() const { return workerCount; }
+		// Удалось ли закрепить все запущенные потоки за ядрами
+		bool isPinned() const { return pinned; }
+		// Индекс рабочего потока этого планировщика, из которого вызвана функция, или ~0u для посторонних потоков
+		uint32_t currentWorkerIndex() const;
+
+	private:
+		struct Job
+		{
+			JobEntry entry = nullptr;
+			void* data = nullptr;
+			uint32_t begin = 0;
+			uint32_t end = 0;
+			VgetJobCounter* counter = nullptr;
+			std::function<void()> function;	// для run(std::function); entry вызывает её
+		};
+
+		// Двусторонняя очередь Чейза-Лева фиксированной ёмкости (Lê и др., "Correct and Efficient Work-Stealing
+		// for Weak Memory Models"). push/pop вызывает только владелец, steal - любой поток. Барьеры из статьи
+		// заменены seq_cst операциями над top и bottom: на x86 это та же стоимость, а проверка санитайзерами проще.
+		class WorkStealingDeque
+		{
+		public:
+			WorkStealingDeque();
+
+			bool push(Job* job);
+			Job* pop();
+			Job* steal();
+
+		private:
+			alignas(64) std::atomic<int64_t> top{ 0 };
+			alignas(64) std::atomic<int64_t> bottom{ 0 };
+			std::unique_ptr<std::atomic<Job*>[]> buffer;
+		};
+
+		template <typename Function>
+		struct ParallelForState
+		{
+			VgetJobSystem* jobSystem;
+			Function* func;
+			uint32_t grainSize;
+			VgetJobCounter counter;
+
+			static void execute(void* data, uint32_t begin, uint32_t end)
+			{
+				auto& state = *static_cast<ParallelForState*>(data);
+				while (end - begin > state.grainSize)
+				{
+					const uint32_t middle = begin + (end - begin) / 2;
+					state.jobSystem->run(&ParallelForState::execute, data, middle, end, state.counter);
+					end = middle;
+				}
+				(*state.func)(begin, end);
+			}
+		};
+
+		void submit(Job* job);
+		// Поиск и выполнение одной задачи: своя очередь, чужие очереди, общая очередь. false - задач не нашлось.
+		bool executeOne(uint32_t workerIndex);
+		Job* stealJob(uint32_t workerIndex);
+		void execute(Job* job);
+		void workerLoop(uint32_t workerIndex);
+		static bool pinThread(std::thread& thread, uint32_t core);
+
+		uint32_t workerCount;
+		bool pinned = false;
+		std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+		std::vector<std::thread> threads;
+
+		std::mutex injectedMutex;
+		std::deque<Job*> injectedJobs;	// задачи из потоков, не принадлежащих планировщику
+		std::atomic<uint32_t> injectedCount{ 0 };
+
+		// Сон свободных потоков: queuedJobs увеличивается до проверки sleepingWorkers, а поток перед сном
+		// увеличивает sleepingWorkers и затем проверяет queuedJobs, поэтому пробуждение не теряется
+		std::atomic<int32_t> queuedJobs{ 0 };	// может ненадолго уйти в минус, если задачу украли до увеличения
+		std::atomic<uint32_t> sleepingWorkers{ 0 };
+		std::mutex sleepMutex;
+		std::condition_variable wakeCondition;
+		std::atomic<bool> stopping{ false };
+
+		const VgetJobSystem* previousOwner = nullptr;	// планировщик, которому поток-создатель принадлежал до этого
+		uint32_t previousOwnerIndex = ~0u;
+	};
+
+	// Граф задач с зависимостями. Строится один раз и может запускаться многократно (например, каждый кадр).
+	// Задача запускается, когда завершены все задачи, от которых она зависит.
+	class VgetTaskGraph
+	{
+	public:
+		using TaskId = uint32_t;
+
+		VgetTaskGraph() = default;
+		VgetTaskGraph(const VgetTaskGraph&) = delete;
+		VgetTaskGraph& operator=(const VgetTaskGraph&) = delete;
+
+		TaskId addTask(std::function<void()> function);
+		// after запускается только после завершения before
+		void addDependency(TaskId before, TaskId after);
+		// Выполнение всех задач графа. Возвращает управление после завершения последней.
+		// Бросает исключение, если зависимости образуют цикл.
+		void run(VgetJobSystem& jobSystem);
+		void clear();
+
+		uint32_t getTaskCount() const { return static_cast<uint32_t>(tasks.size()); }
+
+	private:
+		struct Task
+		{
+			std::function<void()> function;
+			std::vector<TaskId> successors;
+			uint32_t dependencyCount = 0;
+			std::atomic<uint32_t> remainingDependencies{ 0 };
+		};
+
+		static void executeTask(void* data, uint32_t task, uint32_t);
+		void validate();
+
+		std::deque<Task> tasks;	// deque: атомарные счётчики задач не перемещаются при добавлении
+		bool validated = false;
+		VgetJobSystem* jobSystem = nullptr;
+		VgetJobCounter counter;
+	};
+}
@@ -0,0 +1,147 @@
+#include "vget_light_clusters.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace vget
+{
+	void VgetLightClusters::updateClusterBounds(const glm::mat4& projection)
+	{
+		if (!clusterBounds.empty() && projection == boundsProjection) return;
+		boundsProjection = projection;
+
+		// Из матрицы VgetCamera::setPerspectiveProjection: [2][2] = f / (f - n), [3][2] = -f * n / (f - n)
+		nearPlane = -projection[3][2] / projection[2][2];
+		farPlane = projection[3][2] / (1.f - projection[2][2]);
+		sliceScale = static_cast<float>(GRID_Z) / std::log(farPlane / nearPlane);
+		sliceBias = -std::log(nearPlane) * sliceScale;
+
+		// Точка (x, y, z) пространства камеры попадает в x_ndc = P[0][0] * x / z, y_ndc = P[1][1] * y / z
+		clusterBounds.resize(CLUSTER_COUNT);
+		for (uint32_t z = 0; z < GRID_Z; ++z)
+		{
+			const float depthNear = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / GRID_Z);
+			const float depthFar = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z + 1) / GRID_Z);
+			for (uint32_t y = 0; y < GRID_Y; ++y)
+			{
+				const float ndcY0 = -1.f + 2.f * y / GRID_Y;
+				const float ndcY1 = -1.f + 2.f * (y + 1) / GRID_Y;
+				for (uint32_t x = 0; x < GRID_X; ++x)
+				{
+					const float ndcX0 = -1.f + 2.f * x / GRID_X;
+					const float ndcX1 = -1.f + 2.f * (x + 1) / GRID_X;
+
+					Aabb& box = clusterBounds[clusterIndex(x, y, z)];
+					box.min = glm::vec3{
+						std::min(ndcX0 * depthNear, ndcX0 * depthFar) / projection[0][0],
+						std::min(ndcY0 * depthNear, ndcY0 * depthFar) / projection[1][1],
+						depthNear };
+					box.max = glm::vec3{
+						std::max(ndcX1 * depthNear, ndcX1 * depthFar) / projection[0][0],
+						std::max(ndcY1 * depthNear, ndcY1 * depthFar) / projection[1][1],
+						depthFar };
+				}
+			}
+		}
+	}
+
+	uint32_t VgetLightClusters::sliceForDepth(float viewDepth) const
+	{
+		const float slice = std::log(std::max(viewDepth, nearPlane)) * sliceScale + sliceBias;
+		return std::min(static_cast<uint32_t>(std::max(slice, 0.f)), GRID_Z - 1);
+	}
+
+	uint32_t VgetLightClusters::findCluster(const glm::vec3& viewPosition) const
+	{
+		const float depth = std::max(viewPosition.z, nearPlane);
+		const float ndcX = boundsProjection[0][0] * viewPosition.x / depth;
+		const float ndcY = boundsProjection[1][1] * viewPosition.y / depth;
+		const auto tile = [](float ndc, uint32_t count)
+		{
+			const float t = (ndc * .5f + .5f) * static_cast<float>(count);
+			return std::min(static_cast<uint32_t>(std::max(t, 0.f)), count - 1);
+		};
+		return clusterIndex(tile(ndcX, GRID_X), tile(ndcY, GRID_Y), sliceForDepth(viewPosition.z));
+	}
+
+	void VgetLightClusters::build(const glm::mat4& view, const glm::mat4& projection, const std::vector<PointLight>& lights)
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+		updateClusterBounds(projection);
+
+		assignments.clear();
+		for (uint32_t lightIndex = 0; lightIndex < lights.size(); ++lightIndex)
+		{
+			const glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(lights[lightIndex].position), 1.f));
+			const float radius = lights[lightIndex].position.w;
+			if (center.z + radius < nearPlane || center.z - radius > farPlane) continue;
+
+			// Диапазон срезов по глубине сферы
+			const float minDepth = std::max(center.z - radius, nearPlane);
+			const float maxDepth = std::min(center.z + radius, farPlane);
+			const uint32_t minSlice = sliceForDepth(minDepth);
+			const uint32_t maxSlice = sliceForDepth(maxDepth);
+
+			// Консервативный диапазон плиток: x / z на объёме сферы достигает крайних значений в его углах
+			uint32_t minTileX = 0, maxTileX = GRID_X - 1, minTileY = 0, maxTileY = GRID_Y - 1;
+			{
+				const auto tileRange = [&](float minCoord, float maxCoord, float scale, uint32_t count, uint32_t& first, uint32_t& last)
+				{
+					const float minNdc = scale * std::min(minCoord / minDepth, minCoord / maxDepth);
+					const float maxNdc = scale * std::max(maxCoord / minDepth, maxCoord / maxDepth);
+					if (maxNdc < -1.f || minNdc > 1.f) return false;
+					first = static_cast<uint32_t>(std::max((minNdc * .5f + .5f) * count, 0.f));
+					last = std::min(static_cast<uint32_t>(std::max((maxNdc * .5f + .5f) * count, 0.f)), count - 1);
+					return true;
+				};
+				if (!tileRange(center.x - radius, center.x + radius, projection[0][0], GRID_X, minTileX, maxTileX)) continue;
+				if (!tileRange(center.y - radius, center.y + radius, projection[1][1], GRID_Y, minTileY, maxTileY)) continue;
+			}
+
+			// Точная проверка сферы с объёмом каждого кластера в диапазоне
+			const float radiusSquared = radius * radius;
+			for (uint32_t z = minSlice; z <= maxSlice; ++z)
+			{
+				for (uint32_t y = minTileY; y <= maxTileY; ++y)
+				{
+					for (uint32_t x = minTileX; x <= maxTileX; ++x)
+					{
+						const uint32_t cluster = clusterIndex(x, y, z);
+						const Aabb& box = clusterBounds[cluster];
+						const glm::vec3 closest = glm::clamp(center, box.min, box.max);
+						const glm::vec3 offset = closest - center;
+						if (glm::dot(offset, offset) <= radiusSquared)
+						{
+							assignments.push_back(LightAssignment{ cluster, lightIndex });
+						}
+					}
+				}
+			}
+		}
+
+		// Сортировка подсчётом по кластерам. Внутри кластера источники остаются в порядке их индексов.
+		clusterRanges.assign(CLUSTER_COUNT, glm::uvec2{ 0, 0 });
+		for (const auto& assignment : assignments)
+		{
+			++clusterRanges[assignment.cluster].y;
+		}
+		uint32_t offset = 0;
+		for (auto& range : clusterRanges)
+		{
+			range.x = offset;
+			offset += range.y;
+		}
+		lightIndices.resize(assignments.size());
+		std::vector<uint32_t>& cursor = scratchCursor;
+		cursor.resize(CLUSTER_COUNT);
+		for (uint32_t i = 0; i < CLUSTER_COUNT; ++i) cursor[i] = clusterRanges[i].x;
+		for (const auto& assignment : assignments)
+		{
+			lightIndices[cursor[assignment.cluster]++] = assignment.light;
+		}
+
+		buildTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "vget_bounds.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace vget
+{
+	// Точечный источник света в том виде, в котором он хранится в SSBO источников света
+	struct PointLight
+	{
+		glm::vec4 position{}; // w - радиус влияния, за пределами которого вклад источника отбрасывается
+		glm::vec4 color{};	  // w - интенсивность цвета
+	};
+
+	// Кластеры для forward освещения (clustered forward shading).
+	// Пирамида видимости камеры делится на GRID_X x GRID_Y экранных плиток и GRID_Z срезов по глубине,
+	// толщина которых растёт экспоненциально от ближней плоскости к дальней. Для каждого кластера строится список
+	// источников света, сфера влияния которых пересекает его объём, и шейдер фрагмента перебирает только источники
+	// своего кластера. Размеры сетки и формула среза продублированы в шейдерах simple_shader.frag и texture_shader.frag.
+	class VgetLightClusters
+	{
+	public:
+		static constexpr uint32_t GRID_X = 16;
+		static constexpr uint32_t GRID_Y = 9;
+		static constexpr uint32_t GRID_Z = 24;
+		static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+		// Построение списков для перспективной проекции камеры (ближняя и дальняя плоскости извлекаются из матрицы)
+		void build(const glm::mat4& view, const glm::mat4& projection, const std::vector<PointLight>& lights);
+
+		static uint32_t clusterIndex(uint32_t x, uint32_t y, uint32_t z) { return x + y * GRID_X + z * GRID_X * GRID_Y; }
+		// Кластер, в который попадает точка в пространстве камеры (так же, как это делает шейдер)
+		uint32_t findCluster(const glm::vec3& viewPosition) const;
+		// Ограничивающий объём кластера в пространстве камеры
+		const Aabb& getClusterBounds(uint32_t cluster) const { return clusterBounds[cluster]; }
+
+		// Для каждого кластера - (отступ в списке индексов, количество источников)
+		const std::vector<glm::uvec2>& getClusterRanges() const { return clusterRanges; }
+		const std::vector<uint32_t>& getLightIndices() const { return lightIndices; }
+		// Параметры среза для шейдера: slice = log(z) * x + y; z - ближняя, w - дальняя плоскость
+		glm::vec4 getDepthSliceParams() const { return glm::vec4{ sliceScale, sliceBias, nearPlane, farPlane }; }
+		double getBuildTimeMs() const { return buildTimeMs; }
+
+	private:
+		// Объёмы кластеров пересчитываются только при изменении проекции
+		void updateClusterBounds(const glm::mat4& projection);
+		uint32_t sliceForDepth(float viewDepth) const;
+
+		glm::mat4 boundsProjection{ 0.f };
+		std::vector<Aabb> clusterBounds;
+		float nearPlane = 0.f;
+		float farPlane = 0.f;
+		float sliceScale = 0.f;
+		float sliceBias = 0.f;
+
+		struct LightAssignment
+		{
+			uint32_t cluster;
+			uint32_t light;
+		};
+		std::vector<LightAssignment> assignments;	// переиспользуется между кадрами
+		std::vector<uint32_t> scratchCursor;
+		std::vector<glm::uvec2> clusterRanges;
+		std::vector<uint32_t> lightIndices;
+		double buildTimeMs = 0.0;
+	};
+}
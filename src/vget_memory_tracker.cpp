@@ -0,0 +1,244 @@
+#include "vget_memory_tracker.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace vget
+{
+	void VgetMemoryTracker::init(VkPhysicalDevice physicalDevice, PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		this->physicalDevice = physicalDevice;
+		this->getMemoryProperties2 = getMemoryProperties2;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		heaps.assign(memoryProperties.memoryHeapCount, Heap{});
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+		{
+			heaps[i].driverBudget = memoryProperties.memoryHeaps[i].size;
+		}
+	}
+
+	void VgetMemoryTracker::onAllocate(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, const MemoryTag& tag)
+	{
+		std::vector<MemoryBudgetEvent> events;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			assert(memoryTypeIndex < memoryProperties.memoryTypeCount && "Memory tracker is not initialized");
+			const uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+
+			Heap& heap = heaps[heapIndex];
+			heap.allocated += size;
+			++heap.allocationCount;
+			categoryBytes[static_cast<size_t>(tag.category)] += size;
+			++categoryAllocations[static_cast<size_t>(tag.category)];
+			allocations[memory] = Allocation{ size, heapIndex, tag.category, tag.owner };
+			checkBudget(events);
+		}
+		notify(events);
+	}
+
+	void VgetMemoryTracker::onFree(VkDeviceMemory memory)
+	{
+		if (memory == VK_NULL_HANDLE) return;
+
+		std::vector<MemoryBudgetEvent> events;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			auto it = allocations.find(memory);
+			if (it == allocations.end()) return;
+
+			const Allocation& allocation = it->second;
+			Heap& heap = heaps[allocation.heapIndex];
+			heap.allocated -= allocation.size;
+			--heap.allocationCount;
+			categoryBytes[static_cast<size_t>(allocation.category)] -= allocation.size;
+			--categoryAllocations[static_cast<size_t>(allocation.category)];
+			allocations.erase(it);
+			checkBudget(events);
+		}
+		notify(events);
+	}
+
+	void VgetMemoryTracker::updateBudget()
+	{
+		std::vector<MemoryBudgetEvent> events;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (getMemoryProperties2 != nullptr)
+			{
+				VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+				budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+				VkPhysicalDeviceMemoryProperties2 properties{};
+				properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+				properties.pNext = &budgetProperties;
+				getMemoryProperties2(physicalDevice, &properties);
+
+				for (size_t i = 0; i < heaps.size(); ++i)
+				{
+					heaps[i].driverUsage = budgetProperties.heapUsage[i];
+					heaps[i].driverBudget = budgetProperties.heapBudget[i];
+					heaps[i].allocatedAtQuery = heaps[i].allocated;
+				}
+			}
+			checkBudget(events);
+		}
+		notify(events);
+	}
+
+	void VgetMemoryTracker::setBudgetFraction(float fraction)
+	{
+		std::vector<MemoryBudgetEvent> events;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			budgetFraction = std::clamp(fraction, 0.01f, 1.0f);
+			checkBudget(events);
+		}
+		notify(events);
+	}
+
+	float VgetMemoryTracker::getBudgetFraction() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return budgetFraction;
+	}
+
+	void VgetMemoryTracker::setHeapLimit(uint32_t heapIndex, VkDeviceSize limit)
+	{
+		std::vector<MemoryBudgetEvent> events;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			if (heapIndex >= heaps.size()) return;
+			heaps[heapIndex].userLimit = limit;
+			checkBudget(events);
+		}
+		notify(events);
+	}
+
+	void VgetMemoryTracker::addOverBudgetCallback(OverBudgetCallback callback)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		callbacks.push_back(std::move(callback));
+	}
+
+	MemoryStats VgetMemoryTracker::getStats() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		MemoryStats stats{};
+		stats.budgetExtension = getMemoryProperties2 != nullptr;
+		stats.categoryBytes = categoryBytes;
+		stats.categoryAllocations = categoryAllocations;
+
+		stats.heaps.resize(heaps.size());
+		for (size_t i = 0; i < heaps.size(); ++i)
+		{
+			MemoryHeapStats& heapStats = stats.heaps[i];
+			heapStats.size = memoryProperties.memoryHeaps[i].size;
+			heapStats.flags = memoryProperties.memoryHeaps[i].flags;
+			heapStats.allocated = heaps[i].allocated;
+			heapStats.allocationCount = heaps[i].allocationCount;
+			heapStats.usage = getUsage(heaps[i]);
+			heapStats.budget = heaps[i].driverBudget;
+			heapStats.limit = getLimit(heaps[i]);
+			heapStats.overBudget = heaps[i].overBudget;
+		}
+
+		std::unordered_map<std::string, MemoryOwnerStats> owners;
+		for (const auto& [memory, allocation] : allocations)
+		{
+			MemoryOwnerStats& owner = owners[allocation.owner];
+			owner.bytes += allocation.size;
+			++owner.allocationCount;
+		}
+		stats.owners.reserve(owners.size());
+		for (auto& [name, owner] : owners)
+		{
+			owner.owner = name;
+			stats.owners.push_back(std::move(owner));
+		}
+		std::sort(stats.owners.begin(), stats.owners.end(),
+			[](const MemoryOwnerStats& a, const MemoryOwnerStats& b) { return a.bytes > b.bytes; });
+		return stats;
+	}
+
+	const char* VgetMemoryTracker::getCategoryName(MemoryCategory category)
+	{
+		static constexpr const char* NAMES[MEMORY_CATEGORY_COUNT] = {
+			"unknown",
+			"vertex",
+			"index",
+			"texture",
+			"uniform",
+			"storage",
+			"staging",
+			"attachment",
+		};
+		return NAMES[static_cast<size_t>(category)];
+	}
+
+	MemoryCategory VgetMemoryTracker::categoryFromBufferUsage(VkBufferUsageFlags usage)
+	{
+		if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) return MemoryCategory::Vertex;
+		if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) return MemoryCategory::Index;
+		if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) return MemoryCategory::Uniform;
+		if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) return MemoryCategory::Storage;
+		if (usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) return MemoryCategory::Staging;
+		return MemoryCategory::Unknown;
+	}
+
+	MemoryCategory VgetMemoryTracker::categoryFromImageUsage(VkImageUsageFlags usage)
+	{
+		if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) return MemoryCategory::Attachment;
+		if (usage & VK_IMAGE_USAGE_SAMPLED_BIT) return MemoryCategory::Texture;
+		return MemoryCategory::Unknown;
+	}
+
+	VkDeviceSize VgetMemoryTracker::getUsage(const Heap& heap) const
+	{
+		if (getMemoryProperties2 == nullptr) return heap.allocated;
+
+		// Между опросами драйвера к его значению добавляются выделения и освобождения самого движка
+		if (heap.allocated >= heap.allocatedAtQuery) return heap.driverUsage + (heap.allocated - heap.allocatedAtQuery);
+		const VkDeviceSize freed = heap.allocatedAtQuery - heap.allocated;
+		return heap.driverUsage > freed ? heap.driverUsage - freed : 0;
+	}
+
+	VkDeviceSize VgetMemoryTracker::getLimit(const Heap& heap) const
+	{
+		const VkDeviceSize limit = static_cast<VkDeviceSize>(static_cast<double>(heap.driverBudget) * budgetFraction);
+		return heap.userLimit != 0 ? std::min(limit, heap.userLimit) : limit;
+	}
+
+	void VgetMemoryTracker::checkBudget(std::vector<MemoryBudgetEvent>& events)
+	{
+		for (uint32_t i = 0; i < heaps.size(); ++i)
+		{
+			Heap& heap = heaps[i];
+			const VkDeviceSize usage = getUsage(heap);
+			const VkDeviceSize limit = getLimit(heap);
+			const bool overBudget = usage > limit;
+			if (overBudget && !heap.overBudget)
+			{
+				events.push_back(MemoryBudgetEvent{ i, usage, limit });
+			}
+			heap.overBudget = overBudget;
+		}
+	}
+
+	void VgetMemoryTracker::notify(const std::vector<MemoryBudgetEvent>& events)
+	{
+		if (events.empty()) return;
+
+		std::vector<OverBudgetCallback> listeners;
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			listeners = callbacks;
+		}
+		for (const MemoryBudgetEvent& event : events)
+		{
+			for (const OverBudgetCallback& callback : listeners) callback(event);
+		}
+	}
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vget
+{
+	// Назначение выделенной памяти девайса
+	enum class MemoryCategory : uint32_t
+	{
+		Unknown,	// выводится из флагов назначения буфера или изображения при выделении
+		Vertex,
+		Index,
+		Texture,
+		Uniform,
+		Storage,
+		Staging,
+		Attachment,	// буферы глубины цепи обмена и внеэкранные цели рендера
+		Count
+	};
+
+	constexpr size_t MEMORY_CATEGORY_COUNT = static_cast<size_t>(MemoryCategory::Count);
+
+	// Метка выделения: категория и ассет-владелец (путь модели или текстуры, пустой - без владельца)
+	struct MemoryTag
+	{
+		MemoryCategory category = MemoryCategory::Unknown;
+		std::string owner{};
+	};
+
+	struct MemoryHeapStats
+	{
+		VkDeviceSize size = 0;
+		VkMemoryHeapFlags flags = 0;
+		VkDeviceSize allocated = 0;		// выделено через VgetDevice
+		uint32_t allocationCount = 0;
+		VkDeviceSize usage = 0;			// по VK_EXT_memory_budget - всё использование процессом, иначе совпадает с allocated
+		VkDeviceSize budget = 0;		// бюджет драйвера, без расширения - размер кучи
+		VkDeviceSize limit = 0;			// порог, при пересечении которого вызываются обработчики
+		bool overBudget = false;
+	};
+
+	struct MemoryOwnerStats
+	{
+		std::string owner;
+		VkDeviceSize bytes = 0;
+		uint32_t allocationCount = 0;
+	};
+
+	struct MemoryStats
+	{
+		bool budgetExtension = false;	// бюджет и использование куч получены через VK_EXT_memory_budget
+		std::vector<MemoryHeapStats> heaps;
+		std::array<VkDeviceSize, MEMORY_CATEGORY_COUNT> categoryBytes{};
+		std::array<uint32_t, MEMORY_CATEGORY_COUNT> categoryAllocations{};
+		std::vector<MemoryOwnerStats> owners;	// по убыванию занятой памяти
+	};
+
+	// Пересечение порога кучи снизу вверх
+	struct MemoryBudgetEvent
+	{
+		uint32_t heapIndex = 0;
+		VkDeviceSize usage = 0;
+		VkDeviceSize limit = 0;
+	};
+
+	// Учёт памяти девайса по кучам, категориям и ассетам. Каждое выделение VgetDevice регистрирует здесь вместе с меткой.
+	// Использование кучи сверяется с порогом: доля бюджета драйвера (VK_EXT_memory_budget, если есть, иначе размер кучи)
+	// или заданный явно предел. Обработчики вызываются один раз при переходе через порог - из того потока, где выделили
+	// память или опросили бюджет, вне блокировки трекера, так что внутри обработчика можно освобождать ресурсы.
+	class VgetMemoryTracker
+	{
+	public:
+		using OverBudgetCallback = std::function<void(const MemoryBudgetEvent&)>;
+
+		// getMemoryProperties2 - vkGetPhysicalDeviceMemoryProperties2KHR, nullptr - расширение бюджета не включено
+		void init(VkPhysicalDevice physicalDevice, PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2);
+
+		void onAllocate(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, const MemoryTag& tag);
+		void onFree(VkDeviceMemory memory);
+
+		// Опрос бюджета и использования куч у драйвера (раз в кадр). Без расширения только перепроверяет пороги.
+		void updateBudget();
+
+		// Порог кучи - доля её бюджета, (0, 1]
+		void setBudgetFraction(float fraction);
+		float getBudgetFraction() const;
+		// Явный порог кучи в байтах, 0 - только доля бюджета
+		void setHeapLimit(uint32_t heapIndex, VkDeviceSize limit);
+		void addOverBudgetCallback(OverBudgetCallback callback);
+
+		MemoryStats getStats() const;
+
+		static const char* getCategoryName(MemoryCategory category);
+		static MemoryCategory categoryFromBufferUsage(VkBufferUsageFlags usage);
+		static MemoryCategory categoryFromImageUsage(VkImageUsageFlags usage);
+
+	private:
+		struct Allocation
+		{
+			VkDeviceSize size = 0;
+			uint32_t heapIndex = 0;
+			MemoryCategory category = MemoryCategory::Unknown;
+			std::string owner;
+		};
+
+		struct Heap
+		{
+			VkDeviceSize allocated = 0;
+			uint32_t allocationCount = 0;
+			VkDeviceSize driverUsage = 0;		// использование и бюджет на момент последнего опроса драйвера
+			VkDeviceSize driverBudget = 0;
+			VkDeviceSize allocatedAtQuery = 0;	// allocated на момент того же опроса
+			VkDeviceSize userLimit = 0;
+			bool overBudget = false;
+		};
+
+		VkDeviceSize getUsage(const Heap& heap) const;
+		VkDeviceSize getLimit(const Heap& heap) const;
+		// Вызывается под блокировкой, события пересечения порога добавляются в events
+		void checkBudget(std::vector<MemoryBudgetEvent>& events);
+		void notify(const std::vector<MemoryBudgetEvent>& events);
+
+		mutable std::mutex mutex;
+		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+		PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		std::vector<Heap> heaps;
+		std::unordered_map<VkDeviceMemory, Allocation> allocations;
+		std::array<VkDeviceSize, MEMORY_CATEGORY_COUNT> categoryBytes{};
+		std::array<uint32_t, MEMORY_CATEGORY_COUNT> categoryAllocations{};
+		float budgetFraction = 0.9f;
+		std::vector<OverBudgetCallback> callbacks;
+	};
+}
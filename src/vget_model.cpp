@@ -1,17 +1,11 @@
 #include "vget_model.hpp"
-#include "vget_utils.hpp"
-
-// libs
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include "vget_cpu_profiler.hpp"
 
 // std
+#include <atomic>
 #include <cassert>
 #include <cstring>
 #include <iostream>
-#include <unordered_map>
 
 #ifndef ENGINE_DIR
 #define ENGINE_DIR "../"
@@ -21,37 +15,56 @@
 #define MODELS_DIR "../models/"
 #endif
 
-namespace std
+namespace vget
 {
-	template<>
-	struct hash<vget::VgetModel::Vertex>
+	namespace
+	{
+		std::atomic<uint32_t> nextModelId{ 0 };
+	}
+
+	VgetModel::VgetModel(VgetDevice& device, const VgetModel::Builder& builder, VgetJobSystem* jobSystem)
+		: vgetDevice{device}, id{nextModelId++}, name{builder.name}, subObjectsInfo{builder.subObjectsInfo}, boundingBox{builder.boundingBox}, occluderMesh{builder.occluderMesh}
 	{
-		size_t operator()(vget::VgetModel::Vertex const& vertex) const
+		// Для моделей, собранных вручную без вызова Builder::computeBounds(), объём считается по всем вершинам
+		if (!boundingBox.isValid())
 		{
-			size_t seed = 0;
-			vget::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-			return seed;
+			for (const auto& vertex : builder.vertices)
+				boundingBox.expand(vertex.position);
+		}
+
+		// Без отдельного LOD окклюдер строится по позициям всех вершин модели
+		if (occluderMesh.empty())
+		{
+			occluderMesh.positions.reserve(builder.vertices.size());
+			for (const auto& vertex : builder.vertices)
+				occluderMesh.positions.push_back(vertex.position);
+
+			if (!builder.indices.empty())
+			{
+				occluderMesh.indices = builder.indices;
+			}
+			else
+			{
+				occluderMesh.indices.resize(builder.vertices.size() - builder.vertices.size() % 3);
+				for (uint32_t i = 0; i < occluderMesh.indices.size(); ++i)
+					occluderMesh.indices[i] = i;
+			}
 		}
-	};
-}
 
-namespace vget
-{
-	VgetModel::VgetModel(VgetDevice& device, const VgetModel::Builder& builder) : vgetDevice{device}, subObjectsInfo{builder.subObjectsInfo}
-	{
 		createVertexBuffers(builder.vertices);
 		createIndexBuffers(builder.indices);
-		createTextures(builder.texturePaths);
+		createTextures(builder.texturePaths, jobSystem);
 	}
 
 	VgetModel::~VgetModel(){}
 
-	std::unique_ptr<VgetModel> VgetModel::createModelFromFile(VgetDevice& device, const std::string& filepath)
+	std::unique_ptr<VgetModel> VgetModel::createModelFromFile(VgetDevice& device, const std::string& filepath, VgetJobSystem* jobSystem)
 	{
+		VGET_PROFILE_ZONE("VgetModel::createModelFromFile");
 		Builder builder{};
 		builder.loadModel(filepath);
 		std::cout << "Vertex count: " << builder.vertices.size() << "\n";
-		return std::make_unique<VgetModel>(device, builder);
+		return std::make_unique<VgetModel>(device, builder, jobSystem);
 	}
 
 	void VgetModel::createVertexBuffers(const std::vector<Vertex>& vertices)
@@ -72,7 +85,9 @@ namespace vget
 			// Это важно для получения возможности писать данные в память GPU.
 			// HOST_COHERENT флаг включает полное соответствие памяти хоста и девайса. Это даёт возможность легко
 			// передавать изменения из памяти CPU в память GPU.
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			MemoryTag{ MemoryCategory::Staging, name }
 		};
 
 		stagingBuffer.map();
@@ -86,7 +101,9 @@ namespace vget
 			// Буфер используется для входных данных вершин, а данные для него будут перенесены из другого источника (из промежуточного буфера)
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			// DEVICE_LOCAL флаг указывает на то, что данный буфер будет размещён в оптимальной и быстрой локальной памяти девайса
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			1,
+			MemoryTag{ MemoryCategory::Vertex, name }
 		);
 
 		// Функция, записывающая команду копирования в командный буфер,
@@ -109,7 +126,9 @@ namespace vget
 			indexSize,
 			indexCount,
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			MemoryTag{ MemoryCategory::Staging, name }
 		};
 
 		// Маппинг памяти из девайса и передача туда данных по аналогии со staging буфером из createVertexBuffers()
@@ -123,178 +142,80 @@ namespace vget
 			indexCount,
 			// Буфер используется для индексов, а данные для него будут перенесены из другого источника (из промежуточного буфера)
 			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			1,
+			MemoryTag{ MemoryCategory::Index, name }
 		);
 
 		vgetDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
 	}
 
 	// "../textures/viking_room.png"
-	void VgetModel::createTextures(const std::vector<std::string>& texturePaths)
+	void VgetModel::createTextures(const std::vector<std::string>& texturePaths, VgetJobSystem* jobSystem)
 	{
-		for (auto& path : texturePaths)
+		// Декодирование файлов - самая долгая часть загрузки текстур, и оно не трогает Vulkan, поэтому идёт параллельно.
+		// Изображения Vulkan создаются в вызывающем потоке: пул команд девайса не потокобезопасен.
+		std::vector<VgetTexture::ImageData> images(texturePaths.size());
+		const auto decode = [&](uint32_t begin, uint32_t end)
 		{
-			if (path != MODELS_DIR)
-				textures.push_back(std::make_unique<VgetTexture>(path, vgetDevice));
-			else
+			for (uint32_t i = begin; i < end; ++i)
 			{
-				// TEMPORARY(?): если дифузной текстуры не было у материала, то тогда текстура получит nullptr по данному индексу
-				textures.push_back(nullptr);
+				if (texturePaths[i] != MODELS_DIR) images[i] = VgetTexture::loadImage(texturePaths[i]);
 			}
-		}
-	}
-
-	void VgetModel::Builder::loadModel(const std::string& filepath)
-	{
-		tinyobj::attrib_t attrib;						// содержит данные позиций, цветов, нормалей и координат текстур
-		std::vector<tinyobj::shape_t> shapes;			// shapes хранит значения индексов для каждого из face элементов каждой составной фигуры
-		std::vector<tinyobj::material_t> materials;		// materials хранит данные о материалах
-		std::string warn, err;
-
-		// После успешного выполнения функции LoadObj() переданные локальные переменные заполнятся
-		// данными из предоставленного .obj файла
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str(), MODELS_DIR))
-		{
-			throw std::runtime_error(warn + err);
-		}
+		};
+		if (jobSystem != nullptr) jobSystem->parallelFor(0, static_cast<uint32_t>(texturePaths.size()), 1, decode);
+		else decode(0, static_cast<uint32_t>(texturePaths.size()));
 
-		// очистка текущей структуры Builder перед загрузкой новой модели
-		vertices.clear();
-		indices.clear();
-		texturePaths.clear();
-
-		// Данный способ считывания .obj объекта со множеством текстур в материале основан на данном топике:
-		// https://www.reddit.com/r/vulkan/comments/826w5d/what_needs_to_be_done_in_order_to_load_obj_model/
-		auto textureStart = 0; // first free slot in texture array
-		uint32_t indexCount = 0; // the number of indices to be drawn in one bundle
-		auto indexStart = static_cast<uint32_t>(indices.size()); // index offset for drawing
-		int materialId = 0;
-		//int currentMat = 0; // the current OBJ material being used in face loop
-		SubObjectInfo info{};
-
-	    for (const auto& mat : materials)
-		{
-			// loads a texture and adds it to the global array. also increments textureIndex.
-			// note: if you are loading multiple textures per material (i.e. diffuse + normal textures), 
-			// you'll need to track this better than just a single index variable. Also, this
-			// method here does not account for materials with no textures, it's work in progress.
-			//loadTexture(baseDir + mat.diffuse_texname, textureIndex);
-	    	texturePaths.push_back(MODELS_DIR + mat.diffuse_texname);
-	    }
-
-		// Мапа хранит уникальные вершины с их индексами. С её помощью составляется буфер индексов.
-		std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-
-		// Итерирование по каждой фигуре из obj файла (объект может состоять из нескольких фигур)
-		for (const auto &shape : shapes)
+		for (size_t i = 0; i < texturePaths.size(); ++i)
 		{
-			indexCount = 0;
-			indexStart = static_cast<uint32_t>(indices.size());
-
-			// Итерирование по всем индексам текущей фигуры
-			for (const auto &index : shape.mesh.indices)
+			const std::string& path = texturePaths[i];
+			if (path != MODELS_DIR)
 			{
-				Vertex vertex{};
-
-				if (index.vertex_index >= 0) // отрицательный индекс означает, что позиция не была предоставлена
-				{
-					// с помощью текущего индекса позиции извлекаем из атрибутов позицию вершины
-					vertex.position = {
-						attrib.vertices[3 * index.vertex_index + 0], // x
-						attrib.vertices[3 * index.vertex_index + 1], // y
-						attrib.vertices[3 * index.vertex_index + 2], // z
-					};
-
-					// по таким же индексам из атрибутов извелкается цвет вершины, если он был представлен в файле
-					vertex.color = {
-						attrib.colors[3 * index.vertex_index + 0], // r
-						attrib.colors[3 * index.vertex_index + 1], // g
-						attrib.colors[3 * index.vertex_index + 2], // b
-					};
-				}
-
-				// извлекаем из атрибутов позицию нормали
-				if (index.normal_index >= 0)
-				{
-					vertex.normal = {
-						attrib.normals[3 * index.normal_index + 0], // x
-						attrib.normals[3 * index.normal_index + 1], // y
-						attrib.normals[3 * index.normal_index + 2], // z
-					};
-				}
-
-				// извлекаем из атрибутов координаты текстуры
-				if (index.texcoord_index >= 0)
-				{
-					vertex.uv = {
-						attrib.texcoords[2 * index.texcoord_index + 0],		   // u
-						1.0f - attrib.texcoords[2 * index.texcoord_index + 1], // v (координата по Y переворачивается для коорд. системы вулкана)
-					};
-				}
-
-				// Если считанная вершина не найдена в мапе, то она добавляется в неё и получает
-				// свой индекс, а затем добавляется в вектор builder'а
-				if (uniqueVertices.count(vertex) == 0)
-				{
-					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertex);
-				}
-				indices.push_back(uniqueVertices[vertex]); // Буфер индексов добавляет индекс считанной вершины
-
-				++indexCount;
+				textures.push_back(std::make_unique<VgetTexture>(images[i], vgetDevice, path));
+				images[i] = {}; // пиксели больше не нужны после копирования в промежуточный буфер
 			}
-
-			// Условие на наличие материала, позволяет поддерживать .obj модели без текстур и подобъектов
-			if (materials.size() != 0) {
-				// Индекс текстуры для данной фигуры берётся по индексу её материала
-				materialId = shape.mesh.material_ids.at(0);
-
-				// Данной фигуре .obj модели присваивается её начало, кол-во индексов, индекс текстуры из списка текстур и диффузный цвет
-				info = {
-					indexCount,
-					indexStart,
-					materialId, // исп. как textureIndex в структуре подобъекта
-					glm::vec3(materials.at(materialId).diffuse[0],materials.at(materialId).diffuse[1],materials.at(materialId).diffuse[2])
-				};
+			else
+			{
+				// TEMPORARY(?): если дифузной текстуры не было у материала, то тогда текстура получит nullptr по данному индексу
+				textures.push_back(nullptr);
 			}
-			subObjectsInfo.push_back(info);
 		}
 	}
 
-	void VgetModel::draw(VkCommandBuffer commandBuffer)
+	void VgetModel::draw(VgetCommandRecorder& recorder)
 	{
 		if (hasIndexBuffer)
 		{
 			// Запись команды на отрисовку с применением буфера индексов
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+			recorder.drawIndexed(indexCount, 1, 0, 0, 0);
 		}
 		else
 		{
 			// Запись команды на отрисовку. (vertexCount вершин, 1 экземпляр, без смещений)
-			vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+			recorder.draw(vertexCount, 1, 0, 0);
 		}
 	}
 
-	void VgetModel::drawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t indexStart)
+	void VgetModel::drawIndexed(VgetCommandRecorder& recorder, uint32_t indexCount, uint32_t indexStart)
 	{
-		vkCmdDrawIndexed(commandBuffer, indexCount, 1, indexStart, 0, 0);
+		recorder.drawIndexed(indexCount, 1, indexStart, 0, 0);
 	}
 
-	void VgetModel::bind(VkCommandBuffer commandBuffer)
+	void VgetModel::bind(VgetCommandRecorder& recorder)
 	{
 		VkBuffer buffers[] = { vertexBuffer->getBuffer() };
 		VkDeviceSize offsets[] = { 0 };
 
 		// Запись команды в буфер команд о создании привязки буфера вершин к пайплайну.
 		// После выполнения данная команда создаст Binding[0] для одного буфера вершин из buffers с отступом offsets внутри этого буфера.
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		recorder.bindVertexBuffers(0, 1, buffers, offsets);
 
 		if (hasIndexBuffer)
 		{
 			// Команда создания привязки буфера индексов (если он есть) к пайплайну.
 			// Тип индекса должен совпадать с типом данных в самом буфере и может выбираться
 			// поменьше для экономии памяти при использовании простых моделей объектов.
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			recorder.bindIndexBuffer(indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
 		}
 	}
 
@@ -3,6 +3,10 @@
 #include "vget_device.hpp"
 #include "vget_buffer.hpp"
 #include "vget_texture.hpp"
+#include "vget_bounds.hpp"
+#include "vget_occlusion.hpp"
+#include "vget_command_recorder.hpp"
+#include "vget_job_system.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS			  // Функции GLM будут работать с радианами, а не градусами
@@ -11,6 +15,7 @@
 
 // std
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace vget
@@ -45,17 +50,38 @@ namespace vget
 				uint32_t indexStart;
 				int textureIndex;
 				glm::vec3 diffuseColor;
+				Aabb bounds{};		// ограничивающий объём подобъекта в пространстве модели
 			};
 
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
 			std::vector<std::string> texturePaths{};
 			std::vector<SubObjectInfo> subObjectsInfo{};
+			Aabb boundingBox{};		// ограничивающий объём всей модели в пространстве модели
+			// Упрощённая геометрия (LOD) для программной растеризации окклюдеров.
+			// Если не задана, то окклюдером будет служить полная геометрия модели.
+			OccluderMesh occluderMesh{};
+			std::string name{};		// файл модели, владелец её буферов в учёте памяти (VgetMemoryTracker)
 
+			// Разобранный .obj файл (данные tinyobjloader), определён в vget_model_builder.cpp
+			struct ObjFile;
+
+			// Полная загрузка: parseObj, weldVertices, optimizeIndices и computeBounds
 			void loadModel(const std::string& filepath);
+
+			// Этапы loadModel по отдельности. Они не обращаются к Vulkan и замеряются asset_pipeline_benchmark.
+			static std::shared_ptr<const ObjFile> parseObj(const std::string& filepath);
+			// Слияние одинаковых вершин в буферы вершин и индексов, заполнение подобъектов и путей текстур
+			void weldVertices(const ObjFile& obj);
+			// Порядок треугольников каждого подобъекта под кэш вершин GPU (алгоритм Tipsify),
+			// затем порядок вершин - по первому обращению из буфера индексов
+			void optimizeIndices();
+			// Расчёт AABB всей модели и каждого её подобъекта по текущим вершинам и индексам
+			void computeBounds();
 		};
 
-		VgetModel(VgetDevice& device, const VgetModel::Builder& builder);
+		// С планировщиком задач файлы текстур модели декодируются параллельно
+		VgetModel(VgetDevice& device, const VgetModel::Builder& builder, VgetJobSystem* jobSystem = nullptr);
 		~VgetModel();
 
 		// Избавляемся от copy operator и copy constrcutor, т.к. VgetModel хранит
@@ -63,22 +89,31 @@ namespace vget
 		VgetModel(const VgetModel&) = delete;
 		VgetModel& operator=(const VgetModel&) = delete;
 
-		static std::unique_ptr<VgetModel> createModelFromFile(VgetDevice& device, const std::string& filepath);
+		static std::unique_ptr<VgetModel> createModelFromFile(VgetDevice& device, const std::string& filepath, VgetJobSystem* jobSystem = nullptr);
 
-		void bind(VkCommandBuffer commandBuffer);
+		// Повторная привязка уже привязанной модели отбрасывается рекордером
+		void bind(VgetCommandRecorder& recorder);
 		// todo подумать как можно объединить draw и drawIndexed
-		void draw(VkCommandBuffer commandBuffer);
-		void drawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t indexStart = 0);
+		void draw(VgetCommandRecorder& recorder);
+		void drawIndexed(VgetCommandRecorder& recorder, uint32_t indexCount, uint32_t indexStart = 0);
 
 		std::vector<Builder::SubObjectInfo>& getSubObjectsInfo() {return subObjectsInfo;}
 		std::vector<std::unique_ptr<VgetTexture>>& getTextures() {return textures;}
+		const Aabb& getBoundingBox() const {return boundingBox;}
+		const OccluderMesh& getOccluderMesh() const {return occluderMesh;}
+		void setOccluderMesh(OccluderMesh mesh) {occluderMesh = std::move(mesh);}
+		// Уникальный номер модели, используется в ключах сортировки отрисовок
+		uint32_t getId() const {return id;}
+		const std::string& getName() const {return name;}
 
 	private:
 		void createVertexBuffers(const std::vector<Vertex>& vertices);
 		void createIndexBuffers(const std::vector<uint32_t>& indices);
-		void createTextures(const std::vector<std::string>& texturePaths);
+		void createTextures(const std::vector<std::string>& texturePaths, VgetJobSystem* jobSystem);
 
 		VgetDevice& vgetDevice;
+		uint32_t id;
+		std::string name;
 
 		std::unique_ptr<VgetBuffer> vertexBuffer;
 		uint32_t vertexCount;
@@ -89,5 +124,7 @@ namespace vget
 
 		std::vector<Builder::SubObjectInfo> subObjectsInfo;
 		std::vector<std::unique_ptr<VgetTexture>> textures;
+		Aabb boundingBox{};
+		OccluderMesh occluderMesh{};	// копия геометрии на стороне CPU для VgetOcclusionCuller
 	};
 }
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "vget_model.hpp"
+#include "vget_cpu_profiler.hpp"
+#include "vget_utils.hpp"
+
+// libs
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+// std
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifndef MODELS_DIR
+#define MODELS_DIR "../models/"
+#endif
+
+namespace std
+{
+	template<>
+	struct hash<vget::VgetModel::Vertex>
+	{
+		size_t operator()(vget::VgetModel::Vertex const& vertex) const
+		{
+			size_t seed = 0;
+			vget::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+			return seed;
+		}
+	};
+}
+
+namespace vget
+{
+	// Построитель модели работает только с памятью CPU, поэтому вынесен из vget_model.cpp:
+	// бенчмарк загрузки ассетов собирается с этим файлом без Vulkan.
+	struct VgetModel::Builder::ObjFile
+	{
+		tinyobj::attrib_t attrib;						// содержит данные позиций, цветов, нормалей и координат текстур
+		std::vector<tinyobj::shape_t> shapes;			// shapes хранит значения индексов для каждого из face элементов каждой составной фигуры
+		std::vector<tinyobj::material_t> materials;		// materials хранит данные о материалах
+	};
+
+	namespace
+	{
+		// Размер кэша вершин после вершинного шейдера, под который упорядочиваются треугольники.
+		// Меньше, чем у современных GPU, чтобы порядок не портился на более простых.
+		constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+		// Общие для всех подобъектов массивы Tipsify размером с буфер вершин. Между подобъектами
+		// обнуляются только затронутые элементы, поэтому модель из тысяч подобъектов обрабатывается за линейное время.
+		struct TipsifyState
+		{
+			explicit TipsifyState(size_t vertexCount)
+				: liveTriangles(vertexCount, 0), cacheTime(vertexCount, 0), adjacencyStart(vertexCount, 0), adjacencyFill(vertexCount, 0) {}
+
+			std::vector<uint32_t> liveTriangles;	// ещё не выведенные треугольники вершины
+			std::vector<uint32_t> cacheTime;		// "время" попадания вершины в кэш
+			std::vector<uint32_t> adjacencyStart;	// начало списка треугольников вершины в adjacency
+			std::vector<uint32_t> adjacencyFill;
+			std::vector<uint32_t> adjacency;		// треугольники подобъекта, сгруппированные по вершинам
+			std::vector<uint32_t> rangeVertices;	// уникальные вершины подобъекта
+			std::vector<uint32_t> deadEnd;			// стек недавно выведенных вершин
+			std::vector<uint32_t> candidates;
+			std::vector<bool> emitted;
+			uint32_t time = VERTEX_CACHE_SIZE + 1;
+		};
+
+		// Tipsify (Sander, Nehab, Barczak. Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, 2007):
+		// веер треугольников вокруг текущей вершины, следующая вершина - та, что ещё останется в кэше.
+		// indices указывает на диапазон подобъекта, результат записывается на его же место.
+		void tipsify(uint32_t* indices, uint32_t indexCount, TipsifyState& state)
+		{
+			const uint32_t triangleCount = indexCount / 3;
+			auto& live = state.liveTriangles;
+			auto& cacheTime = state.cacheTime;
+
+			state.rangeVertices.clear();
+			for (uint32_t i = 0; i < indexCount; ++i)
+			{
+				if (live[indices[i]]++ == 0) state.rangeVertices.push_back(indices[i]);
+			}
+			uint32_t offset = 0;
+			for (uint32_t vertex : state.rangeVertices)
+			{
+				state.adjacencyStart[vertex] = state.adjacencyFill[vertex] = offset;
+				offset += live[vertex];
+			}
+			state.adjacency.resize(indexCount);
+			for (uint32_t i = 0; i < indexCount; ++i)
+			{
+				state.adjacency[state.adjacencyFill[indices[i]]++] = i / 3;
+			}
+
+			std::vector<uint32_t> result;
+			result.reserve(indexCount);
+			state.emitted.assign(triangleCount, false);
+			state.deadEnd.clear();
+			// Кэш предыдущего подобъекта считается вытесненным
+			state.time += VERTEX_CACHE_SIZE + 1;
+			uint32_t cursor = 0;		// позиция перебора вершин, когда окрестность и стек исчерпаны
+			int64_t fanning = indexCount > 0 ? indices[0] : -1;
+
+			while (fanning >= 0)
+			{
+				const uint32_t vertex = static_cast<uint32_t>(fanning);
+				state.candidates.clear();
+				for (uint32_t a = state.adjacencyStart[vertex]; a < state.adjacencyFill[vertex]; ++a)
+				{
+					const uint32_t triangle = state.adjacency[a];
+					if (state.emitted[triangle]) continue;
+					for (uint32_t corner = 0; corner < 3; ++corner)
+					{
+						const uint32_t v = indices[triangle * 3 + corner];
+						result.push_back(v);
+						state.deadEnd.push_back(v);
+						state.candidates.push_back(v);
+						--live[v];
+						if (state.time - cacheTime[v] > VERTEX_CACHE_SIZE) cacheTime[v] = state.time++;
+					}
+					state.emitted[triangle] = true;
+				}
+
+				// Лучший кандидат - вершина, которая останется в кэше после вывода всех её треугольников
+				fanning = -1;
+				int64_t bestPriority = -1;
+				for (uint32_t v : state.candidates)
+				{
+					if (live[v] == 0) continue;
+					int64_t priority = 0;
+					if (state.time - cacheTime[v] + 2 * live[v] <= VERTEX_CACHE_SIZE) priority = state.time - cacheTime[v];
+					if (priority > bestPriority)
+					{
+						bestPriority = priority;
+						fanning = v;
+					}
+				}
+				if (fanning >= 0) continue;
+
+				// Тупик: сначала недавно выведенные вершины, затем любые оставшиеся по порядку
+				while (!state.deadEnd.empty() && fanning < 0)
+				{
+					const uint32_t v = state.deadEnd.back();
+					state.deadEnd.pop_back();
+					if (live[v] > 0) fanning = v;
+				}
+				while (cursor < indexCount && fanning < 0)
+				{
+					const uint32_t v = indices[cursor++];
+					if (live[v] > 0) fanning = v;
+				}
+			}
+
+			std::copy(result.begin(), result.end(), indices);
+		}
+	}
+
+	void VgetModel::Builder::loadModel(const std::string& filepath)
+	{
+		VGET_PROFILE_ZONE("VgetModel::Builder::loadModel");
+		name = filepath;
+		weldVertices(*parseObj(filepath));
+		optimizeIndices();
+		computeBounds();
+	}
+
+	std::shared_ptr<const VgetModel::Builder::ObjFile> VgetModel::Builder::parseObj(const std::string& filepath)
+	{
+		VGET_PROFILE_ZONE("VgetModel::Builder::parseObj");
+		auto obj = std::make_shared<ObjFile>();
+		std::string warn, err;
+
+		// После успешного выполнения функции LoadObj() переданные переменные заполнятся
+		// данными из предоставленного .obj файла
+		if (!tinyobj::LoadObj(&obj->attrib, &obj->shapes, &obj->materials, &warn, &err, filepath.c_str(), MODELS_DIR))
+		{
+			throw std::runtime_error(warn + err);
+		}
+		return obj;
+	}
+
+	void VgetModel::Builder::weldVertices(const ObjFile& obj)
+	{
+		VGET_PROFILE_ZONE("VgetModel::Builder::weldVertices");
+		const tinyobj::attrib_t& attrib = obj.attrib;
+		const std::vector<tinyobj::material_t>& materials = obj.materials;
+
+		// очистка текущей структуры Builder перед загрузкой новой модели
+		vertices.clear();
+		indices.clear();
+		texturePaths.clear();
+		subObjectsInfo.clear();
+
+		// Данный способ считывания .obj объекта со множеством текстур в материале основан на данном топике:
+		// https://www.reddit.com/r/vulkan/comments/826w5d/what_needs_to_be_done_in_order_to_load_obj_model/
+		uint32_t indexCount = 0; // the number of indices to be drawn in one bundle
+		auto indexStart = static_cast<uint32_t>(indices.size()); // index offset for drawing
+		int materialId = 0;
+		SubObjectInfo info{};
+
+	    for (const auto& mat : materials)
+		{
+			// loads a texture and adds it to the global array. also increments textureIndex.
+			// note: if you are loading multiple textures per material (i.e. diffuse + normal textures),
+			// you'll need to track this better than just a single index variable. Also, this
+			// method here does not account for materials with no textures, it's work in progress.
+	    	texturePaths.push_back(MODELS_DIR + mat.diffuse_texname);
+	    }
+
+		// Мапа хранит уникальные вершины с их индексами. С её помощью составляется буфер индексов.
+		size_t cornerCount = 0;
+		for (const auto& shape : obj.shapes) cornerCount += shape.mesh.indices.size();
+		std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+		uniqueVertices.reserve(cornerCount);
+		indices.reserve(cornerCount);
+
+		// Итерирование по каждой фигуре из obj файла (объект может состоять из нескольких фигур)
+		for (const auto &shape : obj.shapes)
+		{
+			indexCount = 0;
+			indexStart = static_cast<uint32_t>(indices.size());
+
+			// Итерирование по всем индексам текущей фигуры
+			for (const auto &index : shape.mesh.indices)
+			{
+				Vertex vertex{};
+
+				if (index.vertex_index >= 0) // отрицательный индекс означает, что позиция не была предоставлена
+				{
+					// с помощью текущего индекса позиции извлекаем из атрибутов позицию вершины
+					vertex.position = {
+						attrib.vertices[3 * index.vertex_index + 0], // x
+						attrib.vertices[3 * index.vertex_index + 1], // y
+						attrib.vertices[3 * index.vertex_index + 2], // z
+					};
+
+					// по таким же индексам из атрибутов извелкается цвет вершины, если он был представлен в файле
+					vertex.color = {
+						attrib.colors[3 * index.vertex_index + 0], // r
+						attrib.colors[3 * index.vertex_index + 1], // g
+						attrib.colors[3 * index.vertex_index + 2], // b
+					};
+				}
+
+				// извлекаем из атрибутов позицию нормали
+				if (index.normal_index >= 0)
+				{
+					vertex.normal = {
+						attrib.normals[3 * index.normal_index + 0], // x
+						attrib.normals[3 * index.normal_index + 1], // y
+						attrib.normals[3 * index.normal_index + 2], // z
+					};
+				}
+
+				// извлекаем из атрибутов координаты текстуры
+				if (index.texcoord_index >= 0)
+				{
+					vertex.uv = {
+						attrib.texcoords[2 * index.texcoord_index + 0],		   // u
+						1.0f - attrib.texcoords[2 * index.texcoord_index + 1], // v (координата по Y переворачивается для коорд. системы вулкана)
+					};
+				}
+
+				// Если считанная вершина не найдена в мапе, то она добавляется в неё и получает
+				// свой индекс, а затем добавляется в вектор builder'а. Поиск в мапе - один на вершину.
+				const auto [it, inserted] = uniqueVertices.try_emplace(vertex, static_cast<uint32_t>(vertices.size()));
+				if (inserted) vertices.push_back(vertex);
+				indices.push_back(it->second); // Буфер индексов добавляет индекс считанной вершины
+
+				++indexCount;
+			}
+
+			// Условие на наличие материала, позволяет поддерживать .obj модели без текстур и подобъектов
+			if (materials.size() != 0) {
+				// Индекс текстуры для данной фигуры берётся по индексу её материала
+				materialId = shape.mesh.material_ids.at(0);
+
+				// Данной фигуре .obj модели присваивается её начало, кол-во индексов, индекс текстуры из списка текстур и диффузный цвет
+				info = {
+					indexCount,
+					indexStart,
+					materialId, // исп. как textureIndex в структуре подобъекта
+					glm::vec3(materials.at(materialId).diffuse[0],materials.at(materialId).diffuse[1],materials.at(materialId).diffuse[2])
+				};
+			}
+			subObjectsInfo.push_back(info);
+		}
+	}
+
+	void VgetModel::Builder::optimizeIndices()
+	{
+		VGET_PROFILE_ZONE("VgetModel::Builder::optimizeIndices");
+		if (indices.empty()) return;
+
+		// Треугольники не переходят между подобъектами: их диапазоны рисуются отдельными вызовами.
+		// У модели без материалов подобъекты пустые, и весь буфер индексов - один диапазон.
+		std::vector<std::pair<uint32_t, uint32_t>> ranges;
+		for (const auto& info : subObjectsInfo)
+		{
+			if (info.indexCount > 0) ranges.emplace_back(info.indexStart, info.indexCount);
+		}
+		if (ranges.empty()) ranges.emplace_back(0, static_cast<uint32_t>(indices.size()));
+
+		TipsifyState state{ vertices.size() };
+		for (const auto& [start, count] : ranges)
+		{
+			if (count % 3 != 0 || start + count > indices.size()) continue;
+			tipsify(indices.data() + start, count, state);
+		}
+
+		// Вершины в порядке первого обращения: выборка вершин идёт по памяти последовательно.
+		// Вершины без обращений остаются в конце буфера.
+		constexpr uint32_t UNASSIGNED = ~0u;
+		std::vector<uint32_t> remap(vertices.size(), UNASSIGNED);
+		std::vector<Vertex> ordered;
+		ordered.reserve(vertices.size());
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == UNASSIGNED)
+			{
+				remap[index] = static_cast<uint32_t>(ordered.size());
+				ordered.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+		for (uint32_t i = 0; i < vertices.size(); ++i)
+		{
+			if (remap[i] == UNASSIGNED) ordered.push_back(vertices[i]);
+		}
+		vertices = std::move(ordered);
+	}
+
+	void VgetModel::Builder::computeBounds()
+	{
+		boundingBox = Aabb{};
+		for (const auto& vertex : vertices)
+		{
+			boundingBox.expand(vertex.position);
+		}
+
+		// Объём подобъекта строится только по тем вершинам, на которые ссылается его диапазон индексов
+		for (auto& info : subObjectsInfo)
+		{
+			info.bounds = Aabb{};
+			const uint32_t indexEnd = std::min<uint32_t>(info.indexStart + info.indexCount, static_cast<uint32_t>(indices.size()));
+			for (uint32_t i = info.indexStart; i < indexEnd; ++i)
+			{
+				info.bounds.expand(vertices[indices[i]].position);
+			}
+		}
+	}
+}
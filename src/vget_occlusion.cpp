@@ -0,0 +1,361 @@
+#include "vget_occlusion.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// SIMD intrinsics
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VGET_OCCLUSION_SSE
+#endif
+
+namespace vget
+{
+	namespace
+	{
+		constexpr float MIN_CLIP_W = 1e-5f;
+		constexpr float MIN_TRIANGLE_AREA = 1e-8f;
+		constexpr size_t MIN_ITEMS_PER_THREAD = 256;	// меньшие диапазоны не стоят передачи другому потоку
+
+		// Сужение диапазона пикселей строки [minX, maxX] до участка, где все три функции рёбер неотрицательны.
+		// Границы берутся с запасом в пиксель, точная проверка покрытия всё равно выполняется при растеризации.
+		bool rowSpan(const float edgeA[3], const float edgeB[3], const float edgeC[3], float py, int& minX, int& maxX)
+		{
+			float spanMin = static_cast<float>(minX);
+			float spanMax = static_cast<float>(maxX);
+			for (int e = 0; e < 3; ++e)
+			{
+				const float rowValue = edgeB[e] * py + edgeC[e];
+				if (edgeA[e] > 0.f) spanMin = std::max(spanMin, std::floor(-rowValue / edgeA[e] - .5f) - 1.f);
+				else if (edgeA[e] < 0.f) spanMax = std::min(spanMax, std::ceil(-rowValue / edgeA[e] - .5f) + 1.f);
+				else if (rowValue < 0.f) return false;
+			}
+			if (spanMin > spanMax) return false;
+			minX = static_cast<int>(spanMin);
+			maxX = static_cast<int>(spanMax);
+			return true;
+		}
+	}
+
+	VgetOcclusionCuller::VgetOcclusionCuller(VgetJobSystem* jobSystem) : jobSystem{ jobSystem }
+	{
+		// Размеры уровней пирамиды глубины: каждый следующий вдвое меньше (с округлением вверх) до 1x1
+		glm::ivec2 size{ WIDTH, HEIGHT };
+		while (true)
+		{
+			pyramidSizes.push_back(size);
+			depthPyramid.emplace_back(static_cast<size_t>(size.x) * size.y, 1.f);
+			if (size.x == 1 && size.y == 1) break;
+			size = glm::ivec2{ (size.x + 1) / 2, (size.y + 1) / 2 };
+		}
+	}
+
+	void VgetOcclusionCuller::parallelFor(size_t count, const std::function<void(size_t, size_t)>& func) const
+	{
+		if (jobSystem == nullptr || count <= MIN_ITEMS_PER_THREAD)
+		{
+			func(0, count);
+			return;
+		}
+
+		// Не больше одного диапазона на поток: результаты диапазонов не зависят от разбиения
+		const size_t grainSize = std::max(MIN_ITEMS_PER_THREAD, (count + jobSystem->getWorkerCount() - 1) / jobSystem->getWorkerCount());
+		jobSystem->parallelFor(0, static_cast<uint32_t>(count), static_cast<uint32_t>(grainSize), [&](uint32_t begin, uint32_t end)
+		{
+			func(begin, end);
+		});
+	}
+
+	void VgetOcclusionCuller::beginFrame(const glm::mat4& viewProjection)
+	{
+		this->viewProjection = viewProjection;
+		occluders.clear();
+		screenVertices.clear();
+		triangles.clear();
+		rasterized = false;
+	}
+
+	void VgetOcclusionCuller::addOccluder(const OccluderMesh& mesh, const glm::mat4& modelMatrix)
+	{
+		if (mesh.empty()) return;
+
+		OccluderInstance instance{};
+		instance.mesh = &mesh;
+		instance.modelViewProjection = viewProjection * modelMatrix;
+		instance.firstVertex = static_cast<uint32_t>(screenVertices.size());
+		instance.firstTriangle = static_cast<uint32_t>(triangles.size());
+		occluders.push_back(instance);
+
+		screenVertices.resize(screenVertices.size() + mesh.positions.size());
+		triangles.resize(triangles.size() + mesh.triangleCount());
+	}
+
+	void VgetOcclusionCuller::rasterize()
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+
+		std::fill(depthPyramid[0].begin(), depthPyramid[0].end(), 1.f);
+
+		// Три независимых этапа, каждый из которых пишет только в свой диапазон данных, поэтому результат детерминирован:
+		// перевод вершин в экранное пространство, подготовка треугольников и растеризация горизонтальных полос экрана
+		parallelFor(screenVertices.size(), [this](size_t begin, size_t end) { transformVertices(begin, end); });
+		parallelFor(triangles.size(), [this](size_t begin, size_t end) { setupTriangles(begin, end); });
+		parallelFor(HEIGHT, [this](size_t begin, size_t end) { rasterizeBand(static_cast<int>(begin), static_cast<int>(end) - 1); });
+		buildDepthPyramid();
+
+		rasterized = true;
+		rasterTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	}
+
+	void VgetOcclusionCuller::transformVertices(size_t begin, size_t end)
+	{
+		// Поиск окклюдера, которому принадлежит первая вершина диапазона
+		size_t occluderIndex = std::upper_bound(occluders.begin(), occluders.end(), begin,
+			[](size_t vertex, const OccluderInstance& occluder) { return vertex < occluder.firstVertex; }) - occluders.begin() - 1;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			while (occluderIndex + 1 < occluders.size() && i >= occluders[occluderIndex + 1].firstVertex) ++occluderIndex;
+			const OccluderInstance& occluder = occluders[occluderIndex];
+
+			const glm::vec3& position = occluder.mesh->positions[i - occluder.firstVertex];
+			const glm::vec4 clip = occluder.modelViewProjection * glm::vec4(position, 1.f);
+
+			// Вершины за ближней плоскостью помечаются w = 0, и их треугольники в растеризацию не попадают
+			if (clip.w < MIN_CLIP_W || clip.z < 0.f)
+			{
+				screenVertices[i] = glm::vec4{ 0.f };
+				continue;
+			}
+			const float inverseW = 1.f / clip.w;
+			screenVertices[i] = glm::vec4{
+				(clip.x * inverseW * .5f + .5f) * WIDTH,
+				(clip.y * inverseW * .5f + .5f) * HEIGHT,
+				clip.z * inverseW,
+				1.f };
+		}
+	}
+
+	void VgetOcclusionCuller::setupTriangles(size_t begin, size_t end)
+	{
+		size_t occluderIndex = std::upper_bound(occluders.begin(), occluders.end(), begin,
+			[](size_t triangle, const OccluderInstance& occluder) { return triangle < occluder.firstTriangle; }) - occluders.begin() - 1;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			while (occluderIndex + 1 < occluders.size() && i >= occluders[occluderIndex + 1].firstTriangle) ++occluderIndex;
+			const OccluderInstance& occluder = occluders[occluderIndex];
+			const auto& indices = occluder.mesh->indices;
+			const size_t firstIndex = (i - occluder.firstTriangle) * 3;
+
+			Triangle& triangle = triangles[i];
+			triangle.minX = 1;
+			triangle.maxX = 0;
+
+			glm::vec4 v0 = screenVertices[occluder.firstVertex + indices[firstIndex + 0]];
+			glm::vec4 v1 = screenVertices[occluder.firstVertex + indices[firstIndex + 1]];
+			glm::vec4 v2 = screenVertices[occluder.firstVertex + indices[firstIndex + 2]];
+			if (v0.w == 0.f || v1.w == 0.f || v2.w == 0.f) continue;
+
+			// Окклюдеры двусторонние: треугольники с обратным обходом разворачиваются, чтобы площадь была положительной
+			float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+			if (std::abs(area) < MIN_TRIANGLE_AREA) continue;
+			if (area < 0.f)
+			{
+				std::swap(v1, v2);
+				area = -area;
+			}
+
+			triangle.minX = std::max(0, static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x }))));
+			triangle.maxX = std::min(WIDTH - 1, static_cast<int>(std::ceil(std::max({ v0.x, v1.x, v2.x }))) - 1);
+			triangle.minY = std::max(0, static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))));
+			triangle.maxY = std::min(HEIGHT - 1, static_cast<int>(std::ceil(std::max({ v0.y, v1.y, v2.y }))) - 1);
+			if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+			{
+				triangle.minX = 1;
+				triangle.maxX = 0;
+				continue;
+			}
+
+			// Покрытие определяется по центру пикселя (E >= 0), поэтому смежные треугольники стыкуются без щелей
+			const glm::vec4* vertices[3] = { &v0, &v1, &v2 };
+			for (int e = 0; e < 3; ++e)
+			{
+				const glm::vec4& a = *vertices[e];
+				const glm::vec4& b = *vertices[(e + 1) % 3];
+				triangle.edgeA[e] = a.y - b.y;
+				triangle.edgeB[e] = b.x - a.x;
+				triangle.edgeC[e] = a.x * b.y - a.y * b.x;
+			}
+
+			// Плоскость глубины z(x, y) = depthA * x + depthB * y + depthC, сдвинутая к самой дальней точке пикселя
+			const float inverseArea = 1.f / area;
+			triangle.depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) * inverseArea;
+			triangle.depthB = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) * inverseArea;
+			triangle.depthC = v0.z - triangle.depthA * v0.x - triangle.depthB * v0.y
+				+ .5f * (std::abs(triangle.depthA) + std::abs(triangle.depthB));
+			triangle.maxDepth = std::max({ v0.z, v1.z, v2.z });
+		}
+	}
+
+	void VgetOcclusionCuller::rasterizeBand(int bandMinY, int bandMaxY)
+	{
+		float* depth = depthPyramid[0].data();
+
+		for (const Triangle& triangle : triangles)
+		{
+			if (triangle.minX > triangle.maxX) continue;
+			const int minY = std::max(triangle.minY, bandMinY);
+			const int maxY = std::min(triangle.maxY, bandMaxY);
+			if (minY > maxY) continue;
+
+#if defined(VGET_OCCLUSION_SSE)
+			const __m128 laneOffsets = _mm_setr_ps(.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 maxDepth = _mm_set1_ps(triangle.maxDepth);
+			__m128 edgeA[3], edgeB[3], edgeC[3];
+			for (int e = 0; e < 3; ++e)
+			{
+				edgeA[e] = _mm_set1_ps(triangle.edgeA[e]);
+				edgeB[e] = _mm_set1_ps(triangle.edgeB[e]);
+				edgeC[e] = _mm_set1_ps(triangle.edgeC[e]);
+			}
+			const __m128 depthA = _mm_set1_ps(triangle.depthA);
+			const __m128 depthB = _mm_set1_ps(triangle.depthB);
+			const __m128 depthC = _mm_set1_ps(triangle.depthC);
+
+			for (int y = minY; y <= maxY; ++y)
+			{
+				int spanMinX = triangle.minX, spanMaxX = triangle.maxX;
+				if (!rowSpan(triangle.edgeA, triangle.edgeB, triangle.edgeC, y + .5f, spanMinX, spanMaxX)) continue;
+
+				const __m128 py = _mm_set1_ps(y + .5f);
+				float* row = depth + static_cast<size_t>(y) * WIDTH;
+				// начало выравнивается по ширине SSE регистра (WIDTH кратно 4, поэтому выхода за строку нет)
+				for (int x = spanMinX & ~3; x <= spanMaxX; x += 4)
+				{
+					const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+
+					__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], px), _mm_mul_ps(edgeB[0], py)), edgeC[0]), zero);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], px), _mm_mul_ps(edgeB[1], py)), edgeC[1]), zero));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], px), _mm_mul_ps(edgeB[2], py)), edgeC[2]), zero));
+					if (_mm_movemask_ps(inside) == 0) continue;
+
+					const __m128 z = _mm_min_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(depthA, px), _mm_mul_ps(depthB, py)), depthC), maxDepth);
+					const __m128 current = _mm_loadu_ps(row + x);
+					const __m128 nearest = _mm_min_ps(current, z);
+					// в непокрытые пиксели остаётся записанным текущее значение
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+				}
+			}
+#else
+			for (int y = minY; y <= maxY; ++y)
+			{
+				const float py = y + .5f;
+				int spanMinX = triangle.minX, spanMaxX = triangle.maxX;
+				if (!rowSpan(triangle.edgeA, triangle.edgeB, triangle.edgeC, py, spanMinX, spanMaxX)) continue;
+
+				float* row = depth + static_cast<size_t>(y) * WIDTH;
+				for (int x = spanMinX; x <= spanMaxX; ++x)
+				{
+					const float px = x + .5f;
+					bool inside = true;
+					for (int e = 0; e < 3; ++e)
+					{
+						inside &= (triangle.edgeA[e] * px + triangle.edgeB[e] * py) + triangle.edgeC[e] >= 0.f;
+					}
+					if (!inside) continue;
+
+					const float z = std::min((triangle.depthA * px + triangle.depthB * py) + triangle.depthC, triangle.maxDepth);
+					row[x] = std::min(row[x], z);
+				}
+			}
+#endif
+		}
+	}
+
+	void VgetOcclusionCuller::buildDepthPyramid()
+	{
+		for (size_t level = 1; level < depthPyramid.size(); ++level)
+		{
+			const glm::ivec2 sourceSize = pyramidSizes[level - 1];
+			const glm::ivec2 size = pyramidSizes[level];
+			const std::vector<float>& source = depthPyramid[level - 1];
+			std::vector<float>& target = depthPyramid[level];
+
+			for (int y = 0; y < size.y; ++y)
+			{
+				const int y0 = 2 * y;
+				const int y1 = std::min(y0 + 1, sourceSize.y - 1);
+				for (int x = 0; x < size.x; ++x)
+				{
+					const int x0 = 2 * x;
+					const int x1 = std::min(x0 + 1, sourceSize.x - 1);
+					target[static_cast<size_t>(y) * size.x + x] = std::max(
+						std::max(source[static_cast<size_t>(y0) * sourceSize.x + x0], source[static_cast<size_t>(y0) * sourceSize.x + x1]),
+						std::max(source[static_cast<size_t>(y1) * sourceSize.x + x0], source[static_cast<size_t>(y1) * sourceSize.x + x1]));
+				}
+			}
+		}
+	}
+
+	bool VgetOcclusionCuller::isOccluded(const Aabb& worldBox) const
+	{
+		if (!rasterized) return false;
+
+		// Проекция восьми углов объёма на экран: прямоугольник в пикселях и ближайшая глубина
+		glm::vec2 screenMin{ std::numeric_limits<float>::max() };
+		glm::vec2 screenMax{ -std::numeric_limits<float>::max() };
+		float nearestDepth = std::numeric_limits<float>::max();
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 point{
+				corner & 1 ? worldBox.max.x : worldBox.min.x,
+				corner & 2 ? worldBox.max.y : worldBox.min.y,
+				corner & 4 ? worldBox.max.z : worldBox.min.z };
+			const glm::vec4 clip = viewProjection * glm::vec4(point, 1.f);
+
+			// объём пересекает ближнюю плоскость - камера может быть внутри него
+			if (clip.w < MIN_CLIP_W || clip.z < 0.f) return false;
+
+			const float inverseW = 1.f / clip.w;
+			const glm::vec2 screen{ (clip.x * inverseW * .5f + .5f) * WIDTH, (clip.y * inverseW * .5f + .5f) * HEIGHT };
+			screenMin = glm::min(screenMin, screen);
+			screenMax = glm::max(screenMax, screen);
+			nearestDepth = std::min(nearestDepth, clip.z * inverseW);
+		}
+
+		// Объёмы за пределами экрана - забота отсечения по пирамиде видимости
+		if (screenMax.x < 0.f || screenMax.y < 0.f || screenMin.x > WIDTH || screenMin.y > HEIGHT) return false;
+
+		// Прямоугольник расширяется на пиксель: пиксели на силуэте окклюдера могут быть покрыты им лишь частично
+		int minX = std::max(0, static_cast<int>(std::floor(screenMin.x)) - 1);
+		int minY = std::max(0, static_cast<int>(std::floor(screenMin.y)) - 1);
+		int maxX = std::min(WIDTH - 1, static_cast<int>(std::floor(screenMax.x)) + 1);
+		int maxY = std::min(HEIGHT - 1, static_cast<int>(std::floor(screenMax.y)) + 1);
+
+		// Выбирается уровень пирамиды, на котором прямоугольник покрывает не больше 2x2 текселей
+		size_t level = 0;
+		while (level + 1 < depthPyramid.size() && ((maxX >> level) - (minX >> level) > 1 || (maxY >> level) - (minY >> level) > 1))
+		{
+			++level;
+		}
+		minX >>= level; maxX >>= level;
+		minY >>= level; maxY >>= level;
+
+		const glm::ivec2 size = pyramidSizes[level];
+		const std::vector<float>& depth = depthPyramid[level];
+		float farthestOccluderDepth = 0.f;
+		for (int y = minY; y <= maxY; ++y)
+		{
+			for (int x = minX; x <= maxX; ++x)
+			{
+				farthestOccluderDepth = std::max(farthestOccluderDepth, depth[static_cast<size_t>(y) * size.x + x]);
+			}
+		}
+		return nearestDepth > farthestOccluderDepth;
+	}
+}
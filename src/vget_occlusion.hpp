@@ -0,0 +1,97 @@
+#pragma once
+
+#include "vget_bounds.hpp"
+#include "vget_job_system.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace vget
+{
+	// Упрощённая геометрия окклюдера: только позиции и индексы треугольников (в пространстве модели)
+	struct OccluderMesh
+	{
+		std::vector<glm::vec3> positions{};
+		std::vector<uint32_t> indices{};
+
+		bool empty() const { return indices.empty(); }
+		size_t triangleCount() const { return indices.size() / 3; }
+	};
+
+	// Отсечение перекрытых объектов (occlusion culling) на CPU.
+	// Каждый кадр геометрия назначенных окклюдеров программно растеризуется в буфер глубины низкого разрешения,
+	// по которому строится иерархическая пирамида глубины (каждый уровень хранит самую дальнюю глубину 2x2 текселей
+	// предыдущего). Объём объекта перекрыт, если его ближайшая точка дальше всех окклюдеров в покрываемой им области.
+	//
+	// Отсечение консервативно: в пиксель пишется самая дальняя глубина треугольника внутри пикселя, треугольники,
+	// пересекающие ближнюю плоскость, пропускаются, а проверяемая область объекта расширяется на пиксель, чтобы
+	// учесть частично покрытые пиксели на силуэтах окклюдеров. Поэтому видимый объект не будет ошибочно отсечён.
+	// Экран делится на горизонтальные полосы, которые растеризуются параллельно без синхронизации, а результат
+	// не зависит от количества потоков.
+	class VgetOcclusionCuller
+	{
+	public:
+		static constexpr int WIDTH = 320;	// кратно ширине SSE регистра
+		static constexpr int HEIGHT = 192;
+
+		// Без планировщика задач (jobSystem == nullptr) растеризация идёт в вызывающем потоке
+		explicit VgetOcclusionCuller(VgetJobSystem* jobSystem = nullptr);
+
+		VgetOcclusionCuller(const VgetOcclusionCuller&) = delete;
+		VgetOcclusionCuller& operator=(const VgetOcclusionCuller&) = delete;
+
+		// Начало кадра: очистка списка окклюдеров. Пока не вызван rasterize(), isOccluded() всегда возвращает false.
+		void beginFrame(const glm::mat4& viewProjection);
+		// Геометрия окклюдера должна оставаться в памяти до конца rasterize()
+		void addOccluder(const OccluderMesh& mesh, const glm::mat4& modelMatrix);
+		void rasterize();
+
+		bool isOccluded(const Aabb& worldBox) const;
+
+		uint32_t getThreadCount() const { return jobSystem != nullptr ? jobSystem->getWorkerCount() : 1u; }
+		uint32_t getOccluderTriangleCount() const { return static_cast<uint32_t>(triangles.size()); }
+		double getRasterTimeMs() const { return rasterTimeMs; }
+		const std::vector<float>& getDepthBuffer() const { return depthPyramid[0]; }
+
+	private:
+		struct OccluderInstance
+		{
+			const OccluderMesh* mesh;
+			glm::mat4 modelViewProjection;
+			uint32_t firstVertex;	// отступ вершин окклюдера в общем массиве экранных вершин
+			uint32_t firstTriangle;
+		};
+
+		// Треугольник, подготовленный к растеризации: функции рёбер E(x, y) = a * x + b * y + c
+		// (E >= 0 для всех трёх рёбер - точка внутри треугольника) и плоскость глубины z(x, y)
+		struct Triangle
+		{
+			float edgeA[3], edgeB[3], edgeC[3];
+			float depthA, depthB, depthC;
+			float maxDepth;
+			int minX, maxX, minY, maxY;	// ограничивающий прямоугольник в пикселях; minX > maxX - треугольник пропущен
+		};
+
+		void transformVertices(size_t begin, size_t end);
+		void setupTriangles(size_t begin, size_t end);
+		void rasterizeBand(int bandMinY, int bandMaxY);
+		void buildDepthPyramid();
+
+		// Параллельный запуск func(begin, end) на поддиапазонах [0, count)
+		void parallelFor(size_t count, const std::function<void(size_t, size_t)>& func) const;
+
+		VgetJobSystem* jobSystem;
+
+		glm::mat4 viewProjection{ 1.f };
+		std::vector<OccluderInstance> occluders;
+		std::vector<glm::vec4> screenVertices;	// x, y - пиксели, z - глубина, w - признак вершины перед ближней плоскостью
+		std::vector<Triangle> triangles;
+
+		std::vector<std::vector<float>> depthPyramid;	// [0] - буфер глубины WIDTH x HEIGHT
+		std::vector<glm::ivec2> pyramidSizes;
+		bool rasterized = false;
+		double rasterTimeMs = 0.0;
+	};
+}
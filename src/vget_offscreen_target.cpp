@@ -0,0 +1,252 @@
+#include "vget_offscreen_target.hpp"
+#include "vget_swap_chain.hpp"
+#include "vget_render_stats.hpp"
+
+// std
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace vget
+{
+	VgetOffscreenTarget::VgetOffscreenTarget(VgetDevice& device, VkExtent2D extent) : device{ device }, extent{ extent }
+	{
+		colorFormat = findColorFormat();
+		depthFormat = findDepthFormat();
+		createImages();
+		createRenderPass();
+		createFramebuffers();
+		createSyncObjects();
+	}
+
+	VgetOffscreenTarget::~VgetOffscreenTarget()
+	{
+		for (size_t i = 0; i < colorImages.size(); ++i)
+		{
+			vkDestroyFramebuffer(device.device(), framebuffers[i], nullptr);
+			vkDestroyImageView(device.device(), colorImageViews[i], nullptr);
+			vkDestroyImage(device.device(), colorImages[i], nullptr);
+			device.freeMemory(colorImageMemories[i]);
+			vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
+			vkDestroyImage(device.device(), depthImages[i], nullptr);
+			device.freeMemory(depthImageMemories[i]);
+		}
+
+		vkDestroyRenderPass(device.device(), renderPass, nullptr);
+
+		for (auto fence : inFlightFences)
+		{
+			vkDestroyFence(device.device(), fence, nullptr);
+		}
+	}
+
+	void VgetOffscreenTarget::acquireNextImage(uint32_t* imageIndex)
+	{
+		// Изображение кадра занято, пока не сработал забор его прошлой отправки
+		vkWaitForFences(device.device(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		*imageIndex = static_cast<uint32_t>(currentFrame);
+	}
+
+	void VgetOffscreenTarget::submitCommandBuffers(const VkCommandBuffer* buffers)
+	{
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = buffers;
+
+		vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
+		{
+			std::lock_guard<std::mutex> lock{ device.getQueueMutex() };
+			if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit offscreen command buffer!");
+			}
+		}
+		VgetRenderStats::add(RenderCounter::QueueSubmits);
+
+		currentFrame = (currentFrame + 1) % inFlightFences.size();
+	}
+
+	void VgetOffscreenTarget::createImages()
+	{
+		const size_t count = VgetSwapChain::MAX_FRAMES_IN_FLIGHT;
+		colorImages.resize(count);
+		colorImageMemories.resize(count);
+		colorImageViews.resize(count);
+		depthImages.resize(count);
+		depthImageMemories.resize(count);
+		depthImageViews.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Цвет можно скопировать в буфер для проверки кадра или скриншота
+			createAttachment(colorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				VK_IMAGE_ASPECT_COLOR_BIT, colorImages[i], colorImageMemories[i], colorImageViews[i]);
+			createAttachment(depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+				VK_IMAGE_ASPECT_DEPTH_BIT, depthImages[i], depthImageMemories[i], depthImageViews[i]);
+		}
+	}
+
+	void VgetOffscreenTarget::createAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect,
+		VkImage& image, VkDeviceMemory& memory, VkImageView& view)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = extent.width;
+		imageInfo.extent.height = extent.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory, MemoryTag{ MemoryCategory::Attachment, "offscreen target" });
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange.aspectMask = aspect;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(device.device(), &viewInfo, nullptr, &view) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create offscreen image view!");
+		}
+	}
+
+	// Тот же проход, что и в VgetSwapChain::createRenderPass(), кроме конечной схемы цвета
+	void VgetOffscreenTarget::createRenderPass()
+	{
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depthAttachmentRef{};
+		depthAttachmentRef.attachment = 1;
+		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentDescription colorAttachment{};
+		colorAttachment.format = colorFormat;
+		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		// Показа нет - после прохода изображение готово к копированию
+		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+		VkAttachmentReference colorAttachmentRef{};
+		colorAttachmentRef.attachment = 0;
+		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentRef;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		std::array<VkSubpassDependency, 2> dependencies{};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		// Запись цвета видна копированию, которое читатель кадра запишет после прохода
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
+
+		if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create offscreen render pass!");
+		}
+	}
+
+	void VgetOffscreenTarget::createFramebuffers()
+	{
+		framebuffers.resize(colorImages.size());
+		for (size_t i = 0; i < colorImages.size(); ++i)
+		{
+			std::array<VkImageView, 2> attachments = { colorImageViews[i], depthImageViews[i] };
+
+			VkFramebufferCreateInfo framebufferInfo{};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = renderPass;
+			framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			framebufferInfo.pAttachments = attachments.data();
+			framebufferInfo.width = extent.width;
+			framebufferInfo.height = extent.height;
+			framebufferInfo.layers = 1;
+
+			if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create offscreen framebuffer!");
+			}
+		}
+	}
+
+	void VgetOffscreenTarget::createSyncObjects()
+	{
+		inFlightFences.resize(colorImages.size());
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		for (auto& fence : inFlightFences)
+		{
+			if (vkCreateFence(device.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create synchronization objects for an offscreen frame!");
+			}
+		}
+	}
+
+	// Формат цвета как у цепи обмена (см. VgetSwapChain::chooseSwapSurfaceFormat), чтобы кадры совпадали с оконными
+	VkFormat VgetOffscreenTarget::findColorFormat()
+	{
+		return device.findSupportedFormat(
+			{ VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+	}
+
+	VkFormat VgetOffscreenTarget::findDepthFormat()
+	{
+		return device.findSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+	}
+}
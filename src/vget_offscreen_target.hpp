@@ -0,0 +1,66 @@
+#pragma once
+
+#include "vget_device.hpp"
+
+// std
+#include <vector>
+
+namespace vget
+{
+	// Внеэкранная цель рендера для режима без окна - замена VgetSwapChain. На каждый кадр в полёте своё
+	// изображение цвета и глубины с тем же устройством прохода рендера, что и у цепи обмена (пайплайны систем рендера
+	// совместимы с обоими), только цвет в конце прохода переводится в TRANSFER_SRC для чтения на CPU.
+	// Показа нет, поэтому нет и семафоров: кадры ограничивает только забор кадра в полёте.
+	class VgetOffscreenTarget
+	{
+	public:
+		VgetOffscreenTarget(VgetDevice& device, VkExtent2D extent);
+		~VgetOffscreenTarget();
+
+		VgetOffscreenTarget(const VgetOffscreenTarget&) = delete;
+		VgetOffscreenTarget& operator=(const VgetOffscreenTarget&) = delete;
+
+		VkFramebuffer getFrameBuffer(int index) const { return framebuffers[index]; }
+		VkRenderPass getRenderPass() const { return renderPass; }
+		VkImage getColorImage(int index) const { return colorImages[index]; }
+		VkFormat getColorFormat() const { return colorFormat; }
+		VkExtent2D getExtent() const { return extent; }
+		size_t imageCount() const { return colorImages.size(); }
+		float extentAspectRatio() const
+		{
+			return static_cast<float>(extent.width) / static_cast<float>(extent.height);
+		}
+
+		// Ожидание забора кадра, который использовал изображение в прошлый раз; imageIndex - номер этого изображения
+		void acquireNextImage(uint32_t* imageIndex);
+		// Отправка буфера команд с забором кадра (без семафоров и показа)
+		void submitCommandBuffers(const VkCommandBuffer* buffers);
+
+	private:
+		void createImages();
+		void createRenderPass();
+		void createFramebuffers();
+		void createSyncObjects();
+		VkFormat findColorFormat();
+		VkFormat findDepthFormat();
+		void createAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect,
+			VkImage& image, VkDeviceMemory& memory, VkImageView& view);
+
+		VgetDevice& device;
+		VkExtent2D extent;
+		VkFormat colorFormat;
+		VkFormat depthFormat;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+
+		std::vector<VkImage> colorImages;
+		std::vector<VkDeviceMemory> colorImageMemories;
+		std::vector<VkImageView> colorImageViews;
+		std::vector<VkImage> depthImages;
+		std::vector<VkDeviceMemory> depthImageMemories;
+		std::vector<VkImageView> depthImageViews;
+		std::vector<VkFramebuffer> framebuffers;
+
+		std::vector<VkFence> inFlightFences;
+		size_t currentFrame = 0;
+	};
+}
@@ -0,0 +1,174 @@
+#include "vget_pass_recorder.hpp"
+
+namespace vget
+{
+	VgetPassRecorder::VgetPassRecorder(VgetDevice& device, VgetJobSystem& jobSystem, uint32_t framesInFlight)
+		: vgetDevice{ device }, jobSystem{ jobSystem }, threadPools(static_cast<size_t>(framesInFlight) * (jobSystem.getWorkerCount() + 1))
+	{
+		// TRANSIENT: буферы живут один кадр, а пул сбрасывается целиком, поэтому отдельный сброс буферов не нужен
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = vgetDevice.getGraphicsQueueFamily();
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		for (auto& threadPool : threadPools)
+		{
+			if (vkCreateCommandPool(vgetDevice.device(), &poolInfo, nullptr, &threadPool.commandPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create command pool!");
+			}
+		}
+
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.subpass = 0;
+	}
+
+	VgetPassRecorder::~VgetPassRecorder()
+	{
+		// Уничтожение пула освобождает и все его буферы
+		for (auto& threadPool : threadPools)
+		{
+			vkDestroyCommandPool(vgetDevice.device(), threadPool.commandPool, nullptr);
+		}
+	}
+
+	uint32_t VgetPassRecorder::getMaxThreads() const
+	{
+		const uint32_t workerCount = jobSystem.getWorkerCount();
+		return maxThreads == 0 ? workerCount : std::min(maxThreads, workerCount);
+	}
+
+	void VgetPassRecorder::beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent)
+	{
+		this->frameIndex = frameIndex;
+		for (uint32_t thread = 0; thread <= jobSystem.getWorkerCount(); ++thread)
+		{
+			ThreadPool& threadPool = getThreadPool(thread);
+			if (threadPool.usedCount == 0) continue;
+			if (vkResetCommandPool(vgetDevice.device(), threadPool.commandPool, 0) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to reset command pool!");
+			}
+			threadPool.usedCount = 0;
+		}
+
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.framebuffer = framebuffer;
+
+		// Динамическое состояние не наследуется вторичными буферами, поэтому область вывода ставится в каждом из них
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		scissor = VkRect2D{ {0, 0}, extent };
+
+		recordedBuffers.clear();
+		currentScope = NO_SCOPE;
+		stats = CommandStats{};
+		recordTimeMs = 0.0;
+	}
+
+	VgetPassRecorder::ThreadPool& VgetPassRecorder::getThreadPool(uint32_t workerIndex)
+	{
+		const uint32_t workerCount = jobSystem.getWorkerCount();
+		const uint32_t thread = workerIndex < workerCount ? workerIndex : workerCount;
+		return threadPools[frameIndex * (workerCount + 1) + thread];
+	}
+
+	VkCommandBuffer VgetPassRecorder::beginSecondary()
+	{
+		ThreadPool& threadPool = getThreadPool(jobSystem.currentWorkerIndex());
+
+		// Буферов в пуле становится столько, сколько потоку понадобилось в самом загруженном кадре
+		if (threadPool.usedCount == threadPool.commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandPool = threadPool.commandPool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(vgetDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				recordFailed = true;
+				return VK_NULL_HANDLE;
+			}
+			threadPool.commandBuffers.push_back(commandBuffer);
+		}
+		const VkCommandBuffer commandBuffer = threadPool.commandBuffers[threadPool.usedCount++];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			recordFailed = true;
+			return VK_NULL_HANDLE;
+		}
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		return commandBuffer;
+	}
+
+	VgetPassRecorder::RecordedBuffer VgetPassRecorder::endSecondary(VgetCommandRecorder& recorder)
+	{
+		if (vkEndCommandBuffer(recorder.getCommandBuffer()) != VK_SUCCESS)
+		{
+			recordFailed = true;
+			return RecordedBuffer{};
+		}
+		return RecordedBuffer{ recorder.getCommandBuffer(), recorder.getStats() };
+	}
+
+	void VgetPassRecorder::beginScope(uint32_t scope)
+	{
+		currentScope = scope;
+		recordTimestamp(scope, false);
+	}
+
+	void VgetPassRecorder::endScope()
+	{
+		recordTimestamp(currentScope, true);
+		currentScope = NO_SCOPE;
+	}
+
+	void VgetPassRecorder::recordTimestamp(uint32_t scope, bool scopeEnd)
+	{
+		if (gpuProfiler == nullptr || !gpuProfiler->isTimestampSupported() || scope == NO_SCOPE) return;
+
+		VgetCommandRecorder recorder{};
+		const VkCommandBuffer commandBuffer = beginSecondary();
+		if (commandBuffer != VK_NULL_HANDLE)
+		{
+			recorder.begin(commandBuffer);
+			if (scopeEnd)
+			{
+				gpuProfiler->writeScopeEnd(commandBuffer, scope);
+			}
+			else
+			{
+				gpuProfiler->writeScopeBegin(commandBuffer, scope);
+			}
+			recordedBuffers.push_back(endSecondary(recorder));
+		}
+		if (recordFailed.exchange(false)) throw std::runtime_error("failed to record secondary command buffer!");
+	}
+
+	void VgetPassRecorder::execute(VkCommandBuffer primaryCommandBuffer)
+	{
+		std::vector<VkCommandBuffer> commandBuffers;
+		commandBuffers.reserve(recordedBuffers.size());
+		for (const auto& buffer : recordedBuffers)
+		{
+			if (buffer.commandBuffer == VK_NULL_HANDLE) continue;
+			commandBuffers.push_back(buffer.commandBuffer);
+		}
+		if (commandBuffers.empty()) return;
+		vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+	}
+}
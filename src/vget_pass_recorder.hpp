@@ -0,0 +1,142 @@
+#pragma once
+
+#include "vget_device.hpp"
+#include "vget_command_recorder.hpp"
+#include "vget_job_system.hpp"
+#include "vget_gpu_profiler.hpp"
+#include "vget_cpu_profiler.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace vget
+{
+	// Параллельная запись прохода рендера во вторичные буферы команд.
+	// У каждого рабочего потока VgetJobSystem и каждого кадра в полёте свой VkCommandPool (пулы не потокобезопасны).
+	// Ещё один пул кадра отдан потоку вне планировщика (потоку рендера), из которого вызывается record(); такой
+	// поток может быть только один.
+	// Пул кадра сбрасывается целиком в начале этого кадра - GPU к этому моменту уже выполнил его буферы, - и его
+	// вторичные буферы переиспользуются без освобождения. Системы рендера передают в record() диапазоны отрисовок:
+	// каждый диапазон записывается своим потоком в свой вторичный буфер со своим VgetCommandRecorder, а execute()
+	// исполняет буферы из основного в порядке записи, поэтому порядок отрисовок не зависит от числа потоков.
+	// С профайлером GPU вызовы record() между beginScope() и endScope() замеряются как одна область: метки времени
+	// пишутся в отдельные вторичные буферы до и после буферов области, а статистика конвейера - в каждом из них.
+	class VgetPassRecorder
+	{
+	public:
+		static constexpr uint32_t MIN_DRAWS_PER_BUFFER = 256;	// меньшие диапазоны не окупают отдельный буфер и поток
+
+		VgetPassRecorder(VgetDevice& device, VgetJobSystem& jobSystem, uint32_t framesInFlight);
+		~VgetPassRecorder();
+
+		VgetPassRecorder(const VgetPassRecorder&) = delete;
+		VgetPassRecorder& operator=(const VgetPassRecorder&) = delete;
+
+		// Начало записи кадра. Проход рендера в основном буфере должен начинаться
+		// с VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, его наследуют вторичные буферы.
+		void beginFrame(int frameIndex, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+		// Запись count элементов диапазонами не меньше minItemsPerBuffer, не больше одного диапазона на поток.
+		// func(VgetCommandRecorder& recorder, uint32_t begin, uint32_t end) вызывается из рабочих потоков. Рекордер уже
+		// начат во вторичном буфере с установленными областью вывода и ножницами; пайплайн, дескрипторы и буферы
+		// не наследуются и привязываются в каждом диапазоне заново.
+		template <typename Func>
+		void record(uint32_t count, uint32_t minItemsPerBuffer, Func&& func)
+		{
+			if (count == 0) return;
+			const auto start = std::chrono::high_resolution_clock::now();
+
+			const uint32_t rangeCount = std::max(1u, std::min(getMaxThreads(), count / std::max(1u, minItemsPerBuffer)));
+			const size_t firstBuffer = recordedBuffers.size();
+			recordedBuffers.resize(firstBuffer + rangeCount);
+			jobSystem.parallelFor(0, rangeCount, 1, [&](uint32_t rangeBegin, uint32_t rangeEnd)
+			{
+				for (uint32_t range = rangeBegin; range < rangeEnd; ++range)
+				{
+					VGET_PROFILE_ZONE("Record secondary buffer");
+					VgetCommandRecorder recorder{};
+					const VkCommandBuffer commandBuffer = beginSecondary();
+					if (commandBuffer == VK_NULL_HANDLE) continue;
+					const uint32_t statisticsQuery = gpuProfiler != nullptr && currentScope != NO_SCOPE ?
+						gpuProfiler->beginStatistics(commandBuffer, currentScope) : VgetGpuProfiler::NO_QUERY;
+					recorder.begin(commandBuffer);
+					func(recorder,
+						static_cast<uint32_t>(static_cast<uint64_t>(count) * range / rangeCount),
+						static_cast<uint32_t>(static_cast<uint64_t>(count) * (range + 1) / rangeCount));
+					if (statisticsQuery != VgetGpuProfiler::NO_QUERY) gpuProfiler->endStatistics(commandBuffer, statisticsQuery);
+					recordedBuffers[firstBuffer + range] = endSecondary(recorder);
+				}
+			});
+
+			for (size_t i = firstBuffer; i < recordedBuffers.size(); ++i) stats += recordedBuffers[i].stats;
+			recordTimeMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			// Задачи не бросают исключений, поэтому ошибки Vulkan из рабочих потоков сообщаются здесь
+			if (recordFailed.exchange(false)) throw std::runtime_error("failed to record secondary command buffer!");
+		}
+
+		// Исполнение всех вторичных буферов кадра внутри прохода рендера основного буфера
+		void execute(VkCommandBuffer primaryCommandBuffer);
+
+		// Профайлер GPU для областей (nullptr - без замеров). Его beginFrame() вызывается до исполнения буферов кадра.
+		void setGpuProfiler(VgetGpuProfiler* profiler) { gpuProfiler = profiler; }
+		// Область профайлера для следующих вызовов record(). Вызываются из потока, записывающего кадр.
+		void beginScope(uint32_t scope);
+		void endScope();
+
+		// Ограничение числа потоков записи (0 - все рабочие потоки планировщика)
+		void setMaxThreads(uint32_t threadCount) { maxThreads = threadCount; }
+		uint32_t getMaxThreads() const;
+
+		// Статистика текущего кадра: команды записанных вторичных буферов, число буферов и время внутри record()
+		const CommandStats& getStats() const { return stats; }
+		uint32_t getBufferCount() const { return static_cast<uint32_t>(recordedBuffers.size()); }
+		double getRecordTimeMs() const { return recordTimeMs; }
+
+	private:
+		static constexpr uint32_t NO_SCOPE = ~0u;
+
+		struct RecordedBuffer
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			CommandStats stats{};
+		};
+
+		// Пул одного потока для одного кадра. Выравнивание по кэш-линии: счётчики соседних потоков не делят линию.
+		struct alignas(64) ThreadPool
+		{
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers;	// вторичные буферы, выделенные в пуле
+			uint32_t usedCount = 0;							// из них выданы в текущем кадре
+		};
+
+		// Пул кадра для потока: рабочие потоки планировщика по индексу, поток вне планировщика - последним
+		ThreadPool& getThreadPool(uint32_t workerIndex);
+		// Следующий вторичный буфер пула текущего потока, начатый для продолжения прохода. VK_NULL_HANDLE - ошибка.
+		VkCommandBuffer beginSecondary();
+		RecordedBuffer endSecondary(VgetCommandRecorder& recorder);
+		// Вторичный буфер с одной меткой времени области
+		void recordTimestamp(uint32_t scope, bool scopeEnd);
+
+		VgetDevice& vgetDevice;
+		VgetJobSystem& jobSystem;
+		uint32_t maxThreads = 0;
+		VgetGpuProfiler* gpuProfiler = nullptr;
+		uint32_t currentScope = NO_SCOPE;
+
+		std::vector<ThreadPool> threadPools;	// [кадр * (число рабочих потоков + 1) + поток]
+		int frameIndex = 0;
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		VkViewport viewport{};
+		VkRect2D scissor{};
+
+		std::vector<RecordedBuffer> recordedBuffers;
+		std::atomic<bool> recordFailed{ false };
+		CommandStats stats{};
+		double recordTimeMs = 0.0;
+	};
+}
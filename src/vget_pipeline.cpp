@@ -152,10 +152,10 @@ namespace vget
 			throw std::runtime_error("failed to create shader module");
 	}
 
-	void VgetPipeline::bind(VkCommandBuffer commandBuffer)
+	void VgetPipeline::bind(VgetCommandRecorder& recorder)
 	{
 		// BIND_POINT показывает тип привязанного к буферу команд пайплайна. Можно привязать Graphics, Compute и RayTracing пайплайны
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+		recorder.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 	}
 
 	void VgetPipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vget_device.hpp"
+#include "vget_command_recorder.hpp"
 
 // std
 #include <string>
@@ -50,7 +51,7 @@ namespace vget
 		VgetPipeline(const VgetPipeline&) = delete;
 		VgetPipeline& operator=(const VgetPipeline&) = delete;
 
-		void bind(VkCommandBuffer commandBuffer);
+		void bind(VgetCommandRecorder& recorder);
 
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 		static void enableAlphaBlending(PipelineConfigInfo& configInfo);
@@ -0,0 +1,517 @@
+#include "vget_pvs.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace vget
+{
+	namespace
+	{
+		constexpr char PVS_MAGIC[4] = { 'V', 'P', 'V', 'S' };
+		constexpr uint32_t PVS_VERSION = 1;
+		constexpr float RAY_EPSILON = 1e-4f;
+
+		// Статичная иерархия объёмов над треугольниками сцены для трассировки лучей при запекании
+		class TriangleBvh
+		{
+		public:
+			struct Triangle
+			{
+				glm::vec3 v0, v1, v2;
+				uint32_t item;
+			};
+
+			explicit TriangleBvh(std::vector<Triangle> sceneTriangles) : triangles{ std::move(sceneTriangles) }
+			{
+				if (triangles.empty()) return;
+				nodes.reserve(triangles.size() * 2 / LEAF_SIZE + 1);
+				nodes.resize(1);
+				build(0, 0, static_cast<uint32_t>(triangles.size()));
+			}
+
+			// Есть ли на отрезке from -> to треугольник, не принадлежащий элементу ignoredItem
+			bool isSegmentBlocked(const glm::vec3& from, const glm::vec3& to, uint32_t ignoredItem) const
+			{
+				if (nodes.empty()) return false;
+
+				const glm::vec3 direction = to - from;
+				const float length = glm::length(direction);
+				if (length < RAY_EPSILON) return false;
+				const glm::vec3 unitDirection = direction / length;
+				const glm::vec3 inverseDirection = 1.f / unitDirection;
+				const float maxT = length - RAY_EPSILON;
+
+				uint32_t stack[64];
+				uint32_t stackSize = 0;
+				stack[stackSize++] = 0;
+				while (stackSize > 0)
+				{
+					const Node& node = nodes[stack[--stackSize]];
+
+					const glm::vec3 t1 = (node.box.min - from) * inverseDirection;
+					const glm::vec3 t2 = (node.box.max - from) * inverseDirection;
+					const glm::vec3 tNear = glm::min(t1, t2);
+					const glm::vec3 tFar = glm::max(t1, t2);
+					const float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+					const float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+					if (tEnter > tExit) continue;
+
+					if (node.count > 0)
+					{
+						for (uint32_t i = node.first; i < node.first + node.count; ++i)
+						{
+							if (triangles[i].item != ignoredItem && intersects(triangles[i], from, unitDirection, maxT)) return true;
+						}
+						continue;
+					}
+					stack[stackSize++] = node.first;
+					stack[stackSize++] = node.first + 1;
+				}
+				return false;
+			}
+
+		private:
+			static constexpr uint32_t LEAF_SIZE = 4;
+
+			struct Node
+			{
+				Aabb box;
+				uint32_t first;	// лист - первый треугольник, внутренний узел - индекс левого потомка (правый следует за ним)
+				uint32_t count;	// 0 - внутренний узел
+			};
+
+			// Алгоритм Мёллера-Трумбора
+			static bool intersects(const Triangle& triangle, const glm::vec3& origin, const glm::vec3& direction, float maxT)
+			{
+				const glm::vec3 edge1 = triangle.v1 - triangle.v0;
+				const glm::vec3 edge2 = triangle.v2 - triangle.v0;
+				const glm::vec3 p = glm::cross(direction, edge2);
+				const float determinant = glm::dot(edge1, p);
+				if (std::abs(determinant) < 1e-12f) return false;
+
+				const float inverseDeterminant = 1.f / determinant;
+				const glm::vec3 s = origin - triangle.v0;
+				const float u = glm::dot(s, p) * inverseDeterminant;
+				if (u < 0.f || u > 1.f) return false;
+				const glm::vec3 q = glm::cross(s, edge1);
+				const float v = glm::dot(direction, q) * inverseDeterminant;
+				if (v < 0.f || u + v > 1.f) return false;
+				const float t = glm::dot(edge2, q) * inverseDeterminant;
+				return t > RAY_EPSILON && t < maxT;
+			}
+
+			// Рекурсивное построение делением по медиане центров треугольников вдоль самой длинной оси.
+			// Потомки внутреннего узла лежат в массиве подряд, поэтому хранится только индекс левого.
+			void build(uint32_t nodeIndex, uint32_t first, uint32_t count)
+			{
+				Aabb box{};
+				for (uint32_t i = first; i < first + count; ++i)
+				{
+					box.expand(triangles[i].v0);
+					box.expand(triangles[i].v1);
+					box.expand(triangles[i].v2);
+				}
+				nodes[nodeIndex].box = box;
+				if (count <= LEAF_SIZE)
+				{
+					nodes[nodeIndex].first = first;
+					nodes[nodeIndex].count = count;
+					return;
+				}
+
+				Aabb centroidBox{};
+				for (uint32_t i = first; i < first + count; ++i)
+					centroidBox.expand((triangles[i].v0 + triangles[i].v1 + triangles[i].v2) / 3.f);
+				const glm::vec3 size = centroidBox.max - centroidBox.min;
+				const int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+				const uint32_t half = count / 2;
+				std::nth_element(triangles.begin() + first, triangles.begin() + first + half, triangles.begin() + first + count,
+					[axis](const Triangle& a, const Triangle& b)
+					{
+						return (a.v0[axis] + a.v1[axis] + a.v2[axis]) < (b.v0[axis] + b.v1[axis] + b.v2[axis]);
+					});
+
+				const uint32_t left = static_cast<uint32_t>(nodes.size());
+				nodes.resize(left + 2);
+				nodes[nodeIndex].first = left;
+				nodes[nodeIndex].count = 0;
+				build(left, first, half);
+				build(left + 1, first + half, count - half);
+			}
+
+			std::vector<Triangle> triangles;
+			std::vector<Node> nodes;
+		};
+	}
+
+	void VgetPvs::save(const std::string& filepath) const
+	{
+		std::ofstream file{ filepath, std::ios::binary };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		auto write = [&file](const auto& value) { file.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+		file.write(PVS_MAGIC, sizeof(PVS_MAGIC));
+		write(PVS_VERSION);
+		write(origin);
+		write(cellSize);
+		write(dimensions);
+
+		write(static_cast<uint32_t>(objects.size()));
+		for (const auto& object : objects)
+		{
+			write(static_cast<uint16_t>(object.name.size()));
+			file.write(object.name.data(), object.name.size());
+			write(object.firstItem);
+			write(object.itemCount);
+		}
+		write(itemCount);
+
+		const uint32_t bytesPerSet = (itemCount + 7) / 8;
+		write(static_cast<uint32_t>(uniqueSets.size()));
+		write(bytesPerSet);
+		for (const auto& set : uniqueSets)
+		{
+			file.write(reinterpret_cast<const char*>(set.data()), bytesPerSet);
+		}
+
+		// Индексы множеств ячеек пишутся в 2 байта, если уникальных множеств не больше 65536
+		const uint8_t indexBytes = uniqueSets.size() <= 0x10000 ? 2 : 4;
+		write(indexBytes);
+		for (auto setIndex : cellSets)
+		{
+			if (indexBytes == 2) write(static_cast<uint16_t>(setIndex));
+			else write(setIndex);
+		}
+
+		if (!file.good())
+		{
+			throw std::runtime_error("failed to write PVS file: " + filepath);
+		}
+	}
+
+	void VgetPvs::load(const std::string& filepath)
+	{
+		std::ifstream file{ filepath, std::ios::binary };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		auto read = [&file](auto& value) { file.read(reinterpret_cast<char*>(&value), sizeof(value)); };
+		auto fail = [&filepath]() { throw std::runtime_error("failed to read PVS file: " + filepath); };
+
+		// Размеры из файла сверяются с его остатком до выделения памяти, чтобы испорченный файл не запросил гигабайты
+		file.seekg(0, std::ios::end);
+		const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+		file.seekg(0, std::ios::beg);
+		auto remainingBytes = [&file, fileSize]()
+		{
+			const std::streamoff position = file.tellg();
+			return position < 0 ? 0 : fileSize - static_cast<uint64_t>(position);
+		};
+
+		char magic[4];
+		uint32_t version = 0;
+		file.read(magic, sizeof(magic));
+		read(version);
+		if (!std::equal(magic, magic + 4, PVS_MAGIC) || version != PVS_VERSION)
+		{
+			throw std::runtime_error("unsupported PVS file: " + filepath);
+		}
+
+		read(origin);
+		read(cellSize);
+		read(dimensions);
+
+		uint32_t objectCount = 0;
+		read(objectCount);
+		if (!file.good() || objectCount > remainingBytes()) fail();
+		objects.resize(objectCount);
+		for (auto& object : objects)
+		{
+			uint16_t nameLength = 0;
+			read(nameLength);
+			object.name.resize(nameLength);
+			file.read(&object.name[0], nameLength);
+			read(object.firstItem);
+			read(object.itemCount);
+		}
+		read(itemCount);
+
+		uint32_t setCount = 0, bytesPerSet = 0;
+		read(setCount);
+		read(bytesPerSet);
+		if (!file.good() || bytesPerSet != (static_cast<uint64_t>(itemCount) + 7) / 8 ||
+			static_cast<uint64_t>(setCount) * bytesPerSet > remainingBytes())
+		{
+			fail();
+		}
+		uniqueSets.assign(setCount, std::vector<uint8_t>(bytesPerSet));
+		for (auto& set : uniqueSets)
+		{
+			file.read(reinterpret_cast<char*>(set.data()), bytesPerSet);
+		}
+
+		uint8_t indexBytes = 0;
+		read(indexBytes);
+		const uint64_t cellCount = static_cast<uint64_t>(dimensions.x) * dimensions.y * dimensions.z;
+		if (!file.good() || (indexBytes != 2 && indexBytes != 4) || (cellCount > 0 && setCount == 0) ||
+			cellCount * indexBytes > remainingBytes())
+		{
+			fail();
+		}
+		cellSets.resize(static_cast<size_t>(cellCount));
+		for (auto& setIndex : cellSets)
+		{
+			if (indexBytes == 2)
+			{
+				uint16_t shortIndex = 0;
+				read(shortIndex);
+				setIndex = shortIndex;
+			}
+			else
+			{
+				read(setIndex);
+			}
+			// Индекс за пределами множеств - файл испорчен или записан для другой сцены
+			if (setIndex >= setCount) fail();
+		}
+
+		if (!file.good())
+		{
+			fail();
+		}
+		boundObjects.clear();
+		currentCell = -1;
+	}
+
+	void VgetPvs::bindObject(uint32_t objectId, const std::string& name)
+	{
+		for (uint32_t i = 0; i < objects.size(); ++i)
+		{
+			if (objects[i].name == name)
+			{
+				boundObjects[objectId] = i;
+				return;
+			}
+		}
+	}
+
+	int32_t VgetPvs::findCell(const glm::vec3& position) const
+	{
+		if (cellSets.empty()) return -1;
+
+		const glm::vec3 relative = (position - origin) / cellSize;
+		if (relative.x < 0.f || relative.y < 0.f || relative.z < 0.f) return -1;
+		const glm::uvec3 cell{ static_cast<uint32_t>(relative.x), static_cast<uint32_t>(relative.y), static_cast<uint32_t>(relative.z) };
+		if (cell.x >= dimensions.x || cell.y >= dimensions.y || cell.z >= dimensions.z) return -1;
+		return static_cast<int32_t>(cell.x + cell.y * dimensions.x + cell.z * dimensions.x * dimensions.y);
+	}
+
+	void VgetPvs::selectCell(const glm::vec3& position)
+	{
+		currentCell = findCell(position);
+	}
+
+	bool VgetPvs::isItemVisible(int32_t cell, uint32_t item) const
+	{
+		if (cell < 0 || item >= itemCount) return true;
+		const auto& set = uniqueSets[cellSets[cell]];
+		return (set[item >> 3] >> (item & 7)) & 1;
+	}
+
+	bool VgetPvs::isObjectVisible(uint32_t objectId) const
+	{
+		if (currentCell < 0) return true;
+		auto bound = boundObjects.find(objectId);
+		if (bound == boundObjects.end()) return true;
+
+		const ObjectEntry& object = objects[bound->second];
+		for (uint32_t i = 0; i < object.itemCount; ++i)
+		{
+			if (isItemVisible(currentCell, object.firstItem + i)) return true;
+		}
+		return false;
+	}
+
+	bool VgetPvs::isSubObjectVisible(uint32_t objectId, uint32_t subObjectIndex) const
+	{
+		if (currentCell < 0) return true;
+		auto bound = boundObjects.find(objectId);
+		if (bound == boundObjects.end()) return true;
+
+		const ObjectEntry& object = objects[bound->second];
+		// объект запекался целиком (без подобъектов) - видимость подобъектов совпадает с видимостью объекта
+		if (object.itemCount == 1) return isItemVisible(currentCell, object.firstItem);
+		if (subObjectIndex >= object.itemCount) return true;
+		return isItemVisible(currentCell, object.firstItem + subObjectIndex);
+	}
+
+	VgetPvs VgetPvsBaker::bake(const Settings& settings)
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+
+		struct Item
+		{
+			uint32_t firstTriangle = 0;
+			uint32_t triangleCount = 0;
+			Aabb box{};
+			std::vector<glm::vec3> targets;	// случайные точки на поверхности элемента
+		};
+
+		VgetPvs pvs{};
+		std::vector<Item> items;
+		std::vector<TriangleBvh::Triangle> triangles;
+		Aabb sceneBox{};
+
+		// Каждый подобъект (или объект целиком) становится отдельным элементом со своими треугольниками
+		for (const auto& object : objects)
+		{
+			std::vector<glm::uvec2> ranges = object.subObjects;
+			if (ranges.empty()) ranges.push_back(glm::uvec2{ 0, static_cast<uint32_t>(object.indices.size()) });
+
+			pvs.objects.push_back(VgetPvs::ObjectEntry{ object.name, static_cast<uint32_t>(items.size()), static_cast<uint32_t>(ranges.size()) });
+			for (const auto& range : ranges)
+			{
+				Item item{};
+				item.firstTriangle = static_cast<uint32_t>(triangles.size());
+				for (uint32_t i = range.x; i + 2 < range.x + range.y; i += 3)
+				{
+					const TriangleBvh::Triangle triangle{
+						object.positions[object.indices[i]],
+						object.positions[object.indices[i + 1]],
+						object.positions[object.indices[i + 2]],
+						static_cast<uint32_t>(items.size()) };
+					triangles.push_back(triangle);
+					item.box.expand(triangle.v0);
+					item.box.expand(triangle.v1);
+					item.box.expand(triangle.v2);
+				}
+				item.triangleCount = static_cast<uint32_t>(triangles.size()) - item.firstTriangle;
+				if (item.box.isValid()) sceneBox.expand(item.box);
+				items.push_back(std::move(item));
+			}
+		}
+		pvs.itemCount = static_cast<uint32_t>(items.size());
+
+		// Точки-цели распределяются по треугольникам элемента пропорционально их площади
+		for (uint32_t itemIndex = 0; itemIndex < items.size(); ++itemIndex)
+		{
+			Item& item = items[itemIndex];
+			if (item.triangleCount == 0) continue;
+
+			std::vector<float> cumulativeArea(item.triangleCount);
+			float totalArea = 0.f;
+			for (uint32_t i = 0; i < item.triangleCount; ++i)
+			{
+				const auto& triangle = triangles[item.firstTriangle + i];
+				totalArea += .5f * glm::length(glm::cross(triangle.v1 - triangle.v0, triangle.v2 - triangle.v0));
+				cumulativeArea[i] = totalArea;
+			}
+
+			std::mt19937 rng{ itemIndex * 7919u + 1u };
+			std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+			item.targets.reserve(settings.samplesPerItem);
+			for (uint32_t s = 0; s < settings.samplesPerItem; ++s)
+			{
+				const float pick = unit(rng) * totalArea;
+				const uint32_t index = static_cast<uint32_t>(std::min<size_t>(
+					std::lower_bound(cumulativeArea.begin(), cumulativeArea.end(), pick) - cumulativeArea.begin(), item.triangleCount - 1));
+				const auto& triangle = triangles[item.firstTriangle + index];
+				float u = unit(rng), v = unit(rng);
+				if (u + v > 1.f) { u = 1.f - u; v = 1.f - v; }
+				item.targets.push_back(triangle.v0 + u * (triangle.v1 - triangle.v0) + v * (triangle.v2 - triangle.v0));
+			}
+		}
+
+		const TriangleBvh bvh{ std::move(triangles) };
+
+		// Сетка ячеек над навигационным пространством
+		const Aabb bounds = settings.navigableBounds.isValid() ? settings.navigableBounds : sceneBox;
+		pvs.origin = bounds.min;
+		pvs.cellSize = settings.cellSize;
+		const glm::vec3 gridSize = (bounds.max - bounds.min) / settings.cellSize;
+		pvs.dimensions = glm::uvec3{
+			std::max(1u, static_cast<uint32_t>(std::ceil(gridSize.x))),
+			std::max(1u, static_cast<uint32_t>(std::ceil(gridSize.y))),
+			std::max(1u, static_cast<uint32_t>(std::ceil(gridSize.z))) };
+		const uint32_t cellCount = pvs.dimensions.x * pvs.dimensions.y * pvs.dimensions.z;
+		const uint32_t bytesPerSet = (pvs.itemCount + 7) / 8;
+		std::vector<std::vector<uint8_t>> cellVisibility(cellCount, std::vector<uint8_t>(bytesPerSet, 0));
+
+		std::atomic<uint32_t> nextCell{ 0 };
+		std::atomic<uint64_t> raysCast{ 0 };
+		auto bakeCells = [&]()
+		{
+			uint64_t localRays = 0;
+			for (uint32_t cell = nextCell++; cell < cellCount; cell = nextCell++)
+			{
+				const glm::uvec3 coords{ cell % pvs.dimensions.x, (cell / pvs.dimensions.x) % pvs.dimensions.y, cell / (pvs.dimensions.x * pvs.dimensions.y) };
+				const glm::vec3 cellMin = pvs.origin + glm::vec3(coords) * settings.cellSize;
+
+				// Точки-источники: центр ячейки и случайные точки внутри неё
+				std::mt19937 rng{ cell * 2654435761u + 17u };
+				std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+				std::vector<glm::vec3> sources{ cellMin + glm::vec3{ .5f * settings.cellSize } };
+				for (uint32_t s = 1; s < settings.samplesPerCell; ++s)
+				{
+					sources.push_back(cellMin + glm::vec3{ unit(rng), unit(rng), unit(rng) } * settings.cellSize);
+				}
+				const Aabb cellBox{ cellMin, cellMin + glm::vec3{ settings.cellSize } };
+
+				auto& visibility = cellVisibility[cell];
+				for (uint32_t itemIndex = 0; itemIndex < items.size(); ++itemIndex)
+				{
+					const Item& item = items[itemIndex];
+					// Элементы без геометрии и элементы, пересекающие ячейку, видимы всегда
+					bool visible = item.triangleCount == 0 || item.box.overlaps(cellBox);
+					for (size_t t = 0; !visible && t < item.targets.size(); ++t)
+					{
+						for (size_t s = 0; !visible && s < sources.size(); ++s)
+						{
+							++localRays;
+							visible = !bvh.isSegmentBlocked(sources[s], item.targets[t], itemIndex);
+						}
+					}
+					if (visible) visibility[itemIndex >> 3] |= static_cast<uint8_t>(1u << (itemIndex & 7));
+				}
+			}
+			raysCast += localRays;
+		};
+
+		const uint32_t threadCount = settings.threadCount != 0 ? settings.threadCount : std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::thread> workers;
+		for (uint32_t i = 1; i < threadCount; ++i) workers.emplace_back(bakeCells);
+		bakeCells();
+		for (auto& worker : workers) worker.join();
+
+		// Одинаковые множества хранятся один раз
+		std::map<std::vector<uint8_t>, uint32_t> setIndices;
+		pvs.cellSets.resize(cellCount);
+		for (uint32_t cell = 0; cell < cellCount; ++cell)
+		{
+			auto inserted = setIndices.emplace(cellVisibility[cell], static_cast<uint32_t>(pvs.uniqueSets.size()));
+			if (inserted.second) pvs.uniqueSets.push_back(cellVisibility[cell]);
+			pvs.cellSets[cell] = inserted.first->second;
+		}
+
+		statistics.bakeTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+		statistics.raysCast = raysCast;
+		statistics.cellCount = cellCount;
+		statistics.itemCount = pvs.itemCount;
+		statistics.uniqueSetCount = static_cast<uint32_t>(pvs.uniqueSets.size());
+		return pvs;
+	}
+}
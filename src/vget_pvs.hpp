@@ -0,0 +1,99 @@
+#pragma once
+
+#include "vget_bounds.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vget
+{
+	// Потенциально видимые множества (Potentially Visible Set) для статичных сцен.
+	// Навигационное пространство разбито на равномерную сетку ячеек, и для каждой ячейки хранится битовое множество
+	// видимых из неё элементов. Элемент - это подобъект модели (или вся модель, если подобъектов у неё нет).
+	// Одинаковые множества соседних ячеек хранятся в файле один раз.
+	class VgetPvs
+	{
+	public:
+		// Описание объекта сцены, для которого запекалась видимость. Объекты сопоставляются по имени.
+		struct ObjectEntry
+		{
+			std::string name;
+			uint32_t firstItem;
+			uint32_t itemCount;
+		};
+
+		VgetPvs() = default;
+
+		void load(const std::string& filepath);
+		void save(const std::string& filepath) const;
+		bool empty() const { return cellSets.empty(); }
+
+		// Сопоставление объекта сцены (по имени) с данными PVS. Объекты без данных считаются видимыми всегда.
+		void bindObject(uint32_t objectId, const std::string& name);
+		// Выбор текущей ячейки по позиции камеры. Вне сетки (или без данных) всё считается видимым.
+		void selectCell(const glm::vec3& position);
+		int32_t findCell(const glm::vec3& position) const;
+		int32_t getCurrentCell() const { return currentCell; }
+
+		bool isObjectVisible(uint32_t objectId) const;
+		bool isSubObjectVisible(uint32_t objectId, uint32_t subObjectIndex) const;
+		bool isItemVisible(int32_t cell, uint32_t item) const;
+
+		glm::vec3 origin{ 0.f };	// угол сетки с минимальными координатами
+		float cellSize = 1.f;
+		glm::uvec3 dimensions{ 0 };
+		uint32_t itemCount = 0;
+		std::vector<ObjectEntry> objects;
+		std::vector<std::vector<uint8_t>> uniqueSets;	// уникальные битовые множества видимых элементов
+		std::vector<uint32_t> cellSets;					// индекс множества для каждой ячейки (x + y * dx + z * dx * dy)
+
+	private:
+		std::unordered_map<uint32_t, uint32_t> boundObjects;	// id объекта сцены -> индекс в objects
+		int32_t currentCell = -1;
+	};
+
+	// Офлайн запекание PVS: из каждой ячейки сетки трассируются лучи к случайным точкам на треугольниках каждого
+	// элемента, и элемент считается видимым, если хотя бы один луч дошёл до него. Ячейки обрабатываются на всех ядрах,
+	// а генератор случайных чисел инициализируется индексом ячейки, поэтому результат не зависит от числа потоков.
+	class VgetPvsBaker
+	{
+	public:
+		// Геометрия объекта в мировом пространстве. Каждый подобъект задаётся диапазоном индексов.
+		struct Object
+		{
+			std::string name;
+			std::vector<glm::vec3> positions;
+			std::vector<uint32_t> indices;
+			std::vector<glm::uvec2> subObjects;	// (indexStart, indexCount); пустой - весь объект один элемент
+		};
+
+		struct Settings
+		{
+			Aabb navigableBounds{};			// по умолчанию - объём всей сцены
+			float cellSize = 2.f;
+			uint32_t samplesPerCell = 16;	// точек-источников лучей в каждой ячейке
+			uint32_t samplesPerItem = 64;	// точек-целей на поверхности каждого элемента
+			uint32_t threadCount = 0;		// 0 - по количеству аппаратных потоков
+		};
+
+		struct Statistics
+		{
+			double bakeTimeMs = 0.0;
+			uint64_t raysCast = 0;
+			uint32_t cellCount = 0;
+			uint32_t itemCount = 0;
+			uint32_t uniqueSetCount = 0;
+		};
+
+		void addObject(Object object) { objects.push_back(std::move(object)); }
+		VgetPvs bake(const Settings& settings);
+		const Statistics& getStatistics() const { return statistics; }
+
+	private:
+		std::vector<Object> objects;
+		Statistics statistics{};
+	};
+}
@@ -0,0 +1,147 @@
+#include "vget_render_stats.hpp"
+
+// std
+#include <algorithm>
+
+namespace vget
+{
+	VgetRenderStats::CounterSideScope::CounterSideScope(CounterSide side) : previous{ threadSide() }
+	{
+		threadSide() = side;
+	}
+
+	VgetRenderStats::CounterSideScope::~CounterSideScope()
+	{
+		threadSide() = previous;
+	}
+
+	CounterSide& VgetRenderStats::threadSide()
+	{
+		thread_local CounterSide side = CounterSide::Render;
+		return side;
+	}
+
+	VgetRenderStats& VgetRenderStats::get()
+	{
+		static VgetRenderStats stats{};
+		return stats;
+	}
+
+	void VgetRenderStats::addCommandStats(const CommandStats& stats)
+	{
+		add(RenderCounter::Draws, stats.draws);
+		add(RenderCounter::Instances, stats.instances);
+		add(RenderCounter::Triangles, stats.triangles);
+		add(RenderCounter::PipelineBinds, stats.pipelineBinds);
+		add(RenderCounter::DescriptorSetBinds, stats.descriptorSetBinds);
+		add(RenderCounter::VertexBufferBinds, stats.vertexBufferBinds);
+		add(RenderCounter::IndexBufferBinds, stats.indexBufferBinds);
+		add(RenderCounter::PushConstantBytes, stats.pushConstantBytes);
+	}
+
+	const char* VgetRenderStats::getName(RenderCounter counter)
+	{
+		static constexpr const char* NAMES[RENDER_COUNTER_COUNT] = {
+			"draws",
+			"instances",
+			"triangles",
+			"pipelineBinds",
+			"descriptorSetBinds",
+			"vertexBufferBinds",
+			"indexBufferBinds",
+			"pushConstantBytes",
+			"descriptorWrites",
+			"uploadBytes",
+			"queueSubmits",
+		};
+		return NAMES[static_cast<size_t>(counter)];
+	}
+
+	RenderCounterValues VgetRenderStats::takeUpdateCounters()
+	{
+		auto& updateCounters = counters[static_cast<size_t>(CounterSide::Update)];
+		RenderCounterValues result{};
+		for (size_t i = 0; i < RENDER_COUNTER_COUNT; ++i)
+		{
+			result[i] = updateCounters[i].exchange(0, std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	RenderCounters VgetRenderStats::endFrame(const RenderCounterValues& updateCounters)
+	{
+		auto& renderCounters = counters[static_cast<size_t>(CounterSide::Render)];
+		RenderCounters result{};
+		result.frame = ++frameCount;
+		for (size_t i = 0; i < RENDER_COUNTER_COUNT; ++i)
+		{
+			result.values[i] = renderCounters[i].exchange(0, std::memory_order_relaxed) + updateCounters[i];
+		}
+		return result;
+	}
+
+	void RenderCounterHistory::push(const RenderCounters& counters)
+	{
+		if (counters.frame == 0 || counters.frame == last.frame) return;
+		last = counters;
+		frames[next] = counters;
+		next = (next + 1) % FRAME_COUNT;
+		count = std::min(count + 1, FRAME_COUNT);
+	}
+
+	double RenderCounterHistory::average(RenderCounter counter) const
+	{
+		if (count == 0) return 0.0;
+		double sum = 0.0;
+		for (uint32_t i = 0; i < count; ++i) sum += static_cast<double>(frames[i][counter]);
+		return sum / count;
+	}
+
+	uint64_t RenderCounterHistory::max(RenderCounter counter) const
+	{
+		uint64_t result = 0;
+		for (uint32_t i = 0; i < count; ++i) result = std::max(result, frames[i][counter]);
+		return result;
+	}
+
+	uint32_t RenderCounterHistory::fill(RenderCounter counter, std::array<float, FRAME_COUNT>& out) const
+	{
+		// Пока окно не заполнено, самый старый кадр лежит в начале массива
+		const uint32_t first = count < FRAME_COUNT ? 0 : next;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			out[i] = static_cast<float>(frames[(first + i) % FRAME_COUNT][counter]);
+		}
+		return count;
+	}
+
+	bool VgetRenderStatsCsv::open(const std::string& filepath)
+	{
+		file.open(filepath, std::ios::trunc);
+		if (!file.is_open()) return false;
+
+		file << "frame";
+		for (size_t i = 0; i < RENDER_COUNTER_COUNT; ++i)
+		{
+			file << ',' << VgetRenderStats::getName(static_cast<RenderCounter>(i));
+		}
+		file << '\n';
+		lastFrame = 0;
+		return true;
+	}
+
+	void VgetRenderStatsCsv::close()
+	{
+		file.close();
+	}
+
+	void VgetRenderStatsCsv::write(const RenderCounters& counters)
+	{
+		if (!file.is_open() || counters.frame == 0 || counters.frame == lastFrame) return;
+		lastFrame = counters.frame;
+
+		file << counters.frame;
+		for (const uint64_t value : counters.values) file << ',' << value;
+		file << '\n';
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "vget_command_recorder.hpp"
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace vget
+{
+	// Счётчики рендера за кадр. Порядок совпадает с колонками CSV и строками окна статистики.
+	enum class RenderCounter : uint32_t
+	{
+		Draws,					// команды отрисовки
+		Instances,				// экземпляры всех отрисовок
+		Triangles,				// треугольники всех экземпляров
+		PipelineBinds,			// записанные привязки (повторы, отброшенные рекордером, не считаются)
+		DescriptorSetBinds,
+		VertexBufferBinds,
+		IndexBufferBinds,
+		PushConstantBytes,
+		DescriptorWrites,		// дескрипторы, записанные в таблицу текстур
+		UploadBytes,			// байты, записанные CPU в видимую хосту память буферов (промежуточные, uniform, storage)
+		QueueSubmits,			// вызовы vkQueueSubmit
+		Count
+	};
+
+	constexpr size_t RENDER_COUNTER_COUNT = static_cast<size_t>(RenderCounter::Count);
+
+	using RenderCounterValues = std::array<uint64_t, RENDER_COUNTER_COUNT>;
+
+	// Стадия кадра, к которой относятся счётчики, увеличенные потоком
+	enum class CounterSide : uint32_t
+	{
+		Render,	// кадр, который рендерится сейчас (по умолчанию для всех потоков)
+		Update,	// снимок, который заполняет поток обновления и который отрендерится позже
+		Count
+	};
+
+	// Значения счётчиков за один кадр
+	struct RenderCounters
+	{
+		uint64_t frame = 0;		// номер кадра с единицы; 0 - значений ещё нет
+		RenderCounterValues values{};
+
+		uint64_t operator[](RenderCounter counter) const { return values[static_cast<size_t>(counter)]; }
+	};
+
+	// Реестр счётчиков рендера. Счётчики увеличиваются из любых потоков (атомарно, relaxed), а кадр закрывается
+	// вызовом endFrame() из потока рендера после отправки кадра. Команды вторичных буферов считает сам
+	// VgetCommandRecorder без атомарных операций, а в реестр они попадают одним вызовом addCommandStats() за кадр.
+	//
+	// В многопоточном режиме поток обновления готовит следующий снимок, пока рендерится предыдущий. Поэтому его
+	// счётчики (внутри CounterSideScope с CounterSide::Update) копятся отдельно: takeUpdateCounters() забирает их
+	// в снимок, а endFrame() при рендере этого снимка добавляет их к строке того же кадра.
+	class VgetRenderStats
+	{
+	public:
+		// Стадия, к которой относятся счётчики текущего потока, пока жива область
+		class CounterSideScope
+		{
+		public:
+			explicit CounterSideScope(CounterSide side);
+			~CounterSideScope();
+
+			CounterSideScope(const CounterSideScope&) = delete;
+			CounterSideScope& operator=(const CounterSideScope&) = delete;
+
+		private:
+			CounterSide previous;
+		};
+
+		static VgetRenderStats& get();
+
+		VgetRenderStats(const VgetRenderStats&) = delete;
+		VgetRenderStats& operator=(const VgetRenderStats&) = delete;
+
+		static void add(RenderCounter counter, uint64_t value = 1)
+		{
+			get().counters[static_cast<size_t>(threadSide())][static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+		}
+		static void addCommandStats(const CommandStats& stats);
+		static const char* getName(RenderCounter counter);
+
+		// Счётчики стадии обновления, накопленные с прошлого вызова (обнуляются). Вызывается перед отправкой снимка.
+		RenderCounterValues takeUpdateCounters();
+		// Счётчики стадии рендера, накопленные с прошлого вызова (обнуляются), вместе с updateCounters -
+		// счётчиками обновления, сохранёнными в рендерящемся снимке
+		RenderCounters endFrame(const RenderCounterValues& updateCounters = {});
+
+	private:
+		VgetRenderStats() = default;
+
+		static CounterSide& threadSide();
+
+		std::array<std::array<std::atomic<uint64_t>, RENDER_COUNTER_COUNT>, static_cast<size_t>(CounterSide::Count)> counters{};
+		uint64_t frameCount = 0;
+	};
+
+	// Последние кадры для среднего, максимума и графика в окне статистики.
+	// Повторная запись того же кадра (снимок, который не рендерился) пропускается.
+	class RenderCounterHistory
+	{
+	public:
+		static constexpr uint32_t FRAME_COUNT = 120;
+
+		void push(const RenderCounters& counters);
+
+		const RenderCounters& getLast() const { return last; }
+		uint32_t getFrameCount() const { return count; }
+		double average(RenderCounter counter) const;
+		uint64_t max(RenderCounter counter) const;
+		// Значения счётчика от старого кадра к новому, возвращает их количество
+		uint32_t fill(RenderCounter counter, std::array<float, FRAME_COUNT>& out) const;
+
+	private:
+		std::array<RenderCounters, FRAME_COUNT> frames{};
+		RenderCounters last{};
+		uint32_t count = 0;
+		uint32_t next = 0;
+	};
+
+	// Покадровая выгрузка счётчиков в CSV: строка заголовка, затем строка на каждый новый кадр
+	class VgetRenderStatsCsv
+	{
+	public:
+		// false - файл не открылся
+		bool open(const std::string& filepath);
+		void close();
+		bool isOpen() const { return file.is_open(); }
+		void write(const RenderCounters& counters);
+
+	private:
+		std::ofstream file;
+		uint64_t lastFrame = 0;
+	};
+}
@@ -1,4 +1,5 @@
 #include "vget_renderer.hpp"
+#include "vget_cpu_profiler.hpp"
 
 // std
 #include <stdexcept>
@@ -7,12 +8,18 @@
 
 namespace vget
 {
-	VgetRenderer::VgetRenderer(VgetWindow& window, VgetDevice& device) : vgetWindow{ window }, vgetDevice{ device }
+	VgetRenderer::VgetRenderer(VgetWindow& window, VgetDevice& device) : vgetWindow{ &window }, vgetDevice{ device }
 	{
 		recreateSwapChain();
 		createCommandBuffers();
 	}
 
+	VgetRenderer::VgetRenderer(VgetDevice& device, VkExtent2D extent) : vgetDevice{ device }
+	{
+		offscreenTarget = std::make_unique<VgetOffscreenTarget>(vgetDevice, extent);
+		createCommandBuffers();
+	}
+
 	VgetRenderer::~VgetRenderer()
 	{
 		freeCommandBuffers();
@@ -21,7 +28,7 @@ namespace vget
 	// Пересоздать SwapChain
 	void VgetRenderer::recreateSwapChain()
 	{
-		auto extent = vgetWindow.getExtent();
+		auto extent = vgetWindow->getExtent();
 
 		// Если ширина или высота окна не имеют размера, то поток выполнения пристанавливается функцией glfwWaitEvents()
 		// и ждёт пока не появится какое-либо событие на обработку. С появлением события размеры окна перепроверяются, и
@@ -29,11 +36,15 @@ namespace vget
 		// (сворачивания) окна.
 		while (extent.width == 0 || extent.height == 0)
 		{
-			extent = vgetWindow.getExtent();
-			glfwWaitEvents();
+			extent = vgetWindow->getExtent();
+			vgetWindow->waitEvents();
 		}
 
-		vkDeviceWaitIdle(vgetDevice.device()); // ожидание, пока старый SwapChain не перестанет использоваться девайсом
+		{
+			// vkDeviceWaitIdle требует синхронизации со всеми очередями девайса
+			std::lock_guard<std::mutex> lock{ vgetDevice.getQueueMutex() };
+			vkDeviceWaitIdle(vgetDevice.device()); // ожидание, пока старый SwapChain не перестанет использоваться девайсом
+		}
 
 		if (vgetSwapChain == nullptr)
 		{
@@ -88,22 +99,31 @@ namespace vget
 
 	VkCommandBuffer VgetRenderer::beginFrame()
 	{
+		VGET_PROFILE_ZONE("VgetRenderer::beginFrame");
 		assert(!isFrameStarted && "Can't call beginFrame while already in progress");
 
-		// функция возврашает в currentImageIndex номер следующего FrameBuffer'а для рендеринга
-		auto result = vgetSwapChain->acquireNextImage(&currentImageIndex);
-
-		// Если result получил ошибку OUT_OF_DATE, значит свойства поверхности, на которую выводятся кадры, изменились.
-		// Например, она возникает при изменении размера окна. В этом случае приложение должно пересоздать свой SwapChain для новых размеров.
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		// Без окна изображение кадра всегда доступно после ожидания его забора
+		if (isHeadless())
 		{
-			recreateSwapChain();
-			return nullptr;
+			offscreenTarget->acquireNextImage(&currentImageIndex);
 		}
-
-		if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		else
 		{
-			throw std::runtime_error("failed to acquire swap chain image!");
+			// функция возврашает в currentImageIndex номер следующего FrameBuffer'а для рендеринга
+			auto result = vgetSwapChain->acquireNextImage(&currentImageIndex);
+
+			// Если result получил ошибку OUT_OF_DATE, значит свойства поверхности, на которую выводятся кадры, изменились.
+				// Например, она возникает при изменении размера окна. В этом случае приложение должно пересоздать свой SwapChain для новых размеров.
+			if (result == VK_ERROR_OUT_OF_DATE_KHR)
+			{
+				recreateSwapChain();
+				return nullptr;
+			}
+
+			if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+			{
+				throw std::runtime_error("failed to acquire swap chain image!");
+			}
 		}
 
 		// Начинаем создание кадра со старта записи в текущем буфере команд
@@ -124,6 +144,7 @@ namespace vget
 
 	void VgetRenderer::endFrame()
 	{
+		VGET_PROFILE_ZONE("VgetRenderer::endFrame");
 		assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
 		auto commandBuffer = getCurrentCommandBuffer();
 
@@ -132,6 +153,14 @@ namespace vget
 			throw std::runtime_error("failed to record command buffer!");
 		}
 
+		if (isHeadless())
+		{
+			offscreenTarget->submitCommandBuffers(&commandBuffer);
+			isFrameStarted = false;
+			currentFrameIndex = (currentFrameIndex + 1) % VgetSwapChain::MAX_FRAMES_IN_FLIGHT;
+			return;
+		}
+
 		// Отправка буфера команд для соответствующего кадра в очередь на выполнение девайсом (с учётом синхронизации работы CPU и GPU).
 		// Команды выполняются и SwapChain предоставляет полученное из Color attachment'а изображение дисплею в нужное время (в зависимости от выбранного PRESENT MODE).
 		auto result = vgetSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
@@ -139,9 +168,9 @@ namespace vget
 		/* Проверка изменения размеров окна, сброс флага, пересоздание цепи обмена.
 		   Результат SUBOPTIMAL_KHR позволяет отловить случаи, когда свойства поверхности изменились, но SwapChain
 		   по прежнему может продолжать вывод изображения. Здесь мы избавляемся от таких ситуаций тоже. */
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vgetWindow.wasWindowResized())
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vgetWindow->wasWindowResized())
 		{
-			vgetWindow.resetWindowsResizedFlag();
+			vgetWindow->resetWindowsResizedFlag();
 			recreateSwapChain();
 		}
 		else if (result != VK_SUCCESS)
@@ -153,7 +182,7 @@ namespace vget
 		currentFrameIndex = (currentFrameIndex + 1) % VgetSwapChain::MAX_FRAMES_IN_FLIGHT; // выбираем следующий кадр
 	}
 
-	void VgetRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, ImVec4 clearColors)
+	void VgetRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, ImVec4 clearColors, VkSubpassContents contents)
 	{
 		assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame");
@@ -161,11 +190,11 @@ namespace vget
 		// Первой записывается команда старта RenderPass, поэтому заполняем информацию о ней
 		VkRenderPassBeginInfo renderPassInfo{};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = vgetSwapChain->getRenderPass();
-		renderPassInfo.framebuffer = vgetSwapChain->getFrameBuffer(currentImageIndex);
+		renderPassInfo.renderPass = getSwapChainRenderPass();
+		renderPassInfo.framebuffer = getCurrentFramebuffer();
 
 		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = vgetSwapChain->getSwapChainExtent();
+		renderPassInfo.renderArea.extent = getSwapChainExtent();
 
 		// clear values задают начальные значения вложений (attachments) у FrameBuffer
 		// буферы вложений заполняются этими значениями во время операции очистки перед новым проходом рендеринга
@@ -176,7 +205,10 @@ namespace vget
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE); // начинаем проход рендера
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents); // начинаем проход рендера
+
+		// Проход из вторичных буферов не допускает других команд в основном буфере - Viewport и Scissor ставят сами вторичные буферы
+		if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) return;
 
 		/* Ширина и высота изображения берутся из SwapChain, т.к. они могут отличаться от ширины и высоты из окна VgetWindow.
 		   Например, такой эффект есть при использовании Retina дисплеев (Apple), у которых высокая плотность пикселей.
@@ -187,12 +219,12 @@ namespace vget
 		VkViewport viewport{};
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(vgetSwapChain->getSwapChainExtent().width);
-		viewport.height = static_cast<float>(vgetSwapChain->getSwapChainExtent().height);
+		viewport.width = static_cast<float>(getSwapChainExtent().width);
+		viewport.height = static_cast<float>(getSwapChainExtent().height);
 		viewport.minDepth = 0.0f;
 		viewport.maxDepth = 1.0f;
 		// Scissor (ножницы) - обрезка выводимых пикселей вне заданного Scissor Rectangle
-		VkRect2D scissor{ {0, 0}, vgetSwapChain->getSwapChainExtent() };
+		VkRect2D scissor{ {0, 0}, getSwapChainExtent() };
 
 		// Запись различных команд
 		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);  // установка viewport объекта
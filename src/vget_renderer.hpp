@@ -2,6 +2,7 @@
 
 #include "vget_window.hpp"
 #include "vget_swap_chain.hpp"
+#include "vget_offscreen_target.hpp"
 #include "vget_device.hpp"
 #include "vget_imgui.hpp"
 
@@ -17,6 +18,8 @@ namespace vget
 	public:
 
 		VgetRenderer(VgetWindow& window, VgetDevice& device);
+		// Режим без окна: кадры размера extent рендерятся в VgetOffscreenTarget, темп задают заборы кадров
+		VgetRenderer(VgetDevice& device, VkExtent2D extent);
 		~VgetRenderer();
 
 		// Избавляемся от copy operator и copy constructor, т.к. VgetRenderer хранит в себе указатели
@@ -24,9 +27,28 @@ namespace vget
 		VgetRenderer(const VgetRenderer&) = delete;
 		VgetRenderer& operator=(const VgetRenderer&) = delete;
 
-		VkRenderPass getSwapChainRenderPass() const { return vgetSwapChain->getRenderPass(); }
-		float getAspectRatio() const {return vgetSwapChain->extentAspectRatio();}
+		VkRenderPass getSwapChainRenderPass() const
+		{
+			return isHeadless() ? offscreenTarget->getRenderPass() : vgetSwapChain->getRenderPass();
+		}
+		VkFramebuffer getCurrentFramebuffer() const
+		{
+			assert(isFrameStarted && "Cannot get framebuffer when frame not in progress");
+			const int index = static_cast<int>(currentImageIndex);
+			return isHeadless() ? offscreenTarget->getFrameBuffer(index) : vgetSwapChain->getFrameBuffer(index);
+		}
+		float getAspectRatio() const
+		{
+			return isHeadless() ? offscreenTarget->extentAspectRatio() : vgetSwapChain->extentAspectRatio();
+		}
+		VkExtent2D getSwapChainExtent() const
+		{
+			return isHeadless() ? offscreenTarget->getExtent() : vgetSwapChain->getSwapChainExtent();
+		}
 		bool isFrameInProgress() const { return isFrameStarted; }
+		bool isHeadless() const { return vgetWindow == nullptr; }
+		// Цель рендера без окна (nullptr в оконном режиме)
+		VgetOffscreenTarget* getOffscreenTarget() const { return offscreenTarget.get(); }
 
 		VkCommandBuffer getCurrentCommandBuffer() const
 		{
@@ -42,7 +64,9 @@ namespace vget
 
 		VkCommandBuffer beginFrame();
 		void endFrame();
-		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, ImVec4 clearColors);
+		// contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS - содержимое прохода пишется во вторичные буферы (VgetPassRecorder)
+		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, ImVec4 clearColors,
+			VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
 	private:
@@ -50,9 +74,10 @@ namespace vget
 		void freeCommandBuffers();
 		void recreateSwapChain();
 
-		VgetWindow& vgetWindow;
+		VgetWindow* vgetWindow = nullptr;	// nullptr - режим без окна
 		VgetDevice& vgetDevice;
 		std::unique_ptr<VgetSwapChain> vgetSwapChain;
+		std::unique_ptr<VgetOffscreenTarget> offscreenTarget;
 		std::vector<VkCommandBuffer> commandBuffers;
 
 		uint32_t currentImageIndex;
@@ -0,0 +1,128 @@
+#include "vget_sampler_cache.hpp"
+#include "vget_device.hpp"
+#include "vget_utils.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace vget
+{
+	VgetSamplerCache::Key::Key(const VkSamplerCreateInfo& info)
+		: flags{ info.flags },
+		magFilter{ info.magFilter },
+		minFilter{ info.minFilter },
+		mipmapMode{ info.mipmapMode },
+		addressModeU{ info.addressModeU },
+		addressModeV{ info.addressModeV },
+		addressModeW{ info.addressModeW },
+		mipLodBias{ info.mipLodBias },
+		anisotropyEnable{ info.anisotropyEnable },
+		maxAnisotropy{ info.maxAnisotropy },
+		compareEnable{ info.compareEnable },
+		compareOp{ info.compareOp },
+		minLod{ info.minLod },
+		maxLod{ info.maxLod },
+		borderColor{ info.borderColor },
+		unnormalizedCoordinates{ info.unnormalizedCoordinates }
+	{
+	}
+
+	bool VgetSamplerCache::Key::operator==(const Key& other) const
+	{
+		return flags == other.flags &&
+			magFilter == other.magFilter &&
+			minFilter == other.minFilter &&
+			mipmapMode == other.mipmapMode &&
+			addressModeU == other.addressModeU &&
+			addressModeV == other.addressModeV &&
+			addressModeW == other.addressModeW &&
+			mipLodBias == other.mipLodBias &&
+			anisotropyEnable == other.anisotropyEnable &&
+			maxAnisotropy == other.maxAnisotropy &&
+			compareEnable == other.compareEnable &&
+			compareOp == other.compareOp &&
+			minLod == other.minLod &&
+			maxLod == other.maxLod &&
+			borderColor == other.borderColor &&
+			unnormalizedCoordinates == other.unnormalizedCoordinates;
+	}
+
+	size_t VgetSamplerCache::KeyHash::operator()(const Key& key) const
+	{
+		size_t seed = 0;
+		hashCombine(seed, key.flags, key.magFilter, key.minFilter, key.mipmapMode,
+			key.addressModeU, key.addressModeV, key.addressModeW, key.mipLodBias,
+			key.anisotropyEnable, key.maxAnisotropy, key.compareEnable, key.compareOp,
+			key.minLod, key.maxLod, key.borderColor, key.unnormalizedCoordinates);
+		return seed;
+	}
+
+	VgetSamplerCache::VgetSamplerCache(VgetDevice& device) : vgetDevice{device} {}
+
+	VgetSamplerCache::~VgetSamplerCache()
+	{
+		for (auto& kv : samplers)
+		{
+			vkDestroySampler(vgetDevice.device(), kv.second, nullptr);
+		}
+	}
+
+	VkSampler VgetSamplerCache::getSampler(const VkSamplerCreateInfo& samplerInfo)
+	{
+		assert(samplerInfo.pNext == nullptr && "Sampler cache does not support pNext chains");
+
+		const Key key{ samplerInfo };
+		std::lock_guard<std::mutex> lock{ mutex };
+		auto it = samplers.find(key);
+		if (it != samplers.end()) return it->second;
+
+		VkSampler sampler;
+		if (vkCreateSampler(vgetDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create texture sampler!");
+		}
+		samplers.emplace(key, sampler);
+		return sampler;
+	}
+
+	VkSampler VgetSamplerCache::getSampler(SamplerPreset preset)
+	{
+		return getSampler(presetInfo(preset, vgetDevice.properties.limits.maxSamplerAnisotropy));
+	}
+
+	uint32_t VgetSamplerCache::getSamplerCount() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return static_cast<uint32_t>(samplers.size());
+	}
+
+	VkSamplerCreateInfo VgetSamplerCache::presetInfo(SamplerPreset preset, float maxAnisotropy)
+	{
+		const bool linear = preset != SamplerPreset::NearestRepeat;
+		const VkSamplerAddressMode addressMode = preset == SamplerPreset::LinearClamp
+			? VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE		// координаты за пределами изображения прижимаются к краю
+			: VK_SAMPLER_ADDRESS_MODE_REPEAT;			// повторять текстуру, если координата выходит за пределы изображения
+
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST; // Фильтрация для увеличенных (magnified) текселей. Это случай, когда их больше, чем фрагментов (oversampling)
+		samplerInfo.minFilter = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST; // Для уменьшенных (minified) текселей. Это случай, когда их меньше, чем фрагментов (undersampling)
+		// Режим адресации цвета по заданной оси. U, V, W используются вместо X, Y и Z по соглашению для координат пространства текстуры
+		samplerInfo.addressModeU = addressMode;
+		samplerInfo.addressModeV = addressMode;
+		samplerInfo.addressModeW = addressMode;
+		samplerInfo.anisotropyEnable = linear ? VK_TRUE : VK_FALSE;
+		samplerInfo.maxAnisotropy = linear ? maxAnisotropy : 1.0f; // макс. кол-во текселей для расчёт финального цвета при анизотропной фильтрации
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;	// координаты будут адресоваться в диапазоне [0;1), т.е. они нормализованы для универсального использования
+		samplerInfo.compareEnable = VK_FALSE;			// функция сравнения выбранного текселя с заданным значением отключена (исп. в precentage-closer фильтрации в картах теней)
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		// поля для настройки мипмэппинга
+		samplerInfo.mipmapMode = linear ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.mipLodBias = 0.0f;
+		samplerInfo.minLod = 0.0f;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+		return samplerInfo;
+	}
+}
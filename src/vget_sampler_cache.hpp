@@ -0,0 +1,84 @@
+#pragma once
+
+// libs
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace vget
+{
+	class VgetDevice;
+
+	// Часто используемые наборы параметров выборщика. В режиме раздельных изображений и выборщиков
+	// (VGET_SEPARATE_SAMPLERS) они же становятся неизменяемыми выборщиками таблицы текстур, а номер
+	// набора передаётся в шейдер вместе со слотом текстуры.
+	enum class SamplerPreset : uint32_t
+	{
+		LinearRepeat,	// трилинейная анизотропная фильтрация с повторением текстуры
+		LinearClamp,	// то же, но координаты прижимаются к краю изображения
+		NearestRepeat,	// без фильтрации, для пиксельных и служебных текстур
+		Count
+	};
+
+	constexpr uint32_t SAMPLER_PRESET_COUNT = static_cast<uint32_t>(SamplerPreset::Count);
+
+	// Общий для девайса кэш VkSampler'ов. Выборщики с одинаковыми параметрами не различаются, поэтому текстуры
+	// получают готовый объект по полному VkSamplerCreateInfo, а не создают собственный: число выборщиков ограничено
+	// maxSamplerAllocationCount. Выборщики живут до уничтожения кэша вместе с девайсом.
+	class VgetSamplerCache
+	{
+	public:
+		explicit VgetSamplerCache(VgetDevice& device);
+		~VgetSamplerCache();
+
+		VgetSamplerCache(const VgetSamplerCache&) = delete;
+		VgetSamplerCache& operator=(const VgetSamplerCache&) = delete;
+
+		// Выборщик с заданными параметрами, при первом запросе создаётся (из любого потока).
+		// pNext должен быть пустым: цепочки расширений не входят в ключ кэша.
+		VkSampler getSampler(const VkSamplerCreateInfo& samplerInfo);
+		VkSampler getSampler(SamplerPreset preset);
+		uint32_t getSamplerCount() const;
+
+		// Параметры набора. Диапазон LOD не ограничен, т.к. количество мип-уровней задаёт вид изображения,
+		// и один выборщик подходит текстурам любого размера.
+		static VkSamplerCreateInfo presetInfo(SamplerPreset preset, float maxAnisotropy);
+
+	private:
+		// Все поля VkSamplerCreateInfo, кроме sType и pNext
+		struct Key
+		{
+			VkSamplerCreateFlags flags;
+			VkFilter magFilter;
+			VkFilter minFilter;
+			VkSamplerMipmapMode mipmapMode;
+			VkSamplerAddressMode addressModeU;
+			VkSamplerAddressMode addressModeV;
+			VkSamplerAddressMode addressModeW;
+			float mipLodBias;
+			VkBool32 anisotropyEnable;
+			float maxAnisotropy;
+			VkBool32 compareEnable;
+			VkCompareOp compareOp;
+			float minLod;
+			float maxLod;
+			VkBorderColor borderColor;
+			VkBool32 unnormalizedCoordinates;
+
+			explicit Key(const VkSamplerCreateInfo& info);
+			bool operator==(const Key& other) const;
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const;
+		};
+
+		VgetDevice& vgetDevice;
+		mutable std::mutex mutex;
+		std::unordered_map<Key, VkSampler, KeyHash> samplers;
+	};
+}
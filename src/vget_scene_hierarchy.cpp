@@ -0,0 +1,211 @@
+#include "vget_scene_hierarchy.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace vget
+{
+	VgetSceneHierarchy::VgetSceneHierarchy(VgetJobSystem* jobSystem) : jobSystem{ jobSystem }
+	{
+	}
+
+	void VgetSceneHierarchy::setParent(VgetWorld& world, Entity child, Entity parent)
+	{
+		// Смена родителя через удаление компонента: иначе присваивание не изменило бы версию ParentComponent
+		if (world.hasComponent<ParentComponent>(child)) world.removeComponent<ParentComponent>(child);
+		if (!parent.valid()) return;
+
+		for (Entity ancestor = parent; ancestor.valid();)
+		{
+			if (ancestor == child) throw std::runtime_error("failed to set parent: hierarchy cycle!");
+			const ParentComponent* link = world.getComponent<ParentComponent>(ancestor);
+			ancestor = link != nullptr ? link->parent : Entity{};
+		}
+		world.addComponent(child, ParentComponent{ parent });
+	}
+
+	void VgetSceneHierarchy::update(VgetWorld& world, VgetTransformBatch& transformBatch)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		if (world.getComponentVersion<ParentComponent>() != parentsVersion
+			|| (world.getStructureVersion() != structureVersion && !refreshTransforms(world)))
+		{
+			rebuild(world);
+		}
+		structureVersion = world.getStructureVersion();
+
+		updatedCount = 0;
+		const uint32_t nodeCount = getNodeCount();
+		if (nodeCount == 0)
+		{
+			updateTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			return;
+		}
+
+		// Локальные матрицы изменённых узлов считаются пакетом, а мировые матрицы корней совпадают с локальными
+		dirtyTransforms.clear();
+		dirtyNodes.clear();
+		for (uint32_t i = 0; i < nodeCount; ++i)
+		{
+			changed[i] = world.isChanged<TransformComponent>(entities[i]);
+			if (!changed[i]) continue;
+			world.resetChanged<TransformComponent>(entities[i]);
+			dirtyTransforms.push_back(transforms[i]);
+			dirtyNodes.push_back(i);
+		}
+		transformBatch.update(dirtyTransforms.data(), static_cast<uint32_t>(dirtyTransforms.size()));
+		for (const uint32_t node : dirtyNodes)
+		{
+			localMatrices[node] = transforms[node]->worldMatrix;
+			localNormalMatrices[node] = transforms[node]->worldNormalMatrix;
+		}
+
+		// Диапазоны не зависят друг от друга: узлы каждого читают только свой диапазон и уже готовые корни
+		if (jobSystem == nullptr || nodeCount < MIN_PARALLEL_NODES)
+		{
+			for (const auto& range : ranges) updatedCount += propagate(range.first, range.second);
+		}
+		else
+		{
+			std::atomic<uint32_t> updated{ 0 };
+			jobSystem->parallelFor(0, static_cast<uint32_t>(ranges.size()), 1, [&](uint32_t begin, uint32_t end)
+			{
+				uint32_t rangeUpdated = 0;
+				for (uint32_t i = begin; i < end; ++i) rangeUpdated += propagate(ranges[i].first, ranges[i].second);
+				updated += rangeUpdated;
+			});
+			updatedCount = updated;
+		}
+		updateTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	uint32_t VgetSceneHierarchy::propagate(uint32_t begin, uint32_t end)
+	{
+		uint32_t updated = 0;
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const int32_t parent = parents[i];
+			if (parent < 0)
+			{
+				updated += changed[i];
+				continue;
+			}
+			if (!changed[i] && !changed[parent]) continue;
+
+			changed[i] = 1;
+			transforms[i]->worldMatrix = transforms[parent]->worldMatrix * localMatrices[i];
+			// Матрица нормали произведения равна произведению матриц нормали (обратные транспонированные)
+			transforms[i]->worldNormalMatrix = transforms[parent]->worldNormalMatrix * localNormalMatrices[i];
+			++updated;
+		}
+		return updated;
+	}
+
+	void VgetSceneHierarchy::rebuild(VgetWorld& world)
+	{
+		// Дети каждого родителя. Узел, родитель которого уничтожен или лишился трансформации, становится корнем.
+		std::unordered_map<uint32_t, std::vector<Entity>> children;
+		std::vector<Entity> rootEntities;
+		world.forEach<TransformComponent, ParentComponent>([&](Entity entity, TransformComponent&, ParentComponent& link)
+		{
+			if (world.hasComponent<TransformComponent>(link.parent)) children[link.parent.index].push_back(entity);
+			else rootEntities.push_back(entity);
+		});
+		for (auto& kv : children)
+		{
+			const Entity parent = world.entityAt(kv.first);
+			if (!world.hasComponent<ParentComponent>(parent)) rootEntities.push_back(parent);
+
+			// Порядок детей не зависит от порядка хранения сущностей в архетипах
+			std::sort(kv.second.begin(), kv.second.end(), [](Entity a, Entity b) { return a.index < b.index; });
+		}
+		std::sort(rootEntities.begin(), rootEntities.end(), [](Entity a, Entity b) { return a.index < b.index; });
+
+		entities.clear();
+		parents.clear();
+		roots.clear();
+		std::vector<std::pair<Entity, int32_t>> stack;
+		for (const Entity root : rootEntities)
+		{
+			roots.push_back(static_cast<uint32_t>(entities.size()));
+			stack.emplace_back(root, -1);
+			while (!stack.empty())
+			{
+				const auto [entity, parent] = stack.back();
+				stack.pop_back();
+				const int32_t node = static_cast<int32_t>(entities.size());
+				entities.push_back(entity);
+				parents.push_back(parent);
+
+				auto nodeChildren = children.find(entity.index);
+				if (nodeChildren == children.end()) continue;
+				for (auto child = nodeChildren->second.rbegin(); child != nodeChildren->second.rend(); ++child)
+				{
+					stack.emplace_back(*child, node);
+				}
+			}
+		}
+
+		// В порядке обхода в глубину поддерево заканчивается там же, где поддерево его последнего потомка
+		const uint32_t nodeCount = getNodeCount();
+		subtreeEnds.resize(nodeCount);
+		for (uint32_t i = 0; i < nodeCount; ++i) subtreeEnds[i] = i + 1;
+		for (uint32_t i = nodeCount; i-- > 0;)
+		{
+			if (parents[i] >= 0) subtreeEnds[parents[i]] = std::max(subtreeEnds[parents[i]], subtreeEnds[i]);
+		}
+
+		refreshTransforms(world);
+		// Локальные матрицы всех узлов считаются заново
+		for (const Entity entity : entities) world.markChanged<TransformComponent>(entity);
+		localMatrices.resize(nodeCount);
+		localNormalMatrices.resize(nodeCount);
+		changed.assign(nodeCount, 0);
+		buildRanges();
+		parentsVersion = world.getComponentVersion<ParentComponent>();
+	}
+
+	bool VgetSceneHierarchy::refreshTransforms(VgetWorld& world)
+	{
+		transforms.resize(entities.size());
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			transforms[i] = world.getComponent<TransformComponent>(entities[i]);
+			if (transforms[i] == nullptr) return false;
+		}
+		return true;
+	}
+
+	void VgetSceneHierarchy::buildRanges()
+	{
+		// Разрезать массив можно перед корнем или перед ребёнком корня: мировые матрицы корней готовы до прохода
+		std::vector<uint32_t> cuts;
+		for (const uint32_t root : roots)
+		{
+			cuts.push_back(root);
+			for (uint32_t child = root + 1; child < subtreeEnds[root]; child = subtreeEnds[child])
+			{
+				cuts.push_back(child);
+			}
+		}
+
+		// Несколько диапазонов на поток, чтобы потоки выравнивались при неравных поддеревьях
+		const uint32_t nodeCount = getNodeCount();
+		const uint32_t threadCount = jobSystem != nullptr ? jobSystem->getWorkerCount() : 1u;
+		const uint32_t targetSize = std::max(1u, nodeCount / (threadCount * 4));
+		ranges.clear();
+		uint32_t begin = 0;
+		for (const uint32_t cut : cuts)
+		{
+			if (cut - begin < targetSize) continue;
+			ranges.emplace_back(begin, cut);
+			begin = cut;
+		}
+		if (begin < nodeCount) ranges.emplace_back(begin, nodeCount);
+	}
+}
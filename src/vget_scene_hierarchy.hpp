@@ -0,0 +1,76 @@
+#pragma once
+
+#include "vget_game_object.hpp"
+#include "vget_job_system.hpp"
+#include "vget_transforms.hpp"
+
+// std
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace vget
+{
+	// Иерархия сцены: сущности с ParentComponent и их родители, разложенные в плоские массивы в порядке обхода
+	// в глубину. Родитель в таком порядке всегда стоит раньше потомков, а поддерево узла занимает непрерывный
+	// диапазон [узел; subtreeEnd), поэтому мировые матрицы считаются одним проходом по массиву.
+	// Отметка об изменении трансформации распространяется на поддерево: пересчитываются только узлы, у которых изменилась
+	// своя трансформация или трансформация кого-то из предков. Поддеревья, которые не зависят друг от друга
+	// (корни и дети корней), обрабатываются параллельно.
+	class VgetSceneHierarchy
+	{
+	public:
+		// Узлов меньше этого числа обрабатываются в одном потоке: раздача задач дороже самого прохода
+		static constexpr uint32_t MIN_PARALLEL_NODES = 4096;
+
+		// Без планировщика задач (jobSystem == nullptr) иерархия обрабатывается в вызывающем потоке
+		explicit VgetSceneHierarchy(VgetJobSystem* jobSystem = nullptr);
+
+		// Привязка child к parent (недействительный parent - отвязка). Бросает исключение при попытке создать цикл.
+		static void setParent(VgetWorld& world, Entity child, Entity parent);
+
+		// Пересчёт мировых матриц изменённых поддеревьев. Вызывается до VgetTransformBatch::update(world):
+		// локальные матрицы изменённых узлов считаются тем же пакетным кодом, а отметки об изменении с них снимаются.
+		// Узлы, родитель которых уничтожен, становятся корнями.
+		void update(VgetWorld& world, VgetTransformBatch& transformBatch);
+
+		uint32_t getNodeCount() const { return static_cast<uint32_t>(entities.size()); }
+		uint32_t getUpdatedCount() const { return updatedCount; }
+		double getUpdateTimeMs() const { return updateTimeMs; }
+
+		// Порядок обхода, индекс родителя (-1 у корня) и конец поддерева для каждого узла
+		const std::vector<Entity>& getEntities() const { return entities; }
+		const std::vector<int32_t>& getParents() const { return parents; }
+		const std::vector<uint32_t>& getSubtreeEnds() const { return subtreeEnds; }
+
+	private:
+		// Перестроение порядка обхода по компонентам ParentComponent
+		void rebuild(VgetWorld& world);
+		// Обновление указателей на трансформации. Возвращает false, если какой-то узел исчез.
+		bool refreshTransforms(VgetWorld& world);
+		// Разбиение массива на независимые диапазоны для параллельного прохода
+		void buildRanges();
+		// Пересчёт мировых матриц узлов [begin; end). Возвращает число пересчитанных.
+		uint32_t propagate(uint32_t begin, uint32_t end);
+
+		VgetJobSystem* jobSystem;
+
+		std::vector<Entity> entities;
+		std::vector<int32_t> parents;
+		std::vector<uint32_t> subtreeEnds;
+		std::vector<TransformComponent*> transforms;
+		std::vector<glm::mat4> localMatrices;
+		std::vector<glm::mat4> localNormalMatrices;
+		std::vector<uint8_t> changed;	// изменилась мировая матрица узла в этом кадре
+		std::vector<uint32_t> roots;
+		std::vector<std::pair<uint32_t, uint32_t>> ranges;
+
+		uint64_t parentsVersion = ~0ull;
+		uint64_t structureVersion = ~0ull;
+
+		std::vector<TransformComponent*> dirtyTransforms;
+		std::vector<uint32_t> dirtyNodes;
+		uint32_t updatedCount = 0;
+		double updateTimeMs = 0.0;
+	};
+}
@@ -1,5 +1,6 @@
 // ReSharper disable CppMemberFunctionMayBeStatic
 #include "vget_swap_chain.hpp"
+#include "vget_render_stats.hpp"
 
 // std
 #include <array>
@@ -52,7 +53,7 @@ namespace vget
       for (int i = 0; i < depthImages.size(); i++) {
         vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
         vkDestroyImage(device.device(), depthImages[i], nullptr);
-        vkFreeMemory(device.device(), depthImageMemories[i], nullptr);
+        device.freeMemory(depthImageMemories[i]);
       }
 
       for (auto framebuffer : swapChainFramebuffers) {
@@ -114,10 +115,13 @@ namespace vget
       submitInfo.pSignalSemaphores = signalSemaphores;
 
       vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
+      // Отправка и показ под мьютексом очередей: модели и текстуры могут загружаться из потока обновления
+      std::lock_guard<std::mutex> lock{device.getQueueMutex()};
       if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
           VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
       }
+      VgetRenderStats::add(RenderCounter::QueueSubmits);
 
       VkPresentInfoKHR presentInfo = {};
       presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -365,7 +369,8 @@ namespace vget
 			    imageInfo,
 			    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			    depthImages[i],
-			    depthImageMemories[i]);
+			    depthImageMemories[i],
+			    MemoryTag{MemoryCategory::Attachment, "swap chain depth"});
 
 		    VkImageViewCreateInfo viewInfo{};
 		    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
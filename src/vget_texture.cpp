@@ -1,45 +1,49 @@
 ﻿#include "vget_texture.hpp"
+#include "vget_cpu_profiler.hpp"
 #include "vget_buffer.hpp"
-
-// libs
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include "vget_texture_table.hpp"
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <stdexcept>
 
 namespace vget
 {
-	VgetTexture::VgetTexture(const std::string& path, VgetDevice& device) : vgetDevice{device}
+	VgetTexture::VgetTexture(const std::string& path, VgetDevice& device) : VgetTexture{loadImage(path), device, path} {}
+
+	VgetTexture::VgetTexture(const ImageData& image, VgetDevice& device, const std::string& name, SamplerPreset samplerPreset)
+		: vgetDevice{device}, name{name}, samplerPreset{samplerPreset}
 	{
-		createTextureImage(path);
+		VGET_PROFILE_ZONE("VgetTexture::VgetTexture");
+		createTextureImage(image);
 		createTextureImageView();
-		createTextureSampler();
+		// Выборщик с одинаковыми параметрами общий для всех текстур
+		textureSampler = vgetDevice.getSamplerCache().getSampler(samplerPreset);
+		slot = vgetDevice.getTextureTable().allocate(descriptorInfo());
 	}
 
 	VgetTexture::~VgetTexture()
 	{
-		vkDestroySampler(vgetDevice.device(), textureSampler, nullptr);
-		vkDestroyImageView(vgetDevice.device(), textureImageView, nullptr);
-		vkDestroyImage(vgetDevice.device(), textureImage, nullptr);
-		vkFreeMemory(vgetDevice.device(), textureImageMemory, nullptr);
+		// Изображение ещё может читаться кадрами в полёте: таблица уничтожит его вместе с переработкой слота
+		vgetDevice.getTextureTable().release(slot, textureImage, textureImageView, textureImageMemory);
 	}
 
-	void VgetTexture::createTextureImage(const std::string& path)
+	void VgetTexture::createTextureImage(const ImageData& image)
 	{
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-		uint32_t pixelCount = texWidth * texHeight;
-		uint32_t pixelSize = 4;
-		VkDeviceSize imageSize = pixelCount * pixelSize;
-
-		if (!pixels)
+		if (image.pixels.empty())
 		{
 			throw std::runtime_error("failed to load texture image!");
 		}
 
+		const uint32_t texWidth = image.width;
+		const uint32_t texHeight = image.height;
+		mipLevels = image.mipLevels;
+		// Промежуточный буфер вмещает все мип-уровни изображения
+		uint32_t pixelCount = static_cast<uint32_t>(image.pixels.size() / 4);
+		uint32_t pixelSize = 4;
+
 		// Создание промежуточного буфера
 		VgetBuffer stagingBuffer
 		{
@@ -47,29 +51,47 @@ namespace vget
 			pixelSize,
 			pixelCount,
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT, // буфер используется как источник для операции переноса памяти
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			MemoryTag{ MemoryCategory::Staging, name }
 		};
 
 		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)pixels); // запись пикселей в память девайса
-		stbi_image_free(pixels); // очистка изначально прочитанного массива пикселей
+		stagingBuffer.writeToBuffer((void*)image.pixels.data()); // запись пикселей в память девайса
 
 		// Создание изображения и выделение памяти под него
-		createImage(texWidth, texHeight,
+		createImage(texWidth, texHeight, mipLevels,
 			VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
 			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			textureImage, textureImageMemory);
 
-		// Копируем буфер с пикселами в изображение текстуры, при этом меняя лэйауты на нужные
-		transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		vgetDevice.copyBufferToImage(stagingBuffer.getBuffer(), textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-		transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// Копируем буфер с пикселами в изображение текстуры, при этом меняя лэйауты на нужные.
+		// Смена схем и копирование всех уровней записываются в один командный буфер.
+		std::vector<VkBufferImageCopy> regions(mipLevels);
+		for (uint32_t level = 0; level < mipLevels; ++level)
+		{
+			VkBufferImageCopy& region = regions[level];
+			region.bufferOffset = mipOffset(texWidth, texHeight, level);
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { std::max(1u, texWidth >> level), std::max(1u, texHeight >> level), 1 };
+		}
+
+		VkCommandBuffer commandBuffer = vgetDevice.beginSingleTimeCommands();
+		transitionImageLayout(commandBuffer, textureImage, mipLevels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.getBuffer(), textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+		transitionImageLayout(commandBuffer, textureImage, mipLevels, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		vgetDevice.endSingleTimeCommands(commandBuffer);
 	}
 
 	void VgetTexture::createImage(
 		uint32_t width,
 		uint32_t height,
+		uint32_t mipLevels,
 		VkFormat format,
 		VkImageTiling tiling,
 		VkImageUsageFlags usage,
@@ -84,7 +106,7 @@ namespace vget
 		imageInfo.extent.width = width;	   // кол-во текселей по X
 		imageInfo.extent.height = height;  // кол-во текселей по Y
 		imageInfo.extent.depth = 1;		   // кол-во текселей по Z
-		imageInfo.mipLevels = 1;
+		imageInfo.mipLevels = mipLevels;
 		imageInfo.arrayLayers = 1;
 		imageInfo.format = format;
 		imageInfo.tiling = tiling;  // исп. оптимальное расположение текселей, заданное реализацией
@@ -96,14 +118,12 @@ namespace vget
 		imageInfo.flags = 0;	// Optional
 
 		// Выделение памяти под изображение в девайсе
-		vgetDevice.createImageWithInfo(imageInfo, properties, image, imageMemory);
+		vgetDevice.createImageWithInfo(imageInfo, properties, image, imageMemory, MemoryTag{ MemoryCategory::Texture, name });
 	}
 
 	// Смена схемы изображения
-	void VgetTexture::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
+	void VgetTexture::transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, uint32_t mipLevels, VkImageLayout oldLayout, VkImageLayout newLayout)
 	{
-		VkCommandBuffer commandBuffer = vgetDevice.beginSingleTimeCommands();
-
 		// Для смены схемы будет использоваться барьер для изображения
 		VkImageMemoryBarrier barrier{};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -115,7 +135,7 @@ namespace vget
 		barrier.image = image;
 		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.levelCount = mipLevels;
 		barrier.subresourceRange.baseArrayLayer = 0;
 		barrier.subresourceRange.layerCount = 1;
 
@@ -153,8 +173,6 @@ namespace vget
 			0, nullptr, // массив барьеров памяти буфера
 			1, &barrier  // массив барьеров памяти изображения
 		);
-
-		vgetDevice.endSingleTimeCommands(commandBuffer);
 	}
 
 	// Создание представления изображения для текстуры
@@ -167,7 +185,7 @@ namespace vget
 		viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
 		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.levelCount = mipLevels;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount = 1;
 
@@ -177,35 +195,6 @@ namespace vget
 		}
 	}
 
-	// Создание выборщика для текстуры (ищет цвет, соответствующий координате)
-	void VgetTexture::createTextureSampler()
-	{
-		VkSamplerCreateInfo samplerInfo{};
-		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.magFilter = VK_FILTER_LINEAR; // Фильтрация для увеличенных (magnified) текселей. Это случай, когда их больше, чем фрагментов (oversampling)
-		samplerInfo.minFilter = VK_FILTER_LINEAR; // Для уменьшенных (minified) текселей. Это случай, когда их меньше, чем фрагментов (undersampling)
-		// Режим адресации цвета по заданной оси. U, V, W используются вместо X, Y и Z по соглашению для координат пространства текстуры
-		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT; // Повторять текстуру, если координата выходит за пределы изображения
-		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.anisotropyEnable = VK_TRUE;
-		samplerInfo.maxAnisotropy = vgetDevice.properties.limits.maxSamplerAnisotropy; // макс. кол-во текселей для расчёт финального цвета при анизотропной фильтрации
-		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		samplerInfo.unnormalizedCoordinates = VK_FALSE;	// координаты будут адресоваться в диапазоне [0;1), т.е. они нормализованы для универсального использования
-		samplerInfo.compareEnable = VK_FALSE;			// функция сравнения выбранного текселя с заданным значением отключена (исп. в precentage-closer фильтрации в картах теней)
-		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-		// поля для настройки мипмэппинга
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.mipLodBias = 0.0f;
-		samplerInfo.minLod = 0.0f;
-		samplerInfo.maxLod = 0.0f;
-
-		if (vkCreateSampler(vgetDevice.device(), &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to create texture sampler!");
-		}
-	}
-
 	VkDescriptorImageInfo VgetTexture::descriptorInfo()
 	{
 		return VkDescriptorImageInfo {
@@ -1,21 +1,54 @@
 ﻿#pragma once
 
 #include "vget_device.hpp"
+#include "vget_sampler_cache.hpp"
+
+// std
+#include <string>
+#include <vector>
 
 namespace vget
 {
 	class VgetTexture
 	{
 	public:
+		// Декодированное изображение RGBA8 на стороне CPU. Пустой pixels - файл не удалось прочитать.
+		struct ImageData
+		{
+			uint32_t width = 0;		// размеры нулевого уровня
+			uint32_t height = 0;
+			uint32_t mipLevels = 1;
+			std::vector<unsigned char> pixels;	// уровни подряд, каждый следующий вдвое меньше (но не меньше 1 пикселя)
+		};
+
+		// Чтение и декодирование файла изображения, с generateMips при withMips. Не обращается к Vulkan
+		// и не бросает исключений, поэтому может выполняться задачей VgetJobSystem.
+		// Определены в vget_texture_image.cpp, который собирается без Vulkan.
+		static ImageData loadImage(const std::string& path, bool withMips = true);
+		// Достраивает полную цепочку мип-уровней к изображению из одного уровня.
+		// Фильтр 2x2 усредняет цвет в линейном пространстве, т.к. текстура хранится в sRGB.
+		static void generateMips(ImageData& image);
+		static uint32_t mipLevelCount(uint32_t width, uint32_t height);
+		// Смещение уровня level в ImageData::pixels
+		static size_t mipOffset(uint32_t width, uint32_t height, uint32_t level);
+
 		VgetTexture(const std::string& path, VgetDevice& device);
+		// name - файл текстуры, владелец её памяти в учёте VgetMemoryTracker;
+		// samplerPreset - параметры выборщика из общего кэша девайса
+		VgetTexture(const ImageData& image, VgetDevice& device, const std::string& name = {},
+			SamplerPreset samplerPreset = SamplerPreset::LinearRepeat);
 		~VgetTexture();
 
 		VkDescriptorImageInfo descriptorInfo();
+		// Постоянный слот текстуры в глобальной таблице VgetTextureTable, по нему шейдеры выбирают текстуру
+		uint32_t getSlot() const { return slot; }
+		SamplerPreset getSamplerPreset() const { return samplerPreset; }
 
 	private:
 		void createImage(
 			uint32_t width,
 			uint32_t height,
+			uint32_t mipLevels,
 			VkFormat format,
 			VkImageTiling tiling,
 			VkImageUsageFlags usage,
@@ -23,17 +56,20 @@ namespace vget
 			VkImage& image,
 			VkDeviceMemory& imageMemory);
 
-		void createTextureImage(const std::string& path);
+		void createTextureImage(const ImageData& image);
 		void createTextureImageView();
-		void createTextureSampler();
 
-		void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
+		void transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, uint32_t mipLevels, VkImageLayout oldLayout, VkImageLayout newLayout);
 
 		VgetDevice& vgetDevice;
+		std::string name;
 
 		VkImage textureImage;
 		VkDeviceMemory textureImageMemory;
 		VkImageView textureImageView;
-		VkSampler textureSampler;
+		SamplerPreset samplerPreset;
+		VkSampler textureSampler;	// принадлежит VgetSamplerCache
+		uint32_t mipLevels = 1;
+		uint32_t slot = 0;
 	};
 }
@@ -0,0 +1,132 @@
+﻿#include "vget_texture.hpp"
+#include "vget_cpu_profiler.hpp"
+
+// libs
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+// std
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace vget
+{
+	namespace
+	{
+		// Таблицы перевода 8-битного sRGB в линейное пространство и обратно. Обратный перевод выбирает ближайший код
+		// по серединам между соседними значениями, поэтому однотонное изображение проходит через уровни без искажений.
+		// Грубая таблица даёт нижнюю границу кода, от которой до точного остаётся не больше пары шагов.
+		struct SrgbTables
+		{
+			SrgbTables()
+			{
+				for (int i = 0; i < 256; ++i)
+				{
+					const float c = i / 255.f;
+					toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+				}
+				for (int i = 0; i < 255; ++i)
+				{
+					midpoints[i] = (toLinear[i] + toLinear[i + 1]) * .5f;
+				}
+				midpoints[255] = 2.f;
+				for (int i = 0; i < COARSE_SIZE; ++i)
+				{
+					const float linear = static_cast<float>(i) / (COARSE_SIZE - 1);
+					coarse[i] = static_cast<unsigned char>(std::upper_bound(midpoints.begin(), midpoints.end() - 1, linear) - midpoints.begin());
+				}
+			}
+
+			unsigned char toSrgb(float linear) const
+			{
+				uint32_t code = coarse[static_cast<int>(linear * (COARSE_SIZE - 1))];
+				while (linear > midpoints[code]) ++code;
+				return static_cast<unsigned char>(code);
+			}
+
+			static constexpr int COARSE_SIZE = 4096;
+			std::array<float, 256> toLinear{};
+			std::array<float, 256> midpoints{};		// последний элемент - ограничитель поиска
+			std::array<unsigned char, COARSE_SIZE> coarse{};
+		};
+	}
+
+	VgetTexture::ImageData VgetTexture::loadImage(const std::string& path, bool withMips)
+	{
+		VGET_PROFILE_ZONE("VgetTexture::loadImage");
+		ImageData image{};
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		if (!pixels) return image;
+
+		image.width = static_cast<uint32_t>(texWidth);
+		image.height = static_cast<uint32_t>(texHeight);
+		// Память сразу под все уровни, чтобы generateMips не копировал нулевой уровень
+		if (withMips) image.pixels.reserve(mipOffset(image.width, image.height, mipLevelCount(image.width, image.height)));
+		image.pixels.assign(pixels, pixels + static_cast<size_t>(texWidth) * texHeight * 4);
+		stbi_image_free(pixels); // очистка изначально прочитанного массива пикселей
+
+		if (withMips) generateMips(image);
+		return image;
+	}
+
+	uint32_t VgetTexture::mipLevelCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1) ++levels;
+		return levels;
+	}
+
+	size_t VgetTexture::mipOffset(uint32_t width, uint32_t height, uint32_t level)
+	{
+		size_t offset = 0;
+		for (uint32_t i = 0; i < level; ++i)
+		{
+			offset += static_cast<size_t>(std::max(1u, width >> i)) * std::max(1u, height >> i) * 4;
+		}
+		return offset;
+	}
+
+	void VgetTexture::generateMips(ImageData& image)
+	{
+		VGET_PROFILE_ZONE("VgetTexture::generateMips");
+		if (image.pixels.empty() || image.mipLevels > 1) return;
+
+		static const SrgbTables srgb{};
+		const uint32_t levels = mipLevelCount(image.width, image.height);
+		image.pixels.resize(mipOffset(image.width, image.height, levels));
+		image.mipLevels = levels;
+
+		// Каждый уровень строится из предыдущего. У нечётной стороны последний столбец (строка) учитывается дважды.
+		for (uint32_t level = 1; level < levels; ++level)
+		{
+			const uint32_t srcWidth = std::max(1u, image.width >> (level - 1));
+			const uint32_t srcHeight = std::max(1u, image.height >> (level - 1));
+			const uint32_t width = std::max(1u, image.width >> level);
+			const uint32_t height = std::max(1u, image.height >> level);
+			const unsigned char* src = image.pixels.data() + mipOffset(image.width, image.height, level - 1);
+			unsigned char* dst = image.pixels.data() + mipOffset(image.width, image.height, level);
+
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				const unsigned char* row0 = src + static_cast<size_t>(std::min(2 * y, srcHeight - 1)) * srcWidth * 4;
+				const unsigned char* row1 = src + static_cast<size_t>(std::min(2 * y + 1, srcHeight - 1)) * srcWidth * 4;
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const uint32_t x0 = std::min(2 * x, srcWidth - 1) * 4;
+					const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1) * 4;
+					unsigned char* out = dst + (static_cast<size_t>(y) * width + x) * 4;
+					for (uint32_t c = 0; c < 3; ++c)
+					{
+						const float sum = srgb.toLinear[row0[x0 + c]] + srgb.toLinear[row0[x1 + c]] +
+							srgb.toLinear[row1[x0 + c]] + srgb.toLinear[row1[x1 + c]];
+						out[c] = srgb.toSrgb(sum * .25f);
+					}
+					// Прозрачность хранится линейно
+					out[3] = static_cast<unsigned char>((row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3] + 2) / 4);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,146 @@
+#include "vget_texture_table.hpp"
+#include "vget_swap_chain.hpp"
+#include "vget_frame_pipeline.hpp"
+#include "vget_render_stats.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+namespace vget
+{
+	namespace
+	{
+		// Освобождённый слот ещё может читаться кадрами в полёте, а текстура удалённой модели - попасть
+		// в снимок, который отрендерится позже, поэтому слот ждёт завершения и тех, и других
+		constexpr uint64_t RECYCLE_DELAY = VgetSwapChain::MAX_FRAMES_IN_FLIGHT + VgetFramePipeline::SNAPSHOT_COUNT;
+
+		constexpr VkDescriptorType TEXTURE_DESCRIPTOR_TYPE = VgetTextureTable::SEPARATE_SAMPLERS
+			? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+			: VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	}
+
+	VgetTextureTable::VgetTextureTable(VgetDevice& device) : vgetDevice{device}
+	{
+		// Раздельным изображениям лимиты выборщиков не нужны: неизменяемых выборщиков всего несколько
+		const auto& limits = device.descriptorIndexingProperties;
+		capacity = std::min({ MAX_TEXTURES,
+			limits.maxPerStageDescriptorUpdateAfterBindSampledImages, limits.maxDescriptorSetUpdateAfterBindSampledImages });
+		if (!SEPARATE_SAMPLERS)
+		{
+			capacity = std::min({ capacity,
+				limits.maxPerStageDescriptorUpdateAfterBindSamplers, limits.maxDescriptorSetUpdateAfterBindSamplers });
+		}
+
+		VgetDescriptorSetLayout::Builder layoutBuilder{ device };
+		VgetDescriptorPool::Builder poolBuilder{ device };
+		layoutBuilder.addBinding(TEXTURE_BINDING, TEXTURE_DESCRIPTOR_TYPE, VK_SHADER_STAGE_FRAGMENT_BIT, capacity)
+			.setBindingFlags(TEXTURE_BINDING,
+				VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+				VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+				VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT)
+			.setLayoutFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+		poolBuilder.addPoolSize(TEXTURE_DESCRIPTOR_TYPE, capacity);
+
+		std::array<VkSampler, SAMPLER_PRESET_COUNT> immutableSamplers{};
+		if (SEPARATE_SAMPLERS)
+		{
+			for (uint32_t i = 0; i < SAMPLER_PRESET_COUNT; ++i)
+			{
+				immutableSamplers[i] = device.getSamplerCache().getSampler(static_cast<SamplerPreset>(i));
+			}
+			layoutBuilder.addBinding(SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT,
+				SAMPLER_PRESET_COUNT, immutableSamplers.data());
+			poolBuilder.addPoolSize(VK_DESCRIPTOR_TYPE_SAMPLER, SAMPLER_PRESET_COUNT);
+		}
+
+		setLayout = layoutBuilder.build();
+		pool = poolBuilder
+			.setMaxSets(1)
+			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+			.build();
+
+		if (!pool->allocateDescriptor(setLayout->getDescriptorSetLayout(), descriptorSet))
+		{
+			throw std::runtime_error("failed to allocate texture table descriptor set!");
+		}
+	}
+
+	VgetTextureTable::~VgetTextureTable()
+	{
+		for (const ReleasedSlot& released : releasedSlots) destroyResources(released);
+	}
+
+	uint32_t VgetTextureTable::allocate(const VkDescriptorImageInfo& imageInfo)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		uint32_t slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else if (nextSlot < capacity)
+		{
+			slot = nextSlot++;
+		}
+		else
+		{
+			throw std::runtime_error("failed to allocate texture table slot!");
+		}
+
+		// Запись под мьютексом: обновление набора требует внешней синхронизации
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstBinding = TEXTURE_BINDING;
+		write.dstArrayElement = slot;
+		write.descriptorCount = 1;
+		write.descriptorType = TEXTURE_DESCRIPTOR_TYPE;
+		write.pImageInfo = &imageInfo;
+		vkUpdateDescriptorSets(vgetDevice.device(), 1, &write, 0, nullptr);
+		VgetRenderStats::add(RenderCounter::DescriptorWrites);
+		return slot;
+	}
+
+	void VgetTextureTable::release(uint32_t slot, VkImage image, VkImageView imageView, VkDeviceMemory memory)
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		assert(slot < nextSlot && "Texture table slot was never allocated");
+		releasedSlots.push_back(ReleasedSlot{ slot, frameCount, image, imageView, memory });
+	}
+
+	void VgetTextureTable::beginFrame()
+	{
+		// beginFrame() вызывается только из потока рендера, поэтому recycledSlots не нужен мьютекс
+		recycledSlots.clear();
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			++frameCount;
+			while (!releasedSlots.empty() && frameCount - releasedSlots.front().frame > RECYCLE_DELAY)
+			{
+				freeSlots.push_back(releasedSlots.front().slot);
+				recycledSlots.push_back(releasedSlots.front());
+				releasedSlots.pop_front();
+			}
+		}
+
+		// Кадры, которые могли читать изображения, завершены, а дескрипторы в их слотах больше не используются
+		for (const ReleasedSlot& released : recycledSlots) destroyResources(released);
+	}
+
+	void VgetTextureTable::destroyResources(const ReleasedSlot& released)
+	{
+		vkDestroyImageView(vgetDevice.device(), released.imageView, nullptr);
+		vkDestroyImage(vgetDevice.device(), released.image, nullptr);
+		vgetDevice.freeMemory(released.memory);
+	}
+
+	uint32_t VgetTextureTable::getUsedCount() const
+	{
+		std::lock_guard<std::mutex> lock{ mutex };
+		return nextSlot - static_cast<uint32_t>(freeSlots.size() + releasedSlots.size());
+	}
+}
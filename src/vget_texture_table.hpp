@@ -0,0 +1,85 @@
+#pragma once
+
+#include "vget_descriptors.hpp"
+#include "vget_sampler_cache.hpp"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace vget
+{
+	// Глобальная таблица текстур (bindless): один набор дескрипторов с массивом Combined Image Sampler'ов,
+	// в котором каждая текстура получает постоянный слот при создании. Шейдеры выбирают текстуру по номеру слота,
+	// поэтому появление и удаление моделей не пересоздаёт ни пул, ни схему, ни наборы дескрипторов.
+	//
+	// Привязка массива частичная (PARTIALLY_BOUND) и обновляемая после привязки (UPDATE_AFTER_BIND,
+	// UPDATE_UNUSED_WHILE_PENDING): слот пишется сразу, даже пока набор используется кадрами в полёте, т.к. эти кадры
+	// к новому слоту не обращаются. Освобождённый слот возвращается в список свободных только тогда, когда все кадры
+	// и снимки, которые могли к нему обращаться, уже завершены. До этого же момента откладывается и уничтожение
+	// изображения текстуры, её вида и памяти, поэтому текстуру можно удалить, не дожидаясь простоя девайса.
+	//
+	// При сборке с VGET_SEPARATE_SAMPLERS изображения и выборщики разделены: массив содержит Sampled Image'ы,
+	// а вторая привязка - неизменяемые выборщики всех SamplerPreset. Шейдер сочетает слот с номером выборщика,
+	// так что дескрипторы выборщиков вовсе не пишутся, а одно изображение можно читать разными выборщиками.
+	class VgetTextureTable
+	{
+	public:
+#ifdef VGET_SEPARATE_SAMPLERS
+		static constexpr bool SEPARATE_SAMPLERS = true;
+#else
+		static constexpr bool SEPARATE_SAMPLERS = false;
+#endif
+		static constexpr uint32_t MAX_TEXTURES = 4096;	// верхняя граница, ограничивается ещё и лимитами девайса
+		static constexpr uint32_t TEXTURE_BINDING = 0;
+		static constexpr uint32_t SAMPLER_BINDING = 1;	// только с SEPARATE_SAMPLERS
+
+		explicit VgetTextureTable(VgetDevice& device);
+		// Уничтожает ресурсы ещё не переработанных текстур: вызывается, когда девайс уже простаивает
+		~VgetTextureTable();
+
+		VgetTextureTable(const VgetTextureTable&) = delete;
+		VgetTextureTable& operator=(const VgetTextureTable&) = delete;
+
+		// Выдача слота и запись в него дескриптора текстуры (из любого потока). С SEPARATE_SAMPLERS выборщик из imageInfo не используется.
+		uint32_t allocate(const VkDescriptorImageInfo& imageInfo);
+		// Слот вернётся в список свободных через несколько кадров (см. RECYCLE_DELAY в vget_texture_table.cpp),
+		// тогда же таблица уничтожит вид, изображение и память текстуры, которая занимала слот
+		void release(uint32_t slot, VkImage image, VkImageView imageView, VkDeviceMemory memory);
+		// Начало кадра в потоке рендера, после ожидания его fence: переработка слотов, освобождённых достаточно давно
+		void beginFrame();
+
+		VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+		VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+		uint32_t getCapacity() const { return capacity; }
+		uint32_t getUsedCount() const;
+
+	private:
+		struct ReleasedSlot
+		{
+			uint32_t slot;
+			uint64_t frame;	// номер кадра, в котором слот освобождён
+			VkImage image;
+			VkImageView imageView;
+			VkDeviceMemory memory;
+		};
+
+		void destroyResources(const ReleasedSlot& released);
+
+		VgetDevice& vgetDevice;
+		uint32_t capacity = 0;
+		std::unique_ptr<VgetDescriptorSetLayout> setLayout;
+		std::unique_ptr<VgetDescriptorPool> pool;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+		mutable std::mutex mutex;
+		uint32_t nextSlot = 0;				// слоты за nextSlot ещё ни разу не выдавались
+		std::vector<uint32_t> freeSlots;
+		std::deque<ReleasedSlot> releasedSlots;	// по возрастанию кадра освобождения
+		std::vector<ReleasedSlot> recycledSlots;	// переработанные в beginFrame(), ресурсы уничтожаются вне мьютекса
+		uint64_t frameCount = 0;
+	};
+}
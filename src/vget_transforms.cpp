@@ -0,0 +1,231 @@
+#include "vget_transforms.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// SIMD intrinsics
+#if defined(__AVX__)
+#include <immintrin.h>
+#define VGET_TRANSFORMS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VGET_TRANSFORMS_SSE
+#endif
+
+namespace vget
+{
+	namespace
+	{
+		constexpr float PI = 3.14159265358979f;
+		constexpr float HALF_PI = 1.57079632679490f;
+		constexpr float INV_TWO_PI = 0.159154943091895f;
+		// 2*pi разбито на две части: старшая точно умножается на небольшие целые, младшая уточняет остаток
+		constexpr float TWO_PI_HI = 6.28125f;
+		constexpr float TWO_PI_LO = 0.00193530717958647f;
+
+		// Коэффициенты рядов Тейлора на [-pi/2; pi/2]
+		constexpr float SIN_3 = -1.f / 6.f;
+		constexpr float SIN_5 = 1.f / 120.f;
+		constexpr float SIN_7 = -1.f / 5040.f;
+		constexpr float SIN_9 = 1.f / 362880.f;
+		constexpr float SIN_11 = -1.f / 39916800.f;
+		constexpr float COS_2 = -1.f / 2.f;
+		constexpr float COS_4 = 1.f / 24.f;
+		constexpr float COS_6 = -1.f / 720.f;
+		constexpr float COS_8 = 1.f / 40320.f;
+		constexpr float COS_10 = -1.f / 3628800.f;
+		constexpr float COS_12 = 1.f / 479001600.f;
+
+#if defined(VGET_TRANSFORMS_AVX)
+		constexpr size_t LANES = 8;
+
+		void sinCosLanes(const float* angles, float* sines, float* cosines)
+		{
+			const __m256 signMask = _mm256_set1_ps(-0.f);
+			const __m256 x = _mm256_loadu_ps(angles);
+
+			// r = x - 2*pi*k, r в [-pi; pi]
+			const __m256 k = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(INV_TWO_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			__m256 r = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(k, _mm256_set1_ps(TWO_PI_HI))), _mm256_mul_ps(k, _mm256_set1_ps(TWO_PI_LO)));
+
+			// при |r| > pi/2: sin(r) = sin(sign(r) * (pi - |r|)), а косинус меняет знак
+			const __m256 sign = _mm256_and_ps(r, signMask);
+			const __m256 absR = _mm256_andnot_ps(signMask, r);
+			const __m256 folded = _mm256_cmp_ps(absR, _mm256_set1_ps(HALF_PI), _CMP_GT_OQ);
+			r = _mm256_blendv_ps(r, _mm256_or_ps(_mm256_sub_ps(_mm256_set1_ps(PI), absR), sign), folded);
+
+			const __m256 r2 = _mm256_mul_ps(r, r);
+			__m256 s = _mm256_add_ps(_mm256_mul_ps(r2, _mm256_set1_ps(SIN_11)), _mm256_set1_ps(SIN_9));
+			s = _mm256_add_ps(_mm256_mul_ps(r2, s), _mm256_set1_ps(SIN_7));
+			s = _mm256_add_ps(_mm256_mul_ps(r2, s), _mm256_set1_ps(SIN_5));
+			s = _mm256_add_ps(_mm256_mul_ps(r2, s), _mm256_set1_ps(SIN_3));
+			s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(r2, r), s), r);
+
+			__m256 c = _mm256_add_ps(_mm256_mul_ps(r2, _mm256_set1_ps(COS_12)), _mm256_set1_ps(COS_10));
+			c = _mm256_add_ps(_mm256_mul_ps(r2, c), _mm256_set1_ps(COS_8));
+			c = _mm256_add_ps(_mm256_mul_ps(r2, c), _mm256_set1_ps(COS_6));
+			c = _mm256_add_ps(_mm256_mul_ps(r2, c), _mm256_set1_ps(COS_4));
+			c = _mm256_add_ps(_mm256_mul_ps(r2, c), _mm256_set1_ps(COS_2));
+			c = _mm256_add_ps(_mm256_mul_ps(r2, c), _mm256_set1_ps(1.f));
+			c = _mm256_xor_ps(c, _mm256_and_ps(folded, signMask));
+
+			_mm256_storeu_ps(sines, s);
+			_mm256_storeu_ps(cosines, c);
+		}
+#elif defined(VGET_TRANSFORMS_SSE)
+		constexpr size_t LANES = 4;
+
+		void sinCosLanes(const float* angles, float* sines, float* cosines)
+		{
+			const __m128 signMask = _mm_set1_ps(-0.f);
+			const __m128 x = _mm_loadu_ps(angles);
+
+			// r = x - 2*pi*k, r в [-pi; pi] (_mm_cvtps_epi32 округляет к ближайшему)
+			const __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(INV_TWO_PI))));
+			__m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(TWO_PI_HI))), _mm_mul_ps(k, _mm_set1_ps(TWO_PI_LO)));
+
+			// при |r| > pi/2: sin(r) = sin(sign(r) * (pi - |r|)), а косинус меняет знак
+			const __m128 sign = _mm_and_ps(r, signMask);
+			const __m128 absR = _mm_andnot_ps(signMask, r);
+			const __m128 folded = _mm_cmpgt_ps(absR, _mm_set1_ps(HALF_PI));
+			const __m128 reflected = _mm_or_ps(_mm_sub_ps(_mm_set1_ps(PI), absR), sign);
+			r = _mm_or_ps(_mm_and_ps(folded, reflected), _mm_andnot_ps(folded, r));
+
+			const __m128 r2 = _mm_mul_ps(r, r);
+			__m128 s = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(SIN_11)), _mm_set1_ps(SIN_9));
+			s = _mm_add_ps(_mm_mul_ps(r2, s), _mm_set1_ps(SIN_7));
+			s = _mm_add_ps(_mm_mul_ps(r2, s), _mm_set1_ps(SIN_5));
+			s = _mm_add_ps(_mm_mul_ps(r2, s), _mm_set1_ps(SIN_3));
+			s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r2, r), s), r);
+
+			__m128 c = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(COS_12)), _mm_set1_ps(COS_10));
+			c = _mm_add_ps(_mm_mul_ps(r2, c), _mm_set1_ps(COS_8));
+			c = _mm_add_ps(_mm_mul_ps(r2, c), _mm_set1_ps(COS_6));
+			c = _mm_add_ps(_mm_mul_ps(r2, c), _mm_set1_ps(COS_4));
+			c = _mm_add_ps(_mm_mul_ps(r2, c), _mm_set1_ps(COS_2));
+			c = _mm_add_ps(_mm_mul_ps(r2, c), _mm_set1_ps(1.f));
+			c = _mm_xor_ps(c, _mm_and_ps(folded, signMask));
+
+			_mm_storeu_ps(sines, s);
+			_mm_storeu_ps(cosines, c);
+		}
+#else
+		constexpr size_t LANES = 1;
+
+		void sinCosLanes(const float* angles, float* sines, float* cosines)
+		{
+			sines[0] = std::sin(angles[0]);
+			cosines[0] = std::cos(angles[0]);
+		}
+#endif
+
+		TransformComponent& transformAt(TransformComponent* transforms, uint32_t i) { return transforms[i]; }
+		TransformComponent& transformAt(TransformComponent* const* transforms, uint32_t i) { return *transforms[i]; }
+	}
+
+	void sinCosBatch(const float* angles, float* sines, float* cosines, size_t count)
+	{
+		size_t i = 0;
+		for (; i + LANES <= count; i += LANES)
+		{
+			sinCosLanes(angles + i, sines + i, cosines + i);
+		}
+
+		// Хвост дополняется нулями до полного вектора, чтобы все значения считались одним и тем же способом
+		if (i < count)
+		{
+			float tailAngles[LANES] = {};
+			float tailSines[LANES];
+			float tailCosines[LANES];
+			const size_t tail = count - i;
+			for (size_t j = 0; j < tail; ++j) tailAngles[j] = angles[i + j];
+			sinCosLanes(tailAngles, tailSines, tailCosines);
+			for (size_t j = 0; j < tail; ++j)
+			{
+				sines[i + j] = tailSines[j];
+				cosines[i + j] = tailCosines[j];
+			}
+		}
+	}
+
+	VgetTransformBatch::VgetTransformBatch()
+	{
+		angles.resize(3 * BLOCK_SIZE);
+		sines.resize(3 * BLOCK_SIZE);
+		cosines.resize(3 * BLOCK_SIZE);
+	}
+
+	uint32_t VgetTransformBatch::update(VgetWorld& world)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		changedTransforms.clear();
+		for (const Entity entity : world.getChanged<TransformComponent>())
+		{
+			// в списке остаются уничтоженные сущности и узлы, которые уже пересчитала VgetSceneHierarchy
+			if (!world.isChanged<TransformComponent>(entity)) continue;
+			TransformComponent* transform = world.getComponent<TransformComponent>(entity);
+			if (transform != nullptr) changedTransforms.push_back(transform);
+		}
+		world.clearChanged<TransformComponent>();
+
+		updatedCount = update(changedTransforms.data(), static_cast<uint32_t>(changedTransforms.size()));
+		updateTimeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return updatedCount;
+	}
+
+	uint32_t VgetTransformBatch::update(TransformComponent* transforms, uint32_t count)
+	{
+		return updateAll(transforms, count);
+	}
+
+	uint32_t VgetTransformBatch::update(TransformComponent* const* transforms, uint32_t count)
+	{
+		return updateAll(transforms, count);
+	}
+
+	template <typename Transforms>
+	uint32_t VgetTransformBatch::updateAll(Transforms transforms, uint32_t count)
+	{
+		// Массив обрабатывается блоками, чтобы трансформации блока ещё были в кэше, когда в них записываются матрицы
+		for (uint32_t blockStart = 0; blockStart < count; blockStart += BLOCK_SIZE)
+		{
+			updateBlock(transforms + blockStart, std::min(BLOCK_SIZE, count - blockStart));
+		}
+		return count;
+	}
+
+	template <typename Transforms>
+	void VgetTransformBatch::updateBlock(Transforms transforms, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const glm::vec3& rotation = transformAt(transforms, i).rotation;
+			angles[i] = rotation.x;
+			angles[BLOCK_SIZE + i] = rotation.y;
+			angles[2 * BLOCK_SIZE + i] = rotation.z;
+		}
+
+		// Углы осей лежат в массиве с шагом BLOCK_SIZE, поэтому при неполном блоке каждая ось считается отдельно
+		if (count == BLOCK_SIZE)
+		{
+			sinCosBatch(angles.data(), sines.data(), cosines.data(), 3 * BLOCK_SIZE);
+		}
+		else
+		{
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				const size_t offset = axis * BLOCK_SIZE;
+				sinCosBatch(angles.data() + offset, sines.data() + offset, cosines.data() + offset, count);
+			}
+		}
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			transformAt(transforms, i).setMatrices(
+				{ sines[i], sines[BLOCK_SIZE + i], sines[2 * BLOCK_SIZE + i] },
+				{ cosines[i], cosines[BLOCK_SIZE + i], cosines[2 * BLOCK_SIZE + i] });
+		}
+	}
+}
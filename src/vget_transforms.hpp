@@ -0,0 +1,54 @@
+#pragma once
+
+#include "vget_game_object.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vget
+{
+	// Векторизованное вычисление sines[i] = sin(angles[i]) и cosines[i] = cos(angles[i]).
+	// Угол приводится к [-pi; pi] и отражается в [-pi/2; pi/2], где синус и косинус считаются многочленами
+	// (абсолютная погрешность порядка 1e-6 для углов до нескольких тысяч радиан).
+	// Использует AVX при сборке с __AVX__, иначе SSE, а на прочих архитектурах - std::sin/std::cos.
+	void sinCosBatch(const float* angles, float* sines, float* cosines, size_t count);
+
+	// Пакетный пересчёт кэшированных матриц трансформаций. Углы поворота собираются в плотный массив (SoA),
+	// синусы и косинусы для них считаются одним векторизованным проходом, а затем матрицы собираются из готовых
+	// значений. Изменённые трансформации мира берутся из списка VgetWorld::getChanged<TransformComponent>(),
+	// поэтому неизменённые не читаются и не пересчитываются.
+	class VgetTransformBatch
+	{
+	public:
+		static constexpr uint32_t BLOCK_SIZE = 1024;	// совпадает с размером чанка VgetWorld
+
+		VgetTransformBatch();
+
+		// Пересчёт отмеченных изменёнными трансформаций мира, после чего отметки снимаются. Возвращает число пересчитанных.
+		uint32_t update(VgetWorld& world);
+		// Пересчёт всех трансформаций непрерывного массива. Возвращает число пересчитанных.
+		uint32_t update(TransformComponent* transforms, uint32_t count);
+		// То же для разрозненных трансформаций (например, изменённых узлов VgetSceneHierarchy)
+		uint32_t update(TransformComponent* const* transforms, uint32_t count);
+
+		uint32_t getUpdatedCount() const { return updatedCount; }
+		double getUpdateTimeMs() const { return updateTimeMs; }
+
+	private:
+		template <typename Transforms>
+		uint32_t updateAll(Transforms transforms, uint32_t count);
+		template <typename Transforms>
+		void updateBlock(Transforms transforms, uint32_t count);
+
+		std::vector<TransformComponent*> changedTransforms;
+		// Буферы одного блока. Углы (и результаты) хранятся по осям: X в [0; BLOCK_SIZE), Y и Z - следом.
+		std::vector<float> angles;
+		std::vector<float> sines;
+		std::vector<float> cosines;
+
+		uint32_t updatedCount = 0;
+		double updateTimeMs = 0.0;
+	};
+}
@@ -1,6 +1,7 @@
 #include "vget_window.hpp"
 
 // std
+#include <chrono>
 #include <stdexcept>
 
 namespace vget
@@ -25,6 +26,18 @@ namespace vget
 		}
 	}
 
+	void VgetWindow::waitEvents()
+	{
+		if (std::this_thread::get_id() == eventThread)
+		{
+			glfwWaitEvents();
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(EVENT_WAIT_SLEEP_MS));
+		}
+	}
+
 	void VgetWindow::initWindow()
 	{
 		glfwInit();  // GLFW library initialization
@@ -34,7 +47,7 @@ namespace vget
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);  // Включить возможность изменять размер окна.
 
 		// Создание окна и его контекста.
-		window = glfwCreateWindow(width, height, windowName.c_str(), nullptr, nullptr);
+		window = glfwCreateWindow(width.load(), height.load(), windowName.c_str(), nullptr, nullptr);
 		glfwSetWindowUserPointer(window, this);  // Сопряжение указателя GLFWwindow* и указателя на текущий экземпляр VgetWindow*.
 		glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);  // установка callback функции на изменение размера окна (буфера кадра)
 	}
@@ -45,8 +58,9 @@ namespace vget
 		   указатель на пользовательский тип окна VgetWindow*, которые были сопряжены ранее функцией */
 		auto vgetWindow = reinterpret_cast<VgetWindow*>(glfwGetWindowUserPointer(window));
 
-		vgetWindow->framebufferResized = true;
+		// Флаг ставится последним: поток рендера, увидевший его, прочитает уже новый размер
 		vgetWindow->width = width;
 		vgetWindow->height = height;
+		vgetWindow->framebufferResized = true;
 	}
 }
\ No newline at end of file
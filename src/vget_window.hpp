@@ -3,7 +3,9 @@
 #define GLFW_INCLUDE_VULKAN // GLFW will include Vulkan headers for its work
 #include <GLFW/glfw3.h>
 
+#include <atomic>
 #include <string>
+#include <thread>
 
 namespace vget
 {
@@ -23,11 +25,17 @@ namespace vget
 
 		// Возвращает флаг закрытия окна.
 		bool shouldClose() { return glfwWindowShouldClose(window); }
-		VkExtent2D getExtent() { return { static_cast<uint32_t>(width), static_cast<uint32_t>(height) }; }
+		// Размер и флаг изменения размера атомарны: их пишет поток событий окна, а читает и поток рендера
+		VkExtent2D getExtent() { return { static_cast<uint32_t>(width.load()), static_cast<uint32_t>(height.load()) }; }
 		bool wasWindowResized() { return framebufferResized; }
 		void resetWindowsResizedFlag() { framebufferResized = false; }
 		GLFWwindow* getGLFWwindow() const { return window; }
 
+		// Ожидание событий окна. События GLFW обрабатывает только поток, создавший окно, поэтому
+		// другие потоки (поток рендера) просто ненадолго засыпают, пока он обрабатывает события.
+		void waitEvents();
+		static constexpr int EVENT_WAIT_SLEEP_MS = 10;
+
 		void createWindowSurface(VkInstance instance, VkSurfaceKHR* surface);
 
 	private:
@@ -36,9 +44,10 @@ namespace vget
 		// Callback функция, которая вызывается при изменении размера окна
 		static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
 
-		int width;
-		int height;
-		bool framebufferResized = false;  // флаг изменения размера окна
+		std::atomic<int> width;
+		std::atomic<int> height;
+		std::atomic<bool> framebufferResized{ false };  // флаг изменения размера окна
+		std::thread::id eventThread = std::this_thread::get_id();	// поток, создавший окно
 
 		std::string windowName;
 		GLFWwindow* window;
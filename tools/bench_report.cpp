@@ -0,0 +1,266 @@
+#include "bench_report.hpp"
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace vget
+{
+	namespace
+	{
+		// Перцентиль по ближайшему рангу из отсортированной выборки
+		double percentile(const std::vector<double>& sorted, double fraction)
+		{
+			const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+			return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+		}
+
+		void writeJsonString(std::ostream& out, const std::string& text)
+		{
+			out << '"';
+			for (char c : text)
+			{
+				if (c == '"' || c == '\\') out << '\\';
+				if (static_cast<unsigned char>(c) >= 0x20) out << c;
+			}
+			out << '"';
+		}
+
+		// Разбор JSON в объёме отчёта vget_bench: объекты, строки, числа и true/false
+		class JsonReader
+		{
+		public:
+			JsonReader(std::string text, std::string filepath) : text{ std::move(text) }, filepath{ std::move(filepath) } {}
+
+			// Обход полей объекта: onField(key) должен прочитать значение поля
+			template<typename Func>
+			void readObject(Func&& onField)
+			{
+				expect('{');
+				if (peek() == '}') { ++position; return; }
+				while (true)
+				{
+					const std::string key = readString();
+					expect(':');
+					onField(key);
+					if (peek() == ',') { ++position; continue; }
+					expect('}');
+					return;
+				}
+			}
+
+			std::string readString()
+			{
+				expect('"');
+				std::string result;
+				while (position < text.size() && text[position] != '"')
+				{
+					if (text[position] == '\\') ++position;
+					if (position < text.size()) result += text[position++];
+				}
+				expect('"');
+				return result;
+			}
+
+			double readNumber()
+			{
+				skipWhitespace();
+				size_t length = 0;
+				double value = 0.0;
+				try
+				{
+					value = std::stod(text.substr(position, 32), &length);
+				}
+				catch (const std::exception&)
+				{
+					fail();
+				}
+				position += length;
+				return value;
+			}
+
+			bool readBool()
+			{
+				skipWhitespace();
+				if (text.compare(position, 4, "true") == 0) { position += 4; return true; }
+				if (text.compare(position, 5, "false") == 0) { position += 5; return false; }
+				fail();
+				return false;
+			}
+
+			// Пропуск значения неизвестного поля
+			void skipValue()
+			{
+				const char c = peek();
+				if (c == '{') readObject([&](const std::string&) { skipValue(); });
+				else if (c == '"') readString();
+				else if (c == 't' || c == 'f') readBool();
+				else readNumber();
+			}
+
+			char peek()
+			{
+				skipWhitespace();
+				return position < text.size() ? text[position] : '\0';
+			}
+
+		private:
+			void skipWhitespace()
+			{
+				while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) ++position;
+			}
+
+			void expect(char c)
+			{
+				if (peek() != c) fail();
+				++position;
+			}
+
+			[[noreturn]] void fail()
+			{
+				throw std::runtime_error("invalid benchmark report " + filepath + " at offset " + std::to_string(position));
+			}
+
+			std::string text;
+			std::string filepath;
+			size_t position = 0;
+		};
+	}
+
+	BenchMetric BenchMetric::fromSamples(const std::string& name, const std::string& unit, std::vector<double> values)
+	{
+		BenchMetric metric{ name, unit };
+		metric.samples = static_cast<uint32_t>(values.size());
+		if (values.empty()) return metric;
+
+		std::sort(values.begin(), values.end());
+		metric.mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+		metric.p50 = percentile(values, 0.50);
+		metric.p95 = percentile(values, 0.95);
+		metric.p99 = percentile(values, 0.99);
+		metric.min = values.front();
+		metric.max = values.back();
+		return metric;
+	}
+
+	const BenchMetric* BenchReport::findMetric(const std::string& name) const
+	{
+		for (const auto& metric : metrics)
+		{
+			if (metric.name == name) return &metric;
+		}
+		return nullptr;
+	}
+
+	void BenchReport::writeJson(std::ostream& out) const
+	{
+		out << std::setprecision(9);
+		out << "{\n  \"scene\": ";
+		writeJsonString(out, scene);
+		out << ",\n  \"device\": ";
+		writeJsonString(out, device);
+		out << ",\n  \"headless\": " << (headless ? "true" : "false")
+			<< ",\n  \"width\": " << width
+			<< ",\n  \"height\": " << height
+			<< ",\n  \"frames\": " << frames
+			<< ",\n  \"metrics\": {";
+		for (size_t i = 0; i < metrics.size(); ++i)
+		{
+			const BenchMetric& metric = metrics[i];
+			out << (i == 0 ? "\n    " : ",\n    ");
+			writeJsonString(out, metric.name);
+			out << ": { \"unit\": ";
+			writeJsonString(out, metric.unit);
+			out << ", \"mean\": " << metric.mean << ", \"p50\": " << metric.p50 << ", \"p95\": " << metric.p95
+				<< ", \"p99\": " << metric.p99 << ", \"min\": " << metric.min << ", \"max\": " << metric.max
+				<< ", \"samples\": " << metric.samples << " }";
+		}
+		out << "\n  }\n}\n";
+	}
+
+	void BenchReport::saveJson(const std::string& filepath) const
+	{
+		std::ofstream file{ filepath, std::ios::trunc };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+		writeJson(file);
+	}
+
+	BenchReport BenchReport::loadJson(const std::string& filepath)
+	{
+		std::ifstream file{ filepath };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+		std::stringstream content;
+		content << file.rdbuf();
+
+		BenchReport report{};
+		JsonReader reader{ content.str(), filepath };
+		reader.readObject([&](const std::string& key)
+		{
+			if (key == "scene") report.scene = reader.readString();
+			else if (key == "device") report.device = reader.readString();
+			else if (key == "headless") report.headless = reader.readBool();
+			else if (key == "width") report.width = static_cast<uint32_t>(reader.readNumber());
+			else if (key == "height") report.height = static_cast<uint32_t>(reader.readNumber());
+			else if (key == "frames") report.frames = static_cast<uint32_t>(reader.readNumber());
+			else if (key == "metrics")
+			{
+				reader.readObject([&](const std::string& name)
+				{
+					BenchMetric metric{ name, {} };
+					reader.readObject([&](const std::string& field)
+					{
+						if (field == "unit") metric.unit = reader.readString();
+						else if (field == "mean") metric.mean = reader.readNumber();
+						else if (field == "p50") metric.p50 = reader.readNumber();
+						else if (field == "p95") metric.p95 = reader.readNumber();
+						else if (field == "p99") metric.p99 = reader.readNumber();
+						else if (field == "min") metric.min = reader.readNumber();
+						else if (field == "max") metric.max = reader.readNumber();
+						else if (field == "samples") metric.samples = static_cast<uint32_t>(reader.readNumber());
+						else reader.skipValue();
+					});
+					report.metrics.push_back(metric);
+				});
+			}
+			else reader.skipValue();
+		});
+		return report;
+	}
+
+	std::vector<BenchRegression> compareReports(const BenchReport& baseline, const BenchReport& current, double tolerance)
+	{
+		std::vector<BenchRegression> regressions;
+		for (const auto& metric : current.metrics)
+		{
+			const BenchMetric* base = baseline.findMetric(metric.name);
+			if (base == nullptr || base->samples == 0 || metric.samples == 0) continue;
+
+			const std::pair<const char*, double BenchMetric::*> statistics[] = {
+				{ "mean", &BenchMetric::mean }, { "p50", &BenchMetric::p50 }, { "p95", &BenchMetric::p95 }, { "p99", &BenchMetric::p99 } };
+			for (const auto& [statistic, field] : statistics)
+			{
+				const double baseValue = base->*field;
+				const double value = metric.*field;
+				// Сравнение относительное; нулевая базовая линия (например, 0 отсечённых объектов) допускает только ноль
+				if (value > baseValue * (1.0 + tolerance) + 1e-9)
+				{
+					regressions.push_back(BenchRegression{ metric.name, statistic, baseValue, value });
+				}
+			}
+		}
+		return regressions;
+	}
+}
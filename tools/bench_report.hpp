@@ -0,0 +1,59 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace vget
+{
+	// Распределение одной метрики за прогон vget_bench (по всем замеренным кадрам)
+	struct BenchMetric
+	{
+		std::string name;
+		std::string unit;
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double min = 0.0;
+		double max = 0.0;
+		uint32_t samples = 0;
+
+		static BenchMetric fromSamples(const std::string& name, const std::string& unit, std::vector<double> values);
+	};
+
+	// Результат прогона. Формат JSON:
+	// { "scene": ..., "device": ..., "headless": ..., "width": ..., "height": ..., "frames": ...,
+	//   "metrics": { "<name>": { "unit": ..., "mean": ..., "p50": ..., "p95": ..., "p99": ..., "min": ..., "max": ..., "samples": ... }, ... } }
+	struct BenchReport
+	{
+		std::string scene;
+		std::string device;
+		bool headless = true;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t frames = 0;
+		std::vector<BenchMetric> metrics;
+
+		const BenchMetric* findMetric(const std::string& name) const;
+		void writeJson(std::ostream& out) const;
+		void saveJson(const std::string& filepath) const;
+		// Чтение отчёта, записанного saveJson (базовая линия для сравнения)
+		static BenchReport loadJson(const std::string& filepath);
+	};
+
+	// Статистика метрики, ухудшившаяся сильнее допуска
+	struct BenchRegression
+	{
+		std::string metric;
+		std::string statistic;
+		double baseline = 0.0;
+		double current = 0.0;
+	};
+
+	// Сравнение с базовой линией. Все метрики отчёта - "меньше значит лучше": регрессия - рост mean, p50, p95 или p99
+	// больше чем в (1 + tolerance) раз. Метрики, которых нет в одном из отчётов, не сравниваются.
+	std::vector<BenchRegression> compareReports(const BenchReport& baseline, const BenchReport& current, double tolerance);
+}
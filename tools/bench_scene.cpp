@@ -0,0 +1,151 @@
+#include "bench_scene.hpp"
+
+// libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace vget
+{
+	BenchScene BenchScene::load(const std::string& filepath)
+	{
+		std::ifstream file{ filepath };
+		if (!file.is_open())
+		{
+			throw std::runtime_error("failed to open file: " + filepath);
+		}
+
+		const std::filesystem::path directory = std::filesystem::path{ filepath }.parent_path();
+		auto resolve = [&](const std::string& path) { return (directory / path).lexically_normal().string(); };
+
+		BenchScene scene{};
+		scene.name = std::filesystem::path{ filepath }.filename().string();
+		bool hasCamera = false;
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(file, line))
+		{
+			++lineNumber;
+			std::istringstream stream{ line };
+			std::string command;
+			if (!(stream >> command) || command[0] == '#') continue;
+
+			if (command == "model")
+			{
+				Model model{};
+				TransformComponent& t = model.transform;
+				std::string path;
+				stream >> path >> t.translation.x >> t.translation.y >> t.translation.z >> t.rotation.x >> t.rotation.y >> t.rotation.z
+					>> t.scale.x >> t.scale.y >> t.scale.z;
+				// Необязательный флаг в конце строки: его отсутствие не ошибка разбора
+				const bool valid = !stream.fail();
+				std::string flag;
+				if (valid && stream >> flag) model.occluder = flag == "occluder";
+				if (valid) stream.clear();
+				model.path = resolve(path);
+				scene.models.push_back(model);
+			}
+			else if (command == "grid")
+			{
+				Grid grid{};
+				std::string path;
+				stream >> path >> grid.count.x >> grid.count.y >> grid.count.z >> grid.spacing >> grid.origin.x >> grid.origin.y >> grid.origin.z >> grid.scale;
+				grid.path = resolve(path);
+				scene.grids.push_back(grid);
+			}
+			else if (command == "lights")
+			{
+				LightRing ring{};
+				stream >> ring.count >> ring.center.x >> ring.center.y >> ring.center.z >> ring.radius >> ring.intensity;
+				scene.lights.push_back(ring);
+			}
+			else if (command == "camera")
+			{
+				std::string path;
+				stream >> path;
+				scene.cameraPath.load(resolve(path));
+				hasCamera = true;
+			}
+			else if (command == "frames")
+			{
+				stream >> scene.frames;
+			}
+			else if (command == "warmup")
+			{
+				stream >> scene.warmupFrames;
+			}
+			else
+			{
+				throw std::runtime_error("unknown scene command '" + command + "' in " + filepath);
+			}
+
+			if (stream.fail())
+			{
+				throw std::runtime_error("invalid scene line at " + filepath + ":" + std::to_string(lineNumber));
+			}
+		}
+
+		if (!hasCamera)
+		{
+			throw std::runtime_error("scene has no camera path: " + filepath);
+		}
+		return scene;
+	}
+
+	uint32_t BenchScene::populate(VgetDevice& device, VgetJobSystem& jobSystem, VgetWorld& world) const
+	{
+		std::map<std::string, std::shared_ptr<VgetModel>> loadedModels;
+		auto loadModel = [&](const std::string& path)
+		{
+			auto& model = loadedModels[path];
+			if (model == nullptr) model = VgetModel::createModelFromFile(device, path, &jobSystem);
+			return model;
+		};
+
+		uint32_t objectCount = 0;
+		for (const auto& entry : models)
+		{
+			const Entity entity = VgetGameObject::createGameObject(world, std::filesystem::path{ entry.path }.stem().string());
+			*world.getComponent<TransformComponent>(entity) = entry.transform;
+			world.addComponent(entity, ModelComponent{ loadModel(entry.path) });
+			if (entry.occluder) world.addComponent(entity, OccluderComponent{});
+			++objectCount;
+		}
+
+		// Экземпляры сеток без имён, как нагрузочная сетка интерфейса
+		for (const auto& grid : grids)
+		{
+			const std::shared_ptr<VgetModel> model = loadModel(grid.path);
+			for (int x = 0; x < grid.count.x; ++x)
+				for (int y = 0; y < grid.count.y; ++y)
+					for (int z = 0; z < grid.count.z; ++z)
+					{
+						TransformComponent transform{};
+						transform.translation = grid.origin + grid.spacing * glm::vec3(x, -y, z);
+						transform.scale = glm::vec3(grid.scale);
+						world.createEntity(transform, ModelComponent{ model });
+						++objectCount;
+					}
+		}
+
+		const std::array<glm::vec3, 6> lightColors{ {
+			{ 1.f, .1f, .1f }, { .1f, .1f, 1.f }, { .1f, 1.f, .1f }, { 1.f, 1.f, .1f }, { .1f, 1.f, 1.f }, { 1.f, 1.f, 1.f } } };
+		for (const auto& ring : lights)
+		{
+			for (uint32_t i = 0; i < ring.count; ++i)
+			{
+				const float angle = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(ring.count);
+				const Entity light = VgetGameObject::makePointLight(world, ring.intensity, 0.1f, lightColors[i % lightColors.size()]);
+				world.getComponent<TransformComponent>(light)->translation =
+					ring.center + ring.radius * glm::vec3(glm::cos(angle), 0.f, glm::sin(angle));
+			}
+		}
+		return objectCount;
+	}
+}
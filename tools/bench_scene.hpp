@@ -0,0 +1,63 @@
+#pragma once
+
+#include "vget_device.hpp"
+#include "vget_game_object.hpp"
+#include "vget_job_system.hpp"
+#include "vget_camera_path.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vget
+{
+	// Описание сцены vget_bench. Текстовый файл, строки с # - комментарии, пути - относительно файла сцены:
+	//   model <model.obj> tx ty tz rx ry rz sx sy sz [occluder]   - одиночный объект (трансформация как в TransformComponent)
+	//   grid <model.obj> nx ny nz spacing ox oy oz scale            - сетка nx * ny * nz экземпляров модели с началом в o
+	//   lights <count> cx cy cz radius intensity                   - кольцо точечных источников света вокруг c
+	//   camera <path.txt>                                          - путь камеры (VgetCameraPath)
+	//   frames <count>                                             - замеряемые кадры
+	//   warmup <count>                                             - кадры прогрева перед замером
+	struct BenchScene
+	{
+		struct Model
+		{
+			std::string path;
+			TransformComponent transform{};
+			bool occluder = false;
+		};
+
+		struct Grid
+		{
+			std::string path;
+			glm::ivec3 count{ 1 };
+			float spacing = 1.f;
+			glm::vec3 origin{};
+			float scale = 1.f;
+		};
+
+		struct LightRing
+		{
+			uint32_t count = 0;
+			glm::vec3 center{};
+			float radius = 1.f;
+			float intensity = 1.f;
+		};
+
+		std::string name;	// имя файла сцены без каталога
+		std::vector<Model> models;
+		std::vector<Grid> grids;
+		std::vector<LightRing> lights;
+		VgetCameraPath cameraPath{};
+		uint32_t frames = 600;
+		uint32_t warmupFrames = 60;
+
+		static BenchScene load(const std::string& filepath);
+
+		// Создание сущностей сцены в мире. Каждая модель загружается один раз, сколько бы раз она ни встречалась.
+		// Возвращает число объектов с моделями.
+		uint32_t populate(VgetDevice& device, VgetJobSystem& jobSystem, VgetWorld& world) const;
+	};
+}
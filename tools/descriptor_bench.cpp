@@ -0,0 +1,219 @@
+#include "vget_device.hpp"
+#include "vget_descriptors.hpp"
+#include "vget_buffer.hpp"
+#include "vget_texture.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Микробенчмарк выделения и записи наборов дескрипторов на девайсе без окна.
+//
+// descriptor_bench [--sets N] [--rounds N] [--pool-sets N]
+//
+// Каждый раунд выделяет и пишет N наборов (по умолчанию 100000) со схемой из uniform-буфера, storage-буфера
+// и Combined Image Sampler'а - как у наборов систем рендера - и затем сбрасывает пулы, как в начале кадра.
+// Сравниваются три способа:
+//   pool + writer       - текущий путь: пул фиксированного размера на все наборы и VgetDescriptorWriter;
+//   allocator + writer  - VgetDescriptorAllocator с цепочкой пулов по --pool-sets наборов и тот же писатель;
+//   allocator + template - тот же распределитель и запись набора шаблоном VgetDescriptorUpdateTemplate.
+// Выводится лучший и средний по раундам темп в наборах в секунду.
+namespace
+{
+	struct Options
+	{
+		uint32_t sets = 100000;
+		uint32_t rounds = 10;
+		uint32_t poolSets = 1024;
+	};
+
+	Options parseOptions(int argc, char** argv)
+	{
+		Options options{};
+		for (int arg = 1; arg < argc; ++arg)
+		{
+			const std::string option = argv[arg];
+			if (arg + 1 >= argc)
+			{
+				throw std::runtime_error("usage: descriptor_bench [--sets N] [--rounds N] [--pool-sets N]");
+			}
+
+			const uint32_t value = static_cast<uint32_t>(std::stoul(argv[++arg]));
+			if (option == "--sets") options.sets = value;
+			else if (option == "--rounds") options.rounds = value;
+			else if (option == "--pool-sets") options.poolSets = value;
+			else throw std::runtime_error("unknown option: " + option);
+		}
+		options.sets = std::max(options.sets, 1u);
+		options.rounds = std::max(options.rounds, 1u);
+		options.poolSets = std::max(options.poolSets, 1u);
+		return options;
+	}
+
+	// Данные набора в порядке привязок: по ним же описан шаблон обновления
+	struct SetData
+	{
+		VkDescriptorBufferInfo uniform;
+		VkDescriptorBufferInfo storage;
+		VkDescriptorImageInfo image;
+	};
+
+	struct CaseResult
+	{
+		std::string name;
+		double bestMs = 0.0;
+		double meanMs = 0.0;
+	};
+
+	// Раунд: allocateAndWrite на каждый набор, затем reset. Первый раунд - прогрев (создание пулов цепочки).
+	CaseResult runCase(
+		const std::string& name,
+		const Options& options,
+		const std::function<void()>& allocateAndWrite,
+		const std::function<void()>& reset)
+	{
+		CaseResult result{ name, 0.0, 0.0 };
+		double totalMs = 0.0;
+		for (uint32_t round = 0; round <= options.rounds; ++round)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < options.sets; ++i) allocateAndWrite();
+			reset();
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			if (round == 0) continue;
+
+			totalMs += ms;
+			result.bestMs = round == 1 ? ms : std::min(result.bestMs, ms);
+		}
+		result.meanMs = totalMs / options.rounds;
+		return result;
+	}
+
+	void printResult(const CaseResult& result, uint32_t sets)
+	{
+		const auto perSecond = [sets](double ms) { return sets / (ms * 1e-3) * 1e-3; };
+		std::cout << "  " << std::left << std::setw(22) << result.name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(10) << perSecond(result.bestMs) << " K sets/s best"
+			<< std::setw(10) << perSecond(result.meanMs) << " K sets/s mean"
+			<< std::setprecision(3) << std::setw(10) << result.meanMs << " ms/round" << std::endl;
+	}
+
+	void runBenchmark(const Options& options)
+	{
+		using namespace vget;
+
+		VgetDevice device{};
+
+		auto setLayout = VgetDescriptorSetLayout::Builder(device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.build();
+
+		VgetBuffer uniformBuffer{ device, 256, 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+		VgetBuffer storageBuffer{ device, 256, 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT };
+		VgetTexture::ImageData image{};
+		image.width = 1;
+		image.height = 1;
+		image.pixels = { 255, 255, 255, 255 };
+		VgetTexture texture{ image, device, "descriptor_bench" };
+
+		SetData data{};
+		data.uniform = uniformBuffer.descriptorInfo();
+		data.storage = storageBuffer.descriptorInfo();
+		data.image = texture.descriptorInfo();
+
+		// Текущий путь: пул должен вмещать все наборы кадра заранее
+		auto pool = VgetDescriptorPool::Builder(device)
+			.setMaxSets(options.sets)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, options.sets)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, options.sets)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, options.sets)
+			.build();
+		auto allocator = VgetDescriptorAllocator::Builder(device)
+			.setMaxSets(options.poolSets)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, options.poolSets)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, options.poolSets)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, options.poolSets)
+			.build();
+		auto updateTemplate = VgetDescriptorUpdateTemplate::Builder(device, *setLayout)
+			.addBinding(0, offsetof(SetData, uniform))
+			.addBinding(1, offsetof(SetData, storage))
+			.addBinding(2, offsetof(SetData, image))
+			.build();
+
+		std::cout << "device: " << device.properties.deviceName << "\n"
+			<< options.sets << " sets per round, " << options.rounds << " rounds, " << options.poolSets << " sets per allocator pool\n"
+			<< "descriptor update templates: " << (updateTemplate->isNative() ? "VK_KHR_descriptor_update_template" : "not supported, vkUpdateDescriptorSets fallback")
+			<< std::endl;
+
+		VkDescriptorSet set = VK_NULL_HANDLE;
+		const CaseResult poolWriter = runCase("pool + writer", options,
+			[&]()
+			{
+				if (!VgetDescriptorWriter(*setLayout, *pool)
+					.writeBuffer(0, &data.uniform)
+					.writeBuffer(1, &data.storage)
+					.writeImage(2, &data.image)
+					.build(set))
+				{
+					throw std::runtime_error("failed to allocate descriptor set!");
+				}
+			},
+			[&]() { pool->resetPool(); });
+
+		const CaseResult allocatorWriter = runCase("allocator + writer", options,
+			[&]()
+			{
+				if (!VgetDescriptorWriter(*setLayout, *allocator)
+					.writeBuffer(0, &data.uniform)
+					.writeBuffer(1, &data.storage)
+					.writeImage(2, &data.image)
+					.build(set))
+				{
+					throw std::runtime_error("failed to allocate descriptor set!");
+				}
+			},
+			[&]() { allocator->reset(); });
+
+		const CaseResult allocatorTemplate = runCase("allocator + template", options,
+			[&]()
+			{
+				if (!allocator->allocateDescriptor(setLayout->getDescriptorSetLayout(), set))
+				{
+					throw std::runtime_error("failed to allocate descriptor set!");
+				}
+				updateTemplate->update(set, &data);
+			},
+			[&]() { allocator->reset(); });
+
+		printResult(poolWriter, options.sets);
+		printResult(allocatorWriter, options.sets);
+		printResult(allocatorTemplate, options.sets);
+		std::cout << "allocator pools: " << allocator->getPoolCount() << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		runBenchmark(parseOptions(argc, argv));
+	}
+	catch (const std::exception& ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include "vget_pvs.hpp"
+#include "vget_game_object.hpp"
+
+// std
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Офлайн запекание потенциально видимых множеств (PVS) для статичной сцены.
+//
+// pvs_baker <output.pvs> <cellSize> <name> <model.obj> tx ty tz rx ry rz sx sy sz [<name> <model.obj> ...]
+//
+// name - полное имя игрового объекта в сцене (вместе с id, например LivingRoom0), по нему FirstApp сопоставляет
+// объект с запечёнными данными. Трансформация задаётся так же, как в TransformComponent.
+int main(int argc, char** argv)
+{
+	constexpr int ARGS_PER_OBJECT = 11;
+	if (argc < 3 + ARGS_PER_OBJECT || (argc - 3) % ARGS_PER_OBJECT != 0)
+	{
+		std::cerr << "usage: pvs_baker <output.pvs> <cellSize> "
+			"<name> <model.obj> tx ty tz rx ry rz sx sy sz [<name> <model.obj> ...]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		const std::string outputPath = argv[1];
+		vget::VgetPvsBaker::Settings settings{};
+		settings.cellSize = std::stof(argv[2]);
+
+		vget::VgetPvsBaker baker{};
+		for (int arg = 3; arg < argc; arg += ARGS_PER_OBJECT)
+		{
+			vget::TransformComponent transform{};
+			transform.translation = { std::stof(argv[arg + 2]), std::stof(argv[arg + 3]), std::stof(argv[arg + 4]) };
+			transform.rotation = { std::stof(argv[arg + 5]), std::stof(argv[arg + 6]), std::stof(argv[arg + 7]) };
+			transform.scale = { std::stof(argv[arg + 8]), std::stof(argv[arg + 9]), std::stof(argv[arg + 10]) };
+			const glm::mat4 modelMatrix = transform.mat4();
+
+			vget::VgetModel::Builder builder{};
+			builder.loadModel(argv[arg + 1]);
+
+			vget::VgetPvsBaker::Object object{};
+			object.name = argv[arg];
+			object.indices = builder.indices;
+			object.positions.reserve(builder.vertices.size());
+			for (const auto& vertex : builder.vertices)
+			{
+				object.positions.push_back(glm::vec3(modelMatrix * glm::vec4(vertex.position, 1.f)));
+			}
+			// Элементы совпадают с подобъектами, которые по отдельности рисует TextureRenderSystem.
+			// У моделей без материалов подобъекты пустые, и такая модель запекается одним элементом.
+			if (!builder.texturePaths.empty())
+			{
+				for (const auto& info : builder.subObjectsInfo)
+				{
+					object.subObjects.push_back(glm::uvec2{ info.indexStart, info.indexCount });
+				}
+			}
+
+			std::cout << object.name << ": " << object.indices.size() / 3 << " triangles, "
+				<< object.subObjects.size() << " sub-objects" << std::endl;
+			baker.addObject(std::move(object));
+		}
+
+		const vget::VgetPvs pvs = baker.bake(settings);
+		pvs.save(outputPath);
+
+		const auto& stats = baker.getStatistics();
+		std::cout << "cells: " << stats.cellCount << " (" << pvs.dimensions.x << "x" << pvs.dimensions.y << "x" << pvs.dimensions.z << ")"
+			<< ", items: " << stats.itemCount << ", unique sets: " << stats.uniqueSetCount << std::endl;
+		std::cout << "bake time: " << stats.bakeTimeMs << " ms, rays cast: " << stats.raysCast << std::endl;
+		std::cout << "file size: " << std::filesystem::file_size(outputPath) << " bytes -> " << outputPath << std::endl;
+	}
+	catch (const std::exception& ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
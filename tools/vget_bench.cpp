@@ -0,0 +1,400 @@
+#include "bench_scene.hpp"
+#include "bench_report.hpp"
+
+#include "vget_window.hpp"
+#include "vget_device.hpp"
+#include "vget_renderer.hpp"
+#include "vget_descriptors.hpp"
+#include "vget_buffer.hpp"
+#include "vget_camera.hpp"
+#include "vget_aabb_tree.hpp"
+#include "vget_occlusion.hpp"
+#include "vget_pvs.hpp"
+#include "vget_pass_recorder.hpp"
+#include "vget_texture_table.hpp"
+#include "vget_gpu_profiler.hpp"
+#include "vget_render_stats.hpp"
+#include "vget_transforms.hpp"
+#include "vget_scene_hierarchy.hpp"
+#include "vget_job_system.hpp"
+#include "vget_frame_info.hpp"
+#include "systems/simple_render_system.hpp"
+#include "systems/texture_render_system.hpp"
+#include "systems/point_light_system.hpp"
+#include "systems/light_cluster_system.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Воспроизводимый замер кадров движка для отслеживания регрессий производительности.
+//
+// vget_bench <scene.txt> [--frames N] [--warmup N] [--width W] [--height H] [--windowed] [--threads N]
+//            [--output report.json] [--baseline baseline.json] [--tolerance percent]
+//
+// Сцена (см. BenchScene) задаёт модели, сетки экземпляров, источники света и путь камеры. Время кадра фиксировано
+// (FRAME_TIME), а путь камеры растягивается на замеряемые кадры, поэтому каждый прогон рисует одни и те же кадры.
+// По умолчанию рендер идёт без окна во внеэкранные изображения (подходит для CI и программного ICD, например
+// lavapipe: VGET_PHYSICAL_DEVICE=llvmpipe). Отчёт с mean/p50/p95/p99 по каждой метрике пишется в JSON.
+// С --baseline отчёт сравнивается с базовой линией: код выхода 2 - регрессия больше допуска (по умолчанию 10%).
+namespace
+{
+	constexpr float FRAME_TIME = 1.f / 60.f;
+	constexpr int REGRESSION_EXIT_CODE = 2;
+
+	struct Options
+	{
+		std::string scenePath;
+		uint32_t frames = 0;	// 0 - из файла сцены
+		uint32_t warmupFrames = UINT32_MAX;	// UINT32_MAX - из файла сцены
+		uint32_t width = 1280;
+		uint32_t height = 960;
+		bool windowed = false;
+		uint32_t threads = 0;	// потоки записи команд, 0 - все рабочие потоки планировщика
+		std::string outputPath = "vget_bench.json";
+		std::string baselinePath;
+		double tolerancePercent = 10.0;
+	};
+
+	Options parseOptions(int argc, char** argv)
+	{
+		if (argc < 2)
+		{
+			throw std::runtime_error("usage: vget_bench <scene.txt> [--frames N] [--warmup N] [--width W] [--height H] [--windowed] "
+				"[--threads N] [--output report.json] [--baseline baseline.json] [--tolerance percent]");
+		}
+
+		Options options{};
+		options.scenePath = argv[1];
+		for (int arg = 2; arg < argc; ++arg)
+		{
+			const std::string option = argv[arg];
+			if (option == "--windowed")
+			{
+				options.windowed = true;
+				continue;
+			}
+			if (arg + 1 >= argc)
+			{
+				throw std::runtime_error("missing value for " + option);
+			}
+			const std::string value = argv[++arg];
+			if (option == "--frames") options.frames = static_cast<uint32_t>(std::stoul(value));
+			else if (option == "--warmup") options.warmupFrames = static_cast<uint32_t>(std::stoul(value));
+			else if (option == "--width") options.width = static_cast<uint32_t>(std::stoul(value));
+			else if (option == "--height") options.height = static_cast<uint32_t>(std::stoul(value));
+			else if (option == "--threads") options.threads = static_cast<uint32_t>(std::stoul(value));
+			else if (option == "--output") options.outputPath = value;
+			else if (option == "--baseline") options.baselinePath = value;
+			else if (option == "--tolerance") options.tolerancePercent = std::stod(value);
+			else throw std::runtime_error("unknown option " + option);
+		}
+		return options;
+	}
+
+	// Выборки метрик по замеряемым кадрам, в порядке их появления в отчёте
+	class MetricSamples
+	{
+	public:
+		void add(const std::string& name, const std::string& unit, double value)
+		{
+			auto found = indices.find(name);
+			if (found == indices.end())
+			{
+				found = indices.emplace(name, series.size()).first;
+				series.push_back(Series{ name, unit, {} });
+			}
+			series[found->second].values.push_back(value);
+		}
+
+		std::vector<vget::BenchMetric> build() const
+		{
+			std::vector<vget::BenchMetric> metrics;
+			for (const auto& entry : series) metrics.push_back(vget::BenchMetric::fromSamples(entry.name, entry.unit, entry.values));
+			return metrics;
+		}
+
+	private:
+		struct Series
+		{
+			std::string name;
+			std::string unit;
+			std::vector<double> values;
+		};
+
+		std::vector<Series> series;
+		std::unordered_map<std::string, size_t> indices;
+	};
+
+	vget::BenchReport runBenchmark(const vget::BenchScene& scene, const Options& options)
+	{
+		using namespace vget;
+
+		// Порядок объявления важен: девайс переживает все объекты, которые из него создаются
+		std::unique_ptr<VgetWindow> window;
+		std::unique_ptr<VgetDevice> device;
+		std::unique_ptr<VgetRenderer> renderer;
+		if (options.windowed)
+		{
+			window = std::make_unique<VgetWindow>(static_cast<int>(options.width), static_cast<int>(options.height), "vget_bench");
+			device = std::make_unique<VgetDevice>(*window);
+			renderer = std::make_unique<VgetRenderer>(*window, *device);
+		}
+		else
+		{
+			device = std::make_unique<VgetDevice>();
+			renderer = std::make_unique<VgetRenderer>(*device, VkExtent2D{ options.width, options.height });
+		}
+
+		VgetJobSystem jobSystem{};
+		auto globalPool = VgetDescriptorPool::Builder(*device)
+			.setMaxSets(VgetSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VgetSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * VgetSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.build();
+		VgetWorld world{};
+		VgetTransformBatch transformBatch{};
+		VgetSceneHierarchy sceneHierarchy{ &jobSystem };
+		VgetAabbTree sceneTree{};
+		VgetOcclusionCuller occlusionCuller{ &jobSystem };
+		VgetPvs pvs{};
+		VgetGpuProfiler gpuProfiler{ *device, VgetSwapChain::MAX_FRAMES_IN_FLIGHT };
+		VgetPassRecorder passRecorder{ *device, jobSystem, VgetSwapChain::MAX_FRAMES_IN_FLIGHT };
+
+		const uint32_t objectCount = scene.populate(*device, jobSystem, world);
+
+		std::vector<std::unique_ptr<VgetBuffer>> uboBuffers(VgetSwapChain::MAX_FRAMES_IN_FLIGHT);
+		for (auto& buffer : uboBuffers)
+		{
+			buffer = std::make_unique<VgetBuffer>(*device, sizeof(GlobalUbo), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			buffer->map();
+		}
+
+		auto globalSetLayout = VgetDescriptorSetLayout::Builder(*device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(LightClusterSystem::LIGHTS_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(LightClusterSystem::CLUSTER_RANGES_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.addBinding(LightClusterSystem::LIGHT_INDICES_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			.build();
+
+		std::vector<VkDescriptorSet> globalDescriptorSets(VgetSwapChain::MAX_FRAMES_IN_FLIGHT);
+		for (size_t i = 0; i < globalDescriptorSets.size(); ++i)
+		{
+			auto bufferInfo = uboBuffers[i]->descriptorInfo();
+			VgetDescriptorWriter(*globalSetLayout, *globalPool)
+				.writeBuffer(0, &bufferInfo)
+				.build(globalDescriptorSets[i]);
+		}
+
+		VgetCamera camera{};
+		SimpleRenderSystem simpleRenderSystem{ *device, renderer->getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+		TextureRenderSystem textureRenderSystem{ *device, renderer->getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+		PointLightSystem pointLightSystem{ *device, renderer->getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+		LightClusterSystem lightClusterSystem{ *device, *globalSetLayout, *globalPool };
+
+		passRecorder.setGpuProfiler(&gpuProfiler);
+		passRecorder.setMaxThreads(options.threads > 0 ? options.threads : jobSystem.getWorkerCount());
+		const uint32_t simpleRenderScope = gpuProfiler.addScope("SimpleRenderSystem");
+		const uint32_t textureRenderScope = gpuProfiler.addScope("TextureRenderSystem");
+		const uint32_t pointLightScope = gpuProfiler.addScope("PointLightSystem");
+		std::vector<uint64_t> gpuSampleCounts(gpuProfiler.getTimings().scopes.size(), 0);
+
+		const uint32_t frames = options.frames > 0 ? options.frames : scene.frames;
+		const uint32_t warmupFrames = options.warmupFrames != UINT32_MAX ? options.warmupFrames : scene.warmupFrames;
+		const VgetCameraPath& path = scene.cameraPath;
+		const float pathStart = path.getStartTime();
+
+		std::cout << "scene " << scene.name << ": " << objectCount << " objects, " << frames << " frames (+" << warmupFrames
+			<< " warmup), " << (options.windowed ? "windowed" : "headless") << " " << options.width << "x" << options.height << std::endl;
+
+		MetricSamples samples{};
+		bool sceneTreeBuilt = false;
+		for (uint32_t frame = 0; frame < warmupFrames + frames; ++frame)
+		{
+			if (window != nullptr)
+			{
+				glfwPollEvents();
+				if (window->shouldClose()) throw std::runtime_error("window closed before the benchmark finished");
+			}
+			const auto frameStart = std::chrono::high_resolution_clock::now();
+			const bool measured = frame >= warmupFrames;
+
+			// Прогрев стоит в начале пути, замеряемые кадры проходят его целиком
+			const uint32_t pathFrame = measured ? frame - warmupFrames : 0;
+			const float pathTime = frames > 1 ? path.getDuration() * static_cast<float>(pathFrame) / static_cast<float>(frames - 1) : 0.f;
+			const VgetCameraPath::Key key = path.sample(pathStart + pathTime);
+			camera.setViewYXZ(key.position, key.rotation);
+			camera.setPerspectiveProjection(glm::radians(50.f), renderer->getAspectRatio(), 0.1f, 100.f);
+
+			// Обновление сцены как в однопоточном цикле FirstApp: поток рендера не нужен, снимок всегда нулевой
+			FrameInfo updateInfo{ -1, FRAME_TIME, VK_NULL_HANDLE, passRecorder, camera, VK_NULL_HANDLE, world, sceneTree, occlusionCuller, pvs, 0 };
+			sceneHierarchy.update(world, transformBatch);
+			transformBatch.update(world);
+			if (!sceneTreeBuilt)
+			{
+				// Сцена статична: дерево объёмов строится один раз после первого пересчёта матриц
+				world.forEach<TransformComponent, ModelComponent>([&](Entity entity, TransformComponent& transform, ModelComponent& model)
+				{
+					sceneTree.createProxy(model.model->getBoundingBox().transformed(transform.worldMatrix), entity.index);
+				});
+				sceneTreeBuilt = true;
+			}
+			occlusionCuller.beginFrame(camera.getProjection() * camera.getView());
+			world.forEach<TransformComponent, ModelComponent, OccluderComponent>(
+				[&](Entity, TransformComponent& transform, ModelComponent& model, OccluderComponent&)
+				{
+					occlusionCuller.addOccluder(model.model->getOccluderMesh(), transform.worldMatrix);
+				});
+			occlusionCuller.rasterize();
+			pointLightSystem.update(updateInfo);
+			simpleRenderSystem.prepare(updateInfo);
+			textureRenderSystem.prepare(updateInfo);
+
+			auto commandBuffer = renderer->beginFrame();
+			if (commandBuffer == nullptr) continue; // окно изменило размер, кадр пропускается
+			device->getTextureTable().beginFrame();
+			const int frameIndex = renderer->getFrameIndex();
+			FrameInfo frameInfo{ frameIndex, FRAME_TIME, commandBuffer, passRecorder, camera,
+				globalDescriptorSets[frameIndex], world, sceneTree, occlusionCuller, pvs, 0 };
+
+			gpuProfiler.beginFrame(commandBuffer, frameIndex);
+			GlobalUbo ubo{};
+			ubo.projection = camera.getProjection();
+			ubo.view = camera.getView();
+			ubo.inverseView = camera.getInverseView();
+			lightClusterSystem.update(frameInfo, pointLightSystem.getLights(0), renderer->getSwapChainExtent(), ubo);
+			uboBuffers[frameIndex]->writeToBuffer(&ubo);
+			uboBuffers[frameIndex]->flush();
+			TextureSystemUbo textureSystemUbo{};
+			textureRenderSystem.update(frameInfo, textureSystemUbo);
+
+			passRecorder.beginFrame(frameIndex, renderer->getSwapChainRenderPass(), renderer->getCurrentFramebuffer(), renderer->getSwapChainExtent());
+			passRecorder.beginScope(simpleRenderScope);
+			simpleRenderSystem.renderGameObjects(frameInfo);
+			passRecorder.endScope();
+			passRecorder.beginScope(textureRenderScope);
+			textureRenderSystem.renderGameObjects(frameInfo);
+			passRecorder.endScope();
+			passRecorder.beginScope(pointLightScope);
+			pointLightSystem.render(frameInfo);
+			passRecorder.endScope();
+
+			renderer->beginSwapChainRenderPass(commandBuffer, ImVec4{ 0.f, 0.f, 0.f, 1.f }, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			passRecorder.execute(commandBuffer);
+			renderer->endSwapChainRenderPass(commandBuffer);
+			gpuProfiler.endFrame(commandBuffer);
+			renderer->endFrame();
+			gpuProfiler.markSubmitted();
+			// Кадр закрывается и на прогреве, чтобы загрузки и отправки прогрева не попали в первый замер
+			VgetRenderStats::addCommandStats(passRecorder.getStats());
+			const RenderCounters counters = VgetRenderStats::get().endFrame();
+
+			const double cpuFrameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count();
+			if (!measured) continue;
+
+			DrawStats drawStats = simpleRenderSystem.getDrawStats();
+			drawStats += textureRenderSystem.getDrawStats();
+			samples.add("cpuFrameMs", "ms", cpuFrameMs);
+			samples.add("recordMs", "ms", passRecorder.getRecordTimeMs());
+
+			// Замеры GPU читаются без ожидания и отстают на кадры в полёте: в выборку идут только новые
+			const GpuTimings& timings = gpuProfiler.getTimings();
+			for (size_t scope = 0; scope < timings.scopes.size() && timings.timestampsSupported; ++scope)
+			{
+				if (timings.scopes[scope].sampleCount == gpuSampleCounts[scope]) continue;
+				gpuSampleCounts[scope] = timings.scopes[scope].sampleCount;
+				samples.add(scope == VgetGpuProfiler::FRAME_SCOPE ? "gpuFrameMs" : "gpuMs/" + timings.scopes[scope].name, "ms",
+					timings.scopes[scope].lastMs);
+			}
+
+			samples.add("draws", "count", drawStats.draws);
+			samples.add("stateChanges", "count", drawStats.stateChanges);
+			samples.add("commandsIssued", "count", passRecorder.getStats().issued);
+			samples.add("secondaryBuffers", "count", passRecorder.getBufferCount());
+			samples.add("triangles", "count", counters[RenderCounter::Triangles]);
+			samples.add("uploadBytes", "bytes", counters[RenderCounter::UploadBytes]);
+			samples.add("queueSubmits", "count", counters[RenderCounter::QueueSubmits]);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{ device->getQueueMutex() };
+			vkDeviceWaitIdle(device->device());
+		}
+
+		BenchReport report{};
+		report.scene = scene.name;
+		report.device = device->properties.deviceName;
+		report.headless = !options.windowed;
+		report.width = renderer->getSwapChainExtent().width;
+		report.height = renderer->getSwapChainExtent().height;
+		report.frames = frames;
+		report.metrics = samples.build();
+		return report;
+	}
+
+	void printReport(const vget::BenchReport& report)
+	{
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "device: " << report.device << "\n";
+		std::cout << std::left << std::setw(34) << "metric" << std::right << std::setw(11) << "mean" << std::setw(11) << "p50"
+			<< std::setw(11) << "p95" << std::setw(11) << "p99" << "\n";
+		for (const auto& metric : report.metrics)
+		{
+			std::cout << std::left << std::setw(34) << metric.name << std::right << std::setw(11) << metric.mean << std::setw(11) << metric.p50
+				<< std::setw(11) << metric.p95 << std::setw(11) << metric.p99 << "\n";
+		}
+		std::cout << std::defaultfloat;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		const Options options = parseOptions(argc, argv);
+		const vget::BenchScene scene = vget::BenchScene::load(options.scenePath);
+		const vget::BenchReport report = runBenchmark(scene, options);
+
+		printReport(report);
+		report.saveJson(options.outputPath);
+		std::cout << "report: " << options.outputPath << std::endl;
+
+		if (!options.baselinePath.empty())
+		{
+			const vget::BenchReport baseline = vget::BenchReport::loadJson(options.baselinePath);
+			if (baseline.device != report.device || baseline.width != report.width || baseline.height != report.height)
+			{
+				std::cout << "warning: baseline was recorded on " << baseline.device << " at " << baseline.width << "x" << baseline.height << std::endl;
+			}
+
+			const auto regressions = vget::compareReports(baseline, report, options.tolerancePercent / 100.0);
+			for (const auto& regression : regressions)
+			{
+				std::cout << "REGRESSION " << regression.metric << " " << regression.statistic << ": " << regression.baseline
+					<< " -> " << regression.current << " (+" << (regression.baseline > 0.0 ? (regression.current / regression.baseline - 1.0) * 100.0 : 100.0)
+					<< "%)" << std::endl;
+			}
+			if (!regressions.empty())
+			{
+				std::cout << regressions.size() << " regression(s) over " << options.tolerancePercent << "% tolerance" << std::endl;
+				return REGRESSION_EXIT_CODE;
+			}
+			std::cout << "no regressions over " << options.tolerancePercent << "% tolerance" << std::endl;
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}